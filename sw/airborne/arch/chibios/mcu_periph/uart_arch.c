@@ -38,6 +38,7 @@
 #include <ch.h>
 #include <hal.h>
 #include "mcu_periph/gpio.h"
+#include <string.h>
 #include BOARD_CONFIG
 
 struct SerialInit {
@@ -78,14 +79,20 @@ static void handle_uart_tx(struct uart_periph *p)
   struct SerialInit *init_struct = (struct SerialInit *)(p->init_struct);
   chSemWait(init_struct->tx_sem);
   while (p->tx_insert_idx != p->tx_extract_idx) {
-    uint8_t data = p->tx_buf[p->tx_extract_idx];
+    // send the contiguous part of the circular buffer in one block,
+    // the producers only write after tx_insert_idx
+    uint16_t insert_idx = p->tx_insert_idx;
+    uint16_t len;
+    if (insert_idx > p->tx_extract_idx) {
+      len = insert_idx - p->tx_extract_idx;
+    } else {
+      len = UART_TX_BUFFER_SIZE - p->tx_extract_idx;
+    }
     p->tx_running = true;
-    sdWrite((SerialDriver *)p->reg_addr, &data, sizeof(data));
+    sdWrite((SerialDriver *)p->reg_addr, &p->tx_buf[p->tx_extract_idx], len);
     p->tx_running = false;
-    // TODO send by block (be careful with circular buffer)
     chMtxLock(init_struct->tx_mtx);
-    p->tx_extract_idx++;
-    p->tx_extract_idx %= UART_TX_BUFFER_SIZE;
+    p->tx_extract_idx = (p->tx_extract_idx + len) % UART_TX_BUFFER_SIZE;
     chMtxUnlock(init_struct->tx_mtx);
   }
 }
@@ -1007,12 +1014,14 @@ void uart_put_buffer(struct uart_periph *p, long fd, const uint8_t *data, uint16
       return;  // no room
     }
   }
-  // insert data into buffer
-  int i;
-  for (i = 0; i < len; i++) {
-    p->tx_buf[p->tx_insert_idx] = data[i];
-    p->tx_insert_idx = (p->tx_insert_idx + 1) % UART_TX_BUFFER_SIZE;
+  // insert data into buffer, in two blocks if it wraps around
+  uint16_t first = UART_TX_BUFFER_SIZE - p->tx_insert_idx;
+  if (first > len) {
+    first = len;
   }
+  memcpy(&p->tx_buf[p->tx_insert_idx], data, first);
+  memcpy(p->tx_buf, &data[first], len - first);
+  p->tx_insert_idx = (p->tx_insert_idx + len) % UART_TX_BUFFER_SIZE;
   // unlock if needed
   if (fd == 0) {
     chMtxUnlock(init_struct->tx_mtx);
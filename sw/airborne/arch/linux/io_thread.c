@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of Paparazzi.
+ *
+ * Paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * Paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Paparazzi; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * @file arch/linux/io_thread.c
+ * Single epoll based thread handling the input of all linux peripherals.
+ */
+
+#include "io_thread.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+
+#include "rt_priority.h"
+
+#ifndef IO_THREAD_PRIO
+#define IO_THREAD_PRIO 11
+#endif
+
+struct io_thread_source {
+  int fd;
+  io_thread_cb cb;
+  void *data;
+  uint32_t gen;   ///< incremented at each registration, to ignore the events of a previous one
+  bool busy;      ///< the callback is running in the I/O thread
+};
+
+static struct io_thread_source io_sources[IO_THREAD_MAX_FDS];
+static int io_epoll_fd = -1;
+static pthread_t io_tid;
+static pthread_once_t io_once = PTHREAD_ONCE_INIT;
+/** Protects io_sources, the callbacks are run without it */
+static pthread_mutex_t io_sources_mutex = PTHREAD_MUTEX_INITIALIZER;
+/** Signaled when a callback returns */
+static pthread_cond_t io_sources_cond = PTHREAD_COND_INITIALIZER;
+
+static void *io_thread(void *data __attribute__((unused)))
+{
+  get_rt_prio(IO_THREAD_PRIO);
+
+  struct epoll_event events[IO_THREAD_MAX_FDS];
+  while (1) {
+    int nb = epoll_wait(io_epoll_fd, events, IO_THREAD_MAX_FDS, -1);
+    if (nb < 0) {
+      if (errno != EINTR) {
+        perror("io_thread: epoll_wait failed");
+      }
+      continue;
+    }
+    for (int i = 0; i < nb; i++) {
+      // the source may have been removed since epoll_wait returned
+      struct io_thread_source *src = &io_sources[events[i].data.u64 & 0xffffffff];
+      pthread_mutex_lock(&io_sources_mutex);
+      io_thread_cb cb = (src->gen == events[i].data.u64 >> 32) ? src->cb : NULL;
+      void *cb_data = src->data;
+      src->busy = (cb != NULL);
+      pthread_mutex_unlock(&io_sources_mutex);
+      if (cb != NULL) {
+        cb(cb_data);
+        pthread_mutex_lock(&io_sources_mutex);
+        src->busy = false;
+        pthread_cond_broadcast(&io_sources_cond);
+        pthread_mutex_unlock(&io_sources_mutex);
+      }
+    }
+  }
+  return NULL;
+}
+
+static void io_thread_start(void)
+{
+  for (int i = 0; i < IO_THREAD_MAX_FDS; i++) {
+    io_sources[i].fd = -1;
+  }
+  io_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (io_epoll_fd < 0) {
+    perror("io_thread_start: epoll_create1 failed");
+    return;
+  }
+  if (pthread_create(&io_tid, NULL, io_thread, NULL) != 0) {
+    fprintf(stderr, "io_thread_start: Could not create I/O thread.\n");
+    return;
+  }
+}
+
+bool io_thread_add(int fd, io_thread_cb cb, void *data)
+{
+  pthread_once(&io_once, io_thread_start);
+  if (io_epoll_fd < 0 || fd < 0) {
+    return false;
+  }
+
+  pthread_mutex_lock(&io_sources_mutex);
+  int idx = -1;
+  for (int i = 0; i < IO_THREAD_MAX_FDS; i++) {
+    if (io_sources[i].fd < 0) {
+      idx = i;
+      break;
+    }
+  }
+  bool ok = false;
+  if (idx >= 0) {
+    struct io_thread_source *src = &io_sources[idx];
+    src->fd = fd;
+    src->cb = cb;
+    src->data = data;
+    src->gen++;
+    struct epoll_event ev = { .events = EPOLLIN, .data.u64 = ((uint64_t)src->gen << 32) | idx };
+    ok = epoll_ctl(io_epoll_fd, EPOLL_CTL_ADD, fd, &ev) == 0;
+    if (!ok) {
+      perror("io_thread_add: epoll_ctl failed");
+      src->fd = -1;
+    }
+  } else {
+    fprintf(stderr, "io_thread_add: more than %d file descriptors\n", IO_THREAD_MAX_FDS);
+  }
+  pthread_mutex_unlock(&io_sources_mutex);
+  return ok;
+}
+
+void io_thread_remove(int fd)
+{
+  if (io_epoll_fd < 0 || fd < 0) {
+    return;
+  }
+  pthread_mutex_lock(&io_sources_mutex);
+  for (int i = 0; i < IO_THREAD_MAX_FDS; i++) {
+    if (io_sources[i].fd == fd) {
+      epoll_ctl(io_epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+      io_sources[i].cb = NULL;
+      io_sources[i].fd = -1;
+      // wait for a running callback, unless it is the one removing its source
+      while (io_sources[i].busy && !pthread_equal(pthread_self(), io_tid)) {
+        pthread_cond_wait(&io_sources_cond, &io_sources_mutex);
+      }
+      break;
+    }
+  }
+  pthread_mutex_unlock(&io_sources_mutex);
+}
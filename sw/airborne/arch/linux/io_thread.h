@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of Paparazzi.
+ *
+ * Paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * Paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Paparazzi; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * @file arch/linux/io_thread.h
+ * Single epoll based thread handling the input of all linux peripherals.
+ *
+ * Peripherals register their file descriptor with a callback that is run
+ * from the I/O thread whenever the descriptor becomes readable. The thread
+ * is started by the first registration.
+ */
+
+#ifndef IO_THREAD_H
+#define IO_THREAD_H
+
+#include <stdbool.h>
+
+/** Maximum number of file descriptors handled by the I/O thread */
+#ifndef IO_THREAD_MAX_FDS
+#define IO_THREAD_MAX_FDS 16
+#endif
+
+typedef void (*io_thread_cb)(void *data);
+
+/**
+ * Run a callback from the I/O thread each time a file descriptor is readable.
+ * @param[in] fd file descriptor to watch
+ * @param[in] cb callback reading from fd
+ * @param[in] data user data passed to the callback
+ * @return true on success
+ */
+extern bool io_thread_add(int fd, io_thread_cb cb, void *data);
+
+/**
+ * Stop watching a file descriptor, before closing it.
+ * If its callback is running, wait until it returns, so that its data can be
+ * freed afterwards (except when called from the callback itself).
+ * @param[in] fd file descriptor previously registered with io_thread_add
+ */
+extern void io_thread_remove(int fd);
+
+#endif /* IO_THREAD_H */
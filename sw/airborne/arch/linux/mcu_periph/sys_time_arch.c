@@ -47,6 +47,39 @@ void *sys_time_thread_main(void *data);
 
 #define NSEC_OF_SEC(sec) ((sec) * 1e9)
 
+/**
+ * Deadline scheduling: instead of waking up every sys_time.resolution,
+ * the sys_time thread sleeps until the earliest timer deadline.
+ */
+#ifndef SYS_TIME_DEADLINE_SCHED
+#define SYS_TIME_DEADLINE_SCHED FALSE
+#endif
+
+/** Maximum sleep time in deadline mode, bounds the delay of timers registered while sleeping */
+#ifndef SYS_TIME_DEADLINE_MAX_SLEEP
+#define SYS_TIME_DEADLINE_MAX_SLEEP 0.01
+#endif
+
+#if SYS_TIME_DEADLINE_SCHED
+/**
+ * Absolute time of the next timer deadline, at most SYS_TIME_DEADLINE_MAX_SLEEP from now.
+ */
+static void sys_time_next_deadline(struct timespec *next)
+{
+  uint32_t next_tick = sys_time.nb_tick + sys_time_ticks_of_sec(SYS_TIME_DEADLINE_MAX_SLEEP);
+  for (unsigned int i = 0; i < SYS_TIME_NB_TIMER; i++) {
+    if (sys_time.timer[i].in_use && (int32_t)(sys_time.timer[i].end_time - next_tick) < 0) {
+      next_tick = sys_time.timer[i].end_time;
+    }
+  }
+  // rounded up to the next usec, as sys_tick_handler computes the ticks from truncated usec
+  uint64_t usec = ((uint64_t)next_tick * 1000000ULL + sys_time.ticks_per_sec - 1) / sys_time.ticks_per_sec;
+  uint64_t nsec = usec * 1000ULL + startup_time.tv_nsec;
+  next->tv_sec = startup_time.tv_sec + nsec / 1000000000ULL;
+  next->tv_nsec = nsec % 1000000000ULL;
+}
+#endif
+
 void *sys_time_thread_main(void *data)
 {
   int fd;
@@ -60,6 +93,23 @@ void *sys_time_thread_main(void *data)
 
   get_rt_prio(SYS_TIME_THREAD_PRIO);
 
+#if SYS_TIME_DEADLINE_SCHED
+  while (1) {
+    /* one shot timer at the next deadline (absolute time) */
+    struct itimerspec timer = { .it_interval = { 0, 0 } };
+    sys_time_next_deadline(&timer.it_value);
+    if (timerfd_settime(fd, TFD_TIMER_ABSTIME, &timer, NULL) == -1) {
+      perror("Could not set up timer.");
+      return NULL;
+    }
+    unsigned long long expirations;
+    if (read(fd, &expirations, sizeof(expirations)) == -1) {
+      perror("Couldn't read timer!");
+    }
+    /* set current sys_time and run elapsed timers */
+    sys_tick_handler();
+  }
+#else
   /* Make the timer periodic */
   struct itimerspec timer;
   /* timer expires after sys_time.resolution sec */
@@ -88,6 +138,7 @@ void *sys_time_thread_main(void *data)
     /* set current sys_time */
     sys_tick_handler();
   }
+#endif
   return NULL;
 }
 
@@ -35,181 +35,19 @@
 #include <errno.h>
 
 #include "serial_port.h"
-#include "rt_priority.h"
+#include "io_thread.h"
 
-#include <pthread.h>
-#include <sys/select.h>
-
-#ifndef UART_THREAD_PRIO
-#define UART_THREAD_PRIO 11
-#endif
-
-static void uart_receive_handler(struct uart_periph *periph);
-static void *uart_thread(void *data __attribute__((unused)));
-static pthread_mutex_t uart_mutex = PTHREAD_MUTEX_INITIALIZER;
+static void uart_receive_handler(void *data);
 
 //#define TRACE(fmt,args...)    fprintf(stderr, fmt, args)
 #define TRACE(fmt,args...)
 
+/**
+ * Serial ports are registered with the common I/O thread when opened,
+ * nothing left to do here.
+ */
 void uart_arch_init(void)
 {
-  pthread_mutex_init(&uart_mutex, NULL);
-
-  pthread_t tid;
-  if (pthread_create(&tid, NULL, uart_thread, NULL) != 0) {
-    fprintf(stderr, "uart_arch_init: Could not create UART reading thread.\n");
-    return;
-  }
-}
-
-static void *uart_thread(void *data __attribute__((unused)))
-{
-  get_rt_prio(UART_THREAD_PRIO);
-
-  /* file descriptor list */
-  fd_set fds_master;
-  /* maximum file descriptor number */
-  int fdmax = 0;
-
-  /* clear the fd list */
-  FD_ZERO(&fds_master);
-  /* add used fds */
-  int __attribute__ ((unused)) fd;
-#if USE_UART0
-  if (uart0.reg_addr != NULL) {
-    fd = ((struct SerialPort *)uart0.reg_addr)->fd;
-    FD_SET(fd, &fds_master);
-    if (fd > fdmax) {
-      fdmax =fd;
-    }
-  }
-#endif
-#if USE_UART1
-  if (uart1.reg_addr != NULL) {
-    fd = ((struct SerialPort *)uart1.reg_addr)->fd;
-    FD_SET(fd, &fds_master);
-    if (fd > fdmax) {
-      fdmax =fd;
-    }
-  }
-#endif
-#if USE_UART2
-  if (uart2.reg_addr != NULL) {
-    fd = ((struct SerialPort *)uart2.reg_addr)->fd;
-    FD_SET(fd, &fds_master);
-    if (fd > fdmax) {
-      fdmax =fd;
-    }
-  }
-#endif
-#if USE_UART3
-  if (uart3.reg_addr != NULL) {
-    fd = ((struct SerialPort *)uart3.reg_addr)->fd;
-    FD_SET(fd, &fds_master);
-    if (fd > fdmax) {
-      fdmax =fd;
-    }
-  }
-#endif
-#if USE_UART4
-  if (uart4.reg_addr != NULL) {
-    fd = ((struct SerialPort *)uart4.reg_addr)->fd;
-    FD_SET(fd, &fds_master);
-    if (fd > fdmax) {
-      fdmax =fd;
-    }
-  }
-#endif
-#if USE_UART5
-  if (uart5.reg_addr != NULL) {
-    fd = ((struct SerialPort *)uart5.reg_addr)->fd;
-    FD_SET(fd, &fds_master);
-    if (fd > fdmax) {
-      fdmax =fd;
-    }
-  }
-#endif
-#if USE_UART6
-  if (uart6.reg_addr != NULL) {
-    fd = ((struct SerialPort *)uart6.reg_addr)->fd;
-    FD_SET(fd, &fds_master);
-    if (fd > fdmax) {
-      fdmax =fd;
-    }
-  }
-#endif
-
-  /* fds to be read, modified after each select */
-  fd_set fds;
-
-  while (1) {
-    /* reset list of fds to check */
-    fds = fds_master;
-
-    if (select(fdmax + 1, &fds, NULL, NULL, NULL) < 0) {
-      fprintf(stderr, "uart_thread: select failed!");
-    }
-    else {
-#if USE_UART0
-      if (uart0.reg_addr != NULL) {
-        fd = ((struct SerialPort *)uart0.reg_addr)->fd;
-        if (FD_ISSET(fd, &fds)) {
-          uart_receive_handler(&uart0);
-        }
-      }
-#endif
-#if USE_UART1
-      if (uart1.reg_addr != NULL) {
-        fd = ((struct SerialPort *)uart1.reg_addr)->fd;
-        if (FD_ISSET(fd, &fds)) {
-          uart_receive_handler(&uart1);
-        }
-      }
-#endif
-#if USE_UART2
-      if (uart2.reg_addr != NULL) {
-        fd = ((struct SerialPort *)uart2.reg_addr)->fd;
-        if (FD_ISSET(fd, &fds)) {
-          uart_receive_handler(&uart2);
-        }
-      }
-#endif
-#if USE_UART3
-      if (uart3.reg_addr != NULL) {
-        fd = ((struct SerialPort *)uart3.reg_addr)->fd;
-        if (FD_ISSET(fd, &fds)) {
-          uart_receive_handler(&uart3);
-        }
-      }
-#endif
-#if USE_UART4
-      if (uart4.reg_addr != NULL) {
-        fd = ((struct SerialPort *)uart4.reg_addr)->fd;
-        if (FD_ISSET(fd, &fds)) {
-          uart_receive_handler(&uart4);
-        }
-      }
-#endif
-#if USE_UART5
-      if (uart5.reg_addr != NULL) {
-        fd = ((struct SerialPort *)uart5.reg_addr)->fd;
-        if (FD_ISSET(fd, &fds)) {
-          uart_receive_handler(&uart5);
-        }
-      }
-#endif
-#if USE_UART6
-      if (uart6.reg_addr != NULL) {
-        fd = ((struct SerialPort *)uart6.reg_addr)->fd;
-        if (FD_ISSET(fd, &fds)) {
-          uart_receive_handler(&uart6);
-        }
-      }
-#endif
-    }
-  }
-
-  return 0;
 }
 
 // open serial link
@@ -222,6 +60,7 @@ static void uart_periph_open(struct uart_periph *periph, uint32_t baud)
   // close serial port if already open
   if (periph->reg_addr != NULL) {
     port = (struct SerialPort *)(periph->reg_addr);
+    io_thread_remove(port->fd);
     serial_port_close(port);
     serial_port_free(port);
   }
@@ -238,7 +77,9 @@ static void uart_periph_open(struct uart_periph *periph, uint32_t baud)
     TRACE("Error opening %s code %d\n", periph->dev, ret);
     serial_port_free(port);
     periph->reg_addr = NULL;
+    return;
   }
+  io_thread_add(port->fd, uart_receive_handler, periph);
 }
 
 void uart_periph_set_baudrate(struct uart_periph *periph, uint32_t baud)
@@ -285,49 +126,58 @@ void uart_put_byte(struct uart_periph *periph, long fd __attribute__((unused)),
 }
 
 
-static void __attribute__ ((unused)) uart_receive_handler(struct uart_periph *periph)
+/**
+ * Read all available bytes into the rx buffer.
+ * Called from the I/O thread, which is the only writer of rx_insert_idx.
+ * The rx buffer is a single producer/single consumer ring, indexes are
+ * published with release stores so no lock is needed.
+ */
+static void uart_receive_handler(void *data)
 {
-  unsigned char c = 'D';
+  struct uart_periph *periph = (struct uart_periph *)data;
+  uint8_t buf[UART_RX_BUFFER_SIZE];
 
   if (periph->reg_addr == NULL) { return; } // device not initialized ?
 
   struct SerialPort *port = (struct SerialPort *)(periph->reg_addr);
-  int fd = port->fd;
-
-  pthread_mutex_lock(&uart_mutex);
-
-  if (read(fd, &c, 1) > 0) {
-    //printf("r %x %c\n",c,c);
-    uint16_t temp = (periph->rx_insert_idx + 1) % UART_RX_BUFFER_SIZE;
-    // check for more room in queue
-    if (temp != periph->rx_extract_idx) {
-      periph->rx_buf[periph->rx_insert_idx] = c;
-      periph->rx_insert_idx = temp;  // update insert index
-    }
-    else {
-      TRACE("uart_receive_handler: rx_buf full! discarding received byte: %x %c\n", c, c);
-    }
+
+  uint16_t insert = periph->rx_insert_idx;
+  uint16_t extract = __atomic_load_n(&periph->rx_extract_idx, __ATOMIC_ACQUIRE);
+  int16_t space = extract - insert - 1;
+  if (space < 0) {
+    space += UART_RX_BUFFER_SIZE;
   }
-  pthread_mutex_unlock(&uart_mutex);
+
+  // when the buffer is full the bytes are still read (and discarded) to not spin on a readable fd
+  ssize_t nb = read(port->fd, buf, space > 0 ? space : sizeof(buf));
+  if (nb <= 0) {
+    return;
+  }
+  if (space == 0) {
+    TRACE("uart_receive_handler: rx_buf full! discarding %d received bytes\n", (int)nb);
+    return;
+  }
+
+  uint16_t first = Min(nb, UART_RX_BUFFER_SIZE - insert);
+  memcpy(&periph->rx_buf[insert], buf, first);
+  memcpy(periph->rx_buf, &buf[first], nb - first);
+  __atomic_store_n(&periph->rx_insert_idx, (insert + nb) % UART_RX_BUFFER_SIZE, __ATOMIC_RELEASE);
 }
 
 uint8_t uart_getch(struct uart_periph *p)
 {
-  pthread_mutex_lock(&uart_mutex);
-  uint8_t ret = p->rx_buf[p->rx_extract_idx];
-  p->rx_extract_idx = (p->rx_extract_idx + 1) % UART_RX_BUFFER_SIZE;
-  pthread_mutex_unlock(&uart_mutex);
+  uint16_t extract = p->rx_extract_idx;
+  uint8_t ret = p->rx_buf[extract];
+  __atomic_store_n(&p->rx_extract_idx, (extract + 1) % UART_RX_BUFFER_SIZE, __ATOMIC_RELEASE);
   return ret;
 }
 
 uint16_t uart_char_available(struct uart_periph *p)
 {
-  pthread_mutex_lock(&uart_mutex);
-  int16_t available = p->rx_insert_idx - p->rx_extract_idx;
+  int16_t available = __atomic_load_n(&p->rx_insert_idx, __ATOMIC_ACQUIRE) - p->rx_extract_idx;
   if (available < 0) {
     available += UART_RX_BUFFER_SIZE;
   }
-  pthread_mutex_unlock(&uart_mutex);
   return (uint16_t)available;
 }
 
@@ -23,28 +23,37 @@
  * linux UDP handling
  */
 
+#define _GNU_SOURCE // for recvmmsg
+
 #include "mcu_periph/udp.h"
 #include "udp_socket.h"
+#include "io_thread.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <errno.h>
 
-#include <pthread.h>
-#include <sys/select.h>
-
-#include "rt_priority.h"
-
-#ifndef UDP_THREAD_PRIO
-#define UDP_THREAD_PRIO 10
+/** Maximum number of datagrams read by a single recvmmsg call */
+#ifndef UDP_RECV_BATCH
+#define UDP_RECV_BATCH 8
 #endif
 
-static void *udp_thread(void *data __attribute__((unused)));
-static pthread_mutex_t udp_mutex = PTHREAD_MUTEX_INITIALIZER;
+/** UDP socket of a peripheral with the buffers of the batched reads */
+struct UdpArchSocket {
+  struct UdpSocket sock;    ///< first member, p->network points to it
+  uint8_t buf[UDP_RECV_BATCH][UDP_RX_BUFFER_SIZE];
+  struct iovec iov[UDP_RECV_BATCH];
+  struct sockaddr_in addr[UDP_RECV_BATCH];
+  struct mmsghdr msgs[UDP_RECV_BATCH];
+};
 
-void udp_arch_init(void)
+static void udp_receive_handler(void *data)
 {
-  pthread_mutex_init(&udp_mutex, NULL);
+  udp_receive((struct udp_periph *)data);
+}
 
+void udp_arch_init(void)
+{
 #ifdef USE_UDP0
   UDP0Init();
 #endif
@@ -54,38 +63,45 @@ void udp_arch_init(void)
 #ifdef USE_UDP2
   UDP2Init();
 #endif
-
-  pthread_t tid;
-  if (pthread_create(&tid, NULL, udp_thread, NULL) != 0) {
-    fprintf(stderr, "udp_arch_init: Could not create UDP reading thread.\n");
-    return;
-  }
 }
 
 /**
  * Initialize the UDP peripheral.
- * Allocate UdpSocket struct and create and bind the UDP socket.
+ * Allocate UdpSocket struct with the receive buffers, create and bind the
+ * UDP socket and register it with the common I/O thread.
  */
 void udp_arch_periph_init(struct udp_periph *p, char *host, int port_out, int port_in, bool broadcast)
 {
-  struct UdpSocket *sock = malloc(sizeof(struct UdpSocket));
+  struct UdpArchSocket *arch = malloc(sizeof(struct UdpArchSocket));
+  memset(arch->msgs, 0, sizeof(arch->msgs));
+  for (int i = 0; i < UDP_RECV_BATCH; i++) {
+    arch->iov[i].iov_base = arch->buf[i];
+    arch->iov[i].iov_len = UDP_RX_BUFFER_SIZE;
+    arch->msgs[i].msg_hdr.msg_iov = &arch->iov[i];
+    arch->msgs[i].msg_hdr.msg_iovlen = 1;
+    arch->msgs[i].msg_hdr.msg_name = &arch->addr[i];
+  }
+  struct UdpSocket *sock = &arch->sock;
   udp_socket_create(sock, host, port_out, port_in, broadcast);
   p->network = (void *)sock;
+  if (port_in >= 0) {
+    io_thread_add(sock->sockfd, udp_receive_handler, p);
+  }
 }
 
 /**
  * Get number of bytes available in receive buffer.
+ * The rx buffer is a single producer (I/O thread) single consumer ring,
+ * indexes are published with release stores so no lock is needed.
  * @param p pointer to UDP peripheral
  * @return number of bytes available in receive buffer
  */
 uint16_t udp_char_available(struct udp_periph *p)
 {
-  pthread_mutex_lock(&udp_mutex);
-  int16_t available = p->rx_insert_idx - p->rx_extract_idx;
+  int16_t available = __atomic_load_n(&p->rx_insert_idx, __ATOMIC_ACQUIRE) - p->rx_extract_idx;
   if (available < 0) {
     available += UDP_RX_BUFFER_SIZE;
   }
-  pthread_mutex_unlock(&udp_mutex);
   return (uint16_t)available;
 }
 
@@ -96,44 +112,50 @@ uint16_t udp_char_available(struct udp_periph *p)
  */
 uint8_t udp_getch(struct udp_periph *p)
 {
-  pthread_mutex_lock(&udp_mutex);
-  uint8_t ret = p->rx_buf[p->rx_extract_idx];
-  p->rx_extract_idx = (p->rx_extract_idx + 1) % UDP_RX_BUFFER_SIZE;
-  pthread_mutex_unlock(&udp_mutex);
+  uint16_t extract = p->rx_extract_idx;
+  uint8_t ret = p->rx_buf[extract];
+  __atomic_store_n(&p->rx_extract_idx, (extract + 1) % UDP_RX_BUFFER_SIZE, __ATOMIC_RELEASE);
   return ret;
 }
 
 /**
- * Read bytes from UDP
+ * Read pending datagrams from UDP, up to UDP_RECV_BATCH per system call.
+ * Data not fitting in the receive buffer is dropped.
+ * The address of the sender of the last datagram is kept in addr_in.
  */
 void udp_receive(struct udp_periph *p)
 {
   if (p == NULL) return;
   if (p->network == NULL) return;
 
-  int16_t i;
-  int16_t available = UDP_RX_BUFFER_SIZE - udp_char_available(p);
-  uint8_t buf[UDP_RX_BUFFER_SIZE];
-  struct UdpSocket *sock = (struct UdpSocket *) p->network;
-
-  if (available <= 0) {
-    return;  // No space
+  struct UdpArchSocket *arch = (struct UdpArchSocket *) p->network;
+  struct mmsghdr *msgs = arch->msgs;
+  for (int i = 0; i < UDP_RECV_BATCH; i++) {
+    msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
   }
 
-  socklen_t slen = sizeof(struct sockaddr_in);
-  ssize_t byte_read = recvfrom(sock->sockfd, buf, available, MSG_DONTWAIT,
-                               (struct sockaddr *)&sock->addr_in, &slen);
-
-  pthread_mutex_lock(&udp_mutex);
+  int nb_msgs = recvmmsg(arch->sock.sockfd, msgs, UDP_RECV_BATCH, MSG_DONTWAIT, NULL);
+  if (nb_msgs <= 0) {
+    return;
+  }
+  arch->sock.addr_in = arch->addr[nb_msgs - 1];
 
-  if (byte_read > 0) {
-    for (i = 0; i < byte_read; i++) {
-      p->rx_buf[p->rx_insert_idx] = buf[i];
-      p->rx_insert_idx = (p->rx_insert_idx + 1) % UDP_RX_BUFFER_SIZE;
-    }
+  uint16_t insert = p->rx_insert_idx;
+  uint16_t extract = __atomic_load_n(&p->rx_extract_idx, __ATOMIC_ACQUIRE);
+  int16_t space = extract - insert - 1;
+  if (space < 0) {
+    space += UDP_RX_BUFFER_SIZE;
   }
 
-  pthread_mutex_unlock(&udp_mutex);
+  for (int i = 0; i < nb_msgs && space > 0; i++) {
+    uint16_t len = Min(msgs[i].msg_len, (uint16_t)space);
+    uint16_t first = Min(len, UDP_RX_BUFFER_SIZE - insert);
+    memcpy(&p->rx_buf[insert], arch->buf[i], first);
+    memcpy(p->rx_buf, &arch->buf[i][first], len - first);
+    insert = (insert + len) % UDP_RX_BUFFER_SIZE;
+    space -= len;
+  }
+  __atomic_store_n(&p->rx_insert_idx, insert, __ATOMIC_RELEASE);
 }
 
 /**
@@ -174,75 +196,3 @@ void udp_send_raw(struct udp_periph *p, long fd __attribute__((unused)), uint8_t
   ssize_t test __attribute__((unused)) = sendto(sock->sockfd, buffer, size, MSG_DONTWAIT,
                                          (struct sockaddr *)&sock->addr_out, sizeof(sock->addr_out));
 }
-
-/**
- * check for new udp packets to receive or send.
- */
-static void *udp_thread(void *data __attribute__((unused)))
-{
-  get_rt_prio(UDP_THREAD_PRIO);
-
-  /* file descriptor list */
-  fd_set socks_master;
-  /* maximum file descriptor number */
-  int fdmax = 0;
-
-  /* clear the fd list */
-  FD_ZERO(&socks_master);
-  /* add used sockets */
-  int fd __attribute__((unused));
-#if USE_UDP0
-  fd = ((struct UdpSocket *)udp0.network)->sockfd;
-  FD_SET(fd, &socks_master);
-  if (fd > fdmax) {
-    fdmax =fd;
-  }
-#endif
-#if USE_UDP1
-  fd = ((struct UdpSocket *)udp1.network)->sockfd;
-  FD_SET(fd, &socks_master);
-  if (fd > fdmax) {
-    fdmax =fd;
-  }
-#endif
-#if USE_UDP2
-  fd = ((struct UdpSocket *)udp2.network)->sockfd;
-  FD_SET(fd, &socks_master);
-  if (fd > fdmax) {
-    fdmax =fd;
-  }
-#endif
-
-  /* socks to be read, modified after each select */
-  fd_set socks;
-
-  while (1) {
-    /* reset list of socks to check */
-    socks = socks_master;
-
-    if (select(fdmax + 1, &socks, NULL, NULL, NULL) < 0) {
-      fprintf(stderr, "udp_thread: select failed!");
-    }
-    else {
-#if USE_UDP0
-      fd = ((struct UdpSocket *)udp0.network)->sockfd;
-      if (FD_ISSET(fd, &socks)) {
-        udp_receive(&udp0);
-      }
-#endif
-#if USE_UDP1
-      fd = ((struct UdpSocket *)udp1.network)->sockfd;
-      if (FD_ISSET(fd, &socks)) {
-        udp_receive(&udp1);
-      }
-#endif
-#if USE_UDP2
-      fd = ((struct UdpSocket *)udp2.network)->sockfd;
-      if (FD_ISSET(fd, &socks)) {
-        udp_receive(&udp2);
-      }
-#endif
-    }
-  }
-  return 0;
-}
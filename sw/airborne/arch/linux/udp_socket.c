@@ -24,6 +24,8 @@
  * Easily create and use UDP sockets.
  */
 
+#define _GNU_SOURCE // for sendmmsg
+
 #include "udp_socket.h"
 #include <sys/socket.h>
 #include <arpa/inet.h>
@@ -149,6 +151,63 @@ int udp_socket_send_dontwait(struct UdpSocket *sock, uint8_t *buffer, uint32_t l
   return bytes_sent;
 }
 
+/**
+ * Send multiple packets with as few system calls as possible (sendmmsg).
+ * Every packet is gathered from iov_per_packet consecutive entries of iov, so headers
+ * and payload do not need to be copied into one buffer.
+ * A packet which can not be sent (e.g. full socket buffer with dontwait) is dropped and
+ * the following packets are still sent, like separate calls to udp_socket_send_dontwait would do.
+ * @param[in] sock  pointer to UdpSocket struct
+ * @param[in] iov   the buffers of all packets (packets * iov_per_packet entries)
+ * @param[in] iov_per_packet amount of buffers per packet
+ * @param[in] packets  amount of packets
+ * @param[in] dontwait if TRUE do not block when the socket buffer is full
+ * @return number of packets sent (-1 on error)
+ */
+int udp_socket_send_batch(struct UdpSocket *sock, struct iovec *iov, uint8_t iov_per_packet, uint16_t packets,
+                          bool dontwait)
+{
+  if (sock == NULL) {
+    return -1;
+  }
+
+  struct mmsghdr msgs[UDP_SOCKET_SEND_BATCH];
+  int flags = dontwait ? MSG_DONTWAIT : 0;
+  int sent = 0;
+  uint16_t idx = 0;
+
+  while (idx < packets) {
+    // Prepare the next batch of messages
+    uint16_t cnt = Min(packets - idx, UDP_SOCKET_SEND_BATCH);
+    memset(msgs, 0, sizeof(struct mmsghdr) * cnt);
+    for (uint16_t i = 0; i < cnt; i++) {
+      msgs[i].msg_hdr.msg_name = &sock->addr_out;
+      msgs[i].msg_hdr.msg_namelen = sizeof(sock->addr_out);
+      msgs[i].msg_hdr.msg_iov = &iov[(idx + i) * iov_per_packet];
+      msgs[i].msg_hdr.msg_iovlen = iov_per_packet;
+    }
+
+    int ret = sendmmsg(sock->sockfd, msgs, cnt, flags);
+    if (ret < 0 && errno == ENOSYS) {
+      // Kernel without sendmmsg, send one by one
+      ret = 0;
+      while (ret < cnt && sendmsg(sock->sockfd, &msgs[ret].msg_hdr, flags) >= 0) {
+        ret++;
+      }
+    }
+
+    if (ret < 0) {
+      TRACE(TRACE_ERROR, "error sending to sock (%s)\n", strerror(errno));
+      ret = 0;
+    }
+    sent += ret;
+
+    // Skip the packet which failed
+    idx += (ret < cnt) ? ret + 1 : cnt;
+  }
+  return sent;
+}
+
 /**
  * Receive a UDP packet, dont wait.
  * Sets the MSG_DONTWAIT flag, returns 0 if no data is available.
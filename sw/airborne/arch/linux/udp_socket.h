@@ -29,8 +29,14 @@
 #define UDP_SOCKET_H
 
 #include <netinet/in.h>
+#include <sys/uio.h>
 #include "std.h"
 
+/** Maximum number of packets submitted by a single sendmmsg call */
+#ifndef UDP_SOCKET_SEND_BATCH
+#define UDP_SOCKET_SEND_BATCH 32
+#endif
+
 struct UdpSocket {
   int sockfd;
   struct sockaddr_in addr_in;
@@ -66,6 +72,18 @@ extern int udp_socket_send(struct UdpSocket *sock, uint8_t *buffer, uint32_t len
  */
 extern int udp_socket_send_dontwait(struct UdpSocket *sock, uint8_t *buffer, uint32_t len);
 
+/**
+ * Send multiple packets with one system call, each gathered from iov_per_packet buffers.
+ * @param[in] sock  pointer to UdpSocket struct
+ * @param[in] iov   the buffers of all packets (packets * iov_per_packet entries)
+ * @param[in] iov_per_packet amount of buffers per packet
+ * @param[in] packets  amount of packets
+ * @param[in] dontwait if TRUE do not block when the socket buffer is full
+ * @return number of packets sent (-1 on error)
+ */
+extern int udp_socket_send_batch(struct UdpSocket *sock, struct iovec *iov, uint8_t iov_per_packet, uint16_t packets,
+                                 bool dontwait);
+
 /**
  * Receive a UDP packet, dont wait.
  * @param[in] sock  pointer to UdpSocket struct
@@ -36,6 +36,7 @@
 #include <libopencm3/cm3/nvic.h>
 
 #include "std.h"
+#include <string.h>
 
 #include BOARD_CONFIG
 
@@ -133,6 +134,38 @@ void uart_put_byte(struct uart_periph *p, long fd __attribute__((unused)), uint8
 
 }
 
+void uart_put_buffer(struct uart_periph *p, long fd __attribute__((unused)), const uint8_t *data, uint16_t len)
+{
+  // free room in the queue, the interrupt can only make it larger
+  int16_t space = p->tx_extract_idx - p->tx_insert_idx;
+  if (space <= 0) {
+    space += UART_TX_BUFFER_SIZE;
+  }
+  if (len > space - 1) {
+    len = space - 1;  // no room for the end of the buffer
+  }
+  if (len == 0) {
+    return;
+  }
+
+  // copy after the bytes being sent, in two blocks if it wraps around
+  uint16_t first = Min(len, UART_TX_BUFFER_SIZE - p->tx_insert_idx);
+  memcpy(&p->tx_buf[p->tx_insert_idx], data, first);
+  memcpy(p->tx_buf, &data[first], len - first);
+
+  USART_CR1((uint32_t)p->reg_addr) &= ~USART_CR1_TXEIE; // Disable TX interrupt
+
+  p->tx_insert_idx = (p->tx_insert_idx + len) % UART_TX_BUFFER_SIZE;
+  if (!p->tx_running) {
+    // start sending with the first byte, the next ones are sent by the interrupt
+    p->tx_running = true;
+    usart_send((uint32_t)p->reg_addr, p->tx_buf[p->tx_extract_idx]);
+    p->tx_extract_idx = (p->tx_extract_idx + 1) % UART_TX_BUFFER_SIZE;
+  }
+
+  USART_CR1((uint32_t)p->reg_addr) |= USART_CR1_TXEIE; // Enable TX interrupt
+}
+
 static inline void usart_isr(struct uart_periph *p)
 {
 
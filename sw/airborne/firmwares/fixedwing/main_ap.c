@@ -231,27 +231,32 @@ void handle_periodic_tasks_ap(void)
 
   if (sys_time_check_and_ack_timer(sensors_tid)) {
     sensors_task();
+    sys_time_timer_done(sensors_tid);
   }
 
 #if USE_BARO_BOARD
   if (sys_time_check_and_ack_timer(baro_tid)) {
     baro_periodic();
+    sys_time_timer_done(baro_tid);
   }
 #endif
 
 #if USE_GENERATED_AUTOPILOT
   if (sys_time_check_and_ack_timer(attitude_tid)) {
     autopilot_periodic();
+    sys_time_timer_done(attitude_tid);
   }
 #else
   // static autopilot
   if (sys_time_check_and_ack_timer(navigation_tid)) {
     navigation_task();
+    sys_time_timer_done(navigation_tid);
   }
 
 #ifndef AHRS_TRIGGERED_ATTITUDE_LOOP
   if (sys_time_check_and_ack_timer(attitude_tid)) {
     attitude_loop();
+    sys_time_timer_done(attitude_tid);
   }
 #endif
 
@@ -259,15 +264,18 @@ void handle_periodic_tasks_ap(void)
 
   if (sys_time_check_and_ack_timer(modules_tid)) {
     modules_periodic_task();
+    sys_time_timer_done(modules_tid);
   }
 
   if (sys_time_check_and_ack_timer(monitor_tid)) {
     monitor_task();
+    sys_time_timer_done(monitor_tid);
   }
 
   if (sys_time_check_and_ack_timer(telemetry_tid)) {
     reporting_task();
     LED_PERIODIC();
+    sys_time_timer_done(telemetry_tid);
   }
 
 }
@@ -375,6 +383,11 @@ void event_task_ap(void)
   mcu_event();
 #endif /* SINGLE_MCU */
 
+#if ABI_USE_QUEUE
+  /* deliver the ABI messages queued by other threads */
+  AbiQueueEvent();
+#endif
+
 #if USE_BARO_BOARD
   BaroEvent();
 #endif
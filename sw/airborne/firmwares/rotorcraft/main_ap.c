@@ -210,28 +210,36 @@ void handle_periodic_tasks(void)
      * This is mainly useful for logging each step.
      */
     modules_periodic_task();
+    sys_time_timer_done(main_periodic_tid);
 #else
+    sys_time_timer_done(main_periodic_tid);
   }
   /* separate timer for modules, since it has a different freq than main */
   if (sys_time_check_and_ack_timer(modules_tid)) {
     modules_periodic_task();
+    sys_time_timer_done(modules_tid);
 #endif
   }
   if (sys_time_check_and_ack_timer(radio_control_tid)) {
     radio_control_periodic_task();
+    sys_time_timer_done(radio_control_tid);
   }
   if (sys_time_check_and_ack_timer(failsafe_tid)) {
     failsafe_check();
+    sys_time_timer_done(failsafe_tid);
   }
   if (sys_time_check_and_ack_timer(electrical_tid)) {
     electrical_periodic();
+    sys_time_timer_done(electrical_tid);
   }
   if (sys_time_check_and_ack_timer(telemetry_tid)) {
     telemetry_periodic();
+    sys_time_timer_done(telemetry_tid);
   }
 #if USE_BARO_BOARD
   if (sys_time_check_and_ack_timer(baro_tid)) {
     baro_periodic();
+    sys_time_timer_done(baro_tid);
   }
 #endif
 }
@@ -335,6 +343,11 @@ void main_event(void)
   /* event functions for mcu peripherals: i2c, usb_serial.. */
   mcu_event();
 
+#if ABI_USE_QUEUE
+  /* deliver the ABI messages queued by other threads */
+  AbiQueueEvent();
+#endif
+
   if (autopilot.use_rc) {
     RadioControlEvent(autopilot_on_rc_frame);
   }
@@ -45,6 +45,13 @@
 #include "wls/wls_alloc.h"
 #include <stdio.h>
 
+#if INDI_NUM_ACT > WLS_N_U
+#error "INDI_NUM_ACT is larger than WLS_N_U, the maximum number of controls of the allocation"
+#endif
+#if INDI_OUTPUTS > WLS_N_V
+#error "INDI_OUTPUTS is larger than WLS_N_V, the maximum number of control objectives of the allocation"
+#endif
+
 // Factor that the estimated G matrix is allowed to deviate from initial one
 #define INDI_ALLOWED_G_FACTOR 2.0
 
@@ -54,6 +61,10 @@ float du_pref[INDI_NUM_ACT];
 float indi_v[INDI_OUTPUTS];
 float *Bwls[INDI_OUTPUTS];
 int num_iter = 0;
+#if !STABILIZATION_INDI_ALLOCATION_PSEUDO_INVERSE
+// working set of the previous cycle, to warm start the allocation
+static float wls_working_set[INDI_NUM_ACT];
+#endif
 
 static void lms_estimation(void);
 static void get_actuator_state(void);
@@ -421,7 +432,8 @@ static void stabilization_indi_calc_cmd(struct Int32Quat *att_err, bool rate_con
 
   // WLS Control Allocator
   num_iter =
-    wls_alloc(indi_du, indi_v, du_min, du_max, Bwls, INDI_NUM_ACT, INDI_OUTPUTS, 0, 0, Wv, 0, du_pref, 10000, 10);
+    wls_alloc(indi_du, indi_v, du_min, du_max, Bwls, INDI_NUM_ACT, INDI_OUTPUTS, 0, wls_working_set, Wv, 0, du_pref,
+              10000, 10);
 #endif
 
   // Add the increments to the actuators
@@ -440,6 +452,9 @@ static void stabilization_indi_calc_cmd(struct Int32Quat *att_err, bool rate_con
   if (!in_flight) {
     float_vect_zero(indi_u, INDI_NUM_ACT);
     float_vect_zero(indi_du, INDI_NUM_ACT);
+#if !STABILIZATION_INDI_ALLOCATION_PSEUDO_INVERSE
+    float_vect_zero(wls_working_set, INDI_NUM_ACT);
+#endif
   }
 
   // Propagate actuator filters
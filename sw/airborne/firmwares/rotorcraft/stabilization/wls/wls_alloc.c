@@ -46,7 +46,6 @@
 #include "math/qr_solve/r8lib_min.h"
 
 void print_final_values(int n_u, int n_v, float* u, float** B, float* v, float* umin, float* umax);
-void print_in_and_outputs(int n_c, int n_free, float** A_free_ptr, float* d, float* p_free);
 
 // provide loop feedback
 #define WLS_VERBOSE FALSE
@@ -73,6 +72,102 @@ void qr_solve_wrapper(int m, int n, float** A, float* b, float* x) {
   qr_solve(m, n, in, b, x);
 }
 
+/**
+ * @brief Apply a Givens rotation to rows i and i+1 of R and columns i and i+1 of Q
+ *
+ * The rotation zeroes R[i+1][col] with R[i][col], the columns of R before col
+ * are zero in both rows and are not touched.
+ *
+ * @param n_c number of rows of Q and R
+ * @param n_free number of columns of R
+ */
+static void qr_givens(int n_c, int n_free, float Q[WLS_N_C][WLS_N_C], float R[WLS_N_C][WLS_N_U], int i, int col)
+{
+  float r = hypotf(R[i][col], R[i + 1][col]);
+  if (r < FLT_MIN) {
+    return;
+  }
+  float c = R[i][col] / r;
+  float s = R[i + 1][col] / r;
+  for (int j = col; j < n_free; j++) {
+    float r1 = R[i][j];
+    float r2 = R[i + 1][j];
+    R[i][j] = c * r1 + s * r2;
+    R[i + 1][j] = -s * r1 + c * r2;
+  }
+  R[i + 1][col] = 0;
+  for (int k = 0; k < n_c; k++) {
+    float q1 = Q[k][i];
+    float q2 = Q[k][i + 1];
+    Q[k][i] = c * q1 + s * q2;
+    Q[k][i + 1] = -s * q1 + c * q2;
+  }
+}
+
+/**
+ * @brief Add column col of A as last column of the factorization A_free = Q*R
+ *
+ * @param n_c number of rows of A
+ * @param n_free number of columns of R before adding the column
+ */
+static void qr_add_column(int n_c, int n_free, float Q[WLS_N_C][WLS_N_C], float R[WLS_N_C][WLS_N_U],
+                          float A[WLS_N_C][WLS_N_U], int col)
+{
+  // new column of R is Q'*a
+  for (int i = 0; i < n_c; i++) {
+    R[i][n_free] = 0;
+    for (int k = 0; k < n_c; k++) {
+      R[i][n_free] += Q[k][i] * A[k][col];
+    }
+  }
+  // make it upper triangular again from the bottom up
+  for (int i = n_c - 2; i >= n_free; i--) {
+    qr_givens(n_c, n_free + 1, Q, R, i, n_free);
+  }
+}
+
+/**
+ * @brief Remove column k of the factorization A_free = Q*R
+ *
+ * @param n_c number of rows of A
+ * @param n_free number of columns of R before removing the column
+ */
+static void qr_remove_column(int n_c, int n_free, float Q[WLS_N_C][WLS_N_C], float R[WLS_N_C][WLS_N_U], int k)
+{
+  for (int i = 0; i < n_c; i++) {
+    for (int j = k; j < n_free - 1; j++) {
+      R[i][j] = R[i][j + 1];
+    }
+  }
+  // R is now upper Hessenberg from column k, zero the subdiagonal
+  for (int j = k; j < n_free - 1; j++) {
+    qr_givens(n_c, n_free - 1, Q, R, j, j);
+  }
+}
+
+/**
+ * @brief Least squares solution of A_free*x = d with the factorization A_free = Q*R
+ *
+ * @param n_c number of rows of A_free
+ * @param n_free number of columns of A_free
+ */
+static void qr_solve_factorized(int n_c, int n_free, float Q[WLS_N_C][WLS_N_C], float R[WLS_N_C][WLS_N_U],
+                                float *d, float *x)
+{
+  for (int i = 0; i < n_free; i++) {
+    x[i] = 0;
+    for (int k = 0; k < n_c; k++) {
+      x[i] += Q[k][i] * d[k];
+    }
+  }
+  for (int i = n_free - 1; i >= 0; i--) {
+    for (int j = i + 1; j < n_free; j++) {
+      x[i] -= R[i][j] * x[j];
+    }
+    x[i] /= R[i][i];
+  }
+}
+
 /**
  * @brief active set algorithm for control allocation
  *
@@ -80,15 +175,20 @@ void qr_solve_wrapper(int m, int n, float** A, float* b, float* x) {
  * the inputs that will satisfy most of the control objective, subject to the
  * weighting matrices Wv and Wu
  *
+ * The QR factorization of the free columns is updated with Givens rotations
+ * when the working set changes instead of being computed again at every
+ * iteration, and all buffers have the fixed size WLS_N_U x WLS_N_V.
+ *
  * @param u The control output vector
  * @param v The control objective
  * @param umin The minimum u vector
  * @param umax The maximum u vector
  * @param B The control effectiveness matrix
- * @param n_u Length of u
- * @param n_v Lenght of v
+ * @param n_u Length of u (at most WLS_N_U)
+ * @param n_v Lenght of v (at most WLS_N_V)
  * @param u_guess Initial value for u
- * @param W_init Initial working set, if known
+ * @param W_init Initial working set, if known. The final working set is
+ * written back, so passing the same array every cycle warm starts the solver
  * @param Wv Weighting on different control objectives
  * @param Wu Weighting on different controls
  * @param up Preferred control vector
@@ -104,33 +204,27 @@ int wls_alloc(float* u, float* v, float* umin, float* umax, float** B,
   // allocate variables, use defaults where parameters are set to 0
   if(!gamma_sq) gamma_sq = 100000;
   if(!imax) imax = 100;
+  if (n_u > WLS_N_U || n_v > WLS_N_V) return -1;
   int n_c = n_u + n_v;
 
-  float A[n_c][n_u];
-  float A_free[n_c][n_u];
-
-  // Create a pointer array to the rows of A_free
-  // such that we can pass it to a function
-  float * A_free_ptr[n_c];
-  for(int i = 0; i < n_c; i++)
-    A_free_ptr[i] = A_free[i];
+  float A[WLS_N_C][WLS_N_U];
+  float Q[WLS_N_C][WLS_N_C];
+  float R[WLS_N_C][WLS_N_U];
 
-  float b[n_c];
-  float d[n_c];
+  float b[WLS_N_C];
+  float d[WLS_N_C];
 
-  int free_index[n_u];
-  int free_index_lookup[n_u];
+  // free variables, in the order of the columns of R
+  int free_index[WLS_N_U];
   int n_free = 0;
-  int free_chk = -1;
 
   int iter = 0;
-  float p_free[n_u];
-  float p[n_u];
-  float u_opt[n_u];
-  int infeasible_index[n_u] UNUSED;
+  float p_free[WLS_N_U];
+  float p[WLS_N_U];
+  float u_opt[WLS_N_U];
   int n_infeasible = 0;
-  float lambda[n_u];
-  float W[n_u];
+  float lambda[WLS_N_U];
+  float W[WLS_N_U];
 
   // Initialize u and the working set, if provided from input
   if (!u_guess) {
@@ -145,18 +239,16 @@ int wls_alloc(float* u, float* v, float* umin, float* umax, float** B,
   W_init ? memcpy(W, W_init, n_u * sizeof(float))
     : memset(W, 0, n_u * sizeof(float));
 
-  memset(free_index_lookup, -1, n_u * sizeof(float));
-
-
-  // find free indices
+  // find free indices, the others start at their limit
   for (int i = 0; i < n_u; i++) {
     if (W[i] == 0) {
-      free_index_lookup[i] = n_free;
       free_index[n_free++] = i;
+    } else {
+      u[i] = (W[i] > 0) ? umax[i] : umin[i];
     }
   }
 
-  // fill up A, A_free, b and d
+  // fill up A, b and d
   for (int i = 0; i < n_v; i++) {
     // If Wv is a NULL pointer, use Wv = identity
     b[i] = Wv ? gamma_sq * Wv[i] * v[i] : gamma_sq * v[i];
@@ -170,38 +262,31 @@ int wls_alloc(float* u, float* v, float* umin, float* umax, float** B,
   for (int i = n_v; i < n_c; i++) {
     memset(A[i], 0, n_u * sizeof(float));
     A[i][i - n_v] = Wu ? Wu[i - n_v] : 1.0;
-    b[i] = up ? (Wu ? Wu[i] * up[i] : up[i]) : 0;
+    b[i] = up ? (Wu ? Wu[i - n_v] * up[i - n_v] : up[i - n_v]) : 0;
     d[i] = b[i] - A[i][i - n_v] * u[i - n_v];
   }
 
+  // QR factorization of the free columns of A
+  for (int i = 0; i < n_c; i++) {
+    for (int j = 0; j < n_c; j++) {
+      Q[i][j] = (i == j) ? 1.0 : 0.0;
+    }
+  }
+  for (int j = 0; j < n_free; j++) {
+    qr_add_column(n_c, j, Q, R, A, free_index[j]);
+  }
+
   // -------------- Start loop ------------
   while (iter++ < imax) {
     // clear p, copy u to u_opt
     memset(p, 0, n_u * sizeof(float));
     memcpy(u_opt, u, n_u * sizeof(float));
 
-    // Construct a matrix with the free columns of A
-    if (free_chk != n_free) {
-      for (int i = 0; i < n_c; i++) {
-        for (int j = 0; j < n_free; j++) {
-          A_free[i][j] = A[i][free_index[j]];
-        }
-      }
-      free_chk = n_free;
-    }
-
-
     if (n_free) {
       // Still free variables left, calculate corresponding solution
 
-      // use a solver to find the solution to A_free*p_free = d
-      qr_solve_wrapper(n_c, n_free, A_free_ptr, d, p_free);
-
-      //print results current step
-#if WLS_VERBOSE
-      print_in_and_outputs(n_c, n_free, A_free_ptr, d, p_free);
-#endif
-
+      // use the factorization to find the solution to A_free*p_free = d
+      qr_solve_factorized(n_c, n_free, Q, R, d, p_free);
     }
 
     // Set the nonzero values of p and add to u_opt
@@ -213,7 +298,7 @@ int wls_alloc(float* u, float* v, float* umin, float* umax, float** B,
     n_infeasible = 0;
     for (int i = 0; i < n_u; i++) {
       if (u_opt[i] >= (umax[i] + 1.0) || u_opt[i] <= (umin[i] - 1.0)) {
-        infeasible_index[n_infeasible++] = i;
+        n_infeasible++;
       }
     }
 
@@ -223,10 +308,10 @@ int wls_alloc(float* u, float* v, float* umin, float* umax, float** B,
       memcpy(u, u_opt, n_u * sizeof(float));
       memset(lambda, 0, n_u * sizeof(float));
 
-      // d = d + A_free*p_free; lambda = A*d;
+      // d = d - A*p; lambda = A'*d;
       for (int i = 0; i < n_c; i++) {
-        for (int k = 0; k < n_free; k++) {
-          d[i] -= A_free[i][k] * p_free[k];
+        for (int k = 0; k < n_u; k++) {
+          d[i] -= A[i][k] * p[k];
         }
         for (int k = 0; k < n_u; k++) {
           lambda[k] += A[i][k] * d[i];
@@ -242,18 +327,19 @@ int wls_alloc(float* u, float* v, float* umin, float* umax, float** B,
           break_flag = false;
           W[i] = 0;
           // add a free index
-          if (free_index_lookup[i] < 0) {
-            free_index_lookup[i] = n_free;
-            free_index[n_free++] = i;
-          }
+          qr_add_column(n_c, n_free, Q, R, A, i);
+          free_index[n_free++] = i;
         }
       }
       if (break_flag) {
 
 #if WLS_VERBOSE
-        print_final_values(1, n_u, n_v, u, B, v, umin, umax);
+        print_final_values(n_u, n_v, u, B, v, umin, umax);
 #endif
 
+        if (W_init) {
+          memcpy(W_init, W, n_u * sizeof(float));
+        }
         // if solution is found, return number of iterations
         return iter;
       }
@@ -273,7 +359,7 @@ int wls_alloc(float* u, float* v, float* umin, float* umax, float** B,
         }
         if (alpha_tmp < alpha) {
           alpha = alpha_tmp;
-          id_alpha = id;
+          id_alpha = i;
         }
       }
 
@@ -281,50 +367,31 @@ int wls_alloc(float* u, float* v, float* umin, float* umax, float** B,
       for (int i = 0; i < n_u; i++) {
         u[i] += alpha * p[i];
       }
-      // update d = d-alpha*A*p_free
+      // update d = d-alpha*A*p
       for (int i = 0; i < n_c; i++) {
-        for (int k = 0; k < n_free; k++) {
-          d[i] -= A_free[i][k] * alpha * p_free[k];
+        for (int k = 0; k < n_u; k++) {
+          d[i] -= A[i][k] * alpha * p[k];
         }
       }
       // get rid of a free index
-      W[id_alpha] = (p[id_alpha] > 0) ? 1.0 : -1.0;
+      int id = free_index[id_alpha];
+      W[id] = (p[id] > 0) ? 1.0 : -1.0;
 
-      free_index[free_index_lookup[id_alpha]] = free_index[--n_free];
-      free_index_lookup[free_index[free_index_lookup[id_alpha]]] =
-        free_index_lookup[id_alpha];
-      free_index_lookup[id_alpha] = -1;
+      qr_remove_column(n_c, n_free, Q, R, id_alpha);
+      for (int i = id_alpha; i < n_free - 1; i++) {
+        free_index[i] = free_index[i + 1];
+      }
+      n_free--;
     }
   }
+  if (W_init) {
+    memcpy(W_init, W, n_u * sizeof(float));
+  }
   // solution failed, return negative one to indicate failure
   return -1;
 }
 
 #if WLS_VERBOSE
-void print_in_and_outputs(int n_c, int n_free, float** A_free_ptr, float* d, float* p_free) {
-
-  printf("n_c = %d n_free = %d\n", n_c, n_free);
-
-  printf("A_free =\n");
-  for(int i = 0; i < n_c; i++) {
-    for (int j = 0; j < n_free; j++) {
-      printf("%f ", A_free_ptr[i][j]);
-    }
-    printf("\n");
-  }
-
-  printf("d = ");
-  for (int j = 0; j < n_c; j++) {
-    printf("%f ", d[j]);
-  }
-
-  printf("\noutput = ");
-  for (int j = 0; j < n_free; j++) {
-    printf("%f ", p_free[j]);
-  }
-  printf("\n\n");
-}
-
 void print_final_values(int n_u, int n_v, float* u, float** B, float* v, float* umin, float* umax) {
   printf("n_u = %d n_v = %d\n", n_u, n_v);
 
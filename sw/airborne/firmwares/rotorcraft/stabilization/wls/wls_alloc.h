@@ -20,6 +20,23 @@
  * Boston, MA 02111-1307, USA.
  */
 
+#ifndef WLS_ALLOC_H
+#define WLS_ALLOC_H
+
+/**
+ * Maximum number of controls and control objectives.
+ * The solver buffers have a fixed size, sized for a hexacopter by default.
+ */
+#ifndef WLS_N_U
+#define WLS_N_U 6
+#endif
+
+#ifndef WLS_N_V
+#define WLS_N_V 4
+#endif
+
+#define WLS_N_C (WLS_N_U + WLS_N_V)
+
 /**
  * @brief Wrapper for qr solve
  *
@@ -43,10 +60,11 @@ void qr_solve_wrapper(int m, int n, float** A, float* b, float* x);
  * @param umin The minimum u vector
  * @param umax The maximum u vector
  * @param B The control effectiveness matrix
- * @param n_u Length of u
- * @param n_v Lenght of v
+ * @param n_u Length of u (at most WLS_N_U)
+ * @param n_v Lenght of v (at most WLS_N_V)
  * @param u_guess Initial value for u
- * @param W_init Initial working set, if known
+ * @param W_init Initial working set, if known. The final working set is
+ * written back, so passing the same array every cycle warm starts the solver
  * @param Wv Weighting on different control objectives
  * @param Wu Weighting on different controls
  * @param up Preferred control vector
@@ -59,3 +77,5 @@ void qr_solve_wrapper(int m, int n, float** A, float* b, float* x);
 int wls_alloc(float* u, float* v, float* umin, float* umax, float** B,
               int n_u, int n_w, float* u_guess, float* W_init, float* Wv,
               float* Wu, float* ud, float gamma, int imax);
+
+#endif /* WLS_ALLOC_H */
@@ -25,6 +25,7 @@
  */
 
 #include "pprz_algebra_float.h"
+#include "pprz_approx_float.h"
 
 /** in place first order integration of a 3D-vector */
 void float_vect3_integrate_fi(struct FloatVect3 *vec, struct FloatVect3 *dv, float dt)
@@ -193,12 +194,10 @@ void float_rmat_of_axis_angle(struct FloatRMat *rm, struct FloatVect3 *uv, float
 /* C n->b rotation matrix */
 void float_rmat_of_eulers_321(struct FloatRMat *rm, struct FloatEulers *e)
 {
-  const float sphi   = sinf(e->phi);
-  const float cphi   = cosf(e->phi);
-  const float stheta = sinf(e->theta);
-  const float ctheta = cosf(e->theta);
-  const float spsi   = sinf(e->psi);
-  const float cpsi   = cosf(e->psi);
+  float sphi, cphi, stheta, ctheta, spsi, cpsi;
+  pprz_sincosf(e->phi, &sphi, &cphi);
+  pprz_sincosf(e->theta, &stheta, &ctheta);
+  pprz_sincosf(e->psi, &spsi, &cpsi);
 
   RMAT_ELMT(*rm, 0, 0) = ctheta * cpsi;
   RMAT_ELMT(*rm, 0, 1) = ctheta * spsi;
@@ -213,12 +212,10 @@ void float_rmat_of_eulers_321(struct FloatRMat *rm, struct FloatEulers *e)
 
 void float_rmat_of_eulers_312(struct FloatRMat *rm, struct FloatEulers *e)
 {
-  const float sphi   = sinf(e->phi);
-  const float cphi   = cosf(e->phi);
-  const float stheta = sinf(e->theta);
-  const float ctheta = cosf(e->theta);
-  const float spsi   = sinf(e->psi);
-  const float cpsi   = cosf(e->psi);
+  float sphi, cphi, stheta, ctheta, spsi, cpsi;
+  pprz_sincosf(e->phi, &sphi, &cphi);
+  pprz_sincosf(e->theta, &stheta, &ctheta);
+  pprz_sincosf(e->psi, &spsi, &cpsi);
 
   RMAT_ELMT(*rm, 0, 0) =  ctheta * cpsi - sphi * stheta * spsi;
   RMAT_ELMT(*rm, 0, 1) =  ctheta * spsi + sphi * stheta * cpsi;
@@ -418,6 +415,36 @@ void float_quat_integrate(struct FloatQuat *q, struct FloatRates *omega, float d
   }
 }
 
+void float_quat_slerp(struct FloatQuat *qo, struct FloatQuat *q1, struct FloatQuat *q2, float t)
+{
+  float cos_theta = q1->qi * q2->qi + q1->qx * q2->qx + q1->qy * q2->qy + q1->qz * q2->qz;
+  // q and -q are the same rotation, take the shortest path
+  float sign = 1.f;
+  if (cos_theta < 0.f) {
+    cos_theta = -cos_theta;
+    sign = -1.f;
+  }
+
+  float w1, w2;
+  if (cos_theta > 0.9995f) {
+    // almost the same rotation, use a linear interpolation to avoid dividing by sin(theta) ~ 0
+    w1 = 1.f - t;
+    w2 = t;
+  } else {
+    const float theta = acosf(cos_theta);
+    const float sin_theta = sinf(theta);
+    w1 = sinf((1.f - t) * theta) / sin_theta;
+    w2 = sinf(t * theta) / sin_theta;
+  }
+  w2 *= sign;
+
+  qo->qi = w1 * q1->qi + w2 * q2->qi;
+  qo->qx = w1 * q1->qx + w2 * q2->qx;
+  qo->qy = w1 * q1->qy + w2 * q2->qy;
+  qo->qz = w1 * q1->qz + w2 * q2->qz;
+  float_quat_normalize(qo);
+}
+
 void float_quat_vmult(struct FloatVect3 *v_out, struct FloatQuat *q, const struct FloatVect3 *v_in)
 {
   const float qi2_M1_2  = q->qi * q->qi - 0.5;
@@ -481,12 +508,10 @@ void float_quat_of_eulers(struct FloatQuat *q, struct FloatEulers *e)
   const float theta2 = e->theta / 2.0;
   const float psi2   = e->psi / 2.0;
 
-  const float s_phi2   = sinf(phi2);
-  const float c_phi2   = cosf(phi2);
-  const float s_theta2 = sinf(theta2);
-  const float c_theta2 = cosf(theta2);
-  const float s_psi2   = sinf(psi2);
-  const float c_psi2   = cosf(psi2);
+  float s_phi2, c_phi2, s_theta2, c_theta2, s_psi2, c_psi2;
+  pprz_sincosf(phi2, &s_phi2, &c_phi2);
+  pprz_sincosf(theta2, &s_theta2, &c_theta2);
+  pprz_sincosf(psi2, &s_psi2, &c_psi2);
 
   q->qi =  c_phi2 * c_theta2 * c_psi2 + s_phi2 * s_theta2 * s_psi2;
   q->qx = -c_phi2 * s_theta2 * s_psi2 + s_phi2 * c_theta2 * c_psi2;
@@ -507,12 +532,10 @@ void float_quat_of_eulers_zxy(struct FloatQuat *q, struct FloatEulers *e)
   const float theta2 = e->theta / 2.0;
   const float psi2   = e->psi / 2.0;
 
-  const float s_phi2   = sinf(phi2);
-  const float c_phi2   = cosf(phi2);
-  const float s_theta2 = sinf(theta2);
-  const float c_theta2 = cosf(theta2);
-  const float s_psi2   = sinf(psi2);
-  const float c_psi2   = cosf(psi2);
+  float s_phi2, c_phi2, s_theta2, c_theta2, s_psi2, c_psi2;
+  pprz_sincosf(phi2, &s_phi2, &c_phi2);
+  pprz_sincosf(theta2, &s_theta2, &c_theta2);
+  pprz_sincosf(psi2, &s_psi2, &c_psi2);
 
   q->qi =  c_phi2 * c_theta2 * c_psi2 - s_phi2 * s_theta2 * s_psi2;
   q->qx =  s_phi2 * c_theta2 * c_psi2 - c_phi2 * s_theta2 * s_psi2;
@@ -605,9 +628,9 @@ void float_eulers_of_rmat(struct FloatEulers *e, struct FloatRMat *rm)
   const float dcm02 = rm->m[2];
   const float dcm12 = rm->m[5];
   const float dcm22 = rm->m[8];
-  e->phi   = atan2f(dcm12, dcm22);
-  e->theta = -asinf(dcm02);
-  e->psi   = atan2f(dcm01, dcm00);
+  e->phi   = pprz_atan2f(dcm12, dcm22);
+  e->theta = -pprz_asinf(dcm02);
+  e->psi   = pprz_atan2f(dcm01, dcm00);
 }
 
 /**
@@ -633,9 +656,9 @@ void float_eulers_of_quat(struct FloatEulers *e, struct FloatQuat *q)
   const float dcm12 =       2.*(qyqz + qiqx);
   const float dcm22 = 1.0 - 2.*(qx2 +  qy2);
 
-  e->phi = atan2f(dcm12, dcm22);
-  e->theta = -asinf(dcm02);
-  e->psi = atan2f(dcm01, dcm00);
+  e->phi = pprz_atan2f(dcm12, dcm22);
+  e->theta = -pprz_asinf(dcm02);
+  e->psi = pprz_atan2f(dcm01, dcm00);
 }
 
 /**
@@ -663,9 +686,9 @@ void float_eulers_of_quat_zxy(struct FloatEulers *e, struct FloatQuat *q)
   const float r31  = -2 * (qxqz - qiqy);
   const float r32  = qi2 - qx2 - qy2 + qz2;
 
-  e->psi = atan2f(r11, r12);
-  e->phi = asinf(r21);
-  e->theta = atan2f(r31, r32);
+  e->psi = pprz_atan2f(r11, r12);
+  e->phi = pprz_asinf(r21);
+  e->theta = pprz_atan2f(r31, r32);
 }
 
 /**
@@ -448,6 +448,11 @@ extern void float_quat_integrate(struct FloatQuat *q, struct FloatRates *omega,
  */
 extern void float_quat_vmult(struct FloatVect3 *v_out, struct FloatQuat *q, const struct FloatVect3 *v_in);
 
+/** Spherical linear interpolation between two quaternions along the shortest path.
+ * qo = q1 for t = 0 and qo = q2 (or its explementary) for t = 1
+ */
+extern void float_quat_slerp(struct FloatQuat *qo, struct FloatQuat *q1, struct FloatQuat *q2, float t);
+
 /// Quaternion from Euler angles.
 extern void float_quat_of_eulers(struct FloatQuat *q, struct FloatEulers *e);
 extern void float_quat_of_eulers_zxy(struct FloatQuat *q, struct FloatEulers *e);
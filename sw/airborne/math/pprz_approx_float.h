@@ -0,0 +1,297 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file pprz_approx_float.h
+ * @brief Paparazzi fast approximations of the float trig and sqrt functions.
+ *
+ * Minimax polynomials evaluated in single precision only (no double promotion,
+ * no table, no libm call), so they map to a few multiply-accumulate of the FPU.
+ * Every function comes in two accuracy tiers, with the maximum absolute error
+ * measured by tests/math/test_pprz_approx_float.c:
+ *
+ * | function                    | precise | fast   |
+ * |-----------------------------|---------|--------|
+ * | sin, cos (|x| < 8192 rad)   | 2e-7    | 2e-5   |
+ * | atan2 (rad)                 | 4e-7    | 4e-5   |
+ * | asin (rad)                  | 3e-7    | 8e-5   |
+ * | sqrt, invsqrt (relative)    | 2e-7    | 5e-6   |
+ *
+ * The pprz_sinf(), pprz_cosf(), pprz_sincosf(), pprz_atan2f(), pprz_asinf()
+ * and pprz_sqrtf() macros are used by the attitude conversions and filters.
+ * They call libm or one of the tiers depending on PPRZ_MATH_APPROX, which can
+ * be set per airframe in the firmware section, e.g.
+ * @code{.xml}
+ * <define name="PPRZ_MATH_APPROX" value="PPRZ_MATH_APPROX_FAST"/>
+ * @endcode
+ */
+
+#ifndef PPRZ_APPROX_FLOAT_H
+#define PPRZ_APPROX_FLOAT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "std.h"
+#include <math.h>
+
+/** Accuracy tiers for PPRZ_MATH_APPROX */
+#define PPRZ_MATH_LIBM 0
+#define PPRZ_MATH_APPROX_PRECISE 1
+#define PPRZ_MATH_APPROX_FAST 2
+
+/** Default is libm */
+#ifndef PPRZ_MATH_APPROX
+#define PPRZ_MATH_APPROX PPRZ_MATH_LIBM
+#endif
+
+#define FLOAT_APPROX_INLINE static inline __attribute__((always_inline))
+
+/* pi/2 in three parts for the range reduction, n * hi is exact for |n| < 2^14 */
+#define FLOAT_APPROX_PIO2_HI 1.5703125f
+#define FLOAT_APPROX_PIO2_MI 4.837512969970703125e-4f
+#define FLOAT_APPROX_PIO2_LO 7.54978995489188216e-8f
+
+/** Sine and cosine of x
+ *
+ * x is reduced to r in [-pi/4, pi/4], where the sine is r * P(r^2) and the
+ * cosine is Q(r^2), and the quadrant gives the signs.
+ */
+FLOAT_APPROX_INLINE void float_approx_sincos_tier(float x, float *s, float *c, const bool fast)
+{
+  const int32_t n = (int32_t)(x * (float)M_2_PI + ((x >= 0.f) ? 0.5f : -0.5f));
+  const float r = ((x - n * FLOAT_APPROX_PIO2_HI) - n * FLOAT_APPROX_PIO2_MI) - n * FLOAT_APPROX_PIO2_LO;
+  const float r2 = r * r;
+  float ps, pc;
+  if (fast) {
+    ps = r + r * r2 * (-1.666345853e-01f + r2 * 8.164608744e-03f);
+    pc = 1.f + r2 * (-4.997763071e-01f + r2 * 4.048893584e-02f);
+  } else {
+    ps = r + r * r2 * (-1.666665494e-01f + r2 * (8.332178146e-03f + r2 * -1.951729898e-04f));
+    pc = 1.f + r2 * (-4.999989478e-01f + r2 * (4.165629458e-02f + r2 * -1.359782311e-03f));
+  }
+  // select and sign by quadrant without branches
+  const float sr = (n & 1) ? pc : ps;
+  const float cr = (n & 1) ? ps : pc;
+  *s = (n & 2) ? -sr : sr;
+  *c = ((n + 1) & 2) ? -cr : cr;
+}
+
+/** Arc tangent of y/x in [-pi, pi]
+ *
+ * atan(t) = t * P(t^2) on t = min / max of |x| and |y| in [0, 1],
+ * then the octant gives the angle. Returns 0 for x = y = 0.
+ */
+FLOAT_APPROX_INLINE float float_approx_atan2_tier(float y, float x, const bool fast)
+{
+  const float ax = fabsf(x);
+  const float ay = fabsf(y);
+  const float mx = (ay > ax) ? ay : ax;
+  const float mn = (ay > ax) ? ax : ay;
+  if (mx == 0.f) {
+    return 0.f;
+  }
+  const float t = mn / mx;
+  const float t2 = t * t;
+  float a;
+  if (fast) {
+    a = t + t * t2 * (-3.322042370e-01f + t2 * (1.872605649e-01f + t2 * (-9.486843429e-02f + t2 * 2.524158437e-02f)));
+  } else {
+    a = t + t * t2 * (-3.333246310e-01f + t2 * (1.997560843e-01f + t2 * (-1.405037630e-01f + t2 * (9.995456652e-02f
+                      + t2 * (-6.060979562e-02f + t2 * (2.503545927e-02f + t2 * -4.909855079e-03f))))));
+  }
+  if (ay > ax) {
+    a = (float)M_PI_2 - a;
+  }
+  if (x < 0.f) {
+    a = (float)M_PI - a;
+  }
+  return (y < 0.f) ? -a : a;
+}
+
+/** Inverse square root of x > 0
+ *
+ * Initial guess from the float representation, refined by Newton iterations.
+ */
+FLOAT_APPROX_INLINE float float_approx_invsqrt_tier(float x, const bool fast)
+{
+  union {
+    float f;
+    uint32_t i;
+  } u = { .f = x };
+  u.i = 0x5f375a86 - (u.i >> 1);
+  float y = u.f;
+  const float hx = 0.5f * x;
+  y = y * (1.5f - hx * y * y);
+  y = y * (1.5f - hx * y * y);
+  if (!fast) {
+    y = y * (1.5f - hx * y * y);
+  }
+  return y;
+}
+
+/** Square root of x >= 0 with the FPU instruction, without the errno handling of libm */
+static inline float float_approx_sqrt(float x)
+{
+#if defined(__ARM_FP) && (__ARM_FP & 4) && !defined(__aarch64__)
+  float r;
+  __asm__("vsqrt.f32 %0, %1" : "=t"(r) : "t"(x));
+  return r;
+#else
+  return __builtin_sqrtf(x);
+#endif
+}
+
+/** Square root of x >= 0, x * 1/sqrt(x) so it is 0 for x = 0 */
+static inline float float_approx_sqrt_fast(float x)
+{
+  return x * float_approx_invsqrt_tier(x, true);
+}
+
+static inline float float_approx_invsqrt(float x)
+{
+  return float_approx_invsqrt_tier(x, false);
+}
+
+static inline float float_approx_invsqrt_fast(float x)
+{
+  return float_approx_invsqrt_tier(x, true);
+}
+
+/** Arc sine of x, with x clamped to [-1, 1]
+ *
+ * asin(|x|) = pi/2 - sqrt(1 - |x|) * P(|x|)
+ * (Abramowitz and Stegun 4.4.46 for the precise tier, 4.4.45 for the fast one).
+ */
+FLOAT_APPROX_INLINE float float_approx_asin_tier(float x, const bool fast)
+{
+  const float ax = (fabsf(x) < 1.f) ? fabsf(x) : 1.f;
+  float p, a;
+  if (fast) {
+    p = 1.5707288f + ax * (-0.2121144f + ax * (0.0742610f + ax * -0.0187293f));
+    a = (float)M_PI_2 - float_approx_sqrt_fast(1.f - ax) * p;
+  } else {
+    p = 1.5707963050f + ax * (-0.2145988016f + ax * (0.0889789874f + ax * (-0.0501743046f + ax * (0.0308918810f
+                              + ax * (-0.0170881256f + ax * (0.0066700901f + ax * -0.0012624911f))))));
+    a = (float)M_PI_2 - float_approx_sqrt(1.f - ax) * p;
+  }
+  return (x < 0.f) ? -a : a;
+}
+
+static inline void float_approx_sincos(float x, float *s, float *c)
+{
+  float_approx_sincos_tier(x, s, c, false);
+}
+
+static inline void float_approx_sincos_fast(float x, float *s, float *c)
+{
+  float_approx_sincos_tier(x, s, c, true);
+}
+
+static inline float float_approx_sin(float x)
+{
+  float s, c;
+  float_approx_sincos_tier(x, &s, &c, false);
+  return s;
+}
+
+static inline float float_approx_sin_fast(float x)
+{
+  float s, c;
+  float_approx_sincos_tier(x, &s, &c, true);
+  return s;
+}
+
+static inline float float_approx_cos(float x)
+{
+  float s, c;
+  float_approx_sincos_tier(x, &s, &c, false);
+  return c;
+}
+
+static inline float float_approx_cos_fast(float x)
+{
+  float s, c;
+  float_approx_sincos_tier(x, &s, &c, true);
+  return c;
+}
+
+static inline float float_approx_atan2(float y, float x)
+{
+  return float_approx_atan2_tier(y, x, false);
+}
+
+static inline float float_approx_atan2_fast(float y, float x)
+{
+  return float_approx_atan2_tier(y, x, true);
+}
+
+static inline float float_approx_asin(float x)
+{
+  return float_approx_asin_tier(x, false);
+}
+
+static inline float float_approx_asin_fast(float x)
+{
+  return float_approx_asin_tier(x, true);
+}
+
+/** Sine and cosine with libm */
+static inline void float_libm_sincos(float x, float *s, float *c)
+{
+  *s = sinf(x);
+  *c = cosf(x);
+}
+
+/*
+ * Functions selected by PPRZ_MATH_APPROX
+ */
+
+#if PPRZ_MATH_APPROX == PPRZ_MATH_LIBM
+#define pprz_sinf(_x) sinf(_x)
+#define pprz_cosf(_x) cosf(_x)
+#define pprz_sincosf(_x, _s, _c) float_libm_sincos(_x, _s, _c)
+#define pprz_atan2f(_y, _x) atan2f(_y, _x)
+#define pprz_asinf(_x) asinf(_x)
+#define pprz_sqrtf(_x) sqrtf(_x)
+#elif PPRZ_MATH_APPROX == PPRZ_MATH_APPROX_PRECISE
+#define pprz_sinf(_x) float_approx_sin(_x)
+#define pprz_cosf(_x) float_approx_cos(_x)
+#define pprz_sincosf(_x, _s, _c) float_approx_sincos(_x, _s, _c)
+#define pprz_atan2f(_y, _x) float_approx_atan2(_y, _x)
+#define pprz_asinf(_x) float_approx_asin(_x)
+#define pprz_sqrtf(_x) float_approx_sqrt(_x)
+#elif PPRZ_MATH_APPROX == PPRZ_MATH_APPROX_FAST
+#define pprz_sinf(_x) float_approx_sin_fast(_x)
+#define pprz_cosf(_x) float_approx_cos_fast(_x)
+#define pprz_sincosf(_x, _s, _c) float_approx_sincos_fast(_x, _s, _c)
+#define pprz_atan2f(_y, _x) float_approx_atan2_fast(_y, _x)
+#define pprz_asinf(_x) float_approx_asin_fast(_x)
+#define pprz_sqrtf(_x) float_approx_sqrt_fast(_x)
+#else
+#error "Unknown PPRZ_MATH_APPROX, use PPRZ_MATH_LIBM, PPRZ_MATH_APPROX_PRECISE or PPRZ_MATH_APPROX_FAST"
+#endif
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* PPRZ_APPROX_FLOAT_H */
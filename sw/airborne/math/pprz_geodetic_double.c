@@ -28,6 +28,7 @@
 #include "pprz_geodetic_double.h"
 
 #include <math.h>
+#include <string.h>
 #include "std.h" /* for RadOfDeg */
 
 
@@ -117,7 +118,8 @@ void lla_of_ecef_d(struct LlaCoor_d *lla, struct EcefCoor_d *ecef)
 
 }
 
-void ecef_of_lla_d(struct EcefCoor_d *ecef, struct LlaCoor_d *lla)
+/** ECEF of one point, shared by the single point and the array versions */
+static inline void ecef_of_lla_point_d(double *x, double *y, double *z, double lat, double lon, double alt)
 {
 
   // FIXME : make an ellipsoid struct
@@ -125,16 +127,44 @@ void ecef_of_lla_d(struct EcefCoor_d *ecef, struct LlaCoor_d *lla)
   static const double f = 1. / 298.257223563;  /* reciprocal flattening          */
   const double e2 = 2.*f - (f * f);            /* first eccentricity squared     */
 
-  const double sin_lat = sin(lla->lat);
-  const double cos_lat = cos(lla->lat);
-  const double sin_lon = sin(lla->lon);
-  const double cos_lon = cos(lla->lon);
+  const double sin_lat = sin(lat);
+  const double cos_lat = cos(lat);
+  const double sin_lon = sin(lon);
+  const double cos_lon = cos(lon);
   const double chi = sqrt(1. - e2 * sin_lat * sin_lat);
   const double a_chi = a / chi;
 
-  ecef->x = (a_chi + lla->alt) * cos_lat * cos_lon;
-  ecef->y = (a_chi + lla->alt) * cos_lat * sin_lon;
-  ecef->z = (a_chi * (1. - e2) + lla->alt) * sin_lat;
+  *x = (a_chi + alt) * cos_lat * cos_lon;
+  *y = (a_chi + alt) * cos_lat * sin_lon;
+  *z = (a_chi * (1. - e2) + alt) * sin_lat;
+}
+
+void ecef_of_lla_d(struct EcefCoor_d *ecef, struct LlaCoor_d *lla)
+{
+  ecef_of_lla_point_d(&ecef->x, &ecef->y, &ecef->z, lla->lat, lla->lon, lla->alt);
+}
+
+/** Loop of ecef_of_lla_d_array, vectorized by the compiler when a vector math library is available */
+static inline void ecef_of_lla_d_soa(double *restrict x, double *restrict y, double *restrict z,
+                                      const double *restrict lat, const double *restrict lon,
+                                      const double *restrict alt, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++) {
+    ecef_of_lla_point_d(&x[i], &y[i], &z[i], lat[i], lon[i], alt[i]);
+  }
+}
+
+/**
+ * Convert arrays of LLA points to ECEF.
+ * The components are separate arrays (structure of arrays), so the loop
+ * can be vectorized by the compiler.
+ * @param[out] ecef arrays of n points in m
+ * @param[in]  lla  arrays of n points in rad, alt in m
+ * @param[in]  n    number of points
+ */
+void ecef_of_lla_d_array(struct EcefCoorArray_d *ecef, struct LlaCoorArray_d *lla, uint32_t n)
+{
+  ecef_of_lla_d_soa(ecef->x, ecef->y, ecef->z, lla->lat, lla->lon, lla->alt, n);
 }
 
 void enu_of_ecef_point_d(struct EnuCoor_d *enu, struct LtpDef_d *def, struct EcefCoor_d *ecef)
@@ -144,6 +174,36 @@ void enu_of_ecef_point_d(struct EnuCoor_d *enu, struct LtpDef_d *def, struct Ece
   MAT33_VECT3_MUL(*enu, def->ltp_of_ecef, delta);
 }
 
+/** Loop of enu_of_ecef_point_d_array, the restrict arrays let the compiler vectorize it */
+static inline void enu_of_ecef_point_d_soa(double *restrict ex, double *restrict ey, double *restrict ez,
+    const double *restrict x, const double *restrict y, const double *restrict z, const struct LtpDef_d *def,
+    uint32_t n)
+{
+  const double *m = def->ltp_of_ecef.m;
+  const double ox = def->ecef.x, oy = def->ecef.y, oz = def->ecef.z;
+  for (uint32_t i = 0; i < n; i++) {
+    const double dx = x[i] - ox;
+    const double dy = y[i] - oy;
+    const double dz = z[i] - oz;
+    ex[i] = m[0] * dx + m[1] * dy + m[2] * dz;
+    ey[i] = m[3] * dx + m[4] * dy + m[5] * dz;
+    ez[i] = m[6] * dx + m[7] * dy + m[8] * dz;
+  }
+}
+
+/**
+ * Convert arrays of ECEF points to local ENU.
+ * @param[out] enu  arrays of n points in m
+ * @param[in]  def  local coordinate system definition
+ * @param[in]  ecef arrays of n points in m
+ * @param[in]  n    number of points
+ */
+void enu_of_ecef_point_d_array(struct EnuCoorArray_d *enu, struct LtpDef_d *def, struct EcefCoorArray_d *ecef,
+                               uint32_t n)
+{
+  enu_of_ecef_point_d_soa(enu->x, enu->y, enu->z, ecef->x, ecef->y, ecef->z, def, n);
+}
+
 void ned_of_ecef_point_d(struct NedCoor_d *ned, struct LtpDef_d *def, struct EcefCoor_d *ecef)
 {
   struct EnuCoor_d enu;
@@ -269,20 +329,13 @@ static inline double inverse_isometric_latitude_d(double lat, double e, double e
     CI(v);              \
   }
 
-/* Convert lla to utm (double).
- * @param[out] utm position in m, alt is copied directly from lla
- * @param[in]  lla position in rad, alt in m
+/* UTM of one point for the zone of central meridian lambda_c,
+ * shared by the single point and the array versions.
  */
-void utm_of_lla_d(struct UtmCoor_d *utm, struct LlaCoor_d *lla)
+static inline void utm_of_lla_point_d(double *north, double *east, double lat, double lon, double lambda_c)
 {
-  // compute zone if not initialised
-  if (utm->zone == 0) {
-    utm->zone = UtmZoneOfLlaLonRad(lla->lon);
-  }
-
-  double lambda_c = LambdaOfUtmZone(utm->zone);
-  double ll = isometric_latitude_d(lla->lat , E);
-  double dl = lla->lon - lambda_c;
+  double ll = isometric_latitude_d(lat , E);
+  double dl = lon - lambda_c;
   double phi_ = asin(sin(dl) / cosh(ll));
   double ll_ = isometric_latitude_fast_d(phi_);
   double lambda_ = atan(sinh(ll) / cos(dl));
@@ -297,13 +350,57 @@ void utm_of_lla_d(struct UtmCoor_d *utm, struct LlaCoor_d *lla)
     VECT2_ADD(z_, z);
   }
   VECT2_SMUL(z_, z_, N);
-  utm->east = DELTA_EAST + z_.y;
-  utm->north = DELTA_NORTH + z_.x;
+  *east = DELTA_EAST + z_.y;
+  *north = DELTA_NORTH + z_.x;
+}
+
+/* Convert lla to utm (double).
+ * @param[out] utm position in m, alt is copied directly from lla
+ * @param[in]  lla position in rad, alt in m
+ */
+void utm_of_lla_d(struct UtmCoor_d *utm, struct LlaCoor_d *lla)
+{
+  // compute zone if not initialised
+  if (utm->zone == 0) {
+    utm->zone = UtmZoneOfLlaLonRad(lla->lon);
+  }
+
+  utm_of_lla_point_d(&utm->north, &utm->east, lla->lat, lla->lon, LambdaOfUtmZone(utm->zone));
 
   // copy alt above reference ellipsoid
   utm->alt = lla->alt;
 }
 
+/* Loop of utm_of_lla_d_array, vectorized by the compiler when a vector math library is available */
+static inline void utm_of_lla_d_soa(double *restrict north, double *restrict east, const double *restrict lat,
+                                     const double *restrict lon, double lambda_c, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++) {
+    utm_of_lla_point_d(&north[i], &east[i], lat[i], lon[i], lambda_c);
+  }
+}
+
+/* Convert arrays of lla to utm (double), all points in the same zone.
+ * @param[out] utm arrays of n points in m, alt is copied directly from lla,
+ *                 the zone of the first point is used if not initialised
+ * @param[in]  lla arrays of n points in rad, alt in m
+ * @param[in]  n   number of points
+ */
+void utm_of_lla_d_array(struct UtmCoorArray_d *utm, struct LlaCoorArray_d *lla, uint32_t n)
+{
+  if (n == 0) {
+    return;
+  }
+  // compute zone if not initialised
+  if (utm->zone == 0) {
+    utm->zone = UtmZoneOfLlaLonRad(lla->lon[0]);
+  }
+
+  utm_of_lla_d_soa(utm->north, utm->east, lla->lat, lla->lon, LambdaOfUtmZone(utm->zone), n);
+  // copy alt above reference ellipsoid
+  memcpy(utm->alt, lla->alt, n * sizeof(double));
+}
+
 /* Convert utm to lla (double).
  * @param[out] lla position in rad, alt is copied directly from utm
  * @param[in]  utm position in m, alt in m
@@ -101,6 +101,44 @@ struct LtpDef_d {
   double hmsl; ///< height in meters above mean sea level
 };
 
+/**
+ * @brief arrays of points in EarthCenteredEarthFixed coordinates
+ * @details Structure of arrays for the batch conversions, one array per component.
+ * Units: meters */
+struct EcefCoorArray_d {
+  double *x; ///< in meters
+  double *y; ///< in meters
+  double *z; ///< in meters
+};
+
+/**
+ * @brief arrays of points in East North Up coordinates
+ * Units: meters */
+struct EnuCoorArray_d {
+  double *x; ///< in meters
+  double *y; ///< in meters
+  double *z; ///< in meters
+};
+
+/**
+ * @brief arrays of points in Latitude, Longitude and Altitude
+ */
+struct LlaCoorArray_d {
+  double *lat; ///< in radians
+  double *lon; ///< in radians
+  double *alt; ///< in meters above WGS84 reference ellipsoid
+};
+
+/**
+ * @brief arrays of points in UTM coordinates, all in the same zone
+ * Units: meters */
+struct UtmCoorArray_d {
+  double *north; ///< in meters
+  double *east; ///< in meters
+  double *alt; ///< in meters (above WGS84 reference ellipsoid or above MSL)
+  uint8_t zone; ///< UTM zone number
+};
+
 extern void lla_of_utm_d(struct LlaCoor_d *lla, struct UtmCoor_d *utm);
 extern void utm_of_lla_d(struct UtmCoor_d *utm, struct LlaCoor_d *lla);
 extern void ltp_def_from_ecef_d(struct LtpDef_d *def, struct EcefCoor_d *ecef);
@@ -123,6 +161,12 @@ extern void ecef_of_ned_vect_d(struct EcefCoor_d *ecef, struct LtpDef_d *def, st
 extern void enu_of_lla_point_d(struct EnuCoor_d *enu, struct LtpDef_d *def, struct LlaCoor_d *lla);
 extern void ned_of_lla_point_d(struct NedCoor_d *ned, struct LtpDef_d *def, struct LlaCoor_d *lla);
 
+/* batch conversions of n points, same results as the single point functions */
+extern void ecef_of_lla_d_array(struct EcefCoorArray_d *ecef, struct LlaCoorArray_d *lla, uint32_t n);
+extern void enu_of_ecef_point_d_array(struct EnuCoorArray_d *enu, struct LtpDef_d *def, struct EcefCoorArray_d *ecef,
+                                      uint32_t n);
+extern void utm_of_lla_d_array(struct UtmCoorArray_d *utm, struct LlaCoorArray_d *lla, uint32_t n);
+
 extern double gc_of_gd_lat_d(double gd_lat, double hmsl);
 
 #ifdef __cplusplus
@@ -29,6 +29,7 @@
 
 #include "pprz_algebra_float.h"
 #include <math.h>
+#include <string.h>
 
 /* for ecef_of_XX functions the double versions are needed */
 #include "pprz_geodetic_double.h"
@@ -123,6 +124,35 @@ void ned_of_lla_point_f(struct NedCoor_f *ned, struct LtpDef_f *def, struct LlaC
   ned_of_ecef_point_f(ned, def, &ecef);
 }
 
+/** Loop of enu_of_ecef_point_f_array, the restrict arrays let the compiler vectorize it */
+static inline void enu_of_ecef_point_f_soa(float *restrict ex, float *restrict ey, float *restrict ez,
+    const float *restrict x, const float *restrict y, const float *restrict z, const struct LtpDef_f *def, uint32_t n)
+{
+  const float *m = def->ltp_of_ecef.m;
+  const float ox = def->ecef.x, oy = def->ecef.y, oz = def->ecef.z;
+  for (uint32_t i = 0; i < n; i++) {
+    const float dx = x[i] - ox;
+    const float dy = y[i] - oy;
+    const float dz = z[i] - oz;
+    ex[i] = m[0] * dx + m[1] * dy + m[2] * dz;
+    ey[i] = m[3] * dx + m[4] * dy + m[5] * dz;
+    ez[i] = m[6] * dx + m[7] * dy + m[8] * dz;
+  }
+}
+
+/**
+ * Convert arrays of ECEF points to local ENU.
+ * @param[out] enu  arrays of n points in m
+ * @param[in]  def  local coordinate system definition
+ * @param[in]  ecef arrays of n points in m
+ * @param[in]  n    number of points
+ */
+void enu_of_ecef_point_f_array(struct EnuCoorArray_f *enu, struct LtpDef_f *def, struct EcefCoorArray_f *ecef,
+                               uint32_t n)
+{
+  enu_of_ecef_point_f_soa(enu->x, enu->y, enu->z, ecef->x, ecef->y, ecef->z, def, n);
+}
+
 /*
  * not enough precision with float - use double
  */
@@ -238,7 +268,8 @@ void lla_of_ecef_f(struct LlaCoor_f *out, struct EcefCoor_f *in)
 
 }
 
-void ecef_of_lla_f(struct EcefCoor_f *out, struct LlaCoor_f *in)
+/** ECEF of one point, shared by the single point and the array versions */
+static inline void ecef_of_lla_point_f(float *x, float *y, float *z, float lat, float lon, float alt)
 {
 
   // FIXME : make an ellipsoid struct
@@ -246,16 +277,44 @@ void ecef_of_lla_f(struct EcefCoor_f *out, struct LlaCoor_f *in)
   static const float f = 1. / 298.257223563;  /* reciprocal flattening          */
   const float e2 = 2.*f - (f * f);            /* first eccentricity squared     */
 
-  const float sin_lat = sinf(in->lat);
-  const float cos_lat = cosf(in->lat);
-  const float sin_lon = sinf(in->lon);
-  const float cos_lon = cosf(in->lon);
+  const float sin_lat = sinf(lat);
+  const float cos_lat = cosf(lat);
+  const float sin_lon = sinf(lon);
+  const float cos_lon = cosf(lon);
   const float chi = sqrtf(1. - e2 * sin_lat * sin_lat);
   const float a_chi = a / chi;
 
-  out->x = (a_chi + in->alt) * cos_lat * cos_lon;
-  out->y = (a_chi + in->alt) * cos_lat * sin_lon;
-  out->z = (a_chi * (1. - e2) + in->alt) * sin_lat;
+  *x = (a_chi + alt) * cos_lat * cos_lon;
+  *y = (a_chi + alt) * cos_lat * sin_lon;
+  *z = (a_chi * (1. - e2) + alt) * sin_lat;
+}
+
+void ecef_of_lla_f(struct EcefCoor_f *out, struct LlaCoor_f *in)
+{
+  ecef_of_lla_point_f(&out->x, &out->y, &out->z, in->lat, in->lon, in->alt);
+}
+
+/** Loop of ecef_of_lla_f_array, vectorized by the compiler when a vector math library is available */
+static inline void ecef_of_lla_f_soa(float *restrict x, float *restrict y, float *restrict z,
+                                      const float *restrict lat, const float *restrict lon, const float *restrict alt,
+                                      uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++) {
+    ecef_of_lla_point_f(&x[i], &y[i], &z[i], lat[i], lon[i], alt[i]);
+  }
+}
+
+/**
+ * Convert arrays of LLA points to ECEF.
+ * The components are separate arrays (structure of arrays), so the loop
+ * can be vectorized by the compiler.
+ * @param[out] ecef arrays of n points in m
+ * @param[in]  lla  arrays of n points in rad, alt in m
+ * @param[in]  n    number of points
+ */
+void ecef_of_lla_f_array(struct EcefCoorArray_f *ecef, struct LlaCoorArray_f *lla, uint32_t n)
+{
+  ecef_of_lla_f_soa(ecef->x, ecef->y, ecef->z, lla->lat, lla->lon, lla->alt, n);
 }
 
 
@@ -300,21 +359,13 @@ static inline float inverse_isometric_latitude_f(float lat, float e, float epsil
   return phi0;
 }
 
-/* Convert lla to utm (float).
- * Note this conversion is not very accurate. If high accuracy needed use lla_of_utm_d.
- * @param[out] utm position in m, alt is copied directly from lla
- * @param[in]  lla position in rad, alt in m
+/* UTM of one point for the zone of central meridian lambda_c,
+ * shared by the single point and the array versions.
  */
-void utm_of_lla_f(struct UtmCoor_f *utm, struct LlaCoor_f *lla)
+static inline void utm_of_lla_point_f(float *north, float *east, float lat, float lon, float lambda_c)
 {
-  // compute zone if not initialised
-  if (utm->zone == 0) {
-    utm->zone = UtmZoneOfLlaLonRad(lla->lon);
-  }
-
-  float lambda_c = LambdaOfUtmZone(utm->zone);
-  float ll = isometric_latitude_f(lla->lat , E);
-  float dl = lla->lon - lambda_c;
+  float ll = isometric_latitude_f(lat , E);
+  float dl = lon - lambda_c;
   float phi_ = asinf(sinf(dl) / coshf(ll));
   float ll_ = isometric_latitude_fast_f(phi_);
   float lambda_ = atanf(sinhf(ll) / cosf(dl));
@@ -329,13 +380,58 @@ void utm_of_lla_f(struct UtmCoor_f *utm, struct LlaCoor_f *lla)
     CAdd(z, z_);
   }
   CScal(N, z_);
-  utm->east = DELTA_EAST + z_.im;
-  utm->north = DELTA_NORTH + z_.re;
+  *east = DELTA_EAST + z_.im;
+  *north = DELTA_NORTH + z_.re;
+}
+
+/* Convert lla to utm (float).
+ * Note this conversion is not very accurate. If high accuracy needed use lla_of_utm_d.
+ * @param[out] utm position in m, alt is copied directly from lla
+ * @param[in]  lla position in rad, alt in m
+ */
+void utm_of_lla_f(struct UtmCoor_f *utm, struct LlaCoor_f *lla)
+{
+  // compute zone if not initialised
+  if (utm->zone == 0) {
+    utm->zone = UtmZoneOfLlaLonRad(lla->lon);
+  }
+
+  utm_of_lla_point_f(&utm->north, &utm->east, lla->lat, lla->lon, LambdaOfUtmZone(utm->zone));
 
   // copy alt above reference ellipsoid
   utm->alt = lla->alt;
 }
 
+/* Loop of utm_of_lla_f_array, vectorized by the compiler when a vector math library is available */
+static inline void utm_of_lla_f_soa(float *restrict north, float *restrict east, const float *restrict lat,
+                                     const float *restrict lon, float lambda_c, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++) {
+    utm_of_lla_point_f(&north[i], &east[i], lat[i], lon[i], lambda_c);
+  }
+}
+
+/* Convert arrays of lla to utm (float), all points in the same zone.
+ * @param[out] utm arrays of n points in m, alt is copied directly from lla,
+ *                 the zone of the first point is used if not initialised
+ * @param[in]  lla arrays of n points in rad, alt in m
+ * @param[in]  n   number of points
+ */
+void utm_of_lla_f_array(struct UtmCoorArray_f *utm, struct LlaCoorArray_f *lla, uint32_t n)
+{
+  if (n == 0) {
+    return;
+  }
+  // compute zone if not initialised
+  if (utm->zone == 0) {
+    utm->zone = UtmZoneOfLlaLonRad(lla->lon[0]);
+  }
+
+  utm_of_lla_f_soa(utm->north, utm->east, lla->lat, lla->lon, LambdaOfUtmZone(utm->zone), n);
+  // copy alt above reference ellipsoid
+  memcpy(utm->alt, lla->alt, n * sizeof(float));
+}
+
 /* Convert utm to lla (float).
  * Note this conversion is not very accurate. If high accuracy needed use lla_of_utm_d.
  * @param[out] lla position in rad, alt is copied directly from utm
@@ -97,6 +97,44 @@ struct LtpDef_f {
   float hmsl; ///< Height above mean sea level in meters
 };
 
+/**
+ * @brief arrays of points in EarthCenteredEarthFixed coordinates
+ * @details Structure of arrays for the batch conversions, one array per component.
+ * Units: meters */
+struct EcefCoorArray_f {
+  float *x; ///< in meters
+  float *y; ///< in meters
+  float *z; ///< in meters
+};
+
+/**
+ * @brief arrays of points in East North Up coordinates
+ * Units: meters */
+struct EnuCoorArray_f {
+  float *x; ///< in meters
+  float *y; ///< in meters
+  float *z; ///< in meters
+};
+
+/**
+ * @brief arrays of points in Latitude, Longitude and Altitude
+ */
+struct LlaCoorArray_f {
+  float *lat; ///< in radians
+  float *lon; ///< in radians
+  float *alt; ///< in meters (normally above WGS84 reference ellipsoid)
+};
+
+/**
+ * @brief arrays of points in UTM coordinates, all in the same zone
+ * Units: meters */
+struct UtmCoorArray_f {
+  float *north; ///< in meters
+  float *east; ///< in meters
+  float *alt; ///< in meters (above WGS84 reference ellipsoid or above MSL)
+  uint8_t zone; ///< UTM zone number
+};
+
 extern void lla_of_utm_f(struct LlaCoor_f *lla, struct UtmCoor_f *utm);
 extern void utm_of_lla_f(struct UtmCoor_f *utm, struct LlaCoor_f *lla);
 extern void ltp_def_from_ecef_f(struct LtpDef_f *def, struct EcefCoor_f *ecef);
@@ -110,6 +148,12 @@ extern void ned_of_ecef_vect_f(struct NedCoor_f *ned, struct LtpDef_f *def, stru
 extern void enu_of_lla_point_f(struct EnuCoor_f *enu, struct LtpDef_f *def, struct LlaCoor_f *lla);
 extern void ned_of_lla_point_f(struct NedCoor_f *ned, struct LtpDef_f *def, struct LlaCoor_f *lla);
 
+/* batch conversions of n points, same results as the single point functions */
+extern void ecef_of_lla_f_array(struct EcefCoorArray_f *ecef, struct LlaCoorArray_f *lla, uint32_t n);
+extern void enu_of_ecef_point_f_array(struct EnuCoorArray_f *enu, struct LtpDef_f *def, struct EcefCoorArray_f *ecef,
+                                      uint32_t n);
+extern void utm_of_lla_f_array(struct UtmCoorArray_f *utm, struct LlaCoorArray_f *lla, uint32_t n);
+
 /*  not enough precision with floats - used the double version */
 extern void ecef_of_enu_point_f(struct EcefCoor_f *ecef, struct LtpDef_f *def, struct EnuCoor_f *enu);
 extern void ecef_of_ned_point_f(struct EcefCoor_f *ecef, struct LtpDef_f *def, struct NedCoor_f *ned);
@@ -107,6 +107,37 @@ void enu_of_ecef_point_i(struct EnuCoor_i *enu, struct LtpDef_i *def, struct Ece
 
 }
 
+/** Loop of enu_of_ecef_point_i_array, vectorized by the compiler on targets with widening vector multiplies */
+static inline void enu_of_ecef_point_i_soa(int32_t *restrict ex, int32_t *restrict ey, int32_t *restrict ez,
+    const int32_t *restrict x, const int32_t *restrict y, const int32_t *restrict z, const struct LtpDef_i *def,
+    uint32_t n)
+{
+  const int32_t *m = def->ltp_of_ecef.m;
+  const int32_t ox = def->ecef.x, oy = def->ecef.y, oz = def->ecef.z;
+  for (uint32_t i = 0; i < n; i++) {
+    const int32_t dx = x[i] - ox;
+    const int32_t dy = y[i] - oy;
+    const int32_t dz = z[i] - oz;
+    /* m[2] is always zero */
+    ex[i] = (int32_t)(((int64_t)m[0] * dx + (int64_t)m[1] * dy) >> HIGH_RES_TRIG_FRAC);
+    ey[i] = (int32_t)(((int64_t)m[3] * dx + (int64_t)m[4] * dy + (int64_t)m[5] * dz) >> HIGH_RES_TRIG_FRAC);
+    ez[i] = (int32_t)(((int64_t)m[6] * dx + (int64_t)m[7] * dy + (int64_t)m[8] * dz) >> HIGH_RES_TRIG_FRAC);
+  }
+}
+
+/** Convert arrays of points from ECEF to local ENU.
+ * Same computation as enu_of_ecef_point_i, with the components in separate arrays.
+ * @param[out] enu  arrays of n ENU points in cm
+ * @param[in]  def  local coordinate system definition
+ * @param[in]  ecef arrays of n ECEF points in cm
+ * @param[in]  n    number of points
+ */
+void enu_of_ecef_point_i_array(struct EnuCoorArray_i *enu, struct LtpDef_i *def, struct EcefCoorArray_i *ecef,
+                               uint32_t n)
+{
+  enu_of_ecef_point_i_soa(enu->x, enu->y, enu->z, ecef->x, ecef->y, ecef->z, def, n);
+}
+
 
 /** Convert a point from ECEF to local NED.
  * @param[out] ned  NED point in cm
@@ -102,6 +102,25 @@ struct LtpDef_i {
   int32_t hmsl;                  ///< Height above mean sea level in mm
 };
 
+/**
+ * @brief arrays of points in EarthCenteredEarthFixed coordinates
+ * @details Structure of arrays for the batch conversions, one array per component.
+ * Units: centimeters */
+struct EcefCoorArray_i {
+  int32_t *x; ///< in centimeters
+  int32_t *y; ///< in centimeters
+  int32_t *z; ///< in centimeters
+};
+
+/**
+ * @brief arrays of points in East North Up coordinates
+ */
+struct EnuCoorArray_i {
+  int32_t *x;  ///< East
+  int32_t *y;  ///< North
+  int32_t *z;  ///< Up
+};
+
 extern void lla_of_utm_i(struct LlaCoor_i *lla, struct UtmCoor_i *utm);
 extern void utm_of_lla_i(struct UtmCoor_i *utm, struct LlaCoor_i *lla);
 extern void ltp_of_ecef_rmat_from_lla_i(struct Int32RMat *ltp_of_ecef, struct LlaCoor_i *lla);
@@ -110,6 +129,8 @@ extern void ltp_def_from_lla_i(struct LtpDef_i *def, struct LlaCoor_i *lla);
 extern void lla_of_ecef_i(struct LlaCoor_i *out, struct EcefCoor_i *in);
 extern void ecef_of_lla_i(struct EcefCoor_i *out, struct LlaCoor_i *in);
 extern void enu_of_ecef_point_i(struct EnuCoor_i *enu, struct LtpDef_i *def, struct EcefCoor_i *ecef);
+extern void enu_of_ecef_point_i_array(struct EnuCoorArray_i *enu, struct LtpDef_i *def, struct EcefCoorArray_i *ecef,
+                                      uint32_t n);
 extern void ned_of_ecef_point_i(struct NedCoor_i *ned, struct LtpDef_i *def, struct EcefCoor_i *ecef);
 extern void enu_of_ecef_pos_i(struct EnuCoor_i *enu, struct LtpDef_i *def, struct EcefCoor_i *ecef);
 extern void ned_of_ecef_pos_i(struct NedCoor_i *ned, struct LtpDef_i *def, struct EcefCoor_i *ecef);
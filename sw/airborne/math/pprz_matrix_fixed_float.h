@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file pprz_matrix_fixed_float.h
+ * @brief Fixed size matrix kernels in floating point.
+ *
+ * Unlike the generic float_mat_* functions and pprz_matrix_decomp_float, which work
+ * on arrays of row pointers, these kernels work on contiguous row major arrays
+ * (e.g. float P[6][6]) and the outputs must not overlap the inputs.
+ * They are always inlined, so when the dimensions are constants the compiler
+ * unrolls and vectorizes the loops for that size.
+ *
+ * The float_mat3_*, float_mat4_* and float_mat6_* functions are the square
+ * versions defined with #FLOAT_MAT_FIXED_SQUARE, the SVD is only defined for
+ * 3 and 4 columns (#FLOAT_MAT_FIXED_SVD). Above these sizes the kernels are
+ * not reliably faster than the generic functions.
+ * There is no product by a transpose: MAT_MUL_T of pprz_simple_matrix.h is
+ * faster on constant sizes than the kernels that were tried.
+ */
+
+#ifndef PPRZ_MATRIX_FIXED_FLOAT_H
+#define PPRZ_MATRIX_FIXED_FLOAT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "std.h"
+#include <math.h>
+#include <float.h>
+
+#define FLOAT_MAT_FIXED_INLINE static inline __attribute__((always_inline))
+
+/** Maximum number of sweeps of float_mat_fixed_svd */
+#define FLOAT_MAT_FIXED_SVD_SWEEPS 30
+
+/** o = a * b
+ *
+ * a: [m x n]
+ * b: [n x l]
+ * o: [m x l]
+ */
+FLOAT_MAT_FIXED_INLINE void float_mat_fixed_mul(float *__restrict o, const float *__restrict a,
+    const float *__restrict b, const int m, const int n, const int l)
+{
+  for (int i = 0; i < m; i++) {
+    for (int j = 0; j < l; j++) {
+      // local sum, the output is only written once
+      float s = a[i * n] * b[j];
+      for (int k = 1; k < n; k++) {
+        s += a[i * n + k] * b[k * l + j];
+      }
+      o[i * l + j] = s;
+    }
+  }
+}
+
+/** Cholesky decomposition a = o * o'
+ *
+ * Same result as pprz_cholesky_float, o is lower triangular.
+ *
+ * @param o output lower triangular matrix [n x n]
+ * @param a input symmetric matrix [n x n]
+ * @param n dimension of the matrix
+ * @return false if the matrix is not positive definite
+ */
+FLOAT_MAT_FIXED_INLINE bool float_mat_fixed_cholesky(float *__restrict o, const float *__restrict a, const int n)
+{
+  for (int i = 0; i < n * n; i++) {
+    o[i] = 0.f;
+  }
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j <= i; j++) {
+      float s = a[i * n + j];
+      for (int k = 0; k < j; k++) {
+        s -= o[i * n + k] * o[j * n + k];
+      }
+      if (i == j) {
+        if (s <= 0.f) {
+          return false;
+        }
+        o[i * n + i] = sqrtf(s);
+      } else {
+        o[i * n + j] = s / o[j * n + j];
+      }
+    }
+  }
+  return true;
+}
+
+/** Solve (L * L') * x = b with the Cholesky decomposition L of a matrix
+ *
+ * @param x solution [n x l]
+ * @param L lower triangular matrix from float_mat_fixed_cholesky [n x n]
+ * @param b right-hand side [n x l]
+ * @param n dimension of the matrix
+ * @param l number of columns of b
+ */
+FLOAT_MAT_FIXED_INLINE void float_mat_fixed_cholesky_solve(float *__restrict x, const float *__restrict L,
+    const float *__restrict b, const int n, const int l)
+{
+  for (int c = 0; c < l; c++) {
+    // L * y = b
+    for (int i = 0; i < n; i++) {
+      float s = b[i * l + c];
+      for (int k = 0; k < i; k++) {
+        s -= L[i * n + k] * x[k * l + c];
+      }
+      x[i * l + c] = s / L[i * n + i];
+    }
+    // L' * x = y
+    for (int i = n - 1; i >= 0; i--) {
+      float s = x[i * l + c];
+      for (int k = i + 1; k < n; k++) {
+        s -= L[k * n + i] * x[k * l + c];
+      }
+      x[i * l + c] = s / L[i * n + i];
+    }
+  }
+}
+
+/** SVD decomposition a = u * diag(w) * v'
+ *
+ * One-sided Jacobi method, which only needs column rotations and is accurate
+ * for the small matrices it is meant for. It is faster than pprz_svd_float up
+ * to about 4 columns, for more columns the sweeps cost more than the
+ * bidiagonalization of pprz_svd_float.
+ * Same interface as pprz_svd_float: u replaces a, and the output can be used
+ * with pprz_svd_solve_float. The singular values are not sorted.
+ * The number of rows can be a variable, the number of columns should be a constant.
+ *
+ * @param a input matrix [m x n], replaced by u
+ * @param w output singular values [n]
+ * @param v output orthogonal matrix [n x n]
+ * @param m number of rows of a (m >= n)
+ * @param n number of columns of a
+ * @return 0 (false) if convergence failed, 1 (true) if decomposition succeeded
+ */
+FLOAT_MAT_FIXED_INLINE int float_mat_fixed_svd(float *__restrict a, float *__restrict w, float *__restrict v,
+    const int m, const int n)
+{
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      v[i * n + j] = (i == j) ? 1.f : 0.f;
+    }
+  }
+
+  // squared norms of the columns, updated with the rotations
+  for (int j = 0; j < n; j++) {
+    w[j] = 0.f;
+    for (int i = 0; i < m; i++) {
+      w[j] += a[i * n + j] * a[i * n + j];
+    }
+  }
+
+  int converged = 0;
+  for (int sweep = 0; sweep < FLOAT_MAT_FIXED_SVD_SWEEPS && !converged; sweep++) {
+    converged = 1;
+    for (int p = 0; p < n - 1; p++) {
+      for (int q = p + 1; q < n; q++) {
+        float gamma = 0.f;
+        for (int i = 0; i < m; i++) {
+          gamma += a[i * n + p] * a[i * n + q];
+        }
+        if (fabsf(gamma) <= FLT_EPSILON * sqrtf(w[p] * w[q])) {
+          continue;
+        }
+        converged = 0;
+
+        // rotation that makes the columns p and q orthogonal
+        float zeta = (w[q] - w[p]) / (2.f * gamma);
+        float t = copysignf(1.f, zeta) / (fabsf(zeta) + sqrtf(1.f + zeta * zeta));
+        float c = 1.f / sqrtf(1.f + t * t);
+        float s = c * t;
+        w[p] -= t * gamma;
+        w[q] += t * gamma;
+        for (int i = 0; i < m; i++) {
+          float ap = a[i * n + p];
+          float aq = a[i * n + q];
+          a[i * n + p] = c * ap - s * aq;
+          a[i * n + q] = s * ap + c * aq;
+        }
+        for (int i = 0; i < n; i++) {
+          float vp = v[i * n + p];
+          float vq = v[i * n + q];
+          v[i * n + p] = c * vp - s * vq;
+          v[i * n + q] = s * vp + c * vq;
+        }
+      }
+    }
+  }
+
+  // singular values are the norms of the columns
+  for (int j = 0; j < n; j++) {
+    float s = 0.f;
+    for (int i = 0; i < m; i++) {
+      s += a[i * n + j] * a[i * n + j];
+    }
+    w[j] = sqrtf(s);
+    if (w[j] > 0.f) {
+      for (int i = 0; i < m; i++) {
+        a[i * n + j] /= w[j];
+      }
+    }
+  }
+  return converged;
+}
+
+/** Define the square matrix kernels of dimension _n
+ *
+ * float_mat<n>_mul, float_mat<n>_cholesky and float_mat<n>_cholesky_solve (one vector)
+ */
+#define FLOAT_MAT_FIXED_SQUARE(_n)                                                                  \
+  static inline void float_mat##_n##_mul(float o[_n][_n], float a[_n][_n], float b[_n][_n])         \
+  {                                                                                                 \
+    float_mat_fixed_mul(o[0], a[0], b[0], _n, _n, _n);                                              \
+  }                                                                                                 \
+  static inline bool float_mat##_n##_cholesky(float o[_n][_n], float a[_n][_n])                     \
+  {                                                                                                 \
+    return float_mat_fixed_cholesky(o[0], a[0], _n);                                                \
+  }                                                                                                 \
+  static inline void float_mat##_n##_cholesky_solve(float x[_n], float L[_n][_n], float b[_n])      \
+  {                                                                                                 \
+    float_mat_fixed_cholesky_solve(x, L[0], b, _n, 1);                                              \
+  }
+
+/** Define float_mat<n>_svd, only faster than pprz_svd_float for a few columns */
+#define FLOAT_MAT_FIXED_SVD(_n)                                                                     \
+  static inline int float_mat##_n##_svd(float a[_n][_n], float w[_n], float v[_n][_n])              \
+  {                                                                                                 \
+    return float_mat_fixed_svd(a[0], w, v[0], _n, _n);                                              \
+  }
+
+FLOAT_MAT_FIXED_SQUARE(3)
+FLOAT_MAT_FIXED_SQUARE(4)
+FLOAT_MAT_FIXED_SQUARE(6)
+FLOAT_MAT_FIXED_SVD(3)
+FLOAT_MAT_FIXED_SVD(4)
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* PPRZ_MATRIX_FIXED_FLOAT_H */
@@ -38,6 +38,27 @@
  */
 #include "pprz_orientation_conversion.h"
 
+#if ORIENTATION_CONVERSION_STATS
+/** Count one conversion to representation rep, which started at tick start */
+static void orientation_stats_add(struct OrientationReps *orientation, uint8_t rep, uint32_t start)
+{
+  struct OrientationStats *stats = &orientation->stats;
+  stats->conversions[rep]++;
+  stats->ticks += (uint32_t)ORIENTATION_CONVERSION_TICKS - start;
+  if (stats->gen_conversions < UINT8_MAX) {
+    stats->gen_conversions++;
+  }
+  if (stats->gen_conversions > stats->max_gen_conversions) {
+    stats->max_gen_conversions = stats->gen_conversions;
+  }
+}
+
+#define ORIENTATION_STATS_START() uint32_t stats_start = ORIENTATION_CONVERSION_TICKS
+#define ORIENTATION_STATS_ADD(_o, _rep) orientation_stats_add(_o, _rep, stats_start)
+#else
+#define ORIENTATION_STATS_START() {}
+#define ORIENTATION_STATS_ADD(_o, _rep) {}
+#endif
 
 /******************************************************************************
  *                                                                            *
@@ -51,6 +72,7 @@ void orientationCalcQuat_i(struct OrientationReps *orientation)
     return;
   }
 
+  ORIENTATION_STATS_START();
   if (bit_is_set(orientation->status, ORREP_QUAT_F)) {
     QUAT_BFP_OF_REAL(orientation->quat_i, orientation->quat_f);
   } else if (bit_is_set(orientation->status, ORREP_RMAT_I)) {
@@ -68,6 +90,7 @@ void orientationCalcQuat_i(struct OrientationReps *orientation)
   }
   /* set bit to indicate this representation is computed */
   SetBit(orientation->status, ORREP_QUAT_I);
+  ORIENTATION_STATS_ADD(orientation, ORREP_QUAT_I);
 }
 
 void orientationCalcRMat_i(struct OrientationReps *orientation)
@@ -76,6 +99,7 @@ void orientationCalcRMat_i(struct OrientationReps *orientation)
     return;
   }
 
+  ORIENTATION_STATS_START();
   if (bit_is_set(orientation->status, ORREP_RMAT_F)) {
     RMAT_BFP_OF_REAL(orientation->rmat_i, orientation->rmat_f);
   } else if (bit_is_set(orientation->status, ORREP_QUAT_I)) {
@@ -93,6 +117,7 @@ void orientationCalcRMat_i(struct OrientationReps *orientation)
   }
   /* set bit to indicate this representation is computed */
   SetBit(orientation->status, ORREP_RMAT_I);
+  ORIENTATION_STATS_ADD(orientation, ORREP_RMAT_I);
 }
 
 void orientationCalcEulers_i(struct OrientationReps *orientation)
@@ -101,6 +126,7 @@ void orientationCalcEulers_i(struct OrientationReps *orientation)
     return;
   }
 
+  ORIENTATION_STATS_START();
   if (bit_is_set(orientation->status, ORREP_EULER_F)) {
     EULERS_BFP_OF_REAL(orientation->eulers_i, orientation->eulers_f);
   } else if (bit_is_set(orientation->status, ORREP_RMAT_I)) {
@@ -118,6 +144,7 @@ void orientationCalcEulers_i(struct OrientationReps *orientation)
   }
   /* set bit to indicate this representation is computed */
   SetBit(orientation->status, ORREP_EULER_I);
+  ORIENTATION_STATS_ADD(orientation, ORREP_EULER_I);
 }
 
 void orientationCalcQuat_f(struct OrientationReps *orientation)
@@ -126,6 +153,7 @@ void orientationCalcQuat_f(struct OrientationReps *orientation)
     return;
   }
 
+  ORIENTATION_STATS_START();
   if (bit_is_set(orientation->status, ORREP_QUAT_I)) {
     QUAT_FLOAT_OF_BFP(orientation->quat_f, orientation->quat_i);
   } else if (bit_is_set(orientation->status, ORREP_RMAT_F)) {
@@ -143,6 +171,7 @@ void orientationCalcQuat_f(struct OrientationReps *orientation)
   }
   /* set bit to indicate this representation is computed */
   SetBit(orientation->status, ORREP_QUAT_F);
+  ORIENTATION_STATS_ADD(orientation, ORREP_QUAT_F);
 }
 
 void orientationCalcRMat_f(struct OrientationReps *orientation)
@@ -151,6 +180,7 @@ void orientationCalcRMat_f(struct OrientationReps *orientation)
     return;
   }
 
+  ORIENTATION_STATS_START();
   if (bit_is_set(orientation->status, ORREP_RMAT_I)) {
     RMAT_FLOAT_OF_BFP(orientation->rmat_f, orientation->rmat_i);
   } else if (bit_is_set(orientation->status, ORREP_QUAT_F)) {
@@ -168,6 +198,7 @@ void orientationCalcRMat_f(struct OrientationReps *orientation)
   }
   /* set bit to indicate this representation is computed */
   SetBit(orientation->status, ORREP_RMAT_F);
+  ORIENTATION_STATS_ADD(orientation, ORREP_RMAT_F);
 }
 
 void orientationCalcEulers_f(struct OrientationReps *orientation)
@@ -176,6 +207,7 @@ void orientationCalcEulers_f(struct OrientationReps *orientation)
     return;
   }
 
+  ORIENTATION_STATS_START();
   if (bit_is_set(orientation->status, ORREP_EULER_I)) {
     EULERS_FLOAT_OF_BFP(orientation->eulers_f, orientation->eulers_i);
   } else if (bit_is_set(orientation->status, ORREP_RMAT_F)) {
@@ -193,6 +225,69 @@ void orientationCalcEulers_f(struct OrientationReps *orientation)
   }
   /* set bit to indicate this representation is computed */
   SetBit(orientation->status, ORREP_EULER_F);
+  ORIENTATION_STATS_ADD(orientation, ORREP_EULER_F);
+}
+
+/**
+ * Compute several representations at once.
+ *
+ * The representations of the same type as the current ones (float or int) are computed
+ * first, the rotation matrix before the euler angles which are then extracted from it,
+ * so the other type only needs copies.
+ *
+ * @param orientation orientation
+ * @param mask bits of the representations to compute (1 << ORREP_*)
+ */
+void orientationCalcReps(struct OrientationReps *orientation, uint8_t mask)
+{
+  /* only the representations which are not computed yet */
+  mask &= ~orientation->status;
+  if (mask == 0 || orientation->status == 0) {
+    return;
+  }
+
+  const bool float_src = !(orientation->status & ORREP_INT_MASK);
+  if (mask & ((1 << ORREP_RMAT_I) | (1 << ORREP_RMAT_F))) {
+    if (float_src) {
+      orientationCalcRMat_f(orientation);
+    } else {
+      orientationCalcRMat_i(orientation);
+    }
+  }
+  if (mask & ((1 << ORREP_QUAT_I) | (1 << ORREP_QUAT_F))) {
+    if (float_src) {
+      orientationCalcQuat_f(orientation);
+    } else {
+      orientationCalcQuat_i(orientation);
+    }
+  }
+  if (mask & ((1 << ORREP_EULER_I) | (1 << ORREP_EULER_F))) {
+    if (float_src) {
+      orientationCalcEulers_f(orientation);
+    } else {
+      orientationCalcEulers_i(orientation);
+    }
+  }
+
+  /* remaining representations of the other type, copies of the ones above */
+  if (bit_is_set(mask, ORREP_QUAT_I)) {
+    orientationCalcQuat_i(orientation);
+  }
+  if (bit_is_set(mask, ORREP_RMAT_I)) {
+    orientationCalcRMat_i(orientation);
+  }
+  if (bit_is_set(mask, ORREP_EULER_I)) {
+    orientationCalcEulers_i(orientation);
+  }
+  if (bit_is_set(mask, ORREP_QUAT_F)) {
+    orientationCalcQuat_f(orientation);
+  }
+  if (bit_is_set(mask, ORREP_RMAT_F)) {
+    orientationCalcRMat_f(orientation);
+  }
+  if (bit_is_set(mask, ORREP_EULER_F)) {
+    orientationCalcEulers_f(orientation);
+  }
 }
 /** @}*/
 /** @}*/
@@ -45,7 +45,18 @@
  * If the desired representation is not available, it will be calculated.
  *
  * When a setter is used to set a representation, all status bits are cleared, and only the
- * status bit for the set representation is set to one.
+ * status bit for the set representation is set to one. Every setter also starts a new
+ * generation, so a representation is computed at most once per update of the orientation,
+ * however many consumers read it.
+ *
+ * With ORIENTATION_CONVERSION_STATS the number of reads, conversions and updates are counted
+ * for each orientation (see OrientationStats), e.g. for the body attitude in the state:
+ * @code{.xml}
+ * <define name="ORIENTATION_CONVERSION_STATS" value="TRUE"/>
+ * @endcode
+ * The time spent in the conversions is also accumulated when ORIENTATION_CONVERSION_TICKS
+ * is defined to a cycle counter, e.g. (*(volatile uint32_t *)0xE0001004) for the DWT
+ * counter of a Cortex-M3/M4.
  */
 
 /**
@@ -72,6 +83,38 @@ extern "C" {
 #define ORREP_QUAT_F  3  ///< Quaternion (float)
 #define ORREP_EULER_F 4  ///< zyx Euler (float)
 #define ORREP_RMAT_F  5  ///< Rotation Matrix (float)
+#define ORREP_NB      6  ///< Number of representations
+
+#define ORREP_INT_MASK ((1 << ORREP_QUAT_I) | (1 << ORREP_EULER_I) | (1 << ORREP_RMAT_I))
+#define ORREP_ALL_MASK ((1 << ORREP_NB) - 1)
+
+#ifndef ORIENTATION_CONVERSION_STATS
+#define ORIENTATION_CONVERSION_STATS FALSE
+#endif
+
+#if ORIENTATION_CONVERSION_STATS
+#ifndef ORIENTATION_CONVERSION_TICKS
+#define ORIENTATION_CONVERSION_TICKS 0
+#endif
+
+/**
+ * Conversion counters of an orientation.
+ * conversions / sets is the number of conversions per update,
+ * gets - conversions the number of reads served without conversion.
+ */
+struct OrientationStats {
+  uint32_t sets;                      ///< number of updates (generations)
+  uint32_t gets;                      ///< number of reads
+  uint32_t conversions[ORREP_NB];     ///< number of conversions to each representation
+  uint32_t ticks;                     ///< time spent in the conversions, in ORIENTATION_CONVERSION_TICKS units
+  uint8_t gen_conversions;            ///< conversions since the last update
+  uint8_t max_gen_conversions;        ///< maximum number of conversions between two updates
+};
+
+#define OrientationStatsGet(_o) { (_o)->stats.gets++; }
+#else
+#define OrientationStatsGet(_o) {}
+#endif
 
 /*
  * @brief Struct with euler/rmat/quaternion orientation representations in BFP int and float
@@ -84,6 +127,16 @@ struct OrientationReps {
    */
   uint8_t status;
 
+  /**
+   * Generation of the orientation, incremented by every setter.
+   * Consumers can compare it to know if the orientation changed since their last read.
+   */
+  uint32_t gen;
+
+#if ORIENTATION_CONVERSION_STATS
+  struct OrientationStats stats;
+#endif
+
   /**
    * Orientation quaternion.
    * Units: #INT32_QUAT_FRAC
@@ -128,6 +181,7 @@ extern void orientationCalcEulers_i(struct OrientationReps *orientation);
 extern void orientationCalcQuat_f(struct OrientationReps *orientation);
 extern void orientationCalcRMat_f(struct OrientationReps *orientation);
 extern void orientationCalcEulers_f(struct OrientationReps *orientation);
+extern void orientationCalcReps(struct OrientationReps *orientation, uint8_t mask);
 
 
 /*********************** validity test functions ******************/
@@ -137,12 +191,23 @@ static inline bool orienationCheckValid(struct OrientationReps *orientation)
   return (orientation->status);
 }
 
+/// Start a new generation where only the representation rep is up to date.
+static inline void orientationNewGeneration(struct OrientationReps *orientation, uint8_t rep)
+{
+  orientation->status = (1 << rep);
+  orientation->gen++;
+#if ORIENTATION_CONVERSION_STATS
+  orientation->stats.sets++;
+  orientation->stats.gen_conversions = 0;
+#endif
+}
+
 /// Set to identity orientation.
 static inline void orientationSetIdentity(struct OrientationReps *orientation)
 {
   int32_quat_identity(&orientation->quat_i);
   /* clear bits for all attitude representations and only set the new one */
-  orientation->status = (1 << ORREP_QUAT_I);
+  orientationNewGeneration(orientation, ORREP_QUAT_I);
 }
 
 /// Set vehicle body attitude from quaternion (int).
@@ -150,7 +215,7 @@ static inline void orientationSetQuat_i(struct OrientationReps *orientation, str
 {
   QUAT_COPY(orientation->quat_i, *quat);
   /* clear bits for all attitude representations and only set the new one */
-  orientation->status = (1 << ORREP_QUAT_I);
+  orientationNewGeneration(orientation, ORREP_QUAT_I);
 }
 
 /// Set vehicle body attitude from rotation matrix (int).
@@ -158,7 +223,7 @@ static inline void orientationSetRMat_i(struct OrientationReps *orientation, str
 {
   RMAT_COPY(orientation->rmat_i, *rmat);
   /* clear bits for all attitude representations and only set the new one */
-  orientation->status = (1 << ORREP_RMAT_I);
+  orientationNewGeneration(orientation, ORREP_RMAT_I);
 }
 
 /// Set vehicle body attitude from euler angles (int).
@@ -166,7 +231,7 @@ static inline void orientationSetEulers_i(struct OrientationReps *orientation, s
 {
   EULERS_COPY(orientation->eulers_i, *eulers);
   /* clear bits for all attitude representations and only set the new one */
-  orientation->status = (1 << ORREP_EULER_I);
+  orientationNewGeneration(orientation, ORREP_EULER_I);
 }
 
 /// Set vehicle body attitude from quaternion (float).
@@ -174,7 +239,7 @@ static inline void orientationSetQuat_f(struct OrientationReps *orientation, str
 {
   QUAT_COPY(orientation->quat_f, *quat);
   /* clear bits for all attitude representations and only set the new one */
-  orientation->status = (1 << ORREP_QUAT_F);
+  orientationNewGeneration(orientation, ORREP_QUAT_F);
 }
 
 /// Set vehicle body attitude from rotation matrix (float).
@@ -182,7 +247,7 @@ static inline void orientationSetRMat_f(struct OrientationReps *orientation, str
 {
   RMAT_COPY(orientation->rmat_f, *rmat);
   /* clear bits for all attitude representations and only set the new one */
-  orientation->status = (1 << ORREP_RMAT_F);
+  orientationNewGeneration(orientation, ORREP_RMAT_F);
 }
 
 /// Set vehicle body attitude from euler angles (float).
@@ -190,13 +255,14 @@ static inline void orientationSetEulers_f(struct OrientationReps *orientation, s
 {
   EULERS_COPY(orientation->eulers_f, *eulers);
   /* clear bits for all attitude representations and only set the new one */
-  orientation->status = (1 << ORREP_EULER_F);
+  orientationNewGeneration(orientation, ORREP_EULER_F);
 }
 
 
 /// Get vehicle body attitude quaternion (int).
 static inline struct Int32Quat *orientationGetQuat_i(struct OrientationReps *orientation)
 {
+  OrientationStatsGet(orientation);
   if (!bit_is_set(orientation->status, ORREP_QUAT_I)) {
     orientationCalcQuat_i(orientation);
   }
@@ -206,6 +272,7 @@ static inline struct Int32Quat *orientationGetQuat_i(struct OrientationReps *ori
 /// Get vehicle body attitude rotation matrix (int).
 static inline struct Int32RMat *orientationGetRMat_i(struct OrientationReps *orientation)
 {
+  OrientationStatsGet(orientation);
   if (!bit_is_set(orientation->status, ORREP_RMAT_I)) {
     orientationCalcRMat_i(orientation);
   }
@@ -215,6 +282,7 @@ static inline struct Int32RMat *orientationGetRMat_i(struct OrientationReps *ori
 /// Get vehicle body attitude euler angles (int).
 static inline struct Int32Eulers *orientationGetEulers_i(struct OrientationReps *orientation)
 {
+  OrientationStatsGet(orientation);
   if (!bit_is_set(orientation->status, ORREP_EULER_I)) {
     orientationCalcEulers_i(orientation);
   }
@@ -224,6 +292,7 @@ static inline struct Int32Eulers *orientationGetEulers_i(struct OrientationReps
 /// Get vehicle body attitude quaternion (float).
 static inline struct FloatQuat *orientationGetQuat_f(struct OrientationReps *orientation)
 {
+  OrientationStatsGet(orientation);
   if (!bit_is_set(orientation->status, ORREP_QUAT_F)) {
     orientationCalcQuat_f(orientation);
   }
@@ -233,6 +302,7 @@ static inline struct FloatQuat *orientationGetQuat_f(struct OrientationReps *ori
 /// Get vehicle body attitude rotation matrix (float).
 static inline struct FloatRMat *orientationGetRMat_f(struct OrientationReps *orientation)
 {
+  OrientationStatsGet(orientation);
   if (!bit_is_set(orientation->status, ORREP_RMAT_F)) {
     orientationCalcRMat_f(orientation);
   }
@@ -242,6 +312,7 @@ static inline struct FloatRMat *orientationGetRMat_f(struct OrientationReps *ori
 /// Get vehicle body attitude euler angles (float).
 static inline struct FloatEulers *orientationGetEulers_f(struct OrientationReps *orientation)
 {
+  OrientationStatsGet(orientation);
   if (!bit_is_set(orientation->status, ORREP_EULER_F)) {
     orientationCalcEulers_f(orientation);
   }
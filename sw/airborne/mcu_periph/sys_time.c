@@ -29,6 +29,7 @@
 
 #include "mcu_periph/sys_time.h"
 #include "mcu.h"
+#include <string.h>
 
 // check the number of timers against max tid_t value
 #include "limits.h"
@@ -49,6 +50,13 @@ tid_t sys_time_register_timer(float duration, sys_time_cb cb)
       sys_time.timer[i].elapsed    = false;
       sys_time.timer[i].end_time   = start_time + sys_time_ticks_of_sec(duration);
       sys_time.timer[i].duration   = sys_time_ticks_of_sec(duration);
+#if SYS_TIME_TIMER_STATS
+      sys_time.timer[i].stats.running = false;
+#endif
+      sys_time_timer_stats_reset(i);
+#if SYS_TIME_TIMER_STATS
+      sys_time.timer[i].stats.deadline = start_time;
+#endif
       sys_time.timer[i].in_use     = true;
       return i;
     }
@@ -75,6 +83,116 @@ void sys_time_update_timer(tid_t id, float duration)
   mcu_int_enable();
 }
 
+#if SYS_TIME_TIMER_STATS
+/**
+ * Exact conversion of SYS_TIME_TICKS to usec.
+ * For dates, wraps like get_sys_time_usec().
+ */
+static inline uint32_t exact_usec_of_sys_time_ticks(uint32_t ticks)
+{
+  return (uint32_t)((uint64_t)ticks * 1000000 / sys_time.ticks_per_sec);
+}
+
+/** Delay between the deadline and the start of the current run in usec */
+static inline uint32_t sys_time_timer_stats_latency(struct sys_time_timer_stats *stats)
+{
+  int32_t latency = stats->start - exact_usec_of_sys_time_ticks(stats->deadline);
+  return latency > 0 ? latency : 0;
+}
+
+void sys_time_timer_stats_start(tid_t id)
+{
+  struct sys_time_timer *timer = &sys_time.timer[id];
+  struct sys_time_timer_stats *stats = &timer->stats;
+  uint32_t now = get_sys_time_usec();
+
+  // end_time was moved one period ahead when the timer elapsed
+  uint32_t deadline = timer->end_time - timer->duration;
+  if (timer->duration > 0 && deadline - stats->deadline > timer->duration) {
+    stats->nb_missed += (deadline - stats->deadline) / timer->duration - 1;
+  }
+  stats->deadline = deadline;
+  stats->start = now;
+
+  uint32_t latency = sys_time_timer_stats_latency(stats);
+  stats->latency_sum += latency;
+  if (latency > stats->latency_max) {
+    stats->latency_max = latency;
+  }
+  stats->nb_runs++;
+  stats->running = true;
+}
+
+void sys_time_timer_stats_end(tid_t id)
+{
+  if ((id >= SYS_TIME_NB_TIMER) || (id < 0)) {
+    return;
+  }
+  struct sys_time_timer *timer = &sys_time.timer[id];
+  struct sys_time_timer_stats *stats = &timer->stats;
+  if (!stats->running) {
+    return;
+  }
+  stats->running = false;
+  uint32_t run = get_sys_time_usec() - stats->start;
+  uint32_t period = exact_usec_of_sys_time_ticks(timer->duration);
+
+  stats->nb_done++;
+  stats->run_sum += run;
+  if (run > stats->run_max) {
+    stats->run_max = run;
+  }
+  if (run > period) {
+    stats->nb_overruns++;
+  }
+  uint32_t bin = period > 0 ? run * SYS_TIME_STATS_HIST_NB / period : SYS_TIME_STATS_HIST_NB;
+  stats->run_hist[Min(bin, SYS_TIME_STATS_HIST_NB - 1)]++;
+}
+
+/**
+ * Get the statistics of a timer and start a new window.
+ * A run in progress, e.g. the task reporting the statistics, is left out of
+ * the returned window (apart from the max latency) and counted in the next one.
+ * @param id Timer id
+ * @param window statistics since the previous call
+ */
+void sys_time_timer_stats_take(tid_t id, struct sys_time_timer_stats *window)
+{
+  struct sys_time_timer_stats *stats = &sys_time.timer[id].stats;
+  *window = *stats;
+  if (stats->running) {
+    window->nb_runs--;
+    window->latency_sum -= sys_time_timer_stats_latency(stats);
+    window->running = false;
+  }
+  sys_time_timer_stats_reset(id);
+}
+#endif
+
+/**
+ * Start a new statistics window.
+ * A run in progress, e.g. the task reporting the statistics, is kept and
+ * counted in the new window.
+ */
+void sys_time_timer_stats_reset(tid_t id __attribute__((unused)))
+{
+#if SYS_TIME_TIMER_STATS
+  struct sys_time_timer_stats *stats = &sys_time.timer[id].stats;
+  uint32_t deadline = stats->deadline;
+  uint32_t start = stats->start;
+  bool running = stats->running;
+  memset(stats, 0, sizeof(struct sys_time_timer_stats));
+  stats->deadline = deadline;
+  stats->start = start;
+  if (running) {
+    stats->running = true;
+    stats->nb_runs = 1;
+    stats->latency_sum = sys_time_timer_stats_latency(stats);
+    stats->latency_max = stats->latency_sum;
+  }
+#endif
+}
+
 void sys_time_init(void)
 {
   sys_time.nb_sec     = 0;
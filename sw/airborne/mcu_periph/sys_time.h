@@ -57,15 +57,45 @@
 #endif /* USE_CHIBIOS_RTOS */
 #endif
 
+/**
+ * Record per timer statistics (latency, run time, overruns).
+ * Latency is measured when the timer is acknowledged,
+ * run time when sys_time_timer_done() is called after the task.
+ */
+#ifndef SYS_TIME_TIMER_STATS
+#define SYS_TIME_TIMER_STATS FALSE
+#endif
+
+/** Number of run time histogram bins, each covering 1/SYS_TIME_STATS_HIST_NB of the timer period */
+#define SYS_TIME_STATS_HIST_NB 8
+
 typedef int8_t tid_t; ///< sys_time timer id type
 typedef void (*sys_time_cb)(uint8_t id);
 
+struct sys_time_timer_stats {
+  uint32_t deadline;      ///< last handled deadline in SYS_TIME_TICKS
+  uint32_t start;         ///< start time of the current run in usec
+  uint32_t nb_runs;       ///< number of runs
+  uint32_t nb_done;       ///< number of runs with a measured run time
+  uint32_t nb_missed;     ///< number of periods elapsed without being handled
+  uint32_t nb_overruns;   ///< number of runs longer than the timer period
+  uint32_t latency_sum;   ///< sum of delays between deadline and start of run in usec
+  uint32_t latency_max;   ///< max delay between deadline and start of run in usec
+  uint32_t run_sum;       ///< sum of run times in usec
+  uint32_t run_max;       ///< max run time in usec
+  uint16_t run_hist[SYS_TIME_STATS_HIST_NB]; ///< run time histogram, last bin includes overruns
+  bool running;           ///< a run was started and is not done yet
+};
+
 struct sys_time_timer {
   bool          in_use;
   sys_time_cb     cb;
   volatile bool elapsed;
   uint32_t        end_time; ///< in SYS_TIME_TICKS
   uint32_t        duration; ///< in SYS_TIME_TICKS
+#if SYS_TIME_TIMER_STATS
+  struct sys_time_timer_stats stats;
+#endif
 };
 
 struct sys_time {
@@ -106,6 +136,18 @@ extern void sys_time_cancel_timer(tid_t id);
  */
 extern void sys_time_update_timer(tid_t id, float duration);
 
+#if SYS_TIME_TIMER_STATS
+extern void sys_time_timer_stats_start(tid_t id);
+extern void sys_time_timer_stats_end(tid_t id);
+extern void sys_time_timer_stats_take(tid_t id, struct sys_time_timer_stats *window);
+#endif
+
+/**
+ * Reset the statistics of a timer.
+ * @param id Timer id
+ */
+extern void sys_time_timer_stats_reset(tid_t id);
+
 /**
  * Check if timer has elapsed.
  * @param id Timer id
@@ -116,12 +158,27 @@ static inline bool sys_time_check_and_ack_timer(tid_t id)
   if ((id < SYS_TIME_NB_TIMER) && (id >= 0)) {
     if (sys_time.timer[id].elapsed) {
         sys_time.timer[id].elapsed = false;
+#if SYS_TIME_TIMER_STATS
+        sys_time_timer_stats_start(id);
+#endif
         return true;
     }
   }
   return false;
 }
 
+/**
+ * Signal the end of the task run after sys_time_check_and_ack_timer().
+ * Only used for run time statistics.
+ * @param id Timer id
+ */
+static inline void sys_time_timer_done(tid_t id __attribute__((unused)))
+{
+#if SYS_TIME_TIMER_STATS
+  sys_time_timer_stats_end(id);
+#endif
+}
+
 /**
  * Get the time in seconds since startup.
  * @return current system time as float with sys_time.resolution
@@ -31,9 +31,13 @@
 #include "cv.h"
 #include "rt_priority.h"
 
+#ifndef NPS_SIMULATE_VIDEO
+#include "lib/v4l/v4l2.h"
+#endif
+
 
 void cv_attach_listener(struct video_config_t *device, struct video_listener *new_listener);
-int8_t cv_async_function(struct cv_async *async, struct image_t *img);
+int8_t cv_async_function(struct cv_async *async, struct image_t *img, bool share);
 void *cv_async_thread(void *args);
 
 
@@ -87,6 +91,8 @@ struct video_listener *cv_add_to_device_async(struct video_config_t *device, cv_
   // Add asynchronous structure to override default synchronous behavior
   listener->async = malloc(sizeof(struct cv_async));
   listener->async->thread_priority = nice_level;
+  listener->async->device = device;
+  listener->async->img = NULL;
 
   // Explicitly mark img_copy as uninitialized
   listener->async->img_copy.buf_size = 0;
@@ -102,21 +108,58 @@ struct video_listener *cv_add_to_device_async(struct video_config_t *device, cv_
 }
 
 
-int8_t cv_async_function(struct cv_async *async, struct image_t *img)
+/**
+ * Take a reference to the frame of the video device instead of copying it.
+ * This only works for V4L2 buffers which are not changed by a synchronous listener
+ * and as long as the device is below its maximum amount of held frames.
+ * @param[in] *async The asynchronous listener structure
+ * @param[in] *img The image to share
+ * @return Whether the image is shared
+ */
+static bool cv_async_image_ref(struct cv_async *async, struct image_t *img)
+{
+#ifndef NPS_SIMULATE_VIDEO
+  struct v4l2_device *dev = async->device->thread.dev;
+  if (dev != NULL && img->type == IMAGE_YUV422) {
+    return v4l2_image_ref(dev, img);
+  }
+#endif
+  return false;
+}
+
+/**
+ * Release the shared frame of an asynchronous listener
+ * @param[in] *async The asynchronous listener structure
+ */
+static void cv_async_image_unref(struct cv_async *async)
+{
+#ifndef NPS_SIMULATE_VIDEO
+  v4l2_image_free(async->device->thread.dev, &async->img_shared);
+#endif
+}
+
+
+int8_t cv_async_function(struct cv_async *async, struct image_t *img, bool share)
 {
   // If the previous image is not yet processed, return
   if (!async->img_processed || pthread_mutex_trylock(&async->img_mutex) != 0) {
     return -1;
   }
 
-  // If the image has not been initialized, do it
-  if (async->img_copy.buf_size == 0) {
-    image_create(&async->img_copy, img->w, img->h, img->type);
-  }
+  // Share the V4L2 buffer when possible, the listener only reads it
+  if (share && cv_async_image_ref(async, img)) {
+    async->img_shared = *img;
+    async->img = &async->img_shared;
+  } else {
+    // If the image has not been initialized, do it
+    if (async->img_copy.buf_size == 0) {
+      image_create(&async->img_copy, img->w, img->h, img->type);
+    }
 
-  // Copy image
-// TODO:this takes time causing some thread lag, should be replaced with gpu operation
-  image_copy(img, &async->img_copy);
+    // Copy image
+    image_copy(img, &async->img_copy);
+    async->img = &async->img_copy;
+  }
 
   // Inform thread of new image
   async->img_processed = false;
@@ -148,7 +191,12 @@ void *cv_async_thread(void *args)
     }
 
     // Execute vision function from this thread
-    listener->func(&async->img_copy);
+    listener->func(async->img);
+
+    // Give the shared buffer back to the device
+    if (async->img == &async->img_shared) {
+      cv_async_image_unref(async);
+    }
 
     // Mark image as processed
     async->img_processed = true;
@@ -159,6 +207,22 @@ void *cv_async_thread(void *args)
 }
 
 
+/**
+ * Check if a synchronous listener could still change the image after this listener
+ * @param[in] *listener The current listener
+ * @return Whether an active synchronous listener follows
+ */
+static bool cv_sync_listener_after(struct video_listener *listener)
+{
+  for (listener = listener->next; listener != NULL; listener = listener->next) {
+    if (listener->active && listener->async == NULL) {
+      return true;
+    }
+  }
+  return false;
+}
+
+
 void cv_run_device(struct video_config_t *device, struct image_t *img)
 {
   struct image_t *result;
@@ -177,7 +241,7 @@ void cv_run_device(struct video_config_t *device, struct image_t *img)
 
     if (listener->async != NULL) {
       // Send image to asynchronous thread, only update listener if successful
-      if (!cv_async_function(listener->async, img)) {
+      if (!cv_async_function(listener->async, img, !cv_sync_listener_after(listener))) {
         // Store timestamp
         listener->ts = img->ts;
       }
@@ -45,7 +45,10 @@ struct cv_async {
   pthread_mutex_t img_mutex;
   pthread_cond_t img_available;
   volatile bool img_processed;
-  struct image_t img_copy;
+  struct image_t img_copy;            ///< Private copy, used when the frame can't be shared
+  struct image_t img_shared;          ///< Reference counted V4L2 frame (zero-copy)
+  struct image_t *img;                ///< The image to process (img_shared or img_copy)
+  struct video_config_t *device;      ///< The device the frames are coming from
 };
 
 struct video_listener {
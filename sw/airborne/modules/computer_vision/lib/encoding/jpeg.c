@@ -14,12 +14,42 @@
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 #include "jpeg.h"
+#include <stdlib.h>
+#include <string.h>
 
 /**
  * @file modules/computer_vision/lib/encoding/jpeg.c
  * Encode images with the use of the JPEG encoding
  */
 
+/** Maximum amount of threads (including the calling thread) used to encode the restart intervals of an image */
+#ifndef JPEG_NUM_THREADS
+#define JPEG_NUM_THREADS 1
+#endif
+
+/** Amount of threads used, can be lowered at runtime (1 == single threaded) */
+uint8_t jpeg_num_threads = JPEG_NUM_THREADS;
+
+/**
+ * Use the vectorized (ARM NEON or x86 SSE2) DCT and quantization when the compiler
+ * targets them. They give exactly the same coefficients as the scalar code.
+ */
+#ifndef JPEG_SIMD
+#define JPEG_SIMD TRUE
+#endif
+
+#if JPEG_SIMD && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define JPEG_NEON 1
+#include <arm_neon.h>
+#elif JPEG_SIMD && defined(__SSE2__)
+#define JPEG_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if JPEG_NUM_THREADS > 1
+#include <pthread.h>
+#endif
+
 static inline unsigned char svs_size_code(int w)
 {
   // 1=(40,30) 2=(128,96) 3=(160,120) 5=(320,240) 7=(640,480) 9=(1280,1024);
@@ -75,6 +105,7 @@ typedef struct JPEG_ENCODER_STRUCTURE {
 
   uint16_t    rows;
   uint16_t    cols;
+  uint32_t    mcu_row_size;
 
   uint16_t    length_minus_mcu_width;
   uint16_t    length_minus_width;
@@ -101,25 +132,33 @@ typedef struct JPEG_ENCODER_STRUCTURE {
   uint32_t   lcode;
   uint16_t   bitindex;
 
+  void (*read_format)(struct JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, uint8_t *input_ptr);
+
 } JPEG_ENCODER_STRUCTURE;
 
 
 static void jpeg_initialization(JPEG_ENCODER_STRUCTURE *, uint32_t, uint32_t, uint32_t);
 
-static uint8_t *jpeg_write_markers(JPEG_ENCODER_STRUCTURE *, uint8_t *, uint32_t, uint32_t, uint32_t);
+static uint8_t *jpeg_write_markers(JPEG_ENCODER_STRUCTURE *, uint8_t *, uint32_t, uint32_t, uint32_t, uint16_t);
 
 static void jpeg_read_400_format(JPEG_ENCODER_STRUCTURE *, uint8_t *);
 static void jpeg_read_422_format(JPEG_ENCODER_STRUCTURE *, uint8_t *);
 
 static uint8_t *jpeg_encodeMCU(JPEG_ENCODER_STRUCTURE *, uint32_t, uint8_t *);
 
+static void jpeg_transform(JPEG_ENCODER_STRUCTURE *, int16_t *, uint16_t *);
+#if !JPEG_NEON && !JPEG_SSE2
 static void jpeg_levelshift(int16_t *);
 static void jpeg_DCT(int16_t *);
-
 static void jpeg_quantization(JPEG_ENCODER_STRUCTURE *, int16_t *, uint16_t *);
+#endif
 static uint8_t *jpeg_huffman(JPEG_ENCODER_STRUCTURE *, uint16_t, uint8_t *);
 
-static uint8_t *jpeg_close_bitstream(JPEG_ENCODER_STRUCTURE *, uint8_t *);
+static uint8_t *jpeg_encode_rows(JPEG_ENCODER_STRUCTURE *, uint32_t, uint8_t *, uint16_t, uint16_t, uint8_t *);
+static uint8_t *jpeg_flush_bitstream(JPEG_ENCODER_STRUCTURE *, uint8_t *);
+#if JPEG_NUM_THREADS > 1
+static uint8_t *jpeg_encode_rows_threaded(JPEG_ENCODER_STRUCTURE *, uint32_t, uint8_t *, uint16_t, uint16_t, uint8_t *);
+#endif
 
 static const uint16_t luminance_dc_code_table [] = {
   0x0000, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006,
@@ -283,8 +322,6 @@ static const uint8_t zigzag_table [] = {
 };
 
 
-void (*read_format)(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, uint8_t *input_ptr);
-
 static void jpeg_initialization(JPEG_ENCODER_STRUCTURE *jpeg, uint32_t image_format, uint32_t image_width, uint32_t image_height)
 {
   uint16_t mcu_width, mcu_height, bytes_per_pixel;
@@ -300,7 +337,7 @@ static void jpeg_initialization(JPEG_ENCODER_STRUCTURE *jpeg, uint32_t image_for
     jpeg->vertical_mcus = (uint16_t)((image_height + mcu_height - 1) >> 3);
 
     bytes_per_pixel = 1;
-    read_format = jpeg_read_400_format;
+    jpeg->read_format = jpeg_read_400_format;
   } else {
     jpeg->mcu_width = mcu_width = 16;
     jpeg->horizontal_mcus = (uint16_t)((image_width + mcu_width - 1) >> 4);
@@ -308,9 +345,11 @@ static void jpeg_initialization(JPEG_ENCODER_STRUCTURE *jpeg, uint32_t image_for
     jpeg->mcu_height = mcu_height = 8;
     jpeg->vertical_mcus = (uint16_t)((image_height + mcu_height - 1) >> 3);
     bytes_per_pixel = 2;
-    read_format = jpeg_read_422_format;
+    jpeg->read_format = jpeg_read_422_format;
   }
 
+  jpeg->mcu_row_size = (uint32_t)image_width * mcu_height * bytes_per_pixel;
+
   jpeg->rows_in_bottom_mcus = (uint16_t)(image_height - (jpeg->vertical_mcus - 1) * mcu_height);
   jpeg->cols_in_right_mcus = (uint16_t)(image_width - (jpeg->horizontal_mcus - 1) * mcu_width);
 
@@ -407,9 +446,25 @@ void MakeTables(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, int q)
  */
 void jpeg_encode_image(struct image_t *in, struct image_t *out, uint32_t quality_factor, bool add_dri_header)
 {
-  uint16_t i, j;
+  jpeg_encode_image_restart(in, out, quality_factor, add_dri_header, 0);
+}
+
+/**
+ * Encode an YUV422 or grayscale image split in restart intervals.
+ * Every restart interval is a band of MCU rows which is encoded independently of the others,
+ * so with JPEG_NUM_THREADS > 1 the bands are encoded in parallel. The output does not depend
+ * on the amount of threads.
+ * @param[in] *in The input image
+ * @param[out] *out The output JPEG image
+ * @param[in] quality_factor Quality factor of the encoding (0-99)
+ * @param[in] add_dri_header Add the JPEG headers (needed for full JPEG)
+ * @param[in] restart_rows Amount of MCU rows (8 pixel rows) per restart interval (0 for no restart intervals)
+ * @return The restart interval in MCUs (0 when the image is encoded as one interval)
+ */
+uint16_t jpeg_encode_image_restart(struct image_t *in, struct image_t *out, uint32_t quality_factor,
+                                   bool add_dri_header, uint16_t restart_rows)
+{
   uint8_t *output_ptr = out->buf;
-  uint8_t *input_ptr = in->buf;
   uint32_t image_format = FOUR_ZERO_ZERO;
 
   if (in->type == IMAGE_YUV422) {
@@ -430,12 +485,76 @@ void jpeg_encode_image(struct image_t *in, struct image_t *out, uint32_t quality
 
   MakeTables(jpeg_encoder_structure, quality_factor);
 
+  /* Restart intervals of whole MCU rows (the interval is limited to 16 bits) */
+  uint16_t vertical_mcus = jpeg_encoder_structure->vertical_mcus;
+  uint16_t horizontal_mcus = jpeg_encoder_structure->horizontal_mcus;
+  if (restart_rows > 0 && (uint32_t)restart_rows * horizontal_mcus > 0xFFFF) {
+    restart_rows = 0xFFFF / horizontal_mcus;
+  }
+  if (restart_rows == 0 || restart_rows >= vertical_mcus) {
+    restart_rows = vertical_mcus;
+  }
+  uint16_t restart_interval = (restart_rows < vertical_mcus) ? restart_rows * horizontal_mcus : 0;
+
   /* Writing Marker Data */
   if (add_dri_header) {
-    output_ptr = jpeg_write_markers(jpeg_encoder_structure, output_ptr, image_format, in->w, in->h);
+    output_ptr = jpeg_write_markers(jpeg_encoder_structure, output_ptr, image_format, in->w, in->h, restart_interval);
   }
 
-  for (i = 1; i <= jpeg_encoder_structure->vertical_mcus; i++) {
+#if JPEG_NUM_THREADS > 1
+  if (jpeg_num_threads > 1 && restart_interval > 0) {
+    output_ptr = jpeg_encode_rows_threaded(jpeg_encoder_structure, image_format, in->buf, restart_rows,
+                                           (vertical_mcus + restart_rows - 1) / restart_rows, output_ptr);
+  } else
+#endif
+  {
+    uint8_t restart_cnt = 0;
+    for (uint16_t row = 0; row < vertical_mcus; row += restart_rows) {
+      // Restart marker (RSTn) between the intervals
+      if (row > 0) {
+        *output_ptr++ = 0xFF;
+        *output_ptr++ = 0xD0 + (restart_cnt++ & 0x07);
+      }
+
+      uint16_t row_end = (vertical_mcus - row > restart_rows) ? row + restart_rows : vertical_mcus;
+      output_ptr = jpeg_encode_rows(jpeg_encoder_structure, image_format, in->buf, row, row_end, output_ptr);
+    }
+  }
+
+  // End of image marker
+  *output_ptr++ = 0xFF;
+  *output_ptr++ = 0xD9;
+
+  out->w = in->w;
+  out->h = in->h;
+  out->buf_size = output_ptr - (uint8_t *)out->buf;
+  return restart_interval;
+}
+
+/**
+ * Encode a band of MCU rows as one restart interval
+ * @param[in] *jpeg_encoder_structure The encoder state, the DC predictions and bitstream are reset
+ * @param[in] image_format The format of the input image
+ * @param[in] *input_ptr The start of the input image
+ * @param[in] row_start The first MCU row to encode
+ * @param[in] row_end The MCU row after the last one to encode
+ * @param[out] *output_ptr Where the entropy coded data is written
+ * @return The end of the written data
+ */
+static uint8_t *jpeg_encode_rows(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, uint32_t image_format,
+                                 uint8_t *input_ptr, uint16_t row_start, uint16_t row_end, uint8_t *output_ptr)
+{
+  uint16_t i, j;
+
+  input_ptr += row_start * jpeg_encoder_structure->mcu_row_size;
+
+  jpeg_encoder_structure->ldc1 = 0;
+  jpeg_encoder_structure->ldc2 = 0;
+  jpeg_encoder_structure->ldc3 = 0;
+  jpeg_encoder_structure->lcode = 0;
+  jpeg_encoder_structure->bitindex = 0;
+
+  for (i = row_start + 1; i <= row_end; i++) {
     if (i < jpeg_encoder_structure->vertical_mcus) {
       jpeg_encoder_structure->rows = jpeg_encoder_structure->mcu_height;
     } else {
@@ -451,7 +570,7 @@ void jpeg_encode_image(struct image_t *in, struct image_t *out, uint32_t quality
         jpeg_encoder_structure->incr = jpeg_encoder_structure->length_minus_width;
       }
 
-      read_format(jpeg_encoder_structure, input_ptr);
+      jpeg_encoder_structure->read_format(jpeg_encoder_structure, input_ptr);
 
       /* Encode the data in MCU */
       output_ptr = jpeg_encodeMCU(jpeg_encoder_structure, image_format, output_ptr);
@@ -462,39 +581,457 @@ void jpeg_encode_image(struct image_t *in, struct image_t *out, uint32_t quality
     input_ptr += jpeg_encoder_structure->offset;
   }
 
-  /* Close Routine */
-  output_ptr = jpeg_close_bitstream(jpeg_encoder_structure, output_ptr);
-  out->w = in->w;
-  out->h = in->h;
-  out->buf_size = output_ptr - (uint8_t *)out->buf;
+  return jpeg_flush_bitstream(jpeg_encoder_structure, output_ptr);
+}
+
+#if JPEG_NUM_THREADS > 1
+/**
+ * Entropy coded data of one restart interval
+ */
+struct jpeg_slice_t {
+  uint8_t *buf;                     ///< Output buffer, kept between the frames
+  uint32_t size;                    ///< Allocated size of buf
+  uint32_t length;                  ///< Amount of bytes written
+};
+
+/**
+ * Persistent pool of worker threads for the JPEG encoding
+ */
+struct jpeg_pool_t {
+  bool initialized;                 ///< Whether the worker threads are started
+  pthread_t threads[JPEG_NUM_THREADS - 1]; ///< Worker threads, the calling thread also encodes slices
+  pthread_mutex_t call_mutex;       ///< Only one encoding at a time can use the pool
+  pthread_mutex_t mutex;            ///< Protects the job state below
+  pthread_cond_t work_cond;         ///< Signaled when a new job is available
+  pthread_cond_t done_cond;         ///< Signaled when all slices are encoded
+  uint32_t job;                     ///< Job counter, increased for every encoding
+  uint16_t next_slice;              ///< Next slice to encode
+  uint16_t slices_done;             ///< Amount of encoded slices
+
+  JPEG_ENCODER_STRUCTURE *jpeg;     ///< Encoder state with the tables of the current job
+  uint32_t image_format;            ///< Format of the input image
+  uint8_t *input;                   ///< Input image buffer
+  uint16_t restart_rows;            ///< MCU rows per slice
+  uint16_t slices_cnt;              ///< Amount of slices of the current job
+  uint16_t slices_length;           ///< Allocated length of slices
+  struct jpeg_slice_t *slices;      ///< The slices, kept between the frames
+};
+
+static struct jpeg_pool_t jpeg_pool = {
+  .initialized = false,
+  .call_mutex = PTHREAD_MUTEX_INITIALIZER,
+  .mutex = PTHREAD_MUTEX_INITIALIZER,
+  .work_cond = PTHREAD_COND_INITIALIZER,
+  .done_cond = PTHREAD_COND_INITIALIZER
+};
+
+/**
+ * Encode slices of the current job until all are taken. Must be called with the pool mutex locked.
+ * Every slice is encoded with its own copy of the encoder state.
+ * @param[in] *pool The pool with the current job
+ */
+static void jpeg_pool_work(struct jpeg_pool_t *pool)
+{
+  while (pool->next_slice < pool->slices_cnt) {
+    uint16_t idx = pool->next_slice++;
+    struct jpeg_slice_t *slice = &pool->slices[idx];
+    pthread_mutex_unlock(&pool->mutex);
+
+    JPEG_ENCODER_STRUCTURE jpeg = *pool->jpeg;
+    uint16_t row_start = idx * pool->restart_rows;
+    uint16_t row_end = (jpeg.vertical_mcus - row_start > pool->restart_rows) ? row_start + pool->restart_rows :
+                       jpeg.vertical_mcus;
+    uint8_t *end = jpeg_encode_rows(&jpeg, pool->image_format, pool->input, row_start, row_end, slice->buf);
+    slice->length = end - slice->buf;
+
+    pthread_mutex_lock(&pool->mutex);
+    if (++pool->slices_done == pool->slices_cnt) {
+      pthread_cond_signal(&pool->done_cond);
+    }
+  }
+}
+
+/**
+ * Worker thread of the pool, waits for a new job and helps encoding its slices
+ * @param[in] *data The index of the worker
+ */
+static void *jpeg_pool_thread(void *data)
+{
+  uint8_t idx = (uint8_t)(uintptr_t)data;
+  uint32_t job = 0;
+
+  pthread_mutex_lock(&jpeg_pool.mutex);
+  while (true) {
+    while (jpeg_pool.job == job) {
+      pthread_cond_wait(&jpeg_pool.work_cond, &jpeg_pool.mutex);
+    }
+    job = jpeg_pool.job;
+
+    // Only use the amount of threads requested at runtime
+    if (idx + 1 < jpeg_num_threads) {
+      jpeg_pool_work(&jpeg_pool);
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Encode the restart intervals with a pool of threads. Every interval is encoded in its own
+ * buffer, which are then concatenated with the restart markers in between.
+ * @param[in] *jpeg_encoder_structure The encoder state with the quantization tables
+ * @param[in] image_format The format of the input image
+ * @param[in] *input_ptr The input image buffer
+ * @param[in] restart_rows The amount of MCU rows per restart interval
+ * @param[in] slices_cnt The amount of restart intervals
+ * @param[out] *output_ptr Where the entropy coded data is written
+ * @return The end of the written data
+ */
+static uint8_t *jpeg_encode_rows_threaded(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, uint32_t image_format,
+    uint8_t *input_ptr, uint16_t restart_rows, uint16_t slices_cnt, uint8_t *output_ptr)
+{
+  struct jpeg_pool_t *pool = &jpeg_pool;
+  pthread_mutex_lock(&pool->call_mutex);
+
+  // Start the worker threads on the first call
+  if (!pool->initialized) {
+    for (uint8_t i = 0; i < JPEG_NUM_THREADS - 1; i++) {
+      pthread_create(&pool->threads[i], NULL, jpeg_pool_thread, (void *)(uintptr_t)i);
+    }
+    pool->initialized = true;
+  }
+
+  // Make sure every slice can hold the worst case output (twice the input with byte stuffing)
+  if (slices_cnt > pool->slices_length) {
+    pool->slices = realloc(pool->slices, sizeof(struct jpeg_slice_t) * slices_cnt);
+    memset(&pool->slices[pool->slices_length], 0, sizeof(struct jpeg_slice_t) * (slices_cnt - pool->slices_length));
+    pool->slices_length = slices_cnt;
+  }
+  uint32_t slice_size = 2 * restart_rows * jpeg_encoder_structure->mcu_row_size + 64;
+  for (uint16_t i = 0; i < slices_cnt; i++) {
+    if (pool->slices[i].size < slice_size) {
+      pool->slices[i].buf = realloc(pool->slices[i].buf, slice_size);
+      pool->slices[i].size = slice_size;
+    }
+  }
+
+  // Set up the job
+  pthread_mutex_lock(&pool->mutex);
+  pool->jpeg = jpeg_encoder_structure;
+  pool->image_format = image_format;
+  pool->input = input_ptr;
+  pool->restart_rows = restart_rows;
+  pool->slices_cnt = slices_cnt;
+  pool->next_slice = 0;
+  pool->slices_done = 0;
+  pool->job++;
+  pthread_cond_broadcast(&pool->work_cond);
+
+  // Help encoding and wait until all slices are done
+  jpeg_pool_work(pool);
+  while (pool->slices_done < slices_cnt) {
+    pthread_cond_wait(&pool->done_cond, &pool->mutex);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+
+  // Concatenate the slices with the restart markers (RSTn)
+  for (uint16_t i = 0; i < slices_cnt; i++) {
+    if (i > 0) {
+      *output_ptr++ = 0xFF;
+      *output_ptr++ = 0xD0 + ((i - 1) & 0x07);
+    }
+    memcpy(output_ptr, pool->slices[i].buf, pool->slices[i].length);
+    output_ptr += pool->slices[i].length;
+  }
+
+  pthread_mutex_unlock(&pool->call_mutex);
+  return output_ptr;
 }
+#endif
 
 static uint8_t *jpeg_encodeMCU(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, uint32_t image_format, uint8_t *output_ptr)
 {
-  jpeg_levelshift(jpeg_encoder_structure->Y1);
-  jpeg_DCT(jpeg_encoder_structure->Y1);
-  jpeg_quantization(jpeg_encoder_structure, jpeg_encoder_structure->Y1, jpeg_encoder_structure->ILqt);
+  jpeg_transform(jpeg_encoder_structure, jpeg_encoder_structure->Y1, jpeg_encoder_structure->ILqt);
   output_ptr = jpeg_huffman(jpeg_encoder_structure, 1, output_ptr);
 
   if (image_format == FOUR_TWO_TWO) {
-    jpeg_levelshift(jpeg_encoder_structure->Y2);
-    jpeg_DCT(jpeg_encoder_structure->Y2);
-    jpeg_quantization(jpeg_encoder_structure, jpeg_encoder_structure->Y2, jpeg_encoder_structure->ILqt);
+    jpeg_transform(jpeg_encoder_structure, jpeg_encoder_structure->Y2, jpeg_encoder_structure->ILqt);
     output_ptr = jpeg_huffman(jpeg_encoder_structure, 1, output_ptr);
 
-    jpeg_levelshift(jpeg_encoder_structure->CB);
-    jpeg_DCT(jpeg_encoder_structure->CB);
-    jpeg_quantization(jpeg_encoder_structure, jpeg_encoder_structure->CB, jpeg_encoder_structure->ICqt);
+    jpeg_transform(jpeg_encoder_structure, jpeg_encoder_structure->CB, jpeg_encoder_structure->ICqt);
     output_ptr = jpeg_huffman(jpeg_encoder_structure, 2, output_ptr);
 
-    jpeg_levelshift(jpeg_encoder_structure->CR);
-    jpeg_DCT(jpeg_encoder_structure->CR);
-    jpeg_quantization(jpeg_encoder_structure, jpeg_encoder_structure->CR, jpeg_encoder_structure->ICqt);
+    jpeg_transform(jpeg_encoder_structure, jpeg_encoder_structure->CR, jpeg_encoder_structure->ICqt);
     output_ptr = jpeg_huffman(jpeg_encoder_structure, 3, output_ptr);
   }
   return output_ptr;
 }
 
+/* DCT constants */
+#define JPEG_C1 1420  // cos PI/16 * root(2)
+#define JPEG_C2 1338  // cos PI/8 * root(2)
+#define JPEG_C3 1204  // cos 3PI/16 * root(2)
+#define JPEG_C5 805   // cos 5PI/16 * root(2)
+#define JPEG_C6 554   // cos 3PI/8 * root(2)
+#define JPEG_C7 283   // cos 7PI/16 * root(2)
+
+#if JPEG_SSE2
+/** Transpose an 8x8 block of 16 bit values */
+static inline void jpeg_transpose_sse2(__m128i *r)
+{
+  __m128i a0 = _mm_unpacklo_epi16(r[0], r[1]);
+  __m128i a1 = _mm_unpackhi_epi16(r[0], r[1]);
+  __m128i a2 = _mm_unpacklo_epi16(r[2], r[3]);
+  __m128i a3 = _mm_unpackhi_epi16(r[2], r[3]);
+  __m128i a4 = _mm_unpacklo_epi16(r[4], r[5]);
+  __m128i a5 = _mm_unpackhi_epi16(r[4], r[5]);
+  __m128i a6 = _mm_unpacklo_epi16(r[6], r[7]);
+  __m128i a7 = _mm_unpackhi_epi16(r[6], r[7]);
+
+  __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+  __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+  __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+  __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+  __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+  __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+  __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+  __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+  r[0] = _mm_unpacklo_epi64(b0, b4);
+  r[1] = _mm_unpackhi_epi64(b0, b4);
+  r[2] = _mm_unpacklo_epi64(b1, b5);
+  r[3] = _mm_unpackhi_epi64(b1, b5);
+  r[4] = _mm_unpacklo_epi64(b2, b6);
+  r[5] = _mm_unpackhi_epi64(b2, b6);
+  r[6] = _mm_unpacklo_epi64(b3, b7);
+  r[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+/** Pack two 16 bit DCT constants for _mm_madd_epi16 (a multiplies the first, b the second input) */
+#define JPEG_SSE2_PAIR(a, b) _mm_set1_epi32((int32_t)(((uint32_t)(uint16_t)(b) << 16) | (uint16_t)(a)))
+
+/** (x * a + y * b + z * c + w * d) >> shift for the interleaved pairs xy and zw, packed back to 16 bit */
+static inline __m128i jpeg_dot4_sse2(__m128i xy_lo, __m128i xy_hi, __m128i zw_lo, __m128i zw_hi, __m128i ab,
+                                     __m128i cd, __m128i shift)
+{
+  __m128i lo = _mm_add_epi32(_mm_madd_epi16(xy_lo, ab), _mm_madd_epi16(zw_lo, cd));
+  __m128i hi = _mm_add_epi32(_mm_madd_epi16(xy_hi, ab), _mm_madd_epi16(zw_hi, cd));
+  return _mm_packs_epi32(_mm_sra_epi32(lo, shift), _mm_sra_epi32(hi, shift));
+}
+
+/** (x * a + y * b) >> shift for the interleaved pair xy, packed back to 16 bit */
+static inline __m128i jpeg_dot2_sse2(__m128i xy_lo, __m128i xy_hi, __m128i ab, __m128i shift)
+{
+  return _mm_packs_epi32(_mm_sra_epi32(_mm_madd_epi16(xy_lo, ab), shift),
+                         _mm_sra_epi32(_mm_madd_epi16(xy_hi, ab), shift));
+}
+
+/**
+ * One dimensional DCT of 8 vectors, element wise (so 8 DCTs at once)
+ * @param[in,out] *v The 8 input vectors, replaced by the 8 coefficient vectors
+ * @param[in] dc_shift The shift of the DC and middle coefficient
+ * @param[in] ac_shift The shift of the other coefficients
+ */
+static inline void jpeg_dct_pass_sse2(__m128i *v, int dc_shift, int ac_shift)
+{
+  __m128i dc = _mm_cvtsi32_si128(dc_shift);
+  __m128i ac = _mm_cvtsi32_si128(ac_shift);
+
+  __m128i x8 = _mm_add_epi16(v[0], v[7]);
+  __m128i x0 = _mm_sub_epi16(v[0], v[7]);
+  __m128i x7 = _mm_add_epi16(v[1], v[6]);
+  __m128i x1 = _mm_sub_epi16(v[1], v[6]);
+  __m128i x6 = _mm_add_epi16(v[2], v[5]);
+  __m128i x2 = _mm_sub_epi16(v[2], v[5]);
+  __m128i x5 = _mm_add_epi16(v[3], v[4]);
+  __m128i x3 = _mm_sub_epi16(v[3], v[4]);
+
+  __m128i x4 = _mm_add_epi16(x8, x5);
+  x8 = _mm_sub_epi16(x8, x5);
+  x5 = _mm_add_epi16(x7, x6);
+  x7 = _mm_sub_epi16(x7, x6);
+
+  v[0] = _mm_sra_epi16(_mm_add_epi16(x4, x5), dc);
+  v[4] = _mm_sra_epi16(_mm_sub_epi16(x4, x5), dc);
+
+  __m128i x87_lo = _mm_unpacklo_epi16(x8, x7);
+  __m128i x87_hi = _mm_unpackhi_epi16(x8, x7);
+  v[2] = jpeg_dot2_sse2(x87_lo, x87_hi, JPEG_SSE2_PAIR(JPEG_C2, JPEG_C6), ac);
+  v[6] = jpeg_dot2_sse2(x87_lo, x87_hi, JPEG_SSE2_PAIR(JPEG_C6, -JPEG_C2), ac);
+
+  __m128i x01_lo = _mm_unpacklo_epi16(x0, x1);
+  __m128i x01_hi = _mm_unpackhi_epi16(x0, x1);
+  __m128i x23_lo = _mm_unpacklo_epi16(x2, x3);
+  __m128i x23_hi = _mm_unpackhi_epi16(x2, x3);
+  v[7] = jpeg_dot4_sse2(x01_lo, x01_hi, x23_lo, x23_hi, JPEG_SSE2_PAIR(JPEG_C7, -JPEG_C5),
+                        JPEG_SSE2_PAIR(JPEG_C3, -JPEG_C1), ac);
+  v[5] = jpeg_dot4_sse2(x01_lo, x01_hi, x23_lo, x23_hi, JPEG_SSE2_PAIR(JPEG_C5, -JPEG_C1),
+                        JPEG_SSE2_PAIR(JPEG_C7, JPEG_C3), ac);
+  v[3] = jpeg_dot4_sse2(x01_lo, x01_hi, x23_lo, x23_hi, JPEG_SSE2_PAIR(JPEG_C3, -JPEG_C7),
+                        JPEG_SSE2_PAIR(-JPEG_C1, -JPEG_C5), ac);
+  v[1] = jpeg_dot4_sse2(x01_lo, x01_hi, x23_lo, x23_hi, JPEG_SSE2_PAIR(JPEG_C1, JPEG_C3),
+                        JPEG_SSE2_PAIR(JPEG_C5, JPEG_C7), ac);
+}
+
+/* Level shift, DCT and quantization of one block(8x8) with SSE2, gives the same result as the scalar code */
+static void jpeg_transform(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, int16_t *data, uint16_t *quant_table_ptr)
+{
+  __m128i v[8];
+  int16_t coeff[64] __attribute__((aligned(16)));
+  const __m128i offset = _mm_set1_epi16(128);
+
+  for (uint8_t i = 0; i < 8; i++) {
+    v[i] = _mm_sub_epi16(_mm_loadu_si128((__m128i *)(data + i * 8)), offset);
+  }
+
+  // Row DCTs on the columns of the transposed block, then the column DCTs on the rows
+  jpeg_transpose_sse2(v);
+  jpeg_dct_pass_sse2(v, 0, 10);
+  jpeg_transpose_sse2(v);
+  jpeg_dct_pass_sse2(v, 3, 13);
+
+  // (data * q + 0x4000) >> 15 where q is split in two halves which fit in a signed 16 bit value
+  const __m128i round = _mm_set1_epi32(0x4000);
+  for (uint8_t i = 0; i < 8; i++) {
+    __m128i q = _mm_loadu_si128((__m128i *)(quant_table_ptr + i * 8));
+    __m128i qb = _mm_srli_epi16(q, 1);
+    __m128i qa = _mm_sub_epi16(q, qb);
+    __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(v[i], v[i]), _mm_unpacklo_epi16(qa, qb));
+    __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(v[i], v[i]), _mm_unpackhi_epi16(qa, qb));
+    lo = _mm_srai_epi32(_mm_add_epi32(lo, round), 15);
+    hi = _mm_srai_epi32(_mm_add_epi32(hi, round), 15);
+    _mm_store_si128((__m128i *)(coeff + i * 8), _mm_packs_epi32(lo, hi));
+  }
+
+  for (uint8_t i = 0; i < 64; i++) {
+    jpeg_encoder_structure->Temp [zigzag_table [i]] = coeff[i];
+  }
+}
+
+#elif JPEG_NEON
+/** Transpose an 8x8 block of 16 bit values */
+static inline void jpeg_transpose_neon(int16x8_t *r)
+{
+  int16x8x2_t a0 = vtrnq_s16(r[0], r[1]);
+  int16x8x2_t a1 = vtrnq_s16(r[2], r[3]);
+  int16x8x2_t a2 = vtrnq_s16(r[4], r[5]);
+  int16x8x2_t a3 = vtrnq_s16(r[6], r[7]);
+
+  int32x4x2_t b0 = vtrnq_s32(vreinterpretq_s32_s16(a0.val[0]), vreinterpretq_s32_s16(a1.val[0]));
+  int32x4x2_t b1 = vtrnq_s32(vreinterpretq_s32_s16(a0.val[1]), vreinterpretq_s32_s16(a1.val[1]));
+  int32x4x2_t b2 = vtrnq_s32(vreinterpretq_s32_s16(a2.val[0]), vreinterpretq_s32_s16(a3.val[0]));
+  int32x4x2_t b3 = vtrnq_s32(vreinterpretq_s32_s16(a2.val[1]), vreinterpretq_s32_s16(a3.val[1]));
+
+  r[0] = vcombine_s16(vreinterpret_s16_s32(vget_low_s32(b0.val[0])), vreinterpret_s16_s32(vget_low_s32(b2.val[0])));
+  r[4] = vcombine_s16(vreinterpret_s16_s32(vget_high_s32(b0.val[0])), vreinterpret_s16_s32(vget_high_s32(b2.val[0])));
+  r[1] = vcombine_s16(vreinterpret_s16_s32(vget_low_s32(b1.val[0])), vreinterpret_s16_s32(vget_low_s32(b3.val[0])));
+  r[5] = vcombine_s16(vreinterpret_s16_s32(vget_high_s32(b1.val[0])), vreinterpret_s16_s32(vget_high_s32(b3.val[0])));
+  r[2] = vcombine_s16(vreinterpret_s16_s32(vget_low_s32(b0.val[1])), vreinterpret_s16_s32(vget_low_s32(b2.val[1])));
+  r[6] = vcombine_s16(vreinterpret_s16_s32(vget_high_s32(b0.val[1])), vreinterpret_s16_s32(vget_high_s32(b2.val[1])));
+  r[3] = vcombine_s16(vreinterpret_s16_s32(vget_low_s32(b1.val[1])), vreinterpret_s16_s32(vget_low_s32(b3.val[1])));
+  r[7] = vcombine_s16(vreinterpret_s16_s32(vget_high_s32(b1.val[1])), vreinterpret_s16_s32(vget_high_s32(b3.val[1])));
+}
+
+/** (x * a + y * b) >> shift, narrowed back to 16 bit */
+static inline int16x8_t jpeg_dot2_neon(int16x8_t x, int16x8_t y, int16_t a, int16_t b, int32x4_t shift)
+{
+  int32x4_t lo = vmlal_n_s16(vmull_n_s16(vget_low_s16(x), a), vget_low_s16(y), b);
+  int32x4_t hi = vmlal_n_s16(vmull_n_s16(vget_high_s16(x), a), vget_high_s16(y), b);
+  return vcombine_s16(vmovn_s32(vshlq_s32(lo, shift)), vmovn_s32(vshlq_s32(hi, shift)));
+}
+
+/** (x * a + y * b + z * c + w * d) >> shift, narrowed back to 16 bit */
+static inline int16x8_t jpeg_dot4_neon(int16x8_t x, int16x8_t y, int16x8_t z, int16x8_t w, int16_t a, int16_t b,
+                                       int16_t c, int16_t d, int32x4_t shift)
+{
+  int32x4_t lo = vmull_n_s16(vget_low_s16(x), a);
+  lo = vmlal_n_s16(lo, vget_low_s16(y), b);
+  lo = vmlal_n_s16(lo, vget_low_s16(z), c);
+  lo = vmlal_n_s16(lo, vget_low_s16(w), d);
+  int32x4_t hi = vmull_n_s16(vget_high_s16(x), a);
+  hi = vmlal_n_s16(hi, vget_high_s16(y), b);
+  hi = vmlal_n_s16(hi, vget_high_s16(z), c);
+  hi = vmlal_n_s16(hi, vget_high_s16(w), d);
+  return vcombine_s16(vmovn_s32(vshlq_s32(lo, shift)), vmovn_s32(vshlq_s32(hi, shift)));
+}
+
+/**
+ * One dimensional DCT of 8 vectors, element wise (so 8 DCTs at once)
+ * @param[in,out] *v The 8 input vectors, replaced by the 8 coefficient vectors
+ * @param[in] dc_shift The shift of the DC and middle coefficient
+ * @param[in] ac_shift The shift of the other coefficients
+ */
+static inline void jpeg_dct_pass_neon(int16x8_t *v, int16_t dc_shift, int32_t ac_shift)
+{
+  int16x8_t dc = vdupq_n_s16(-dc_shift);
+  int32x4_t ac = vdupq_n_s32(-ac_shift);
+
+  int16x8_t x8 = vaddq_s16(v[0], v[7]);
+  int16x8_t x0 = vsubq_s16(v[0], v[7]);
+  int16x8_t x7 = vaddq_s16(v[1], v[6]);
+  int16x8_t x1 = vsubq_s16(v[1], v[6]);
+  int16x8_t x6 = vaddq_s16(v[2], v[5]);
+  int16x8_t x2 = vsubq_s16(v[2], v[5]);
+  int16x8_t x5 = vaddq_s16(v[3], v[4]);
+  int16x8_t x3 = vsubq_s16(v[3], v[4]);
+
+  int16x8_t x4 = vaddq_s16(x8, x5);
+  x8 = vsubq_s16(x8, x5);
+  x5 = vaddq_s16(x7, x6);
+  x7 = vsubq_s16(x7, x6);
+
+  v[0] = vshlq_s16(vaddq_s16(x4, x5), dc);
+  v[4] = vshlq_s16(vsubq_s16(x4, x5), dc);
+
+  v[2] = jpeg_dot2_neon(x8, x7, JPEG_C2, JPEG_C6, ac);
+  v[6] = jpeg_dot2_neon(x8, x7, JPEG_C6, -JPEG_C2, ac);
+
+  v[7] = jpeg_dot4_neon(x0, x1, x2, x3, JPEG_C7, -JPEG_C5, JPEG_C3, -JPEG_C1, ac);
+  v[5] = jpeg_dot4_neon(x0, x1, x2, x3, JPEG_C5, -JPEG_C1, JPEG_C7, JPEG_C3, ac);
+  v[3] = jpeg_dot4_neon(x0, x1, x2, x3, JPEG_C3, -JPEG_C7, -JPEG_C1, -JPEG_C5, ac);
+  v[1] = jpeg_dot4_neon(x0, x1, x2, x3, JPEG_C1, JPEG_C3, JPEG_C5, JPEG_C7, ac);
+}
+
+/* Level shift, DCT and quantization of one block(8x8) with NEON, gives the same result as the scalar code */
+static void jpeg_transform(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, int16_t *data, uint16_t *quant_table_ptr)
+{
+  int16x8_t v[8];
+  int16_t coeff[64] __attribute__((aligned(16)));
+  const int16x8_t offset = vdupq_n_s16(128);
+
+  for (uint8_t i = 0; i < 8; i++) {
+    v[i] = vsubq_s16(vld1q_s16(data + i * 8), offset);
+  }
+
+  // Row DCTs on the columns of the transposed block, then the column DCTs on the rows
+  jpeg_transpose_neon(v);
+  jpeg_dct_pass_neon(v, 0, 10);
+  jpeg_transpose_neon(v);
+  jpeg_dct_pass_neon(v, 3, 13);
+
+  // (data * q + 0x4000) >> 15, with the quantization value up to 0x8000 as unsigned
+  for (uint8_t i = 0; i < 8; i++) {
+    uint16x8_t q = vld1q_u16(quant_table_ptr + i * 8);
+    int32x4_t lo = vmulq_s32(vmovl_s16(vget_low_s16(v[i])), vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(q))));
+    int32x4_t hi = vmulq_s32(vmovl_s16(vget_high_s16(v[i])), vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(q))));
+    lo = vshrq_n_s32(vaddq_s32(lo, vdupq_n_s32(0x4000)), 15);
+    hi = vshrq_n_s32(vaddq_s32(hi, vdupq_n_s32(0x4000)), 15);
+    vst1q_s16(coeff + i * 8, vcombine_s16(vmovn_s32(lo), vmovn_s32(hi)));
+  }
+
+  for (uint8_t i = 0; i < 64; i++) {
+    jpeg_encoder_structure->Temp [zigzag_table [i]] = coeff[i];
+  }
+}
+
+#else
+/* Level shift, DCT and quantization of one block(8x8) */
+static void jpeg_transform(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, int16_t *data, uint16_t *quant_table_ptr)
+{
+  jpeg_levelshift(data);
+  jpeg_DCT(data);
+  jpeg_quantization(jpeg_encoder_structure, data, quant_table_ptr);
+}
+
 /* Level shifting to get 8 bit SIGNED values for the data  */
 static void jpeg_levelshift(int16_t *const data)
 {
@@ -514,12 +1051,12 @@ static void jpeg_DCT(int16_t *data)
   uint16_t i;
   int32_t x0, x1, x2, x3, x4, x5, x6, x7, x8;
 
-  static const uint16_t c1 = 1420;  // cos PI/16 * root(2)
-  static const uint16_t c2 = 1338;  // cos PI/8 * root(2)
-  static const uint16_t c3 = 1204;  // cos 3PI/16 * root(2)
-  static const uint16_t c5 = 805;   // cos 5PI/16 * root(2)
-  static const uint16_t c6 = 554;   // cos 3PI/8 * root(2)
-  static const uint16_t c7 = 283;   // cos 7PI/16 * root(2)
+  static const uint16_t c1 = JPEG_C1;
+  static const uint16_t c2 = JPEG_C2;
+  static const uint16_t c3 = JPEG_C3;
+  static const uint16_t c5 = JPEG_C5;
+  static const uint16_t c6 = JPEG_C6;
+  static const uint16_t c7 = JPEG_C7;
 
   static const uint16_t s1 = 3;
   static const uint16_t s2 = 10;
@@ -593,6 +1130,7 @@ static void jpeg_DCT(int16_t *data)
     data++;
   }
 }
+#endif /* JPEG_NEON / JPEG_SSE2 */
 
 #define PUTBITS    \
   {    \
@@ -714,34 +1252,30 @@ static uint8_t *jpeg_huffman(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, uin
   return output_ptr;
 }
 
-/* For bit Stuffing and EOI marker */
-static uint8_t *jpeg_close_bitstream(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, uint8_t *output_ptr)
+/* For bit Stuffing at the end of an entropy coded segment, the last byte is padded with 1-bits */
+static uint8_t *jpeg_flush_bitstream(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, uint8_t *output_ptr)
 {
   uint16_t i, count;
-  uint8_t *ptr;
+  uint32_t code;
 
   if (jpeg_encoder_structure->bitindex > 0) {
-    jpeg_encoder_structure->lcode <<= (32 - jpeg_encoder_structure->bitindex);
-    //for (i=0; i<bitindex; i++)
-    //    lcode |= (0x00000001 << i);
+    code = (jpeg_encoder_structure->lcode << (32 - jpeg_encoder_structure->bitindex))
+           | (0xFFFFFFFF >> jpeg_encoder_structure->bitindex);
 
     count = (jpeg_encoder_structure->bitindex + 7) >> 3;
 
-    ptr = (uint8_t *) &jpeg_encoder_structure->lcode + 3;
-
     for (i = 0; i < count; i++)
-      if ((*output_ptr++ = *ptr--) == 0xff) {
+      if ((*output_ptr++ = (uint8_t)(code >> (24 - 8 * i))) == 0xff) {
         *output_ptr++ = 0;
       }
   }
 
-  // End of image marker
-  *output_ptr++ = 0xFF;
-  *output_ptr++ = 0xD9;
+  jpeg_encoder_structure->lcode = 0;
+  jpeg_encoder_structure->bitindex = 0;
   return output_ptr;
 }
 
-static uint8_t *jpeg_write_markers(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, uint8_t *output_ptr, uint32_t image_format, uint32_t image_width, uint32_t image_height)
+static uint8_t *jpeg_write_markers(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, uint8_t *output_ptr, uint32_t image_format, uint32_t image_width, uint32_t image_height, uint16_t restart_interval)
 {
   uint16_t i, header_length;
   uint8_t number_of_components;
@@ -845,6 +1379,16 @@ static uint8_t *jpeg_write_markers(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structur
   }
 
 
+  // Define restart interval(DRI)
+  if (restart_interval > 0) {
+    *output_ptr++ = 0xFF;
+    *output_ptr++ = 0xDD;
+    *output_ptr++ = 0x00;
+    *output_ptr++ = 0x04;
+    *output_ptr++ = (uint8_t)(restart_interval >> 8);
+    *output_ptr++ = (uint8_t) restart_interval;
+  }
+
   // Scan header(SOF)
 
   // Start of scan marker
@@ -928,6 +1472,7 @@ static uint8_t *jpeg_write_markers(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structur
   }
 }*/
 
+#if !JPEG_NEON && !JPEG_SSE2
 /* multiply DCT Coefficients with Quantization table and store in ZigZag location */
 static void jpeg_quantization(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, int16_t *const data, uint16_t *const quant_table_ptr)
 {
@@ -941,6 +1486,7 @@ static void jpeg_quantization(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, in
     jpeg_encoder_structure->Temp [zigzag_table [i]] = (int16_t) value;
   }
 }
+#endif
 
 static void jpeg_read_400_format(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, uint8_t *input_ptr)
 {
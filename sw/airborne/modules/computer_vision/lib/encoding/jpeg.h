@@ -31,9 +31,16 @@
 #define FOUR_FOUR_FOUR          3
 #define RGB                     4
 
+/* Amount of threads used by the encoder, can be lowered at runtime (up to JPEG_NUM_THREADS) */
+extern uint8_t jpeg_num_threads;
+
 /* JPEG encode an image */
 void jpeg_encode_image(struct image_t *in, struct image_t *out, uint32_t quality_factor, bool add_dri_header);
 
+/* JPEG encode an image split in restart intervals of restart_rows MCU rows, returns the interval in MCUs */
+uint16_t jpeg_encode_image_restart(struct image_t *in, struct image_t *out, uint32_t quality_factor,
+                                   bool add_dri_header, uint16_t restart_rows);
+
 /* Create an SVS header */
 int jpeg_create_svs_header(unsigned char *buf, int32_t size, int w);
 
@@ -28,12 +28,39 @@
 #include <stdint.h>
 #include <string.h>
 #include <sys/time.h>
+#include <time.h>
 
 #include "rtp.h"
 
+/** Maximum JPEG payload per packet */
+#ifndef RTP_MAX_PACKET_SIZE
+#define RTP_MAX_PACKET_SIZE 1400
+#endif
+
+/** Amount of packets prepared and sent with one system call */
+#ifndef RTP_BURST_PACKETS
+#define RTP_BURST_PACKETS 16
+#endif
+
+/**
+ * Maximum bitrate in kbit/s of one frame. The bursts of a frame are spread over time so the
+ * (Wi-Fi) transmit queue does not overflow (0 = no pacing, send the frame as fast as possible)
+ */
+#ifndef RTP_MAX_BITRATE
+#define RTP_MAX_BITRATE 0
+#endif
+
+#define KRtpHeaderSize 12           // size of the RTP header
+#define KJpegHeaderSize 8           // size of the special JPEG payload header
+#define KRestartHeaderSize 4        // size of the restart marker header
+#define KMaxHeaderSize (KRtpHeaderSize + KJpegHeaderSize + KRestartHeaderSize)
+
 static void rtp_packet_send(struct UdpSocket *udp, uint8_t *Jpeg, int JpegLen, uint16_t m_SequenceNumber,
                             uint32_t m_Timestamp, uint32_t m_offset, uint8_t marker_bit, int w, int h, uint8_t format_code, uint8_t quality_code,
-                            uint8_t has_dri_header);
+                            uint16_t restart_interval);
+static uint8_t rtp_header_fill(uint8_t *RtpBuf, uint16_t m_SequenceNumber, uint32_t m_Timestamp, uint32_t m_offset,
+                               uint8_t marker_bit, int w, int h, uint8_t format_code, uint8_t quality_code,
+                               uint16_t restart_interval);
 
 /*
  * RTP Protocol documentation
@@ -115,45 +142,75 @@ void rtp_frame_test(struct UdpSocket *udp)
 
 /**
  * Send an RTP frame
+ * The packet headers of a burst are prepared in one go and sent together with the payload,
+ * which is not copied, with a single system call.
  * @param[in] *udp The UDP connection to send the frame over
  * @param[in] *img The image to send over the RTP connection
  * @param[in] format_code 0 for YUV422 and 1 for YUV421
  * @param[in] quality_code The JPEG encoding quality
- * @param[in] has_dri_header Whether we have an DRI header or not
+ * @param[in] restart_interval The JPEG restart interval in MCUs (0 if the image has no restart markers)
  * @param[in] frame_time Time image was taken in usec (if set to 0 or less it is calculated)
  * @param[out] packet_number The frame number of the rtp stream
  * @param[out] rtp_time_counter The frame time counter of the rtp stream
  */
 void rtp_frame_send(struct UdpSocket *udp, struct image_t *img, uint8_t format_code,
-                    uint8_t quality_code, uint8_t has_dri_header, float average_frame_rate, uint16_t *packet_number, uint32_t *rtp_time_counter)
+                    uint8_t quality_code, uint16_t restart_interval, float average_frame_rate, uint16_t *packet_number, uint32_t *rtp_time_counter)
 {
+  uint8_t headers[RTP_BURST_PACKETS][KMaxHeaderSize];
+  struct iovec iov[RTP_BURST_PACKETS * 2];
   uint32_t offset = 0;
   uint32_t jpeg_size = img->buf_size;
   uint8_t *jpeg_ptr = img->buf;
 
   *rtp_time_counter += ((uint32_t) (90000.0f / average_frame_rate));
 
-#define MAX_PACKET_SIZE 1400
+#if RTP_MAX_BITRATE > 0
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+#endif
+
+  // Split frame into packets, sent in bursts
+  while (jpeg_size > 0) {
+    uint16_t cnt = 0;
+
+    for (; cnt < RTP_BURST_PACKETS && jpeg_size > 0; cnt++) {
+      uint32_t len = RTP_MAX_PACKET_SIZE;
+      uint8_t lastpacket = 0;
 
-  // Split frame into packets
-  for (; jpeg_size > 0;) {
-    uint32_t len = MAX_PACKET_SIZE;
-    uint8_t lastpacket = 0;
+      if (jpeg_size <= len) {
+        lastpacket = 1;
+        len = jpeg_size;
+      }
 
-    if (jpeg_size <= len) {
-      lastpacket = 1;
-      len = jpeg_size;
+      iov[cnt * 2].iov_base = headers[cnt];
+      iov[cnt * 2].iov_len = rtp_header_fill(headers[cnt], *packet_number, *rtp_time_counter, offset, lastpacket,
+                                             img->w, img->h, format_code, quality_code, restart_interval);
+      iov[cnt * 2 + 1].iov_base = jpeg_ptr;
+      iov[cnt * 2 + 1].iov_len = len;
+
+      (*packet_number)++;
+      jpeg_size -= len;
+      jpeg_ptr  += len;
+      offset    += len;
     }
 
-    rtp_packet_send(udp, jpeg_ptr, len, *packet_number, *rtp_time_counter, offset, lastpacket, img->w, img->h, format_code,
-                    quality_code, has_dri_header);
+    udp_socket_send_batch(udp, iov, 2, cnt, true);
 
-    (*packet_number)++;
-    jpeg_size -= len;
-    jpeg_ptr  += len;
-    offset    += len;
+#if RTP_MAX_BITRATE > 0
+    // Wait until the bytes sent so far fit in the maximum bitrate
+    if (jpeg_size > 0) {
+      uint64_t wait_ns = (uint64_t)offset * 8000000ULL / RTP_MAX_BITRATE;
+      struct timespec until = start;
+      until.tv_sec += wait_ns / 1000000000ULL;
+      until.tv_nsec += wait_ns % 1000000000ULL;
+      if (until.tv_nsec >= 1000000000L) {
+        until.tv_sec++;
+        until.tv_nsec -= 1000000000L;
+      }
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL);
+    }
+#endif
   }
-
 }
 
 /*
@@ -172,7 +229,7 @@ void rtp_frame_send(struct UdpSocket *udp, struct image_t *img, uint8_t format_c
  * @param[in] h The height of the image
  * @param[in] format_code 0 for YUV422 and 1 for YUV421
  * @param[in] quality_code The JPEG encoding quality
- * @param[in] has_dri_header Whether we have an DRI header or not
+ * @param[in] restart_interval The JPEG restart interval in MCUs (0 if the image has no restart markers)
  */
 static void rtp_packet_send(
   struct UdpSocket *udp,
@@ -181,17 +238,37 @@ static void rtp_packet_send(
   uint32_t m_offset, uint8_t marker_bit,
   int w, int h,
   uint8_t format_code, uint8_t quality_code,
-  uint8_t has_dri_header)
+  uint16_t restart_interval)
 {
+  uint8_t header[KMaxHeaderSize];
+  struct iovec iov[2];
 
-#define KRtpHeaderSize 12           // size of the RTP header
-#define KJpegHeaderSize 8           // size of the special JPEG payload header
-
-  uint8_t     RtpBuf[2048];
-  int         RtpPacketSize = JpegLen + KRtpHeaderSize + KJpegHeaderSize;
-
-  memset(RtpBuf, 0x00, sizeof(RtpBuf));
+  iov[0].iov_base = header;
+  iov[0].iov_len = rtp_header_fill(header, m_SequenceNumber, m_Timestamp, m_offset, marker_bit, w, h, format_code,
+                                   quality_code, restart_interval);
+  iov[1].iov_base = Jpeg;
+  iov[1].iov_len = JpegLen;
+  udp_socket_send_batch(udp, iov, 2, 1, true);
+}
 
+/**
+ * Fill the RTP and JPEG payload headers of a packet
+ * @param[out] *RtpBuf The header buffer (at least KMaxHeaderSize bytes)
+ * @param[in] m_SequenceNumber RTP sequence number
+ * @param[in] m_Timestamp Time counter: RTP requires monolitically lineraly increasing timecount. FMT26 uses 90kHz clock.
+ * @param[in] m_offset 3 byte fragmentation offset for fragmented images
+ * @param[in] marker_bit RTP marker bit: must be set in last packet of a frame.
+ * @param[in] w The width of the JPEG image
+ * @param[in] h The height of the image
+ * @param[in] format_code 0 for YUV422 and 1 for YUV421
+ * @param[in] quality_code The JPEG encoding quality
+ * @param[in] restart_interval The JPEG restart interval in MCUs (0 if the image has no restart markers)
+ * @return The size of the headers
+ */
+static uint8_t rtp_header_fill(uint8_t *RtpBuf, uint16_t m_SequenceNumber, uint32_t m_Timestamp, uint32_t m_offset,
+                               uint8_t marker_bit, int w, int h, uint8_t format_code, uint8_t quality_code,
+                               uint16_t restart_interval)
+{
   /*
    The RTP header has the following format:
 
@@ -241,17 +318,28 @@ static void rtp_packet_send(
   RtpBuf[13] = (m_offset & 0x00FF0000) >> 16;      // 3 byte fragmentation offset for fragmented images
   RtpBuf[14] = (m_offset & 0x0000FF00) >> 8;
   RtpBuf[15] = (m_offset & 0x000000FF);
-  RtpBuf[16] = 0x00;                             // type: 0 422 or 1 421
-  RtpBuf[17] = 60;                               // quality scale factor
   RtpBuf[16] = format_code;                      // type: 0 422 or 1 421
-  if (has_dri_header) {
-    RtpBuf[16] |= 0x40;  // DRI flag
+  if (restart_interval > 0) {
+    RtpBuf[16] |= 0x40;  // Restart marker header follows
   }
   RtpBuf[17] = quality_code;                     // quality scale factor
   RtpBuf[18] = w / 8;                            // width  / 8 -> 48 pixel
   RtpBuf[19] = h / 8;                            // height / 8 -> 32 pixel
-  // append the JPEG scan data to the RTP buffer
-  memcpy(&RtpBuf[20], Jpeg, JpegLen);
 
-  udp_socket_send_dontwait(udp, RtpBuf, RtpPacketSize);
-};
+  /* Restart marker header (only for types 64-127):
+
+    0                   1                   2                   3
+    0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   |       Restart Interval        |F|L|       Restart Count       |
+   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   */
+  if (restart_interval > 0) {
+    RtpBuf[20] = restart_interval >> 8;
+    RtpBuf[21] = restart_interval & 0xFF;
+    RtpBuf[22] = 0xFF;                           // F = L = 1 and count 0x3FFF: packets are not aligned
+    RtpBuf[23] = 0xFF;                           // to the restart intervals
+  }
+
+  return (restart_interval > 0) ? KMaxHeaderSize : KRtpHeaderSize + KJpegHeaderSize;
+}
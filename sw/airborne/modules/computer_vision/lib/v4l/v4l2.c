@@ -317,6 +317,8 @@ struct v4l2_device *v4l2_init(char *device_name, struct img_size_t size, struct
   dev->w = size.w;
   dev->h = size.h;
   dev->buffers_cnt = req.count;
+  // Keep one buffer for the capture thread and one in the driver queue besides the one being processed
+  dev->buffers_held_max = (req.count > 3) ? req.count - 3 : 0;
   dev->buffers = buffers;
   return dev;
 }
@@ -343,6 +345,8 @@ void v4l2_image_get(struct v4l2_device *dev, struct image_t *img)
       if (dev->buffers_deq_idx != V4L2_IMG_NONE) {
         img_idx = dev->buffers_deq_idx;
         dev->buffers_deq_idx = V4L2_IMG_NONE;
+        dev->buffers[img_idx].refs = 1;
+        dev->buffers_held++;
       }
 
       pthread_mutex_unlock(&dev->mutex);
@@ -377,6 +381,8 @@ bool v4l2_image_get_nonblock(struct v4l2_device *dev, struct image_t *img)
   if (dev->buffers_deq_idx != V4L2_IMG_NONE) {
     img_idx = dev->buffers_deq_idx;
     dev->buffers_deq_idx = V4L2_IMG_NONE;
+    dev->buffers[img_idx].refs = 1;
+    dev->buffers_held++;
   }
   pthread_mutex_unlock(&dev->mutex);
 
@@ -397,9 +403,44 @@ bool v4l2_image_get_nonblock(struct v4l2_device *dev, struct image_t *img)
   }
 }
 
+/**
+ * Add a reference to an image buffer which was dequeued with v4l2_image_get() (Thread safe)
+ * This allows sharing the memory mapped buffer with other threads without copying it.
+ * Every reference must be released with v4l2_image_free(), the buffer is only enqueued
+ * again after the last reference is released.
+ * Fails when the image is not a buffer of this device, or when sharing it would exceed
+ * the maximum amount of held buffers (buffers_held_max).
+ * @param[in] *dev The video for linux device which the image is from
+ * @param[in] *img The image to reference
+ * @return Whether the reference was taken
+ */
+bool v4l2_image_ref(struct v4l2_device *dev, struct image_t *img)
+{
+  bool ok = false;
+
+  // Only buffers from this device can be referenced
+  if (img->buf_idx >= dev->buffers_cnt || img->buf != dev->buffers[img->buf_idx].buf) {
+    return false;
+  }
+
+  pthread_mutex_lock(&dev->mutex);
+  struct v4l2_img_buf *buf = &dev->buffers[img->buf_idx];
+
+  // A buffer which is not yet shared counts for the budget
+  if (buf->refs > 1 || (buf->refs == 1 && dev->buffers_held <= dev->buffers_held_max)) {
+    buf->refs++;
+    ok = true;
+  }
+  pthread_mutex_unlock(&dev->mutex);
+
+  return ok;
+}
+
 /**
  * Free the image and enqueue the buffer (Thread safe)
- * This must be done after processing the image, because else all buffers are locked
+ * This must be done after processing the image, because else all buffers are locked.
+ * When the image is shared with v4l2_image_ref() only the reference is released and the
+ * buffer is enqueued when the last user frees it.
  * @param[in] *dev The video for linux device which the image is from
  * @param[in] *img The image to free
  */
@@ -407,6 +448,18 @@ void v4l2_image_free(struct v4l2_device *dev, struct image_t *img)
 {
   struct v4l2_buffer buf;
 
+  // Release the reference and only enqueue when nobody is using it anymore
+  pthread_mutex_lock(&dev->mutex);
+  struct v4l2_img_buf *img_buf = &dev->buffers[img->buf_idx];
+  if (img_buf->refs > 1) {
+    img_buf->refs--;
+    pthread_mutex_unlock(&dev->mutex);
+    return;
+  }
+  img_buf->refs = 0;
+  dev->buffers_held--;
+  pthread_mutex_unlock(&dev->mutex);
+
   // Enqueue the buffer
   CLEAR(buf);
   buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
@@ -437,8 +490,10 @@ bool v4l2_start_capture(struct v4l2_device *dev)
 
   // Enqueue all buffers
   dev->buffers_deq_idx = V4L2_IMG_NONE;
+  dev->buffers_held = 0;
   for (i = 0; i < dev->buffers_cnt; ++i) {
     struct v4l2_buffer buf;
+    dev->buffers[i].refs = 0;
 
     CLEAR(buf);
     buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
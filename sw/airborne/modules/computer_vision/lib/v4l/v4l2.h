@@ -43,6 +43,7 @@ struct v4l2_img_buf {
   struct timeval timestamp;   ///< The time value of the image
   uint32_t pprz_timestamp;    ///< The time of the image in us since system startup
   void *buf;                  ///< Pointer to the memory mapped buffer
+  uint8_t refs;               ///< Amount of users holding this buffer (enqueued again when it reaches 0)
 };
 
 /* V4L2 device */
@@ -54,7 +55,9 @@ struct v4l2_device {
   uint16_t h;                       ///< The height of the image
   uint8_t buffers_cnt;              ///< The number of image buffers
   volatile uint8_t buffers_deq_idx; ///< The current dequeued index
-  pthread_mutex_t mutex;            ///< Mutex lock for enqueue/dequeue of buffers (change the deq_idx)
+  uint8_t buffers_held;             ///< The number of buffers currently held by users
+  uint8_t buffers_held_max;         ///< The maximum number of buffers that can be shared with v4l2_image_ref()
+  pthread_mutex_t mutex;            ///< Mutex lock for enqueue/dequeue of buffers (change the deq_idx and refs)
   struct v4l2_img_buf *buffers;     ///< The memory mapped image buffers
 };
 
@@ -64,6 +67,7 @@ struct v4l2_device *v4l2_init(char *device_name, struct img_size_t size, struct
                               uint32_t _pixelformat);
 void v4l2_image_get(struct v4l2_device *dev, struct image_t *img);
 bool v4l2_image_get_nonblock(struct v4l2_device *dev, struct image_t *img);
+bool v4l2_image_ref(struct v4l2_device *dev, struct image_t *img);
 void v4l2_image_free(struct v4l2_device *dev, struct image_t *img);
 bool v4l2_start_capture(struct v4l2_device *dev);
 bool v4l2_stop_capture(struct v4l2_device *dev);
@@ -34,7 +34,34 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdlib.h>
 #include "fast_rosten.h"
 
+/** Maximum amount of threads (including the calling thread) used for the FAST9 detection */
+#ifndef FAST9_NUM_THREADS
+#define FAST9_NUM_THREADS 1
+#endif
+
+/** Amount of horizontal bands the image is split into when detecting with multiple threads */
+#ifndef FAST9_NUM_BANDS
+#define FAST9_NUM_BANDS (2 * FAST9_NUM_THREADS)
+#endif
+
+/** Smallest region (in pixels) for which the detection is split over the threads */
+#ifndef FAST9_THREADED_MIN_PIXELS
+#define FAST9_THREADED_MIN_PIXELS 32768
+#endif
+
+/** Amount of threads used, can be lowered at runtime (1 == single threaded) */
+uint8_t fast9_num_threads = FAST9_NUM_THREADS;
+
 static void fast_make_offsets(int32_t *pixel, uint16_t row_stride, uint8_t pixel_size);
+static int fast9_test_pixel(const uint8_t *p, const int *pixel, uint8_t threshold);
+
+#if FAST9_NUM_THREADS > 1
+#include <pthread.h>
+
+static void fast9_detect_threaded(struct image_t *img, uint8_t threshold, uint16_t min_dist, uint16_t x_start,
+                                  uint16_t x_end, uint16_t y_start, uint16_t y_end, uint16_t *num_corners,
+                                  uint16_t *ret_corners_length, struct point_t **ret_corners);
+#endif
 
 /**
  * Do a FAST9 corner detection. The array *ret_corners can be reallocated in this function every time
@@ -49,3610 +76,91 @@ static void fast_make_offsets(int32_t *pixel, uint16_t row_stride, uint8_t pixel
  * @param[in] **ret_corners pointer to the array which contains the corners that were detected.
  * @param[in] *roi array of format [x0 y0 x1 y1] describing the region of interest in the image where the corners will be detected. If null, the whole image is used.
 */
-void fast9_detect(struct image_t *img, uint8_t threshold, uint16_t min_dist, uint16_t x_padding, uint16_t y_padding, uint16_t *num_corners, uint16_t *ret_corners_length, struct point_t **ret_corners, uint16_t *roi)
-{
-
-  uint16_t corner_cnt = *num_corners;
-  int pixel[16];
-  int16_t i;
-  uint16_t x, y, x_min, x_max, y_min, x_start, x_end, y_start, y_end;
-  uint8_t need_skip;
-  // Set the pixel size
-  uint8_t pixel_size = 1;
-  if (img->type == IMAGE_YUV422) {
-    pixel_size = 2;
-  }
-
-  if(x_padding < min_dist) x_padding = min_dist;
-  if(y_padding < min_dist) y_padding = min_dist;
-
-  if (!roi) {
-    x_start = 3 + x_padding;
-    y_start = 3 + y_padding;
-    x_end = img->w - 3 - x_padding;
-    y_end = img->h - 3 - y_padding;
-  } else {
-    x_start = roi[0] > 0 ? roi[0] : 3 + x_padding;
-    y_start = roi[1] > 0 ? roi[1] : 3 + y_padding;
-    x_end = roi[2] < (img->w - 3 - x_padding) ? roi[2] : img->w - 3 - x_padding;
-    y_end = roi[3] < (img->h - 3 - y_padding) ? roi[3] : img->h - 3 - y_padding;
-
-  }
-
-  // Calculate the pixel offsets
-  fast_make_offsets(pixel, img->w, pixel_size);
-
-  // Go trough all the pixels (minus the borders and inside the requested roi)
-  for (y = y_start; y < y_end; y++) {
-
-    if (min_dist > 0) { y_min = y - min_dist; }
-
-    for (x = x_start; x < x_end; x++) {
-      // First check if we aren't in range vertical (TODO: fix less intensive way)
-      if (min_dist > 0) {
-
-        need_skip = 0;
-
-        x_min = x - min_dist;
-        x_max = x + min_dist;
-
-
-        // Go through the previous corners until y goes out of range
-        i = corner_cnt - 1;
-        while (i >= 0) {
-
-          // corners are stored with increasing y,
-          // so if we go from the last to the first, then their y-coordinate will go out of range
-          if ((*ret_corners)[i].y < y_min) {
-            break;
-          }
-
-          if (x_min < (*ret_corners)[i].x && (*ret_corners)[i].x < x_max) {
-            need_skip = 1;
-            break;
-          }
-
-          i--;
-        }
-
-        // Skip the box if we found a pixel nearby
-        if (need_skip) {
-          x += min_dist;
-          continue;
-        }
-      }
-
-      // Calculate the threshold values
-      const uint8_t *p = ((uint8_t *)img->buf) + y * img->w * pixel_size + x * pixel_size + pixel_size / 2;
-      int16_t cb = *p + threshold;
-      int16_t c_b = *p - threshold;
-
-      // Do the checks if it is a corner
-      if (p[pixel[0]] > cb)
-        if (p[pixel[1]] > cb)
-          if (p[pixel[2]] > cb)
-            if (p[pixel[3]] > cb)
-              if (p[pixel[4]] > cb)
-                if (p[pixel[5]] > cb)
-                  if (p[pixel[6]] > cb)
-                    if (p[pixel[7]] > cb)
-                      if (p[pixel[8]] > cb)
-                      {}
-                      else if (p[pixel[15]] > cb)
-                      {}
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[7]] < c_b)
-                      if (p[pixel[14]] > cb)
-                        if (p[pixel[15]] > cb)
-                        {}
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[14]] < c_b)
-                        if (p[pixel[8]] < c_b)
-                          if (p[pixel[9]] < c_b)
-                            if (p[pixel[10]] < c_b)
-                              if (p[pixel[11]] < c_b)
-                                if (p[pixel[12]] < c_b)
-                                  if (p[pixel[13]] < c_b)
-                                    if (p[pixel[15]] < c_b)
-                                    {}
-                                    else {
-                                      continue;
-                                    }
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[14]] > cb)
-                      if (p[pixel[15]] > cb)
-                      {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[6]] < c_b)
-                    if (p[pixel[15]] > cb)
-                      if (p[pixel[13]] > cb)
-                        if (p[pixel[14]] > cb)
-                        {}
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[13]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                            if (p[pixel[9]] < c_b)
-                              if (p[pixel[10]] < c_b)
-                                if (p[pixel[11]] < c_b)
-                                  if (p[pixel[12]] < c_b)
-                                    if (p[pixel[14]] < c_b)
-                                    {}
-                                    else {
-                                      continue;
-                                    }
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[7]] < c_b)
-                      if (p[pixel[8]] < c_b)
-                        if (p[pixel[9]] < c_b)
-                          if (p[pixel[10]] < c_b)
-                            if (p[pixel[11]] < c_b)
-                              if (p[pixel[12]] < c_b)
-                                if (p[pixel[13]] < c_b)
-                                  if (p[pixel[14]] < c_b)
-                                  {}
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[13]] > cb)
-                    if (p[pixel[14]] > cb)
-                      if (p[pixel[15]] > cb)
-                      {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[13]] < c_b)
-                    if (p[pixel[7]] < c_b)
-                      if (p[pixel[8]] < c_b)
-                        if (p[pixel[9]] < c_b)
-                          if (p[pixel[10]] < c_b)
-                            if (p[pixel[11]] < c_b)
-                              if (p[pixel[12]] < c_b)
-                                if (p[pixel[14]] < c_b)
-                                  if (p[pixel[15]] < c_b)
-                                  {}
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[5]] < c_b)
-                  if (p[pixel[14]] > cb)
-                    if (p[pixel[12]] > cb)
-                      if (p[pixel[13]] > cb)
-                        if (p[pixel[15]] > cb)
-                        {}
-                        else if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                            if (p[pixel[8]] > cb)
-                              if (p[pixel[9]] > cb)
-                                if (p[pixel[10]] > cb)
-                                  if (p[pixel[11]] > cb)
-                                  {}
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[12]] < c_b)
-                      if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                            if (p[pixel[9]] < c_b)
-                              if (p[pixel[10]] < c_b)
-                                if (p[pixel[11]] < c_b)
-                                  if (p[pixel[13]] < c_b)
-                                  {}
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[14]] < c_b)
-                    if (p[pixel[7]] < c_b)
-                      if (p[pixel[8]] < c_b)
-                        if (p[pixel[9]] < c_b)
-                          if (p[pixel[10]] < c_b)
-                            if (p[pixel[11]] < c_b)
-                              if (p[pixel[12]] < c_b)
-                                if (p[pixel[13]] < c_b)
-                                  if (p[pixel[6]] < c_b)
-                                  {}
-                                  else if (p[pixel[15]] < c_b)
-                                  {}
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[6]] < c_b)
-                    if (p[pixel[7]] < c_b)
-                      if (p[pixel[8]] < c_b)
-                        if (p[pixel[9]] < c_b)
-                          if (p[pixel[10]] < c_b)
-                            if (p[pixel[11]] < c_b)
-                              if (p[pixel[12]] < c_b)
-                                if (p[pixel[13]] < c_b)
-                                {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[12]] > cb)
-                  if (p[pixel[13]] > cb)
-                    if (p[pixel[14]] > cb)
-                      if (p[pixel[15]] > cb)
-                      {}
-                      else if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                            if (p[pixel[9]] > cb)
-                              if (p[pixel[10]] > cb)
-                                if (p[pixel[11]] > cb)
-                                {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[12]] < c_b)
-                  if (p[pixel[7]] < c_b)
-                    if (p[pixel[8]] < c_b)
-                      if (p[pixel[9]] < c_b)
-                        if (p[pixel[10]] < c_b)
-                          if (p[pixel[11]] < c_b)
-                            if (p[pixel[13]] < c_b)
-                              if (p[pixel[14]] < c_b)
-                                if (p[pixel[6]] < c_b)
-                                {}
-                                else if (p[pixel[15]] < c_b)
-                                {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else if (p[pixel[4]] < c_b)
-                if (p[pixel[13]] > cb)
-                  if (p[pixel[11]] > cb)
-                    if (p[pixel[12]] > cb)
-                      if (p[pixel[14]] > cb)
-                        if (p[pixel[15]] > cb)
-                        {}
-                        else if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                            if (p[pixel[8]] > cb)
-                              if (p[pixel[9]] > cb)
-                                if (p[pixel[10]] > cb)
-                                {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[5]] > cb)
-                        if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                            if (p[pixel[8]] > cb)
-                              if (p[pixel[9]] > cb)
-                                if (p[pixel[10]] > cb)
-                                {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[11]] < c_b)
-                    if (p[pixel[5]] < c_b)
-                      if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                            if (p[pixel[9]] < c_b)
-                              if (p[pixel[10]] < c_b)
-                                if (p[pixel[12]] < c_b)
-                                {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[13]] < c_b)
-                  if (p[pixel[7]] < c_b)
-                    if (p[pixel[8]] < c_b)
-                      if (p[pixel[9]] < c_b)
-                        if (p[pixel[10]] < c_b)
-                          if (p[pixel[11]] < c_b)
-                            if (p[pixel[12]] < c_b)
-                              if (p[pixel[6]] < c_b)
-                                if (p[pixel[5]] < c_b)
-                                {}
-                                else if (p[pixel[14]] < c_b)
-                                {}
-                                else {
-                                  continue;
-                                }
-                              else if (p[pixel[14]] < c_b)
-                                if (p[pixel[15]] < c_b)
-                                {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[5]] < c_b)
-                  if (p[pixel[6]] < c_b)
-                    if (p[pixel[7]] < c_b)
-                      if (p[pixel[8]] < c_b)
-                        if (p[pixel[9]] < c_b)
-                          if (p[pixel[10]] < c_b)
-                            if (p[pixel[11]] < c_b)
-                              if (p[pixel[12]] < c_b)
-                              {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else if (p[pixel[11]] > cb)
-                if (p[pixel[12]] > cb)
-                  if (p[pixel[13]] > cb)
-                    if (p[pixel[14]] > cb)
-                      if (p[pixel[15]] > cb)
-                      {}
-                      else if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                            if (p[pixel[9]] > cb)
-                              if (p[pixel[10]] > cb)
-                              {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[5]] > cb)
-                      if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                            if (p[pixel[9]] > cb)
-                              if (p[pixel[10]] > cb)
-                              {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else if (p[pixel[11]] < c_b)
-                if (p[pixel[7]] < c_b)
-                  if (p[pixel[8]] < c_b)
-                    if (p[pixel[9]] < c_b)
-                      if (p[pixel[10]] < c_b)
-                        if (p[pixel[12]] < c_b)
-                          if (p[pixel[13]] < c_b)
-                            if (p[pixel[6]] < c_b)
-                              if (p[pixel[5]] < c_b)
-                              {}
-                              else if (p[pixel[14]] < c_b)
-                              {}
-                              else {
-                                continue;
-                              }
-                            else if (p[pixel[14]] < c_b)
-                              if (p[pixel[15]] < c_b)
-                              {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else if (p[pixel[3]] < c_b)
-              if (p[pixel[10]] > cb)
-                if (p[pixel[11]] > cb)
-                  if (p[pixel[12]] > cb)
-                    if (p[pixel[13]] > cb)
-                      if (p[pixel[14]] > cb)
-                        if (p[pixel[15]] > cb)
-                        {}
-                        else if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                            if (p[pixel[8]] > cb)
-                              if (p[pixel[9]] > cb)
-                              {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[5]] > cb)
-                        if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                            if (p[pixel[8]] > cb)
-                              if (p[pixel[9]] > cb)
-                              {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[4]] > cb)
-                      if (p[pixel[5]] > cb)
-                        if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                            if (p[pixel[8]] > cb)
-                              if (p[pixel[9]] > cb)
-                              {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else if (p[pixel[10]] < c_b)
-                if (p[pixel[7]] < c_b)
-                  if (p[pixel[8]] < c_b)
-                    if (p[pixel[9]] < c_b)
-                      if (p[pixel[11]] < c_b)
-                        if (p[pixel[6]] < c_b)
-                          if (p[pixel[5]] < c_b)
-                            if (p[pixel[4]] < c_b)
-                            {}
-                            else if (p[pixel[12]] < c_b)
-                              if (p[pixel[13]] < c_b)
-                              {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else if (p[pixel[12]] < c_b)
-                            if (p[pixel[13]] < c_b)
-                              if (p[pixel[14]] < c_b)
-                              {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else if (p[pixel[12]] < c_b)
-                          if (p[pixel[13]] < c_b)
-                            if (p[pixel[14]] < c_b)
-                              if (p[pixel[15]] < c_b)
-                              {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else if (p[pixel[10]] > cb)
-              if (p[pixel[11]] > cb)
-                if (p[pixel[12]] > cb)
-                  if (p[pixel[13]] > cb)
-                    if (p[pixel[14]] > cb)
-                      if (p[pixel[15]] > cb)
-                      {}
-                      else if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                            if (p[pixel[9]] > cb)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[5]] > cb)
-                      if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                            if (p[pixel[9]] > cb)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[4]] > cb)
-                    if (p[pixel[5]] > cb)
-                      if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                            if (p[pixel[9]] > cb)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else if (p[pixel[10]] < c_b)
-              if (p[pixel[7]] < c_b)
-                if (p[pixel[8]] < c_b)
-                  if (p[pixel[9]] < c_b)
-                    if (p[pixel[11]] < c_b)
-                      if (p[pixel[12]] < c_b)
-                        if (p[pixel[6]] < c_b)
-                          if (p[pixel[5]] < c_b)
-                            if (p[pixel[4]] < c_b)
-                            {}
-                            else if (p[pixel[13]] < c_b)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else if (p[pixel[13]] < c_b)
-                            if (p[pixel[14]] < c_b)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else if (p[pixel[13]] < c_b)
-                          if (p[pixel[14]] < c_b)
-                            if (p[pixel[15]] < c_b)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else if (p[pixel[2]] < c_b)
-            if (p[pixel[9]] > cb)
-              if (p[pixel[10]] > cb)
-                if (p[pixel[11]] > cb)
-                  if (p[pixel[12]] > cb)
-                    if (p[pixel[13]] > cb)
-                      if (p[pixel[14]] > cb)
-                        if (p[pixel[15]] > cb)
-                        {}
-                        else if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                            if (p[pixel[8]] > cb)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[5]] > cb)
-                        if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                            if (p[pixel[8]] > cb)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[4]] > cb)
-                      if (p[pixel[5]] > cb)
-                        if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                            if (p[pixel[8]] > cb)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[3]] > cb)
-                    if (p[pixel[4]] > cb)
-                      if (p[pixel[5]] > cb)
-                        if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                            if (p[pixel[8]] > cb)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else if (p[pixel[9]] < c_b)
-              if (p[pixel[7]] < c_b)
-                if (p[pixel[8]] < c_b)
-                  if (p[pixel[10]] < c_b)
-                    if (p[pixel[6]] < c_b)
-                      if (p[pixel[5]] < c_b)
-                        if (p[pixel[4]] < c_b)
-                          if (p[pixel[3]] < c_b)
-                          {}
-                          else if (p[pixel[11]] < c_b)
-                            if (p[pixel[12]] < c_b)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else if (p[pixel[11]] < c_b)
-                          if (p[pixel[12]] < c_b)
-                            if (p[pixel[13]] < c_b)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[11]] < c_b)
-                        if (p[pixel[12]] < c_b)
-                          if (p[pixel[13]] < c_b)
-                            if (p[pixel[14]] < c_b)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[11]] < c_b)
-                      if (p[pixel[12]] < c_b)
-                        if (p[pixel[13]] < c_b)
-                          if (p[pixel[14]] < c_b)
-                            if (p[pixel[15]] < c_b)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else if (p[pixel[9]] > cb)
-            if (p[pixel[10]] > cb)
-              if (p[pixel[11]] > cb)
-                if (p[pixel[12]] > cb)
-                  if (p[pixel[13]] > cb)
-                    if (p[pixel[14]] > cb)
-                      if (p[pixel[15]] > cb)
-                      {}
-                      else if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[5]] > cb)
-                      if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[4]] > cb)
-                    if (p[pixel[5]] > cb)
-                      if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[3]] > cb)
-                  if (p[pixel[4]] > cb)
-                    if (p[pixel[5]] > cb)
-                      if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else if (p[pixel[9]] < c_b)
-            if (p[pixel[7]] < c_b)
-              if (p[pixel[8]] < c_b)
-                if (p[pixel[10]] < c_b)
-                  if (p[pixel[11]] < c_b)
-                    if (p[pixel[6]] < c_b)
-                      if (p[pixel[5]] < c_b)
-                        if (p[pixel[4]] < c_b)
-                          if (p[pixel[3]] < c_b)
-                          {}
-                          else if (p[pixel[12]] < c_b)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else if (p[pixel[12]] < c_b)
-                          if (p[pixel[13]] < c_b)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[12]] < c_b)
-                        if (p[pixel[13]] < c_b)
-                          if (p[pixel[14]] < c_b)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[12]] < c_b)
-                      if (p[pixel[13]] < c_b)
-                        if (p[pixel[14]] < c_b)
-                          if (p[pixel[15]] < c_b)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else {
-            continue;
-          }
-        else if (p[pixel[1]] < c_b)
-          if (p[pixel[8]] > cb)
-            if (p[pixel[9]] > cb)
-              if (p[pixel[10]] > cb)
-                if (p[pixel[11]] > cb)
-                  if (p[pixel[12]] > cb)
-                    if (p[pixel[13]] > cb)
-                      if (p[pixel[14]] > cb)
-                        if (p[pixel[15]] > cb)
-                        {}
-                        else if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[5]] > cb)
-                        if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[4]] > cb)
-                      if (p[pixel[5]] > cb)
-                        if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[3]] > cb)
-                    if (p[pixel[4]] > cb)
-                      if (p[pixel[5]] > cb)
-                        if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[2]] > cb)
-                  if (p[pixel[3]] > cb)
-                    if (p[pixel[4]] > cb)
-                      if (p[pixel[5]] > cb)
-                        if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else if (p[pixel[8]] < c_b)
-            if (p[pixel[7]] < c_b)
-              if (p[pixel[9]] < c_b)
-                if (p[pixel[6]] < c_b)
-                  if (p[pixel[5]] < c_b)
-                    if (p[pixel[4]] < c_b)
-                      if (p[pixel[3]] < c_b)
-                        if (p[pixel[2]] < c_b)
-                        {}
-                        else if (p[pixel[10]] < c_b)
-                          if (p[pixel[11]] < c_b)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[10]] < c_b)
-                        if (p[pixel[11]] < c_b)
-                          if (p[pixel[12]] < c_b)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[10]] < c_b)
-                      if (p[pixel[11]] < c_b)
-                        if (p[pixel[12]] < c_b)
-                          if (p[pixel[13]] < c_b)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[10]] < c_b)
-                    if (p[pixel[11]] < c_b)
-                      if (p[pixel[12]] < c_b)
-                        if (p[pixel[13]] < c_b)
-                          if (p[pixel[14]] < c_b)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[10]] < c_b)
-                  if (p[pixel[11]] < c_b)
-                    if (p[pixel[12]] < c_b)
-                      if (p[pixel[13]] < c_b)
-                        if (p[pixel[14]] < c_b)
-                          if (p[pixel[15]] < c_b)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else {
-            continue;
-          }
-        else if (p[pixel[8]] > cb)
-          if (p[pixel[9]] > cb)
-            if (p[pixel[10]] > cb)
-              if (p[pixel[11]] > cb)
-                if (p[pixel[12]] > cb)
-                  if (p[pixel[13]] > cb)
-                    if (p[pixel[14]] > cb)
-                      if (p[pixel[15]] > cb)
-                      {}
-                      else if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                        {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[5]] > cb)
-                      if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                        {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[4]] > cb)
-                    if (p[pixel[5]] > cb)
-                      if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                        {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[3]] > cb)
-                  if (p[pixel[4]] > cb)
-                    if (p[pixel[5]] > cb)
-                      if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                        {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else if (p[pixel[2]] > cb)
-                if (p[pixel[3]] > cb)
-                  if (p[pixel[4]] > cb)
-                    if (p[pixel[5]] > cb)
-                      if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                        {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else {
-            continue;
-          }
-        else if (p[pixel[8]] < c_b)
-          if (p[pixel[7]] < c_b)
-            if (p[pixel[9]] < c_b)
-              if (p[pixel[10]] < c_b)
-                if (p[pixel[6]] < c_b)
-                  if (p[pixel[5]] < c_b)
-                    if (p[pixel[4]] < c_b)
-                      if (p[pixel[3]] < c_b)
-                        if (p[pixel[2]] < c_b)
-                        {}
-                        else if (p[pixel[11]] < c_b)
-                        {}
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[11]] < c_b)
-                        if (p[pixel[12]] < c_b)
-                        {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[11]] < c_b)
-                      if (p[pixel[12]] < c_b)
-                        if (p[pixel[13]] < c_b)
-                        {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[11]] < c_b)
-                    if (p[pixel[12]] < c_b)
-                      if (p[pixel[13]] < c_b)
-                        if (p[pixel[14]] < c_b)
-                        {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[11]] < c_b)
-                  if (p[pixel[12]] < c_b)
-                    if (p[pixel[13]] < c_b)
-                      if (p[pixel[14]] < c_b)
-                        if (p[pixel[15]] < c_b)
-                        {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else {
-            continue;
-          }
-        else {
-          continue;
-        }
-      else if (p[pixel[0]] < c_b)
-        if (p[pixel[1]] > cb)
-          if (p[pixel[8]] > cb)
-            if (p[pixel[7]] > cb)
-              if (p[pixel[9]] > cb)
-                if (p[pixel[6]] > cb)
-                  if (p[pixel[5]] > cb)
-                    if (p[pixel[4]] > cb)
-                      if (p[pixel[3]] > cb)
-                        if (p[pixel[2]] > cb)
-                        {}
-                        else if (p[pixel[10]] > cb)
-                          if (p[pixel[11]] > cb)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[10]] > cb)
-                        if (p[pixel[11]] > cb)
-                          if (p[pixel[12]] > cb)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[10]] > cb)
-                      if (p[pixel[11]] > cb)
-                        if (p[pixel[12]] > cb)
-                          if (p[pixel[13]] > cb)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[10]] > cb)
-                    if (p[pixel[11]] > cb)
-                      if (p[pixel[12]] > cb)
-                        if (p[pixel[13]] > cb)
-                          if (p[pixel[14]] > cb)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[10]] > cb)
-                  if (p[pixel[11]] > cb)
-                    if (p[pixel[12]] > cb)
-                      if (p[pixel[13]] > cb)
-                        if (p[pixel[14]] > cb)
-                          if (p[pixel[15]] > cb)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else if (p[pixel[8]] < c_b)
-            if (p[pixel[9]] < c_b)
-              if (p[pixel[10]] < c_b)
-                if (p[pixel[11]] < c_b)
-                  if (p[pixel[12]] < c_b)
-                    if (p[pixel[13]] < c_b)
-                      if (p[pixel[14]] < c_b)
-                        if (p[pixel[15]] < c_b)
-                        {}
-                        else if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[5]] < c_b)
-                        if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[4]] < c_b)
-                      if (p[pixel[5]] < c_b)
-                        if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[3]] < c_b)
-                    if (p[pixel[4]] < c_b)
-                      if (p[pixel[5]] < c_b)
-                        if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[2]] < c_b)
-                  if (p[pixel[3]] < c_b)
-                    if (p[pixel[4]] < c_b)
-                      if (p[pixel[5]] < c_b)
-                        if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else {
-            continue;
-          }
-        else if (p[pixel[1]] < c_b)
-          if (p[pixel[2]] > cb)
-            if (p[pixel[9]] > cb)
-              if (p[pixel[7]] > cb)
-                if (p[pixel[8]] > cb)
-                  if (p[pixel[10]] > cb)
-                    if (p[pixel[6]] > cb)
-                      if (p[pixel[5]] > cb)
-                        if (p[pixel[4]] > cb)
-                          if (p[pixel[3]] > cb)
-                          {}
-                          else if (p[pixel[11]] > cb)
-                            if (p[pixel[12]] > cb)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else if (p[pixel[11]] > cb)
-                          if (p[pixel[12]] > cb)
-                            if (p[pixel[13]] > cb)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[11]] > cb)
-                        if (p[pixel[12]] > cb)
-                          if (p[pixel[13]] > cb)
-                            if (p[pixel[14]] > cb)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[11]] > cb)
-                      if (p[pixel[12]] > cb)
-                        if (p[pixel[13]] > cb)
-                          if (p[pixel[14]] > cb)
-                            if (p[pixel[15]] > cb)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else if (p[pixel[9]] < c_b)
-              if (p[pixel[10]] < c_b)
-                if (p[pixel[11]] < c_b)
-                  if (p[pixel[12]] < c_b)
-                    if (p[pixel[13]] < c_b)
-                      if (p[pixel[14]] < c_b)
-                        if (p[pixel[15]] < c_b)
-                        {}
-                        else if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                            if (p[pixel[8]] < c_b)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[5]] < c_b)
-                        if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                            if (p[pixel[8]] < c_b)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[4]] < c_b)
-                      if (p[pixel[5]] < c_b)
-                        if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                            if (p[pixel[8]] < c_b)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[3]] < c_b)
-                    if (p[pixel[4]] < c_b)
-                      if (p[pixel[5]] < c_b)
-                        if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                            if (p[pixel[8]] < c_b)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else if (p[pixel[2]] < c_b)
-            if (p[pixel[3]] > cb)
-              if (p[pixel[10]] > cb)
-                if (p[pixel[7]] > cb)
-                  if (p[pixel[8]] > cb)
-                    if (p[pixel[9]] > cb)
-                      if (p[pixel[11]] > cb)
-                        if (p[pixel[6]] > cb)
-                          if (p[pixel[5]] > cb)
-                            if (p[pixel[4]] > cb)
-                            {}
-                            else if (p[pixel[12]] > cb)
-                              if (p[pixel[13]] > cb)
-                              {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else if (p[pixel[12]] > cb)
-                            if (p[pixel[13]] > cb)
-                              if (p[pixel[14]] > cb)
-                              {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else if (p[pixel[12]] > cb)
-                          if (p[pixel[13]] > cb)
-                            if (p[pixel[14]] > cb)
-                              if (p[pixel[15]] > cb)
-                              {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else if (p[pixel[10]] < c_b)
-                if (p[pixel[11]] < c_b)
-                  if (p[pixel[12]] < c_b)
-                    if (p[pixel[13]] < c_b)
-                      if (p[pixel[14]] < c_b)
-                        if (p[pixel[15]] < c_b)
-                        {}
-                        else if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                            if (p[pixel[8]] < c_b)
-                              if (p[pixel[9]] < c_b)
-                              {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[5]] < c_b)
-                        if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                            if (p[pixel[8]] < c_b)
-                              if (p[pixel[9]] < c_b)
-                              {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[4]] < c_b)
-                      if (p[pixel[5]] < c_b)
-                        if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                            if (p[pixel[8]] < c_b)
-                              if (p[pixel[9]] < c_b)
-                              {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else if (p[pixel[3]] < c_b)
-              if (p[pixel[4]] > cb)
-                if (p[pixel[13]] > cb)
-                  if (p[pixel[7]] > cb)
-                    if (p[pixel[8]] > cb)
-                      if (p[pixel[9]] > cb)
-                        if (p[pixel[10]] > cb)
-                          if (p[pixel[11]] > cb)
-                            if (p[pixel[12]] > cb)
-                              if (p[pixel[6]] > cb)
-                                if (p[pixel[5]] > cb)
-                                {}
-                                else if (p[pixel[14]] > cb)
-                                {}
-                                else {
-                                  continue;
-                                }
-                              else if (p[pixel[14]] > cb)
-                                if (p[pixel[15]] > cb)
-                                {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[13]] < c_b)
-                  if (p[pixel[11]] > cb)
-                    if (p[pixel[5]] > cb)
-                      if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                            if (p[pixel[9]] > cb)
-                              if (p[pixel[10]] > cb)
-                                if (p[pixel[12]] > cb)
-                                {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[11]] < c_b)
-                    if (p[pixel[12]] < c_b)
-                      if (p[pixel[14]] < c_b)
-                        if (p[pixel[15]] < c_b)
-                        {}
-                        else if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                            if (p[pixel[8]] < c_b)
-                              if (p[pixel[9]] < c_b)
-                                if (p[pixel[10]] < c_b)
-                                {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[5]] < c_b)
-                        if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                            if (p[pixel[8]] < c_b)
-                              if (p[pixel[9]] < c_b)
-                                if (p[pixel[10]] < c_b)
-                                {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[5]] > cb)
-                  if (p[pixel[6]] > cb)
-                    if (p[pixel[7]] > cb)
-                      if (p[pixel[8]] > cb)
-                        if (p[pixel[9]] > cb)
-                          if (p[pixel[10]] > cb)
-                            if (p[pixel[11]] > cb)
-                              if (p[pixel[12]] > cb)
-                              {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else if (p[pixel[4]] < c_b)
-                if (p[pixel[5]] > cb)
-                  if (p[pixel[14]] > cb)
-                    if (p[pixel[7]] > cb)
-                      if (p[pixel[8]] > cb)
-                        if (p[pixel[9]] > cb)
-                          if (p[pixel[10]] > cb)
-                            if (p[pixel[11]] > cb)
-                              if (p[pixel[12]] > cb)
-                                if (p[pixel[13]] > cb)
-                                  if (p[pixel[6]] > cb)
-                                  {}
-                                  else if (p[pixel[15]] > cb)
-                                  {}
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[14]] < c_b)
-                    if (p[pixel[12]] > cb)
-                      if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                            if (p[pixel[9]] > cb)
-                              if (p[pixel[10]] > cb)
-                                if (p[pixel[11]] > cb)
-                                  if (p[pixel[13]] > cb)
-                                  {}
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[12]] < c_b)
-                      if (p[pixel[13]] < c_b)
-                        if (p[pixel[15]] < c_b)
-                        {}
-                        else if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                            if (p[pixel[8]] < c_b)
-                              if (p[pixel[9]] < c_b)
-                                if (p[pixel[10]] < c_b)
-                                  if (p[pixel[11]] < c_b)
-                                  {}
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[6]] > cb)
-                    if (p[pixel[7]] > cb)
-                      if (p[pixel[8]] > cb)
-                        if (p[pixel[9]] > cb)
-                          if (p[pixel[10]] > cb)
-                            if (p[pixel[11]] > cb)
-                              if (p[pixel[12]] > cb)
-                                if (p[pixel[13]] > cb)
-                                {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[5]] < c_b)
-                  if (p[pixel[6]] > cb)
-                    if (p[pixel[15]] < c_b)
-                      if (p[pixel[13]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                            if (p[pixel[9]] > cb)
-                              if (p[pixel[10]] > cb)
-                                if (p[pixel[11]] > cb)
-                                  if (p[pixel[12]] > cb)
-                                    if (p[pixel[14]] > cb)
-                                    {}
-                                    else {
-                                      continue;
-                                    }
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[13]] < c_b)
-                        if (p[pixel[14]] < c_b)
-                        {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[7]] > cb)
-                      if (p[pixel[8]] > cb)
-                        if (p[pixel[9]] > cb)
-                          if (p[pixel[10]] > cb)
-                            if (p[pixel[11]] > cb)
-                              if (p[pixel[12]] > cb)
-                                if (p[pixel[13]] > cb)
-                                  if (p[pixel[14]] > cb)
-                                  {}
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[6]] < c_b)
-                    if (p[pixel[7]] > cb)
-                      if (p[pixel[14]] > cb)
-                        if (p[pixel[8]] > cb)
-                          if (p[pixel[9]] > cb)
-                            if (p[pixel[10]] > cb)
-                              if (p[pixel[11]] > cb)
-                                if (p[pixel[12]] > cb)
-                                  if (p[pixel[13]] > cb)
-                                    if (p[pixel[15]] > cb)
-                                    {}
-                                    else {
-                                      continue;
-                                    }
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[14]] < c_b)
-                        if (p[pixel[15]] < c_b)
-                        {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[7]] < c_b)
-                      if (p[pixel[8]] < c_b)
-                      {}
-                      else if (p[pixel[15]] < c_b)
-                      {}
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[14]] < c_b)
-                      if (p[pixel[15]] < c_b)
-                      {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[13]] > cb)
-                    if (p[pixel[7]] > cb)
-                      if (p[pixel[8]] > cb)
-                        if (p[pixel[9]] > cb)
-                          if (p[pixel[10]] > cb)
-                            if (p[pixel[11]] > cb)
-                              if (p[pixel[12]] > cb)
-                                if (p[pixel[14]] > cb)
-                                  if (p[pixel[15]] > cb)
-                                  {}
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[13]] < c_b)
-                    if (p[pixel[14]] < c_b)
-                      if (p[pixel[15]] < c_b)
-                      {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[12]] > cb)
-                  if (p[pixel[7]] > cb)
-                    if (p[pixel[8]] > cb)
-                      if (p[pixel[9]] > cb)
-                        if (p[pixel[10]] > cb)
-                          if (p[pixel[11]] > cb)
-                            if (p[pixel[13]] > cb)
-                              if (p[pixel[14]] > cb)
-                                if (p[pixel[6]] > cb)
-                                {}
-                                else if (p[pixel[15]] > cb)
-                                {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[12]] < c_b)
-                  if (p[pixel[13]] < c_b)
-                    if (p[pixel[14]] < c_b)
-                      if (p[pixel[15]] < c_b)
-                      {}
-                      else if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                            if (p[pixel[9]] < c_b)
-                              if (p[pixel[10]] < c_b)
-                                if (p[pixel[11]] < c_b)
-                                {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else if (p[pixel[11]] > cb)
-                if (p[pixel[7]] > cb)
-                  if (p[pixel[8]] > cb)
-                    if (p[pixel[9]] > cb)
-                      if (p[pixel[10]] > cb)
-                        if (p[pixel[12]] > cb)
-                          if (p[pixel[13]] > cb)
-                            if (p[pixel[6]] > cb)
-                              if (p[pixel[5]] > cb)
-                              {}
-                              else if (p[pixel[14]] > cb)
-                              {}
-                              else {
-                                continue;
-                              }
-                            else if (p[pixel[14]] > cb)
-                              if (p[pixel[15]] > cb)
-                              {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else if (p[pixel[11]] < c_b)
-                if (p[pixel[12]] < c_b)
-                  if (p[pixel[13]] < c_b)
-                    if (p[pixel[14]] < c_b)
-                      if (p[pixel[15]] < c_b)
-                      {}
-                      else if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                            if (p[pixel[9]] < c_b)
-                              if (p[pixel[10]] < c_b)
-                              {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[5]] < c_b)
-                      if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                            if (p[pixel[9]] < c_b)
-                              if (p[pixel[10]] < c_b)
-                              {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else if (p[pixel[10]] > cb)
-              if (p[pixel[7]] > cb)
-                if (p[pixel[8]] > cb)
-                  if (p[pixel[9]] > cb)
-                    if (p[pixel[11]] > cb)
-                      if (p[pixel[12]] > cb)
-                        if (p[pixel[6]] > cb)
-                          if (p[pixel[5]] > cb)
-                            if (p[pixel[4]] > cb)
-                            {}
-                            else if (p[pixel[13]] > cb)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else if (p[pixel[13]] > cb)
-                            if (p[pixel[14]] > cb)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else if (p[pixel[13]] > cb)
-                          if (p[pixel[14]] > cb)
-                            if (p[pixel[15]] > cb)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else if (p[pixel[10]] < c_b)
-              if (p[pixel[11]] < c_b)
-                if (p[pixel[12]] < c_b)
-                  if (p[pixel[13]] < c_b)
-                    if (p[pixel[14]] < c_b)
-                      if (p[pixel[15]] < c_b)
-                      {}
-                      else if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                            if (p[pixel[9]] < c_b)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[5]] < c_b)
-                      if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                            if (p[pixel[9]] < c_b)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[4]] < c_b)
-                    if (p[pixel[5]] < c_b)
-                      if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                            if (p[pixel[9]] < c_b)
-                            {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else if (p[pixel[9]] > cb)
-            if (p[pixel[7]] > cb)
-              if (p[pixel[8]] > cb)
-                if (p[pixel[10]] > cb)
-                  if (p[pixel[11]] > cb)
-                    if (p[pixel[6]] > cb)
-                      if (p[pixel[5]] > cb)
-                        if (p[pixel[4]] > cb)
-                          if (p[pixel[3]] > cb)
-                          {}
-                          else if (p[pixel[12]] > cb)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else if (p[pixel[12]] > cb)
-                          if (p[pixel[13]] > cb)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[12]] > cb)
-                        if (p[pixel[13]] > cb)
-                          if (p[pixel[14]] > cb)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[12]] > cb)
-                      if (p[pixel[13]] > cb)
-                        if (p[pixel[14]] > cb)
-                          if (p[pixel[15]] > cb)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else if (p[pixel[9]] < c_b)
-            if (p[pixel[10]] < c_b)
-              if (p[pixel[11]] < c_b)
-                if (p[pixel[12]] < c_b)
-                  if (p[pixel[13]] < c_b)
-                    if (p[pixel[14]] < c_b)
-                      if (p[pixel[15]] < c_b)
-                      {}
-                      else if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[5]] < c_b)
-                      if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[4]] < c_b)
-                    if (p[pixel[5]] < c_b)
-                      if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[3]] < c_b)
-                  if (p[pixel[4]] < c_b)
-                    if (p[pixel[5]] < c_b)
-                      if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                          {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else {
-            continue;
-          }
-        else if (p[pixel[8]] > cb)
-          if (p[pixel[7]] > cb)
-            if (p[pixel[9]] > cb)
-              if (p[pixel[10]] > cb)
-                if (p[pixel[6]] > cb)
-                  if (p[pixel[5]] > cb)
-                    if (p[pixel[4]] > cb)
-                      if (p[pixel[3]] > cb)
-                        if (p[pixel[2]] > cb)
-                        {}
-                        else if (p[pixel[11]] > cb)
-                        {}
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[11]] > cb)
-                        if (p[pixel[12]] > cb)
-                        {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[11]] > cb)
-                      if (p[pixel[12]] > cb)
-                        if (p[pixel[13]] > cb)
-                        {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[11]] > cb)
-                    if (p[pixel[12]] > cb)
-                      if (p[pixel[13]] > cb)
-                        if (p[pixel[14]] > cb)
-                        {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[11]] > cb)
-                  if (p[pixel[12]] > cb)
-                    if (p[pixel[13]] > cb)
-                      if (p[pixel[14]] > cb)
-                        if (p[pixel[15]] > cb)
-                        {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else {
-            continue;
-          }
-        else if (p[pixel[8]] < c_b)
-          if (p[pixel[9]] < c_b)
-            if (p[pixel[10]] < c_b)
-              if (p[pixel[11]] < c_b)
-                if (p[pixel[12]] < c_b)
-                  if (p[pixel[13]] < c_b)
-                    if (p[pixel[14]] < c_b)
-                      if (p[pixel[15]] < c_b)
-                      {}
-                      else if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                        {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[5]] < c_b)
-                      if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                        {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[4]] < c_b)
-                    if (p[pixel[5]] < c_b)
-                      if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                        {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[3]] < c_b)
-                  if (p[pixel[4]] < c_b)
-                    if (p[pixel[5]] < c_b)
-                      if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                        {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else if (p[pixel[2]] < c_b)
-                if (p[pixel[3]] < c_b)
-                  if (p[pixel[4]] < c_b)
-                    if (p[pixel[5]] < c_b)
-                      if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                        {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else {
-            continue;
+void fast9_detect(struct image_t *img, uint8_t threshold, uint16_t min_dist, uint16_t x_padding, uint16_t y_padding, uint16_t *num_corners, uint16_t *ret_corners_length, struct point_t **ret_corners, uint16_t *roi)
+{
+
+  uint16_t corner_cnt = *num_corners;
+  int pixel[16];
+  int16_t i;
+  uint16_t x, y, x_min, x_max, y_min, x_start, x_end, y_start, y_end;
+  uint8_t need_skip;
+  // Set the pixel size
+  uint8_t pixel_size = 1;
+  if (img->type == IMAGE_YUV422) {
+    pixel_size = 2;
+  }
+
+  if(x_padding < min_dist) x_padding = min_dist;
+  if(y_padding < min_dist) y_padding = min_dist;
+
+  if (!roi) {
+    x_start = 3 + x_padding;
+    y_start = 3 + y_padding;
+    x_end = img->w - 3 - x_padding;
+    y_end = img->h - 3 - y_padding;
+  } else {
+    x_start = roi[0] > 0 ? roi[0] : 3 + x_padding;
+    y_start = roi[1] > 0 ? roi[1] : 3 + y_padding;
+    x_end = roi[2] < (img->w - 3 - x_padding) ? roi[2] : img->w - 3 - x_padding;
+    y_end = roi[3] < (img->h - 3 - y_padding) ? roi[3] : img->h - 3 - y_padding;
+
+  }
+
+#if FAST9_NUM_THREADS > 1
+  if (fast9_num_threads > 1 && y_end > y_start + FAST9_NUM_BANDS && x_end > x_start
+      && (uint32_t)(y_end - y_start) * (x_end - x_start) >= FAST9_THREADED_MIN_PIXELS) {
+    fast9_detect_threaded(img, threshold, min_dist, x_start, x_end, y_start, y_end, num_corners, ret_corners_length,
+                          ret_corners);
+    return;
+  }
+#endif
+
+  // Calculate the pixel offsets
+  fast_make_offsets(pixel, img->w, pixel_size);
+
+  // Go trough all the pixels (minus the borders and inside the requested roi)
+  for (y = y_start; y < y_end; y++) {
+
+    if (min_dist > 0) { y_min = y - min_dist; }
+
+    for (x = x_start; x < x_end; x++) {
+      // First check if we aren't in range vertical (TODO: fix less intensive way)
+      if (min_dist > 0) {
+
+        need_skip = 0;
+
+        x_min = x - min_dist;
+        x_max = x + min_dist;
+
+
+        // Go through the previous corners until y goes out of range
+        i = corner_cnt - 1;
+        while (i >= 0) {
+
+          // corners are stored with increasing y,
+          // so if we go from the last to the first, then their y-coordinate will go out of range
+          if ((*ret_corners)[i].y < y_min) {
+            break;
           }
-        else {
-          continue;
-        }
-      else if (p[pixel[7]] > cb)
-        if (p[pixel[8]] > cb)
-          if (p[pixel[9]] > cb)
-            if (p[pixel[6]] > cb)
-              if (p[pixel[5]] > cb)
-                if (p[pixel[4]] > cb)
-                  if (p[pixel[3]] > cb)
-                    if (p[pixel[2]] > cb)
-                      if (p[pixel[1]] > cb)
-                      {}
-                      else if (p[pixel[10]] > cb)
-                      {}
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[10]] > cb)
-                      if (p[pixel[11]] > cb)
-                      {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[10]] > cb)
-                    if (p[pixel[11]] > cb)
-                      if (p[pixel[12]] > cb)
-                      {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[10]] > cb)
-                  if (p[pixel[11]] > cb)
-                    if (p[pixel[12]] > cb)
-                      if (p[pixel[13]] > cb)
-                      {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else if (p[pixel[10]] > cb)
-                if (p[pixel[11]] > cb)
-                  if (p[pixel[12]] > cb)
-                    if (p[pixel[13]] > cb)
-                      if (p[pixel[14]] > cb)
-                      {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else if (p[pixel[10]] > cb)
-              if (p[pixel[11]] > cb)
-                if (p[pixel[12]] > cb)
-                  if (p[pixel[13]] > cb)
-                    if (p[pixel[14]] > cb)
-                      if (p[pixel[15]] > cb)
-                      {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else {
-            continue;
+
+          if (x_min < (*ret_corners)[i].x && (*ret_corners)[i].x < x_max) {
+            need_skip = 1;
+            break;
           }
-        else {
-          continue;
+
+          i--;
         }
-      else if (p[pixel[7]] < c_b)
-        if (p[pixel[8]] < c_b)
-          if (p[pixel[9]] < c_b)
-            if (p[pixel[6]] < c_b)
-              if (p[pixel[5]] < c_b)
-                if (p[pixel[4]] < c_b)
-                  if (p[pixel[3]] < c_b)
-                    if (p[pixel[2]] < c_b)
-                      if (p[pixel[1]] < c_b)
-                      {}
-                      else if (p[pixel[10]] < c_b)
-                      {}
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[10]] < c_b)
-                      if (p[pixel[11]] < c_b)
-                      {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[10]] < c_b)
-                    if (p[pixel[11]] < c_b)
-                      if (p[pixel[12]] < c_b)
-                      {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[10]] < c_b)
-                  if (p[pixel[11]] < c_b)
-                    if (p[pixel[12]] < c_b)
-                      if (p[pixel[13]] < c_b)
-                      {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else if (p[pixel[10]] < c_b)
-                if (p[pixel[11]] < c_b)
-                  if (p[pixel[12]] < c_b)
-                    if (p[pixel[13]] < c_b)
-                      if (p[pixel[14]] < c_b)
-                      {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else if (p[pixel[10]] < c_b)
-              if (p[pixel[11]] < c_b)
-                if (p[pixel[12]] < c_b)
-                  if (p[pixel[13]] < c_b)
-                    if (p[pixel[14]] < c_b)
-                      if (p[pixel[15]] < c_b)
-                      {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else {
-            continue;
-          }
-        else {
+
+        // Skip the box if we found a pixel nearby
+        if (need_skip) {
+          x += min_dist;
           continue;
         }
-      else {
+      }
+
+      // Do the checks if it is a corner
+      const uint8_t *p = ((uint8_t *)img->buf) + y * img->w * pixel_size + x * pixel_size + pixel_size / 2;
+      if (!fast9_test_pixel(p, pixel, threshold)) {
         continue;
       }
 
@@ -3673,6 +181,227 @@ void fast9_detect(struct image_t *img, uint8_t threshold, uint16_t min_dist, uin
   *num_corners = corner_cnt;
 }
 
+#if FAST9_NUM_THREADS > 1
+/**
+ * A horizontal band of the image with the corner candidates found in it
+ */
+struct fast9_band_t {
+  uint16_t y_start;                 ///< First row of the band
+  uint16_t y_end;                   ///< Row after the last row of the band
+  struct point_t *corners;          ///< Corner candidates (not suppressed) in raster order
+  uint32_t corners_cnt;             ///< Amount of corner candidates
+  uint32_t corners_length;          ///< Allocated length of corners
+};
+
+/**
+ * Persistent pool of worker threads for the FAST9 detection
+ */
+struct fast9_pool_t {
+  bool initialized;                 ///< Whether the worker threads are started
+  pthread_t threads[FAST9_NUM_THREADS - 1]; ///< Worker threads, the calling thread also processes bands
+  pthread_mutex_t call_mutex;       ///< Only one detection at a time can use the pool
+  pthread_mutex_t mutex;            ///< Protects the job state below
+  pthread_cond_t work_cond;         ///< Signaled when a new job is available
+  pthread_cond_t done_cond;         ///< Signaled when all bands are processed
+  uint32_t job;                     ///< Job counter, increased for every detection
+  uint8_t next_band;                ///< Next band to process
+  uint8_t bands_done;               ///< Amount of processed bands
+
+  struct image_t *img;              ///< Image of the current job
+  uint8_t threshold;                ///< FAST9 threshold of the current job
+  uint16_t x_start;                 ///< First column to scan
+  uint16_t x_end;                   ///< Column after the last column to scan
+  uint8_t pixel_size;               ///< Bytes per pixel of the image
+  int pixel[16];                    ///< Pixel offsets of the circle
+  struct fast9_band_t bands[FAST9_NUM_BANDS];
+};
+
+static struct fast9_pool_t fast9_pool = {
+  .initialized = false,
+  .call_mutex = PTHREAD_MUTEX_INITIALIZER,
+  .mutex = PTHREAD_MUTEX_INITIALIZER,
+  .work_cond = PTHREAD_COND_INITIALIZER,
+  .done_cond = PTHREAD_COND_INITIALIZER
+};
+
+/**
+ * Find all corner candidates in a band, without minimum distance suppression
+ * @param[in] *pool The pool with the job parameters
+ * @param[in,out] *band The band to process
+ */
+static void fast9_band_detect(struct fast9_pool_t *pool, struct fast9_band_t *band)
+{
+  band->corners_cnt = 0;
+  for (uint16_t y = band->y_start; y < band->y_end; y++) {
+    const uint8_t *row = ((uint8_t *)pool->img->buf) + y * pool->img->w * pool->pixel_size + pool->pixel_size / 2;
+    for (uint16_t x = pool->x_start; x < pool->x_end; x++) {
+      if (!fast9_test_pixel(row + x * pool->pixel_size, pool->pixel, pool->threshold)) {
+        continue;
+      }
+
+      if (band->corners_cnt >= band->corners_length) {
+        band->corners_length = (band->corners_length == 0) ? 256 : band->corners_length * 2;
+        band->corners = realloc(band->corners, sizeof(struct point_t) * band->corners_length);
+      }
+      band->corners[band->corners_cnt].x = x;
+      band->corners[band->corners_cnt].y = y;
+      band->corners_cnt++;
+    }
+  }
+}
+
+/**
+ * Process bands of the current job until all are taken. Must be called with the pool mutex locked.
+ * @param[in] *pool The pool with the current job
+ */
+static void fast9_pool_work(struct fast9_pool_t *pool)
+{
+  while (pool->next_band < FAST9_NUM_BANDS) {
+    struct fast9_band_t *band = &pool->bands[pool->next_band++];
+    pthread_mutex_unlock(&pool->mutex);
+    fast9_band_detect(pool, band);
+    pthread_mutex_lock(&pool->mutex);
+
+    if (++pool->bands_done == FAST9_NUM_BANDS) {
+      pthread_cond_signal(&pool->done_cond);
+    }
+  }
+}
+
+/**
+ * Worker thread of the pool, waits for a new job and helps processing its bands
+ * @param[in] *data The index of the worker
+ */
+static void *fast9_pool_thread(void *data)
+{
+  uint8_t idx = (uint8_t)(uintptr_t)data;
+  uint32_t job = 0;
+
+  pthread_mutex_lock(&fast9_pool.mutex);
+  while (true) {
+    while (fast9_pool.job == job) {
+      pthread_cond_wait(&fast9_pool.work_cond, &fast9_pool.mutex);
+    }
+    job = fast9_pool.job;
+
+    // Only use the amount of threads requested at runtime
+    if (idx + 1 < fast9_num_threads) {
+      fast9_pool_work(&fast9_pool);
+    }
+  }
+  return NULL;
+}
+
+/**
+ * FAST9 detection with the image split in horizontal bands which are processed by a pool of threads.
+ * The bands only find the corner candidates, the minimum distance suppression is done afterwards
+ * in raster order exactly like the single threaded fast9_detect, so the result does not depend on the
+ * amount of threads or bands.
+ */
+static void fast9_detect_threaded(struct image_t *img, uint8_t threshold, uint16_t min_dist, uint16_t x_start,
+                                  uint16_t x_end, uint16_t y_start, uint16_t y_end, uint16_t *num_corners,
+                                  uint16_t *ret_corners_length, struct point_t **ret_corners)
+{
+  struct fast9_pool_t *pool = &fast9_pool;
+  pthread_mutex_lock(&pool->call_mutex);
+
+  // Start the worker threads on the first call
+  if (!pool->initialized) {
+    for (uint8_t i = 0; i < FAST9_NUM_THREADS - 1; i++) {
+      pthread_create(&pool->threads[i], NULL, fast9_pool_thread, (void *)(uintptr_t)i);
+    }
+    pool->initialized = true;
+  }
+
+  // Set up the job and divide the rows over the bands
+  pthread_mutex_lock(&pool->mutex);
+  pool->img = img;
+  pool->threshold = threshold;
+  pool->x_start = x_start;
+  pool->x_end = x_end;
+  pool->pixel_size = (img->type == IMAGE_YUV422) ? 2 : 1;
+  fast_make_offsets(pool->pixel, img->w, pool->pixel_size);
+  for (uint8_t i = 0; i < FAST9_NUM_BANDS; i++) {
+    pool->bands[i].y_start = y_start + (uint32_t)(y_end - y_start) * i / FAST9_NUM_BANDS;
+    pool->bands[i].y_end = y_start + (uint32_t)(y_end - y_start) * (i + 1) / FAST9_NUM_BANDS;
+  }
+  pool->next_band = 0;
+  pool->bands_done = 0;
+  pool->job++;
+  pthread_cond_broadcast(&pool->work_cond);
+
+  // Help processing and wait until all bands are done
+  fast9_pool_work(pool);
+  while (pool->bands_done < FAST9_NUM_BANDS) {
+    pthread_cond_wait(&pool->done_cond, &pool->mutex);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+
+  // Merge the candidates with the minimum distance suppression of fast9_detect. A row is scanned from left to right,
+  // after a detection or a pixel close to a corner of the previous min_dist rows the scan jumps min_dist + 1 pixels.
+  uint16_t corner_cnt = *num_corners;
+  for (uint8_t b = 0; b < FAST9_NUM_BANDS; b++) {
+    struct fast9_band_t *band = &pool->bands[b];
+    uint32_t idx = 0;
+
+    while (idx < band->corners_cnt) {
+      uint16_t y = band->corners[idx].y;
+      uint32_t row_end = idx;
+      while (row_end < band->corners_cnt && band->corners[row_end].y == y) {
+        row_end++;
+      }
+
+      // Previous corners which are checked, until the first one out of range vertically
+      uint16_t prev_start = corner_cnt;
+      uint16_t prev_end = corner_cnt;
+      if (min_dist > 0) {
+        while (prev_start > 0 && (*ret_corners)[prev_start - 1].y >= (uint32_t)(y - min_dist)) {
+          prev_start--;
+        }
+      }
+
+      int32_t x = x_start;
+      while (idx < row_end) {
+        int32_t cx = band->corners[idx].x;
+        if (cx < x) {
+          idx++;
+          continue;
+        }
+
+        // First pixel from x on which is close to a previous corner
+        int32_t x_near = INT32_MAX;
+        for (uint16_t i = prev_start; i < prev_end; i++) {
+          int32_t near_min = Max((int32_t)(*ret_corners)[i].x - min_dist + 1, x);
+          if (near_min <= (int32_t)(*ret_corners)[i].x + min_dist - 1 && near_min < x_near) {
+            x_near = near_min;
+          }
+        }
+        if (x_near <= cx) {
+          x = x_near + min_dist + 1;
+          continue;
+        }
+
+        // When we have more corner than allocted space reallocate
+        if (corner_cnt >= *ret_corners_length) {
+          *ret_corners_length *= 2;
+          *ret_corners = realloc(*ret_corners, sizeof(struct point_t) * (*ret_corners_length));
+        }
+
+        (*ret_corners)[corner_cnt].x = cx;
+        (*ret_corners)[corner_cnt].y = y;
+        corner_cnt++;
+
+        x = cx + min_dist + 1;
+        idx++;
+      }
+    }
+  }
+  *num_corners = corner_cnt;
+
+  pthread_mutex_unlock(&pool->call_mutex);
+}
+#endif
+
 /**
  * Make offsets for FAST9 calculation
  * @param[out] *pixel The offset array of the different pixels
@@ -3723,8 +452,20 @@ int fast9_detect_pixel(struct image_t *img, uint8_t threshold, uint16_t x, uint1
     return 0;
   }
   else {
-      // Calculate the threshold values
-            const uint8_t *p = ((uint8_t *)img->buf) + y * img->w * pixel_size + x * pixel_size + pixel_size / 2;
+    // Test the pixel with the decision tree
+    const uint8_t *p = ((uint8_t *)img->buf) + y * img->w * pixel_size + x * pixel_size + pixel_size / 2;
+    return fast9_test_pixel(p, pixel, threshold);
+  }
+}
+
+/**
+ * The FAST9 decision tree for a single pixel. Returns 0 when not a corner, and 1 when a corner.
+ * @param[in] *p Pointer to the pixel in the image
+ * @param[in] *pixel The offsets of the circle pixels (see fast_make_offsets)
+ * @param[in] threshold The threshold which we use for FAST9
+ */
+static int fast9_test_pixel(const uint8_t *p, const int *pixel, uint8_t threshold)
+{
             int16_t cb = *p + threshold;
             int16_t c_b = *p - threshold;
 
@@ -7258,5 +3999,4 @@ int fast9_detect_pixel(struct image_t *img, uint8_t threshold, uint16_t x, uint1
             }
     // if not returned yet, it is a corner:
     return 1;
-  }
 }
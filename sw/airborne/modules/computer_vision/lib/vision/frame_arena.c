@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of Paparazzi.
+ *
+ * Paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * Paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file modules/computer_vision/lib/vision/frame_arena.c
+ * @brief Bump allocator for the scratch buffers of one frame
+ */
+
+#include "frame_arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** Heap block used when an allocation does not fit in the arena, the data follows the header */
+struct frame_arena_block_t {
+  struct frame_arena_block_t *next;
+} __attribute__((aligned(FRAME_ARENA_ALIGN)));
+
+static inline uint32_t frame_arena_align(uint32_t size)
+{
+  return (size + FRAME_ARENA_ALIGN - 1) & ~(uint32_t)(FRAME_ARENA_ALIGN - 1);
+}
+
+/**
+ * Allocate the arena memory
+ * @param[out] *arena The arena to initialize
+ * @param[in] size The initial size of the arena in bytes (can be 0, it grows to what is needed)
+ */
+void frame_arena_init(struct frame_arena_t *arena, uint32_t size)
+{
+  arena->size = frame_arena_align(size);
+  arena->buf = NULL;
+  if (arena->size > 0 && posix_memalign((void **)&arena->buf, FRAME_ARENA_ALIGN, arena->size) != 0) {
+    arena->buf = NULL;
+    arena->size = 0;
+  }
+  arena->offset = 0;
+  arena->used = 0;
+  arena->peak = 0;
+  arena->overflow_cnt = 0;
+  arena->overflow = NULL;
+}
+
+/**
+ * Free the arena memory, all allocations done from it become invalid
+ * @param[in] *arena The arena to free
+ */
+void frame_arena_free(struct frame_arena_t *arena)
+{
+  frame_arena_reset(arena);
+  free(arena->buf);
+  arena->buf = NULL;
+  arena->size = 0;
+}
+
+/**
+ * Release all the allocations of the current frame.
+ * If the frame did not fit in the arena, the arena is grown to the peak usage.
+ * @param[in] *arena The arena to reset
+ */
+void frame_arena_reset(struct frame_arena_t *arena)
+{
+  while (arena->overflow != NULL) {
+    struct frame_arena_block_t *next = arena->overflow->next;
+    free(arena->overflow);
+    arena->overflow = next;
+  }
+
+  if (arena->peak > arena->size) {
+    uint8_t *buf = NULL;
+    if (posix_memalign((void **)&buf, FRAME_ARENA_ALIGN, arena->peak) == 0) {
+      free(arena->buf);
+      arena->buf = buf;
+      arena->size = arena->peak;
+    }
+  }
+
+  arena->offset = 0;
+  arena->used = 0;
+}
+
+/**
+ * Allocate memory which stays valid until the next reset of the arena
+ * @param[in] *arena The arena to allocate from (NULL to use malloc)
+ * @param[in] size The amount of bytes
+ * @return Pointer to the memory (aligned to FRAME_ARENA_ALIGN when allocated from an arena)
+ */
+void *frame_arena_alloc(struct frame_arena_t *arena, uint32_t size)
+{
+  if (arena == NULL) {
+    return malloc(size);
+  }
+
+  size = frame_arena_align(size);
+  arena->used += size;
+  if (arena->used > arena->peak) {
+    arena->peak = arena->used;
+  }
+
+  // Bump the offset when it fits in the arena
+  if (size <= arena->size - arena->offset) {
+    void *ptr = arena->buf + arena->offset;
+    arena->offset += size;
+    return ptr;
+  }
+
+  // Otherwise allocate a heap block which is freed at the next reset
+  struct frame_arena_block_t *block = malloc(sizeof(struct frame_arena_block_t) + size);
+  if (block == NULL) {
+    return NULL;
+  }
+  block->next = arena->overflow;
+  arena->overflow = block;
+  arena->overflow_cnt++;
+  return block + 1;
+}
+
+/**
+ * Allocate zeroed memory which stays valid until the next reset of the arena
+ * @param[in] *arena The arena to allocate from (NULL to use calloc)
+ * @param[in] nmemb The number of elements
+ * @param[in] size The size of one element
+ * @return Pointer to the zeroed memory
+ */
+void *frame_arena_calloc(struct frame_arena_t *arena, uint32_t nmemb, uint32_t size)
+{
+  if (arena == NULL) {
+    return calloc(nmemb, size);
+  }
+
+  void *ptr = frame_arena_alloc(arena, nmemb * size);
+  if (ptr != NULL) {
+    memset(ptr, 0, nmemb * size);
+  }
+  return ptr;
+}
+
+/**
+ * Release memory allocated with frame_arena_alloc or frame_arena_calloc.
+ * This only frees the memory when no arena is used, arena memory is released by frame_arena_reset.
+ * @param[in] *arena The arena the memory was allocated from (can be NULL)
+ * @param[in] *ptr The memory to release
+ */
+void frame_arena_release(struct frame_arena_t *arena, void *ptr)
+{
+  if (arena == NULL) {
+    free(ptr);
+  }
+}
+
+/**
+ * Create a new image with its buffer allocated from the arena
+ * @param[in] *arena The arena to allocate from (NULL to use image_create)
+ * @param[out] *img The output image
+ * @param[in] width The width of the image
+ * @param[in] height The height of the image
+ * @param[in] type The type of image
+ */
+void frame_arena_image_create(struct frame_arena_t *arena, struct image_t *img, uint16_t width, uint16_t height,
+                              enum image_type type)
+{
+  if (arena == NULL) {
+    image_create(img, width, height, type);
+    return;
+  }
+
+  img->type = type;
+  img->w = width;
+  img->h = height;
+  img->buf_size = image_buf_size(width, height, type);
+  img->buf = frame_arena_alloc(arena, img->buf_size);
+}
+
+/**
+ * Free an image created with frame_arena_image_create
+ * @param[in] *arena The arena the image was allocated from (can be NULL)
+ * @param[in] *img The image to free
+ */
+void frame_arena_image_free(struct frame_arena_t *arena, struct image_t *img)
+{
+  if (arena == NULL) {
+    image_free(img);
+  } else {
+    img->buf = NULL;
+  }
+}
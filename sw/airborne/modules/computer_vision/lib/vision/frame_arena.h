@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of Paparazzi.
+ *
+ * Paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * Paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file modules/computer_vision/lib/vision/frame_arena.h
+ * @brief Bump allocator for the scratch buffers of one frame
+ *
+ * A vision pipeline allocates its per frame buffers from the arena and calls
+ * frame_arena_reset() before the next frame, which releases all of them at once.
+ * When a frame needs more than the arena size, the extra allocations are served
+ * from the heap and the arena grows to the peak usage at the next reset, so after
+ * the first frames no heap allocation is done anymore.
+ *
+ * All functions also accept a NULL arena, in which case plain malloc/free is used.
+ */
+
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include "std.h"
+#include "image.h"
+
+/** Alignment of every allocation (enough for the SIMD loads of the image functions) */
+#define FRAME_ARENA_ALIGN 16
+
+struct frame_arena_block_t;
+
+struct frame_arena_t {
+  uint8_t *buf;                           ///< Arena memory
+  uint32_t size;                          ///< Size of the arena memory
+  uint32_t offset;                        ///< First free byte of the arena memory
+  uint32_t used;                          ///< Bytes allocated since the last reset (including overflow)
+  uint32_t peak;                          ///< Largest amount of bytes needed by one frame (including overflow)
+  uint32_t overflow_cnt;                  ///< Number of allocations that did not fit in the arena
+  struct frame_arena_block_t *overflow;   ///< Heap blocks of the current frame that did not fit in the arena
+};
+
+extern void frame_arena_init(struct frame_arena_t *arena, uint32_t size);
+extern void frame_arena_free(struct frame_arena_t *arena);
+extern void frame_arena_reset(struct frame_arena_t *arena);
+extern void *frame_arena_alloc(struct frame_arena_t *arena, uint32_t size);
+extern void *frame_arena_calloc(struct frame_arena_t *arena, uint32_t nmemb, uint32_t size);
+extern void frame_arena_release(struct frame_arena_t *arena, void *ptr);
+extern void frame_arena_image_create(struct frame_arena_t *arena, struct image_t *img, uint16_t width, uint16_t height,
+                                     enum image_type type);
+extern void frame_arena_image_free(struct frame_arena_t *arena, struct image_t *img);
+
+#endif /* FRAME_ARENA_H */
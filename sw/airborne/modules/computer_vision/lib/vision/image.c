@@ -28,6 +28,71 @@
 #include <stdlib.h>
 #include <string.h>
 
+/**
+ * Use the vectorized (ARM NEON or x86 SSE2) versions of the pixel loops when the
+ * compiler targets them. They give exactly the same results as the scalar code,
+ * which is always used for the remaining pixels and on other architectures.
+ */
+#ifndef IMAGE_SIMD
+#define IMAGE_SIMD TRUE
+#endif
+
+#if IMAGE_SIMD && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define IMAGE_NEON 1
+#include <arm_neon.h>
+#elif IMAGE_SIMD && defined(__SSE2__)
+#define IMAGE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if IMAGE_NEON
+/** Sum the 4 lanes of a vector */
+static inline int32_t image_neon_hsum_s32(int32x4_t v)
+{
+  int32x2_t s = vadd_s32(vget_low_s32(v), vget_high_s32(v));
+  return vget_lane_s32(vpadd_s32(s, s), 0);
+}
+
+/** Divide 4 positive integers (< 2^32) by 10000 (exact, using a multiply and shift) */
+static inline uint32x4_t image_neon_div10000_u32(uint32x4_t v)
+{
+  const uint32x2_t magic = vdup_n_u32(3518437209u);  // ceil(2^45 / 10000)
+  uint32x2_t lo = vshrn_n_u64(vmull_u32(vget_low_u32(v), magic), 32);
+  uint32x2_t hi = vshrn_n_u64(vmull_u32(vget_high_u32(v), magic), 32);
+  return vshrq_n_u32(vcombine_u32(lo, hi), 13);
+}
+#endif
+
+#if IMAGE_SSE2
+/** Sum the 4 lanes of a vector */
+static inline int32_t image_sse2_hsum_epi32(__m128i v)
+{
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(v);
+}
+
+/** Divide 4 positive integers (< 2^32) by 10000 (exact, using a multiply and shift) */
+static inline __m128i image_sse2_div10000_epu32(__m128i v)
+{
+  const __m128i magic = _mm_set1_epi32(3518437209u);  // ceil(2^45 / 10000)
+  __m128i even = _mm_srli_epi64(_mm_mul_epu32(v, magic), 45);
+  __m128i odd = _mm_srli_epi64(_mm_mul_epu32(_mm_srli_epi64(v, 32), magic), 45);
+  return _mm_or_si128(even, _mm_slli_epi64(odd, 32));
+}
+
+/** Load 8 pixels and widen them to 16 bit */
+static inline __m128i image_sse2_load8_epu16(const uint8_t *p)
+{
+  return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)p), _mm_setzero_si128());
+}
+#endif
+
+/* Functions only used here */
+static void image_mirror_border(struct image_t *img, uint16_t border_size);
+static void pyramid_downsample(struct image_t *input, uint8_t *output_buf, uint16_t output_w, uint16_t output_h,
+                               uint16_t output_stride, uint16_t border_size);
+
 /**
  * Create a new image
  * @param[out] *img The output image
@@ -41,19 +106,30 @@ void image_create(struct image_t *img, uint16_t width, uint16_t height, enum ima
   img->type = type;
   img->w = width;
   img->h = height;
+  img->buf_size = image_buf_size(width, height, type);
+
+  img->buf = malloc(img->buf_size);
+}
 
+/**
+ * Size of the buffer of an image
+ * @param[in] width The width of the image
+ * @param[in] height The height of the image
+ * @param[in] type The type of image (YUV422 or grayscale)
+ * @return The buffer size in bytes
+ */
+uint32_t image_buf_size(uint16_t width, uint16_t height, enum image_type type)
+{
   // Depending on the type the size differs
   if (type == IMAGE_YUV422) {
-    img->buf_size = sizeof(uint8_t) * 2 * width * height;
+    return sizeof(uint8_t) * 2 * width * height;
   } else if (type == IMAGE_JPEG) {
-    img->buf_size = sizeof(uint8_t) * 2 * width * height;  // At maximum quality this is enough
+    return sizeof(uint8_t) * 2 * width * height;  // At maximum quality this is enough
   } else if (type == IMAGE_GRADIENT) {
-    img->buf_size = sizeof(int16_t) * width * height;
+    return sizeof(int16_t) * width * height;
   } else {
-    img->buf_size = sizeof(uint8_t) * width * height;
+    return sizeof(uint8_t) * width * height;
   }
-
-  img->buf = malloc(img->buf_size);
 }
 
 /**
@@ -119,20 +195,52 @@ void image_to_grayscale(struct image_t *input, struct image_t *output)
 {
   uint8_t *source = input->buf;
   uint8_t *dest = output->buf;
-  source++;
+  uint32_t pixels = output->w * output->h;
+  uint32_t i = 0;
 
   // Copy the creation timestamp (stays the same)
   output->ts = input->ts;
 
-  // Copy the pixels
-  for (int y = 0; y < output->h; y++) {
-    for (int x = 0; x < output->w; x++) {
-      if (output->type == IMAGE_YUV422) {
-        *dest++ = 127;  // U / V
-      }
-      *dest++ = *source;    // Y
-      source += 2;
+  // Copy 16 pixels at once
+#if IMAGE_NEON
+  for (; i + 16 <= pixels; i += 16) {
+    uint8x16x2_t uyvy = vld2q_u8(source);
+    if (output->type == IMAGE_YUV422) {
+      uyvy.val[0] = vdupq_n_u8(127);
+      vst2q_u8(dest, uyvy);
+      dest += 32;
+    } else {
+      vst1q_u8(dest, uyvy.val[1]);
+      dest += 16;
+    }
+    source += 32;
+  }
+#elif IMAGE_SSE2
+  for (; i + 16 <= pixels; i += 16) {
+    __m128i a = _mm_loadu_si128((__m128i *)source);
+    __m128i b = _mm_loadu_si128((__m128i *)(source + 16));
+    if (output->type == IMAGE_YUV422) {
+      const __m128i y_mask = _mm_set1_epi16((int16_t)0xFF00);
+      const __m128i uv = _mm_set1_epi16(127);
+      _mm_storeu_si128((__m128i *)dest, _mm_or_si128(_mm_and_si128(a, y_mask), uv));
+      _mm_storeu_si128((__m128i *)(dest + 16), _mm_or_si128(_mm_and_si128(b, y_mask), uv));
+      dest += 32;
+    } else {
+      _mm_storeu_si128((__m128i *)dest, _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+      dest += 16;
     }
+    source += 32;
+  }
+#endif
+
+  // Copy the remaining pixels
+  source++;
+  for (; i < pixels; i++) {
+    if (output->type == IMAGE_YUV422) {
+      *dest++ = 127;  // U / V
+    }
+    *dest++ = *source;    // Y
+    source += 2;
   }
 }
 
@@ -154,44 +262,88 @@ uint16_t image_yuv422_colorfilt(struct image_t *input, struct image_t *output, u
   uint16_t cnt = 0;
   uint8_t *source = (uint8_t *)input->buf;
   uint8_t *dest = (uint8_t *)output->buf;
+  uint32_t pairs = output->h * ((output->w + 1) / 2);
+  uint32_t i = 0;
 
   // Copy the creation timestamp (stays the same)
   output->ts = input->ts;
 
-  // Go trough all the pixels
-  for (uint16_t y = 0; y < output->h; y++) {
-    for (uint16_t x = 0; x < output->w; x += 2) {
-      // Check if the color is inside the specified values
-      if (
-        (dest[1] >= y_m)
-        && (dest[1] <= y_M)
-        && (dest[0] >= u_m)
-        && (dest[0] <= u_M)
-        && (dest[2] >= v_m)
-        && (dest[2] <= v_M)
-      ) {
-        cnt ++;
-        // UYVY
-        dest[0] = 64;        // U
-        dest[1] = source[1];  // Y
-        dest[2] = 255;        // V
-        dest[3] = source[3];  // Y
-      } else {
-        // UYVY
-        char u = source[0] - 127;
-        u /= 4;
-        dest[0] = 127;        // U
-        dest[1] = source[1];  // Y
-        u = source[2] - 127;
-        u /= 4;
-        dest[2] = 127;        // V
-        dest[3] = source[3];  // Y
-      }
-
-      // Go to the next 2 pixels
-      dest += 4;
-      source += 4;
+  // Filter 8 pixels (4 UYVY pairs) at once
+#if IMAGE_NEON
+  {
+    const uint8_t lo_a[16] = {u_m, y_m, v_m, 0, u_m, y_m, v_m, 0, u_m, y_m, v_m, 0, u_m, y_m, v_m, 0};
+    const uint8_t hi_a[16] = {u_M, y_M, v_M, 255, u_M, y_M, v_M, 255, u_M, y_M, v_M, 255, u_M, y_M, v_M, 255};
+    const uint8x16_t lo = vld1q_u8(lo_a);
+    const uint8x16_t hi = vld1q_u8(hi_a);
+    const uint8x16_t y_mask = vreinterpretq_u8_u32(vdupq_n_u32(0xFF00FF00));
+    const uint8x16_t uv_in = vreinterpretq_u8_u32(vdupq_n_u32(0x00FF0040));
+    const uint8x16_t uv_out = vreinterpretq_u8_u32(vdupq_n_u32(0x007F007F));
+    uint32x4_t cnt_v = vdupq_n_u32(0);
+    for (; i + 4 <= pairs; i += 4) {
+      uint8x16_t d = vld1q_u8(dest);
+      uint8x16_t s = vld1q_u8(source);
+      uint8x16_t in = vandq_u8(vcgeq_u8(d, lo), vcleq_u8(d, hi));
+      uint32x4_t match = vceqq_u32(vreinterpretq_u32_u8(in), vdupq_n_u32(0xFFFFFFFF));
+      cnt_v = vsubq_u32(cnt_v, match);
+      uint8x16_t uv = vbslq_u8(vreinterpretq_u8_u32(match), uv_in, uv_out);
+      vst1q_u8(dest, vorrq_u8(uv, vandq_u8(s, y_mask)));
+      dest += 16;
+      source += 16;
     }
+    cnt += image_neon_hsum_s32(vreinterpretq_s32_u32(cnt_v));
+  }
+#elif IMAGE_SSE2
+  {
+    const __m128i lo = _mm_setr_epi8(u_m, y_m, v_m, 0, u_m, y_m, v_m, 0, u_m, y_m, v_m, 0, u_m, y_m, v_m, 0);
+    const __m128i hi = _mm_setr_epi8(u_M, y_M, v_M, 255, u_M, y_M, v_M, 255, u_M, y_M, v_M, 255, u_M, y_M, v_M, 255);
+    const __m128i ones = _mm_set1_epi32(-1);
+    const __m128i y_mask = _mm_set1_epi32(0xFF00FF00);
+    const __m128i uv_in = _mm_set1_epi32(0x00FF0040);
+    const __m128i uv_out = _mm_set1_epi32(0x007F007F);
+    __m128i cnt_v = _mm_setzero_si128();
+    for (; i + 4 <= pairs; i += 4) {
+      __m128i d = _mm_loadu_si128((__m128i *)dest);
+      __m128i s = _mm_loadu_si128((__m128i *)source);
+      __m128i in = _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(d, lo), d), _mm_cmpeq_epi8(_mm_min_epu8(d, hi), d));
+      __m128i match = _mm_cmpeq_epi32(in, ones);
+      cnt_v = _mm_sub_epi32(cnt_v, match);
+      __m128i uv = _mm_or_si128(_mm_and_si128(match, uv_in), _mm_andnot_si128(match, uv_out));
+      _mm_storeu_si128((__m128i *)dest, _mm_or_si128(uv, _mm_and_si128(s, y_mask)));
+      dest += 16;
+      source += 16;
+    }
+    cnt += image_sse2_hsum_epi32(cnt_v);
+  }
+#endif
+
+  // Go trough the remaining pixels
+  for (; i < pairs; i++) {
+    // Check if the color is inside the specified values
+    if (
+      (dest[1] >= y_m)
+      && (dest[1] <= y_M)
+      && (dest[0] >= u_m)
+      && (dest[0] <= u_M)
+      && (dest[2] >= v_m)
+      && (dest[2] <= v_M)
+    ) {
+      cnt ++;
+      // UYVY
+      dest[0] = 64;        // U
+      dest[1] = source[1];  // Y
+      dest[2] = 255;        // V
+      dest[3] = source[3];  // Y
+    } else {
+      // UYVY
+      dest[0] = 127;        // U
+      dest[1] = source[1];  // Y
+      dest[2] = 127;        // V
+      dest[3] = source[3];  // Y
+    }
+
+    // Go to the next 2 pixels
+    dest += 4;
+    source += 4;
   }
   return cnt;
 }
@@ -223,7 +375,48 @@ void image_yuv422_downsample(struct image_t *input, struct image_t *output, uint
 
   // Go trough all the pixels
   for (uint16_t y = 0; y < output->h; y++) {
-    for (uint16_t x = 0; x < output->w; x += 2) {
+    uint16_t x = 0;
+
+    // Without downsampling the row can just be copied
+    if (downsample == 1) {
+      x = (output->w + 1) & ~1;
+      memcpy(dest, source, x * 2);
+      dest += x * 2;
+      source += x * 2;
+    }
+
+    // Downsample by 2 for 8 output pixels at once (UYVY pairs are 32 bit words)
+#if IMAGE_NEON
+    if (downsample == 2) {
+      const uint32x4_t uyv_mask = vdupq_n_u32(0x00FFFFFF);
+      const uint32x4_t y_mask = vdupq_n_u32(0x0000FF00);
+      for (; x + 8 <= output->w; x += 8) {
+        uint32x4x2_t v = vld2q_u32((uint32_t *)source);
+        uint32x4_t res = vorrq_u32(vandq_u32(v.val[0], uyv_mask), vshlq_n_u32(vandq_u32(v.val[1], y_mask), 16));
+        vst1q_u32((uint32_t *)dest, res);
+        dest += 16;
+        source += 32;
+      }
+    }
+#elif IMAGE_SSE2
+    if (downsample == 2) {
+      const __m128i uyv_mask = _mm_set_epi32(0, 0x00FFFFFF, 0, 0x00FFFFFF);
+      const __m128i y_mask = _mm_set_epi32(0x0000FF00, 0, 0x0000FF00, 0);
+      for (; x + 8 <= output->w; x += 8) {
+        __m128i a = _mm_loadu_si128((__m128i *)source);
+        __m128i b = _mm_loadu_si128((__m128i *)(source + 16));
+        a = _mm_or_si128(_mm_and_si128(a, uyv_mask), _mm_srli_epi64(_mm_and_si128(a, y_mask), 16));
+        b = _mm_or_si128(_mm_and_si128(b, uyv_mask), _mm_srli_epi64(_mm_and_si128(b, y_mask), 16));
+        a = _mm_shuffle_epi32(a, _MM_SHUFFLE(3, 1, 2, 0));
+        b = _mm_shuffle_epi32(b, _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128((__m128i *)dest, _mm_unpacklo_epi64(a, b));
+        dest += 16;
+        source += 32;
+      }
+    }
+#endif
+
+    for (; x < output->w; x += 2) {
       // YUYV
       *dest++ = *source++; // U
       *dest++ = *source++; // Y
@@ -252,29 +445,45 @@ void image_add_border(struct image_t *input, struct image_t *output, uint8_t bor
   uint8_t *input_buf = (uint8_t *)input->buf;
   uint8_t *output_buf = (uint8_t *)output->buf;
 
-  // Skip first `border_size` rows, iterate through next input->h rows
+  // Skip first `border_size` rows, copy corresponding row values from input image
   for (uint16_t i = border_size; i != (output->h - border_size); i++) {
+    memcpy(&output_buf[i * output->w + border_size], &input_buf[(i - border_size) * input->w], sizeof(uint8_t) * input->w);
+  }
+
+  image_mirror_border(output, border_size);
+}
+
+/**
+ * Fill the padding of an image by mirroring the image elements at the edge in place.
+ * Only the inner (w - 2 * border_size) x (h - 2 * border_size) elements have to be set.
+ * @param[in,out] *img - padded image (grayscale only)
+ * @param[in]  border_size  - amount of padding around image
+ *                  Example: f e d c b a | a b c d e f | f e d c b a
+ */
+static void image_mirror_border(struct image_t *img, uint16_t border_size)
+{
+  uint8_t *buf = (uint8_t *)img->buf;
+
+  // Skip first `border_size` rows, iterate through next inner rows
+  for (uint16_t i = border_size; i != (img->h - border_size); i++) {
 
     // Mirror first `border_size` columns
-    for (uint8_t j = 0; j != border_size; j++) {
-      output_buf[i * output->w + (border_size - 1 - j)] = input_buf[(i - border_size) * input->w + j];
+    for (uint16_t j = 0; j != border_size; j++) {
+      buf[i * img->w + (border_size - 1 - j)] = buf[i * img->w + border_size + j];
     }
 
-    // Copy corresponding row values from input image
-    memcpy(&output_buf[i * output->w + border_size], &input_buf[(i - border_size) * input->w], sizeof(uint8_t) * input->w);
-
     // Mirror last `border_size` columns
-    for (uint8_t j = 0; j != border_size; j++) {
-      output_buf[i * output->w + output->w - border_size + j] = output_buf[i * output->w + output->w - border_size - 1 - j];
+    for (uint16_t j = 0; j != border_size; j++) {
+      buf[i * img->w + img->w - border_size + j] = buf[i * img->w + img->w - border_size - 1 - j];
     }
   }
 
   // Mirror first `border_size` and last `border_size` rows
-  for (uint8_t i = 0; i != border_size; i++) {
-    memcpy(&output_buf[(border_size - 1) * output->w - i * output->w], &output_buf[border_size * output->w + i * output->w],
-           sizeof(uint8_t) * output->w);
-    memcpy(&output_buf[(output->h - border_size) * output->w + i * output->w],
-           &output_buf[(output->h - border_size - 1) * output->w - i * output->w], sizeof(uint8_t) * output->w);
+  for (uint16_t i = 0; i != border_size; i++) {
+    memcpy(&buf[(border_size - 1) * img->w - i * img->w], &buf[border_size * img->w + i * img->w],
+           sizeof(uint8_t) * img->w);
+    memcpy(&buf[(img->h - border_size) * img->w + i * img->w],
+           &buf[(img->h - border_size - 1) * img->w - i * img->w], sizeof(uint8_t) * img->w);
   }
 }
 
@@ -294,16 +503,89 @@ void pyramid_next_level(struct image_t *input, struct image_t *output, uint8_t b
   // Create output image, new image size is half the size of input image without padding (border)
   image_create(output, (input->w + 1 - 2 * border_size) / 2, (input->h + 1 - 2 * border_size) / 2, input->type);
 
+  pyramid_downsample(input, (uint8_t *)output->buf, output->w, output->h, output->w, border_size);
+}
+
+/**
+ * Filter and downsample a padded pyramid level into a (part of an) output buffer.
+ * @param[in]  *input  - input image (grayscale only)
+ * @param[out] *output_buf - first output pixel
+ * @param[in]  output_w, output_h - size of the next level without padding
+ * @param[in]  output_stride - row length of the output buffer
+ * @param[in]  border_size  - amount of padding around the input image
+ */
+static void pyramid_downsample(struct image_t *input, uint8_t *output_buf, uint16_t output_w, uint16_t output_h,
+                               uint16_t output_stride, uint16_t border_size)
+{
   uint8_t *input_buf = (uint8_t *)input->buf;
-  uint8_t *output_buf = (uint8_t *)output->buf;
 
   uint16_t row, col; // coordinates of the central pixel; pixel being calculated in input matrix; center of filer matrix
   uint16_t w = input->w;
   int32_t sum = 0;
 
-  for (uint16_t i = 0; i != output->h; i++) {
+  for (uint16_t i = 0; i != output_h; i++) {
+    uint16_t j = 0;
+    row = border_size + 2 * i;
 
-    for (uint16_t j = 0; j != output->w; j++) {
+    // Calculate 8 output pixels at once, the filter is applied per input row as
+    // 'a * (p[-2] + p[2]) + b * (p[-1] + p[1]) + c * p[0]' with the weights of that row
+#if IMAGE_NEON
+    for (; border_size + 2 * j + 30 <= w && j + 8 <= output_w; j += 8) {
+      col = border_size + 2 * j;
+      uint32x4_t sum_lo = vdupq_n_u32(0), sum_hi = vdupq_n_u32(0);
+      for (int8_t r = -2; r <= 2; r++) {
+        const uint16_t wa[3] = {234, 156, 39}, wb[3] = {938, 625, 156}, wc[3] = {1406, 938, 234};
+        uint8_t a = abs(r);
+        uint8_t *p = &input_buf[(row + r) * w + col - 2];
+        uint8x8x2_t v0 = vld2_u8(p);
+        uint8x8x2_t v1 = vld2_u8(p + 2);
+        uint8x8x2_t v2 = vld2_u8(p + 4);
+        uint16x8_t side2 = vaddl_u8(v0.val[0], v2.val[0]);
+        uint16x8_t side1 = vaddl_u8(v0.val[1], v1.val[1]);
+        uint16x8_t center = vmovl_u8(v1.val[0]);
+        sum_lo = vmlal_n_u16(sum_lo, vget_low_u16(side2), wa[a]);
+        sum_lo = vmlal_n_u16(sum_lo, vget_low_u16(side1), wb[a]);
+        sum_lo = vmlal_n_u16(sum_lo, vget_low_u16(center), wc[a]);
+        sum_hi = vmlal_n_u16(sum_hi, vget_high_u16(side2), wa[a]);
+        sum_hi = vmlal_n_u16(sum_hi, vget_high_u16(side1), wb[a]);
+        sum_hi = vmlal_n_u16(sum_hi, vget_high_u16(center), wc[a]);
+      }
+      uint16x8_t res = vcombine_u16(vmovn_u32(image_neon_div10000_u32(sum_lo)),
+                                    vmovn_u32(image_neon_div10000_u32(sum_hi)));
+      vst1_u8(&output_buf[i * output_stride + j], vmovn_u16(res));
+    }
+#elif IMAGE_SSE2
+    for (; border_size + 2 * j + 30 <= w && j + 8 <= output_w; j += 8) {
+      col = border_size + 2 * j;
+      const __m128i lo_mask = _mm_set1_epi16(0x00FF);
+      __m128i sum_lo = _mm_setzero_si128(), sum_hi = _mm_setzero_si128();
+      for (int8_t r = -2; r <= 2; r++) {
+        const int16_t wa[3] = {234, 156, 39}, wb[3] = {938, 625, 156}, wc[3] = {1406, 938, 234};
+        uint8_t a = abs(r);
+        uint8_t *p = &input_buf[(row + r) * w + col - 2];
+        __m128i v_lo = _mm_loadu_si128((__m128i *)p);
+        __m128i v_hi = _mm_loadu_si128((__m128i *)(p + 16));
+        // Split even and odd pixels and shift them by one and two positions
+        __m128i even0 = _mm_and_si128(v_lo, lo_mask), even_next = _mm_and_si128(v_hi, lo_mask);
+        __m128i odd0 = _mm_srli_epi16(v_lo, 8), odd_next = _mm_srli_epi16(v_hi, 8);
+        __m128i even1 = _mm_or_si128(_mm_srli_si128(even0, 2), _mm_slli_si128(even_next, 14));
+        __m128i even2 = _mm_or_si128(_mm_srli_si128(even0, 4), _mm_slli_si128(even_next, 12));
+        __m128i odd1 = _mm_or_si128(_mm_srli_si128(odd0, 2), _mm_slli_si128(odd_next, 14));
+        __m128i side2 = _mm_add_epi16(even0, even2);
+        __m128i side1 = _mm_add_epi16(odd0, odd1);
+        __m128i w_ab = _mm_set1_epi32((wb[a] << 16) | wa[a]);
+        __m128i w_c = _mm_set1_epi32(wc[a]);
+        sum_lo = _mm_add_epi32(sum_lo, _mm_madd_epi16(_mm_unpacklo_epi16(side2, side1), w_ab));
+        sum_hi = _mm_add_epi32(sum_hi, _mm_madd_epi16(_mm_unpackhi_epi16(side2, side1), w_ab));
+        sum_lo = _mm_add_epi32(sum_lo, _mm_madd_epi16(_mm_unpacklo_epi16(even1, _mm_setzero_si128()), w_c));
+        sum_hi = _mm_add_epi32(sum_hi, _mm_madd_epi16(_mm_unpackhi_epi16(even1, _mm_setzero_si128()), w_c));
+      }
+      __m128i res = _mm_packs_epi32(image_sse2_div10000_epu32(sum_lo), image_sse2_div10000_epu32(sum_hi));
+      _mm_storel_epi64((__m128i *)&output_buf[i * output_stride + j], _mm_packus_epi16(res, res));
+    }
+#endif
+
+    for (; j != output_w; j++) {
       row = border_size + 2 * i; // First skip border, then every second pixel
       col = border_size + 2 * j;
 
@@ -321,7 +603,7 @@ void pyramid_next_level(struct image_t *input, struct image_t *output, uint8_t b
                      input_buf[(row) * w    + (col + 1)] + input_buf[(row + 1) * w + (col)]);
       sum += 1406 * input_buf[(row) * w    + (col)];
 
-      output_buf[i * output->w + j] = sum / 10000;
+      output_buf[i * output_stride + j] = sum / 10000;
     }
   }
 }
@@ -338,16 +620,65 @@ void pyramid_next_level(struct image_t *input, struct image_t *output, uint8_t b
  */
 void pyramid_build(struct image_t *input, struct image_t *output_array, uint8_t pyr_level, uint16_t border_size)
 {
-  // Pad input image and save it as '0' pyramid level
-  image_add_border(input, &output_array[0], border_size);
+  pyramid_create(output_array, input->w, input->h, pyr_level, border_size);
+  pyramid_update(input, output_array, pyr_level, border_size);
+}
 
-  // Temporary holds 'i' level version of original image to be padded and saved as 'i' pyramid level
-  struct image_t temp;
+/**
+ * Allocate the padded levels of an image pyramid, so that it can be (re)built with pyramid_update
+ * without allocating memory for every new image.
+ * @param[out] *output_array - array of `pyr_level` + 1 image_t structs to allocate
+ * @param[in]  w, h  - size of the (unpadded) input image
+ * @param[in]  pyr_level  - number of pyramid levels on top of the original image
+ * @param[in]  border_size  - amount of padding around every level
+ */
+void pyramid_create(struct image_t *output_array, uint16_t w, uint16_t h, uint8_t pyr_level, uint16_t border_size)
+{
+  for (uint8_t i = 0; i != pyr_level + 1; i++) {
+    image_create(&output_array[i], w + 2 * border_size, h + 2 * border_size, IMAGE_GRAYSCALE);
+    w = (w + 1) / 2;
+    h = (h + 1) / 2;
+  }
+}
+
+/**
+ * Build an image pyramid in the levels allocated by pyramid_create.
+ * Every level is filtered directly into the inner part of the padded level and mirrored afterwards,
+ * so no temporary images are needed.
+ * @param[in]  *input  - input image (grayscale only), of the size given to pyramid_create
+ * @param[out] *output_array - allocated pyramid levels
+ * @param[in]  pyr_level  - number of pyramid levels on top of the original image
+ * @param[in]  border_size  - amount of padding around every level, as given to pyramid_create
+ */
+void pyramid_update(struct image_t *input, struct image_t *output_array, uint8_t pyr_level, uint16_t border_size)
+{
+  // Copy the input image into the inner part of the '0' pyramid level
+  struct image_t *lvl = &output_array[0];
+  uint8_t *input_buf = (uint8_t *)input->buf;
+  uint8_t *lvl_buf = (uint8_t *)lvl->buf;
+  for (uint16_t i = 0; i != input->h; i++) {
+    memcpy(&lvl_buf[(i + border_size) * lvl->w + border_size], &input_buf[i * input->w], sizeof(uint8_t) * input->w);
+  }
+  image_mirror_border(lvl, border_size);
 
   for (uint8_t i = 1; i != pyr_level + 1; i++) {
-    pyramid_next_level(&output_array[i - 1], &temp, border_size);
-    image_add_border(&temp, &output_array[i], border_size);
-    image_free(&temp);
+    lvl = &output_array[i];
+    lvl_buf = (uint8_t *)lvl->buf;
+    pyramid_downsample(&output_array[i - 1], &lvl_buf[border_size * lvl->w + border_size],
+                       lvl->w - 2 * border_size, lvl->h - 2 * border_size, lvl->w, border_size);
+    image_mirror_border(lvl, border_size);
+  }
+}
+
+/**
+ * Free all levels of an image pyramid
+ * @param[in]  *array - pyramid levels
+ * @param[in]  pyr_level  - number of pyramid levels on top of the original image
+ */
+void pyramid_free(struct image_t *array, uint8_t pyr_level)
+{
+  for (uint8_t i = 0; i != pyr_level + 1; i++) {
+    image_free(&array[i]);
   }
 }
 
@@ -428,12 +759,43 @@ void image_gradients(struct image_t *input, struct image_t *dx, struct image_t *
   int16_t *dx_buf = (int16_t *)dx->buf;
   int16_t *dy_buf = (int16_t *)dy->buf;
 
-  // Go trough all pixels except the borders
-  for (uint16_t x = 1; x < input->w - 1; x++) {
-    for (uint16_t y = 1; y < input->h - 1; y++) {
-      dx_buf[(y - 1)*dx->w + (x - 1)] = (int16_t)input_buf[y * input->w + x + 1] - (int16_t)input_buf[y * input->w + x - 1];
-      dy_buf[(y - 1)*dy->w + (x - 1)] = (int16_t)input_buf[(y + 1) * input->w + x] - (int16_t)
-                                        input_buf[(y - 1) * input->w + x];
+  // Go trough all pixels except the borders (row by row)
+  for (uint16_t y = 1; y < input->h - 1; y++) {
+    uint16_t x = 1;
+    uint8_t *row = &input_buf[y * input->w];
+    int16_t *dx_row = &dx_buf[(y - 1) * dx->w];
+    int16_t *dy_row = &dy_buf[(y - 1) * dy->w];
+
+    // Calculate 16 pixels at once
+#if IMAGE_NEON
+    for (; x + 17 <= input->w; x += 16) {
+      uint8x16_t left = vld1q_u8(&row[x - 1]), right = vld1q_u8(&row[x + 1]);
+      uint8x16_t up = vld1q_u8(&row[x - input->w]), down = vld1q_u8(&row[x + input->w]);
+      vst1q_s16(&dx_row[x - 1], vreinterpretq_s16_u16(vsubl_u8(vget_low_u8(right), vget_low_u8(left))));
+      vst1q_s16(&dx_row[x + 7], vreinterpretq_s16_u16(vsubl_u8(vget_high_u8(right), vget_high_u8(left))));
+      vst1q_s16(&dy_row[x - 1], vreinterpretq_s16_u16(vsubl_u8(vget_low_u8(down), vget_low_u8(up))));
+      vst1q_s16(&dy_row[x + 7], vreinterpretq_s16_u16(vsubl_u8(vget_high_u8(down), vget_high_u8(up))));
+    }
+#elif IMAGE_SSE2
+    for (; x + 17 <= input->w; x += 16) {
+      const __m128i zero = _mm_setzero_si128();
+      __m128i left = _mm_loadu_si128((__m128i *)&row[x - 1]), right = _mm_loadu_si128((__m128i *)&row[x + 1]);
+      __m128i up = _mm_loadu_si128((__m128i *)&row[x - input->w]);
+      __m128i down = _mm_loadu_si128((__m128i *)&row[x + input->w]);
+      __m128i dx_lo = _mm_sub_epi16(_mm_unpacklo_epi8(right, zero), _mm_unpacklo_epi8(left, zero));
+      __m128i dx_hi = _mm_sub_epi16(_mm_unpackhi_epi8(right, zero), _mm_unpackhi_epi8(left, zero));
+      __m128i dy_lo = _mm_sub_epi16(_mm_unpacklo_epi8(down, zero), _mm_unpacklo_epi8(up, zero));
+      __m128i dy_hi = _mm_sub_epi16(_mm_unpackhi_epi8(down, zero), _mm_unpackhi_epi8(up, zero));
+      _mm_storeu_si128((__m128i *)&dx_row[x - 1], dx_lo);
+      _mm_storeu_si128((__m128i *)&dx_row[x + 7], dx_hi);
+      _mm_storeu_si128((__m128i *)&dy_row[x - 1], dy_lo);
+      _mm_storeu_si128((__m128i *)&dy_row[x + 7], dy_hi);
+    }
+#endif
+
+    for (; x < input->w - 1; x++) {
+      dx_row[x - 1] = (int16_t)row[x + 1] - (int16_t)row[x - 1];
+      dy_row[x - 1] = (int16_t)row[x + input->w] - (int16_t)row[x - input->w];
     }
   }
 }
@@ -491,10 +853,38 @@ uint32_t image_difference(struct image_t *img_a, struct image_t *img_b, struct i
     diff_buf = (int16_t *)diff->buf;
   }
 
-  // Go trough the imagge pixels and calculate the difference
-  for (uint16_t x = 0; x < img_b->w; x++) {
-    for (uint16_t y = 0; y < img_b->h; y++) {
-      int16_t diff_c = img_a_buf[(y + 1) * img_a->w + (x + 1)] - img_b_buf[y * img_b->w + x];
+  // Go trough the image pixels (row by row) and calculate the difference
+  for (uint16_t y = 0; y < img_b->h; y++) {
+    uint16_t x = 0;
+    uint8_t *a_row = &img_a_buf[(y + 1) * img_a->w + 1];
+    uint8_t *b_row = &img_b_buf[y * img_b->w];
+
+    // Calculate 8 pixels at once
+#if IMAGE_NEON
+    int32x4_t sum_v = vdupq_n_s32(0);
+    for (; x + 8 <= img_b->w; x += 8) {
+      int16x8_t diff_v = vreinterpretq_s16_u16(vsubl_u8(vld1_u8(&a_row[x]), vld1_u8(&b_row[x])));
+      sum_v = vmlal_s16(sum_v, vget_low_s16(diff_v), vget_low_s16(diff_v));
+      sum_v = vmlal_s16(sum_v, vget_high_s16(diff_v), vget_high_s16(diff_v));
+      if (diff_buf != NULL) {
+        vst1q_s16(&diff_buf[y * diff->w + x], diff_v);
+      }
+    }
+    sum_diff2 += image_neon_hsum_s32(sum_v);
+#elif IMAGE_SSE2
+    __m128i sum_v = _mm_setzero_si128();
+    for (; x + 8 <= img_b->w; x += 8) {
+      __m128i diff_v = _mm_sub_epi16(image_sse2_load8_epu16(&a_row[x]), image_sse2_load8_epu16(&b_row[x]));
+      sum_v = _mm_add_epi32(sum_v, _mm_madd_epi16(diff_v, diff_v));
+      if (diff_buf != NULL) {
+        _mm_storeu_si128((__m128i *)&diff_buf[y * diff->w + x], diff_v);
+      }
+    }
+    sum_diff2 += image_sse2_hsum_epi32(sum_v);
+#endif
+
+    for (; x < img_b->w; x++) {
+      int16_t diff_c = a_row[x] - b_row[x];
       sum_diff2 += diff_c * diff_c;
 
       // Set the difference image
@@ -527,10 +917,39 @@ int32_t image_multiply(struct image_t *img_a, struct image_t *img_b, struct imag
     mult_buf = (int16_t *)mult->buf;
   }
 
-  // Calculate the multiplication
-  for (uint16_t x = 0; x < img_a->w; x++) {
-    for (uint16_t y = 0; y < img_a->h; y++) {
-      int32_t mult_c = img_a_buf[y * img_a->w + x] * img_b_buf[y * img_b->w + x];
+  // Calculate the multiplication (row by row)
+  for (uint16_t y = 0; y < img_a->h; y++) {
+    uint16_t x = 0;
+    int16_t *a_row = &img_a_buf[y * img_a->w];
+    int16_t *b_row = &img_b_buf[y * img_b->w];
+
+    // Calculate 8 pixels at once
+#if IMAGE_NEON
+    int32x4_t sum_v = vdupq_n_s32(0);
+    for (; x + 8 <= img_a->w; x += 8) {
+      int16x8_t a = vld1q_s16(&a_row[x]), b = vld1q_s16(&b_row[x]);
+      int32x4_t mult_lo = vmull_s16(vget_low_s16(a), vget_low_s16(b));
+      int32x4_t mult_hi = vmull_s16(vget_high_s16(a), vget_high_s16(b));
+      sum_v = vaddq_s32(sum_v, vaddq_s32(mult_lo, mult_hi));
+      if (mult_buf != NULL) {
+        vst1q_s16(&mult_buf[y * mult->w + x], vcombine_s16(vmovn_s32(mult_lo), vmovn_s32(mult_hi)));
+      }
+    }
+    sum += image_neon_hsum_s32(sum_v);
+#elif IMAGE_SSE2
+    __m128i sum_v = _mm_setzero_si128();
+    for (; x + 8 <= img_a->w; x += 8) {
+      __m128i a = _mm_loadu_si128((__m128i *)&a_row[x]), b = _mm_loadu_si128((__m128i *)&b_row[x]);
+      sum_v = _mm_add_epi32(sum_v, _mm_madd_epi16(a, b));
+      if (mult_buf != NULL) {
+        _mm_storeu_si128((__m128i *)&mult_buf[y * mult->w + x], _mm_mullo_epi16(a, b));
+      }
+    }
+    sum += image_sse2_hsum_epi32(sum_v);
+#endif
+
+    for (; x < img_a->w; x++) {
+      int32_t mult_c = a_row[x] * b_row[x];
       sum += mult_c;
 
       // Set the difference image
@@ -87,6 +87,7 @@ struct crop_t {
 void image_add_border(struct image_t *input, struct image_t *output, uint8_t border_size);
 void image_create(struct image_t *img, uint16_t width, uint16_t height, enum image_type type);
 void image_free(struct image_t *img);
+uint32_t image_buf_size(uint16_t width, uint16_t height, enum image_type type);
 void image_copy(struct image_t *input, struct image_t *output);
 void image_switch(struct image_t *a, struct image_t *b);
 void image_to_grayscale(struct image_t *input, struct image_t *output);
@@ -108,6 +109,9 @@ void image_draw_line(struct image_t *img, struct point_t *from, struct point_t *
 void image_draw_line_color(struct image_t *img, struct point_t *from, struct point_t *to, uint8_t *color);
 void pyramid_next_level(struct image_t *input, struct image_t *output, uint8_t border_size);
 void pyramid_build(struct image_t *input, struct image_t *output_array, uint8_t pyr_level, uint16_t border_size);
+void pyramid_create(struct image_t *output_array, uint16_t w, uint16_t h, uint8_t pyr_level, uint16_t border_size);
+void pyramid_update(struct image_t *input, struct image_t *output_array, uint8_t pyr_level, uint16_t border_size);
+void pyramid_free(struct image_t *array, uint8_t pyr_level);
 void image_gradient_pixel(struct image_t *img, struct point_t *loc, int method, int *dx, int *dy);
 
 #endif
@@ -53,7 +53,8 @@
  * @param[in] step_threshold The threshold of additional subpixel flow at which the iterations should stop
  * @param[in] max_points The maximum amount of points to track, we skip x points and then take a point.
  * @param[in] pyramid_level Level of pyramid used in computation (0 == no pyramids used)
- * @return The vectors from the original *points in subpixels
+ * @param[in] *arena Frame arena for the vectors and the temporary images (NULL to use malloc)
+ * @return The vectors from the original *points in subpixels, to release with frame_arena_release()
  *
  * Pyramidal implementation of Lucas-Kanade feature tracker.
  *
@@ -72,40 +73,93 @@
  */
 struct flow_t *opticFlowLK(struct image_t *new_img, struct image_t *old_img, struct point_t *points,
                            uint16_t *points_cnt, uint16_t half_window_size,
-                           uint16_t subpixel_factor, uint8_t max_iterations, uint8_t step_threshold, uint8_t max_points, uint8_t pyramid_level)
+                           uint16_t subpixel_factor, uint8_t max_iterations, uint8_t step_threshold, uint8_t max_points, uint8_t pyramid_level,
+                           struct frame_arena_t *arena)
 {
 
   // if no pyramids, use the old code:
   if (pyramid_level == 0) {
     // use the old code in this case:
-    return opticFlowLK_flat(new_img, old_img, points, points_cnt, half_window_size, subpixel_factor, max_iterations, step_threshold, max_points);
+    return opticFlowLK_flat(new_img, old_img, points, points_cnt, half_window_size, subpixel_factor, max_iterations,
+                            step_threshold, max_points, arena);
   }
 
+  // Build pyramid levels
+  uint16_t border_size = opticFlowLK_border_size(half_window_size);
+  struct image_t pyramid_old[pyramid_level + 1];
+  struct image_t pyramid_new[pyramid_level + 1];
+  uint16_t w = old_img->w, h = old_img->h;
+  for (uint8_t i = 0; i != pyramid_level + 1; i++) {
+    frame_arena_image_create(arena, &pyramid_old[i], w + 2 * border_size, h + 2 * border_size, IMAGE_GRAYSCALE);
+    frame_arena_image_create(arena, &pyramid_new[i], w + 2 * border_size, h + 2 * border_size, IMAGE_GRAYSCALE);
+    w = (w + 1) / 2;
+    h = (h + 1) / 2;
+  }
+  pyramid_update(old_img, pyramid_old, pyramid_level, border_size);
+  pyramid_update(new_img, pyramid_new, pyramid_level, border_size);
+
+  struct flow_t *vectors = opticFlowLK_pyramid(pyramid_new, pyramid_old, points, points_cnt, half_window_size,
+                           subpixel_factor, max_iterations, step_threshold, max_points, pyramid_level, arena);
+
+  for (uint8_t i = 0; i != pyramid_level + 1; i++) {
+    frame_arena_image_free(arena, &pyramid_old[i]);
+    frame_arena_image_free(arena, &pyramid_new[i]);
+  }
+
+  // Return the vectors
+  return vectors;
+}
+
+/**
+ * Amount of padding the pyramid levels need for a given Lucas-Kanade window.
+ * Pyramids passed to opticFlowLK_pyramid have to be built with this border size.
+ * @param[in] half_window_size Half the window size (in both x and y direction) to search inside
+ * @return The border size of every pyramid level
+ */
+uint16_t opticFlowLK_border_size(uint16_t half_window_size)
+{
+  uint16_t padded_patch_size = 2 * half_window_size + 3;
+  return padded_patch_size / 2 + 2;
+}
+
+/**
+ * Pyramidal Lucas-Kanade feature tracker on already built image pyramids.
+ * This allows the caller to keep the pyramid of the new image and reuse it as old pyramid for the next image.
+ * @param[in] *pyramid_new Pyramid of the newest grayscale image, built with opticFlowLK_border_size()
+ * @param[in] *pyramid_old Pyramid of the old grayscale image, built with opticFlowLK_border_size()
+ * @param[in] *points Points to start tracking from
+ * @param[in,out] points_cnt The amount of points and it returns the amount of points tracked
+ * @param[in] half_window_size Half the window size (in both x and y direction) to search inside
+ * @param[in] subpixel_factor The subpixel factor which calculations should be based on
+ * @param[in] max_iterations Maximum amount of iterations to find the new point
+ * @param[in] step_threshold The threshold of additional subpixel flow at which the iterations should stop
+ * @param[in] max_points The maximum amount of points to track, we skip x points and then take a point.
+ * @param[in] pyramid_level Highest level of the pyramids (at least 1)
+ * @param[in] *arena Frame arena for the vectors and the window images (NULL to use malloc)
+ * @return The vectors from the original *points in subpixels, to release with frame_arena_release()
+ */
+struct flow_t *opticFlowLK_pyramid(struct image_t *pyramid_new, struct image_t *pyramid_old, struct point_t *points,
+                                   uint16_t *points_cnt, uint16_t half_window_size, uint16_t subpixel_factor,
+                                   uint8_t max_iterations, uint8_t step_threshold, uint8_t max_points, uint8_t pyramid_level,
+                                   struct frame_arena_t *arena)
+{
   // Allocate some memory for returning the vectors
-  struct flow_t *vectors = malloc(sizeof(struct flow_t) * max_points);
+  struct flow_t *vectors = frame_arena_alloc(arena, sizeof(struct flow_t) * max_points);
 
   // Determine patch sizes and initialize neighborhoods
   uint16_t patch_size = 2 * half_window_size + 1;
   // TODO: Feature management shows that this threshold rejects corners maybe too often, maybe another formula could be chosen
   uint32_t error_threshold = (25 * 25) * (patch_size * patch_size);
   uint16_t padded_patch_size = patch_size + 2;
-  uint16_t border_size = padded_patch_size / 2 + 2; // amount of padding added to images
-
-  // Allocate memory for image pyramids
-  struct image_t *pyramid_old = malloc(sizeof(struct image_t) * (pyramid_level + 1));
-  struct image_t *pyramid_new = malloc(sizeof(struct image_t) * (pyramid_level + 1));
-
-  // Build pyramid levels
-  pyramid_build(old_img, pyramid_old, pyramid_level, border_size);
-  pyramid_build(new_img, pyramid_new, pyramid_level, border_size);
+  uint16_t border_size = opticFlowLK_border_size(half_window_size); // amount of padding added to images
 
   // Create the window images
   struct image_t window_I, window_J, window_DX, window_DY, window_diff;
-  image_create(&window_I, padded_patch_size, padded_patch_size, IMAGE_GRAYSCALE);
-  image_create(&window_J, patch_size, patch_size, IMAGE_GRAYSCALE);
-  image_create(&window_DX, patch_size, patch_size, IMAGE_GRADIENT);
-  image_create(&window_DY, patch_size, patch_size, IMAGE_GRADIENT);
-  image_create(&window_diff, patch_size, patch_size, IMAGE_GRADIENT);
+  frame_arena_image_create(arena, &window_I, padded_patch_size, padded_patch_size, IMAGE_GRAYSCALE);
+  frame_arena_image_create(arena, &window_J, patch_size, patch_size, IMAGE_GRAYSCALE);
+  frame_arena_image_create(arena, &window_DX, patch_size, patch_size, IMAGE_GRADIENT);
+  frame_arena_image_create(arena, &window_DY, patch_size, patch_size, IMAGE_GRADIENT);
+  frame_arena_image_create(arena, &window_diff, patch_size, patch_size, IMAGE_GRADIENT);
 
   // Iterate through pyramid levels
   for (int8_t LVL = pyramid_level; LVL != -1; LVL--) {
@@ -218,18 +272,11 @@ struct flow_t *opticFlowLK(struct image_t *new_img, struct image_t *old_img, str
   } // LVL of pyramid
 
   // Free the images
-  image_free(&window_I);
-  image_free(&window_J);
-  image_free(&window_DX);
-  image_free(&window_DY);
-  image_free(&window_diff);
-
-  for (int8_t i = pyramid_level; i != -1; i--) {
-    image_free(&pyramid_old[i]);
-    image_free(&pyramid_new[i]);
-  }
-  pyramid_old = NULL;
-  pyramid_new = NULL;
+  frame_arena_image_free(arena, &window_I);
+  frame_arena_image_free(arena, &window_J);
+  frame_arena_image_free(arena, &window_DX);
+  frame_arena_image_free(arena, &window_DY);
+  frame_arena_image_free(arena, &window_diff);
 
   // Return the vectors
   return vectors;
@@ -248,10 +295,12 @@ struct flow_t *opticFlowLK(struct image_t *new_img, struct image_t *old_img, str
  * @param[in] max_iteration Maximum amount of iterations to find the new point
  * @param[in] step_threshold The threshold at which the iterations should stop
  * @param[in] max_point The maximum amount of points to track, we skip x points and then take a point.
- * @return The vectors from the original *points in subpixels
+ * @param[in] *arena Frame arena for the vectors and the window images (NULL to use malloc)
+ * @return The vectors from the original *points in subpixels, to release with frame_arena_release()
  */
 struct flow_t *opticFlowLK_flat(struct image_t *new_img, struct image_t *old_img, struct point_t *points, uint16_t *points_cnt,
-                                uint16_t half_window_size, uint16_t subpixel_factor, uint8_t max_iterations, uint8_t step_threshold, uint16_t max_points)
+                                uint16_t half_window_size, uint16_t subpixel_factor, uint8_t max_iterations, uint8_t step_threshold, uint16_t max_points,
+                                struct frame_arena_t *arena)
 {
   // A straightforward one-level implementation of Lucas-Kanade.
   // For all points:
@@ -265,7 +314,7 @@ struct flow_t *opticFlowLK_flat(struct image_t *new_img, struct image_t *old_img
   //     [d] calculate the additional flow step and possibly terminate the iteration
 
   // Allocate some memory for returning the vectors
-  struct flow_t *vectors = malloc(sizeof(struct flow_t) * max_points);
+  struct flow_t *vectors = frame_arena_alloc(arena, sizeof(struct flow_t) * max_points);
   uint16_t new_p = 0;
   uint16_t points_orig = *points_cnt;
   *points_cnt = 0;
@@ -277,11 +326,11 @@ struct flow_t *opticFlowLK_flat(struct image_t *new_img, struct image_t *old_img
 
   // Create the window images
   struct image_t window_I, window_J, window_DX, window_DY, window_diff;
-  image_create(&window_I, padded_patch_size, padded_patch_size, IMAGE_GRAYSCALE);
-  image_create(&window_J, patch_size, patch_size, IMAGE_GRAYSCALE);
-  image_create(&window_DX, patch_size, patch_size, IMAGE_GRADIENT);
-  image_create(&window_DY, patch_size, patch_size, IMAGE_GRADIENT);
-  image_create(&window_diff, patch_size, patch_size, IMAGE_GRADIENT);
+  frame_arena_image_create(arena, &window_I, padded_patch_size, padded_patch_size, IMAGE_GRAYSCALE);
+  frame_arena_image_create(arena, &window_J, patch_size, patch_size, IMAGE_GRAYSCALE);
+  frame_arena_image_create(arena, &window_DX, patch_size, patch_size, IMAGE_GRADIENT);
+  frame_arena_image_create(arena, &window_DY, patch_size, patch_size, IMAGE_GRADIENT);
+  frame_arena_image_create(arena, &window_diff, patch_size, patch_size, IMAGE_GRADIENT);
 
   // Calculate the amount of points to skip
   float skip_points = (points_orig > max_points) ? points_orig / max_points : 1;
@@ -374,11 +423,11 @@ struct flow_t *opticFlowLK_flat(struct image_t *new_img, struct image_t *old_img
   }
 
   // Free the images
-  image_free(&window_I);
-  image_free(&window_J);
-  image_free(&window_DX);
-  image_free(&window_DY);
-  image_free(&window_diff);
+  frame_arena_image_free(arena, &window_I);
+  frame_arena_image_free(arena, &window_J);
+  frame_arena_image_free(arena, &window_DX);
+  frame_arena_image_free(arena, &window_DY);
+  frame_arena_image_free(arena, &window_diff);
 
   // Return the vectors
   return vectors;
@@ -33,13 +33,21 @@
 
 #include "std.h"
 #include "image.h"
+#include "frame_arena.h"
 
 struct flow_t *opticFlowLK(struct image_t *new_img, struct image_t *old_img, struct point_t *points,
                            uint16_t *points_cnt, uint16_t half_window_size,
-                           uint16_t subpixel_factor, uint8_t max_iterations, uint8_t step_threshold, uint8_t max_points, uint8_t pyramid_level);
+                           uint16_t subpixel_factor, uint8_t max_iterations, uint8_t step_threshold, uint8_t max_points, uint8_t pyramid_level,
+                           struct frame_arena_t *arena);
+struct flow_t *opticFlowLK_pyramid(struct image_t *pyramid_new, struct image_t *pyramid_old, struct point_t *points,
+                                   uint16_t *points_cnt, uint16_t half_window_size, uint16_t subpixel_factor,
+                                   uint8_t max_iterations, uint8_t step_threshold, uint8_t max_points, uint8_t pyramid_level,
+                                   struct frame_arena_t *arena);
+uint16_t opticFlowLK_border_size(uint16_t half_window_size);
 
 // used when pyramid level is 0:
 struct flow_t *opticFlowLK_flat(struct image_t *new_img, struct image_t *old_img, struct point_t *points, uint16_t *points_cnt,
-                           uint16_t half_window_size, uint16_t subpixel_factor, uint8_t max_iterations, uint8_t step_threshold, uint16_t max_points);
+                           uint16_t half_window_size, uint16_t subpixel_factor, uint8_t max_iterations, uint8_t step_threshold, uint16_t max_points,
+                           struct frame_arena_t *arena);
 
 #endif /* OPTIC_FLOW_INT_H */
@@ -41,6 +41,7 @@
 #include "linear_flow_fit.h"
 #include "math/pprz_algebra_float.h"
 #include "math/pprz_matrix_decomp_float.h"
+#include "math/pprz_matrix_fixed_float.h"
 #include "math/pprz_simple_matrix.h"
 
 // Is this still necessary?
@@ -198,8 +199,8 @@ void fit_linear_flow_field(struct flow_t *vectors, int count, float error_thresh
 
     // for horizontal flow:
     // decompose A in u, w, v with singular value decomposition A = u * w * vT.
-    // u replaces A as output:
-    pprz_svd_float(A, w, v, n_samples, 3);
+    // u replaces A as output, the fixed size version is unrolled for the 3 columns:
+    float_mat_fixed_svd(_A[0], w, _v[0], n_samples, 3);
     pprz_svd_solve_float(pu, A, w, v, bu, n_samples, 3, 1);
     PU[it * 3] = pu[0][0];
     PU[it * 3 + 1] = pu[1][0];
@@ -220,6 +220,12 @@ PRINT_CONFIG_VAR(OPTICFLOW_ACTFAST_GRADIENT_METHOD)
 #endif
 PRINT_CONFIG_VAR(OPTICFLOW_ACTFAST_MIN_GRADIENT)
 
+/** Initial size of the frame arena (in bytes), it grows to the largest frame when needed */
+#ifndef OPTICFLOW_ARENA_SIZE
+#define OPTICFLOW_ARENA_SIZE 32768
+#endif
+PRINT_CONFIG_VAR(OPTICFLOW_ARENA_SIZE)
+
 // Defaults for ARdrone
 #ifndef OPTICFLOW_BODY_TO_CAM_PHI
 #define OPTICFLOW_BODY_TO_CAM_PHI 0
@@ -242,6 +248,8 @@ static int cmp_flow(const void *a, const void *b);
 static int cmp_array(const void *a, const void *b);
 static void manage_flow_features(struct image_t *img, struct opticflow_t *opticflow,
                                  struct opticflow_result_t *result);
+static void opticflow_pyramid_update(struct opticflow_t *opticflow);
+static void opticflow_pyramid_switch(struct opticflow_t *opticflow);
 
 /**
  * Initialize the opticflow calculator
@@ -277,6 +285,15 @@ void opticflow_calc_init(struct opticflow_t *opticflow)
   opticflow->fast9_padding = OPTICFLOW_FAST9_PADDING;
   opticflow->fast9_rsize = 512;
   opticflow->fast9_ret_corners = calloc(opticflow->fast9_rsize, sizeof(struct point_t));
+  opticflow->fast9_region_rsize = opticflow->fast9_rsize;
+  opticflow->fast9_region_corners = calloc(opticflow->fast9_region_rsize, sizeof(struct point_t));
+
+  opticflow->img_pyramid = NULL;
+  opticflow->prev_img_pyramid = NULL;
+  opticflow->img_pyramid_level = 0;
+  opticflow->img_pyramid_border = 0;
+  opticflow->img_pyramid_valid = false;
+  opticflow->prev_img_pyramid_valid = false;
 
   opticflow->corner_method = OPTICFLOW_CORNER_METHOD;
   opticflow->actfast_long_step = OPTICFLOW_ACTFAST_LONG_STEP;
@@ -284,6 +301,8 @@ void opticflow_calc_init(struct opticflow_t *opticflow)
   opticflow->actfast_min_gradient = OPTICFLOW_ACTFAST_MIN_GRADIENT;
   opticflow->actfast_gradient_method = OPTICFLOW_ACTFAST_GRADIENT_METHOD;
 
+  frame_arena_init(&opticflow->arena, OPTICFLOW_ARENA_SIZE);
+
   struct FloatEulers euler = {OPTICFLOW_BODY_TO_CAM_PHI, OPTICFLOW_BODY_TO_CAM_THETA, OPTICFLOW_BODY_TO_CAM_PSI};
   float_rmat_of_eulers(&body_to_cam, &euler);
 }
@@ -305,6 +324,7 @@ bool calc_fast9_lukas_kanade(struct opticflow_t *opticflow, struct image_t *img,
 
     // Set the previous values
     opticflow->got_first_img = false;
+    opticflow->prev_img_pyramid_valid = false;
 
     // Init median filters with zeros
     InitMedianFilterVect3Float(vel_filt, MEDIAN_DEFAULT_SIZE);
@@ -404,6 +424,7 @@ bool calc_fast9_lukas_kanade(struct opticflow_t *opticflow, struct image_t *img,
     result->noise_measurement = 5.0;
 
     image_switch(&opticflow->img_gray, &opticflow->prev_img_gray);
+    opticflow_pyramid_switch(opticflow);
     return false;
   }
 
@@ -413,10 +434,21 @@ bool calc_fast9_lukas_kanade(struct opticflow_t *opticflow, struct image_t *img,
 
   // Execute a Lucas Kanade optical flow
   result->tracked_cnt = result->corner_cnt;
-  struct flow_t *vectors = opticFlowLK(&opticflow->img_gray, &opticflow->prev_img_gray, opticflow->fast9_ret_corners,
-                                       &result->tracked_cnt,
-                                       opticflow->window_size / 2, opticflow->subpixel_factor, opticflow->max_iterations,
-                                       opticflow->threshold_vec, opticflow->max_track_corners, opticflow->pyramid_level);
+  struct flow_t *vectors;
+  if (opticflow->pyramid_level > 0) {
+    // Only the pyramid of the new image is built, the one of the previous image is kept from the last frame
+    opticflow_pyramid_update(opticflow);
+    vectors = opticFlowLK_pyramid(opticflow->img_pyramid, opticflow->prev_img_pyramid, opticflow->fast9_ret_corners,
+                                  &result->tracked_cnt,
+                                  opticflow->window_size / 2, opticflow->subpixel_factor, opticflow->max_iterations,
+                                  opticflow->threshold_vec, opticflow->max_track_corners, opticflow->img_pyramid_level,
+                                  &opticflow->arena);
+  } else {
+    vectors = opticFlowLK_flat(&opticflow->img_gray, &opticflow->prev_img_gray, opticflow->fast9_ret_corners,
+                               &result->tracked_cnt,
+                               opticflow->window_size / 2, opticflow->subpixel_factor, opticflow->max_iterations,
+                               opticflow->threshold_vec, opticflow->max_track_corners, &opticflow->arena);
+  }
 
 #if OPTICFLOW_SHOW_FLOW
   image_show_flow(img, vectors, result->tracked_cnt, opticflow->subpixel_factor);
@@ -425,7 +457,7 @@ bool calc_fast9_lukas_kanade(struct opticflow_t *opticflow, struct image_t *img,
   static int n_samples = 100;
   // Estimate size divergence:
   if (SIZE_DIV) {
-    result->div_size = get_size_divergence(vectors, result->tracked_cnt, n_samples);// * result->fps;
+    result->div_size = get_size_divergence(vectors, result->tracked_cnt, n_samples, &opticflow->arena);// * result->fps;
   } else {
     result->div_size = 0.0f;
   }
@@ -457,8 +489,9 @@ bool calc_fast9_lukas_kanade(struct opticflow_t *opticflow, struct image_t *img,
     result->flow_x = 0;
     result->flow_y = 0;
 
-    free(vectors);
+    frame_arena_release(&opticflow->arena, vectors);
     image_switch(&opticflow->img_gray, &opticflow->prev_img_gray);
+    opticflow_pyramid_switch(opticflow);
     return false;
   } else if (result->tracked_cnt % 2) {
     // Take the median point
@@ -531,12 +564,64 @@ bool calc_fast9_lukas_kanade(struct opticflow_t *opticflow, struct image_t *img,
       opticflow->fast9_ret_corners[i].count = vectors[i].pos.count;
     }
   }
-  free(vectors);
+  frame_arena_release(&opticflow->arena, vectors);
   image_switch(&opticflow->img_gray, &opticflow->prev_img_gray);
+  opticflow_pyramid_switch(opticflow);
 
   return true;
 }
 
+/**
+ * Build the Lucas Kanade pyramid of the current gray image.
+ * The pyramid levels are only (re)allocated when the image size, pyramid level or window size changed,
+ * in which case the pyramid of the previous image is rebuilt as well.
+ * @param[in,out] *opticflow The optical flow structure with the gray images
+ */
+static void opticflow_pyramid_update(struct opticflow_t *opticflow)
+{
+  uint8_t level = opticflow->pyramid_level;
+  uint16_t border = opticFlowLK_border_size(opticflow->window_size / 2);
+
+  if (opticflow->img_pyramid_level != level || opticflow->img_pyramid_border != border
+      || opticflow->img_pyramid[0].w != opticflow->img_gray.w + 2 * border
+      || opticflow->img_pyramid[0].h != opticflow->img_gray.h + 2 * border) {
+    if (opticflow->img_pyramid_level > 0) {
+      pyramid_free(opticflow->img_pyramid, opticflow->img_pyramid_level);
+      pyramid_free(opticflow->prev_img_pyramid, opticflow->img_pyramid_level);
+    }
+
+    opticflow->img_pyramid = realloc(opticflow->img_pyramid, sizeof(struct image_t) * (level + 1));
+    opticflow->prev_img_pyramid = realloc(opticflow->prev_img_pyramid, sizeof(struct image_t) * (level + 1));
+    pyramid_create(opticflow->img_pyramid, opticflow->img_gray.w, opticflow->img_gray.h, level, border);
+    pyramid_create(opticflow->prev_img_pyramid, opticflow->img_gray.w, opticflow->img_gray.h, level, border);
+    opticflow->img_pyramid_level = level;
+    opticflow->img_pyramid_border = border;
+    opticflow->prev_img_pyramid_valid = false;
+  }
+
+  if (!opticflow->prev_img_pyramid_valid) {
+    pyramid_update(&opticflow->prev_img_gray, opticflow->prev_img_pyramid, level, border);
+    opticflow->prev_img_pyramid_valid = true;
+  }
+  pyramid_update(&opticflow->img_gray, opticflow->img_pyramid, level, border);
+  opticflow->img_pyramid_valid = true;
+}
+
+/**
+ * Switch the pyramids of the current and previous image, together with image_switch of the gray images.
+ * @param[in,out] *opticflow The optical flow structure with the pyramids
+ */
+static void opticflow_pyramid_switch(struct opticflow_t *opticflow)
+{
+  struct image_t *tmp = opticflow->img_pyramid;
+  opticflow->img_pyramid = opticflow->prev_img_pyramid;
+  opticflow->prev_img_pyramid = tmp;
+
+  // The pyramid is only built when Lucas Kanade ran on the current image
+  opticflow->prev_img_pyramid_valid = opticflow->img_pyramid_valid;
+  opticflow->img_pyramid_valid = false;
+}
+
 /* manage_flow_features - Update list of corners to be tracked by LK
  * Remembers previous points and tries to find new points in less dense
  * areas of the image first.
@@ -580,9 +665,8 @@ static void manage_flow_features(struct image_t *img, struct opticflow_t *opticf
                  NULL);
   } else {
     // allocating memory and initializing the 2d array that holds the number of corners per region and its index (for the sorting)
-    uint16_t **region_count = calloc(opticflow->fast9_num_regions, sizeof(uint16_t *));
+    uint16_t (*region_count)[2] = frame_arena_alloc(&opticflow->arena, opticflow->fast9_num_regions * sizeof(*region_count));
     for (uint16_t i = 0; i < opticflow->fast9_num_regions; i++) {
-      region_count[i] = calloc(2, sizeof(uint16_t));
       region_count[i][0] = 0;
       region_count[i][1] = i;
     }
@@ -607,12 +691,12 @@ static void manage_flow_features(struct image_t *img, struct opticflow_t *opticf
       roi[2] = roi[0] + (img->w / root_regions);
       roi[3] = roi[1] + (img->h / root_regions);
 
-      struct point_t *new_corners = calloc(opticflow->fast9_rsize, sizeof(struct point_t));
+      // The region corner buffer is kept over the frames, as fast9_detect can reallocate it
       uint16_t new_count = 0;
-
       fast9_detect(&opticflow->prev_img_gray, opticflow->fast9_threshold, opticflow->fast9_min_distance,
                    opticflow->fast9_padding, opticflow->fast9_padding, &new_count,
-                   &opticflow->fast9_rsize, &new_corners, roi);
+                   &opticflow->fast9_region_rsize, &opticflow->fast9_region_corners, roi);
+      struct point_t *new_corners = opticflow->fast9_region_corners;
 
       // check that no identified points already exist in list
       for (uint16_t j = 0; j < new_count; j++) {
@@ -638,13 +722,8 @@ static void manage_flow_features(struct image_t *img, struct opticflow_t *opticf
           }
         }
       }
-
-      free(new_corners);
     }
-    for (uint16_t i = 0; i < opticflow->fast9_num_regions; i++) {
-      free(region_count[i]);
-    }
-    free(region_count);
+    frame_arena_release(&opticflow->arena, region_count);
   }
 }
 
@@ -667,8 +746,8 @@ bool calc_edgeflow_tot(struct opticflow_t *opticflow, struct image_t *img,
 
   // Define Normal variables
   struct edgeflow_displacement_t displacement;
-  displacement.x = calloc(img->w, sizeof(int32_t));
-  displacement.y = calloc(img->h, sizeof(int32_t));
+  displacement.x = frame_arena_calloc(&opticflow->arena, img->w, sizeof(int32_t));
+  displacement.y = frame_arena_calloc(&opticflow->arena, img->h, sizeof(int32_t));
 
   // If the methods just switched to this one, reintialize the
   // array of edge_hist structure.
@@ -810,8 +889,8 @@ bool calc_edgeflow_tot(struct opticflow_t *opticflow, struct image_t *img,
   current_frame_nr = (current_frame_nr + 1) % MAX_HORIZON;
 
   // Free alloc'd variables
-  free(displacement.x);
-  free(displacement.y);
+  frame_arena_release(&opticflow->arena, displacement.x);
+  frame_arena_release(&opticflow->arena, displacement.y);
 
   return true;
 }
@@ -840,6 +919,9 @@ bool opticflow_calc_frame(struct opticflow_t *opticflow, struct image_t *img,
     opticflow->just_switched_method = false;
   }
 
+  // Release the scratch buffers of the previous frame
+  frame_arena_reset(&opticflow->arena);
+
   // Switch between methods (0 = fast9/lukas-kanade, 1 = EdgeFlow)
   if (opticflow->method == 0) {
     flow_successful = calc_fast9_lukas_kanade(opticflow, img, result);
@@ -887,15 +969,15 @@ static int cmp_flow(const void *a, const void *b)
 }
 
 /**
- * Compare the rows of an integer (uint16_t) 2D array based on the first column.
+ * Compare the rows of an integer (uint16_t[2]) 2D array based on the first column.
  * Used for sorting.
- * @param[in] *a The first row (should be *uint16_t)
- * @param[in] *b The second flow vector (should be *uint16_t)
+ * @param[in] *a The first row (should be uint16_t[2])
+ * @param[in] *b The second row (should be uint16_t[2])
  * @return Negative if a[0] < b[0],0 if a[0] == b[0] and positive if a[0] > b[0]
  */
 static int cmp_array(const void *a, const void *b)
 {
-  uint16_t *pa = *(uint16_t **)a;
-  uint16_t *pb = *(uint16_t **)b;
+  const uint16_t *pa = (const uint16_t *)a;
+  const uint16_t *pb = (const uint16_t *)b;
   return pa[0] - pb[0];
 }
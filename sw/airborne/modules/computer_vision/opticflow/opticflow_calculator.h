@@ -35,6 +35,7 @@
 #include "std.h"
 #include "inter_thread_data.h"
 #include "lib/vision/image.h"
+#include "lib/vision/frame_arena.h"
 #include "lib/v4l/v4l2.h"
 
 struct opticflow_t {
@@ -42,6 +43,12 @@ struct opticflow_t {
   bool just_switched_method;        ///< Boolean to check if methods has been switched (for reinitialization)
   struct image_t img_gray;              ///< Current gray image frame
   struct image_t prev_img_gray;         ///< Previous gray image frame
+  struct image_t *img_pyramid;          ///< Lucas Kanade pyramid of the current gray image frame
+  struct image_t *prev_img_pyramid;     ///< Lucas Kanade pyramid of the previous gray image frame
+  uint8_t img_pyramid_level;            ///< Pyramid level the pyramids are allocated for (0 == not allocated)
+  uint16_t img_pyramid_border;          ///< Border size the pyramids are allocated for
+  bool img_pyramid_valid;               ///< Whether img_pyramid is built from img_gray
+  bool prev_img_pyramid_valid;          ///< Whether prev_img_pyramid is built from prev_img_gray
 
   uint8_t method;                   ///< Method to use to calculate the optical flow
   uint8_t corner_method;            ///< Method to use for determining where the corners are
@@ -67,6 +74,8 @@ struct opticflow_t {
 
   uint16_t fast9_rsize;             ///< Amount of corners allocated
   struct point_t *fast9_ret_corners;    ///< Corners
+  uint16_t fast9_region_rsize;          ///< Amount of region corners allocated
+  struct point_t *fast9_region_corners; ///< Corners detected in one region of interest (feature management)
   bool feature_management;        ///< Decides whether to keep track corners in memory for the next frame instead of re-detecting every time
   bool fast9_region_detect;       ///< Decides whether to detect fast9 corners in specific regions of interest or the whole image (only for feature management)
   uint8_t fast9_num_regions;      ///< The number of regions of interest the image is split into
@@ -76,6 +85,7 @@ struct opticflow_t {
   int actfast_min_gradient;       ///< Threshold that decides when there is sufficient texture for edge following
   int actfast_gradient_method;    ///< Whether to use a simple or Sobel filter
 
+  struct frame_arena_t arena;     ///< Scratch memory of the current frame, reset for every frame
 
 };
 
@@ -41,9 +41,10 @@
  * @param[in] vectors    The optical flow vectors
  * @param[in] count      The number of optical flow vectors
  * @param[in] n_samples  The number of line segments that will be taken into account. 0 means all line segments will be considered.
+ * @param[in] arena      Frame arena for the temporary divergence estimates (NULL to use malloc)
  * @return divergence
  */
-float get_size_divergence(struct flow_t *vectors, int count, int n_samples)
+float get_size_divergence(struct flow_t *vectors, int count, int n_samples, struct frame_arena_t *arena)
 {
   float distance_1, distance_2;
   float *divs;  // divs will contain the individual divergence estimates:
@@ -60,7 +61,7 @@ float get_size_divergence(struct flow_t *vectors, int count, int n_samples)
   }
 
   if (n_samples == 0) {
-    divs = (float *) malloc(sizeof(float) * max_samples);
+    divs = (float *) frame_arena_alloc(arena, sizeof(float) * max_samples);
 
     // go through all possible lines:
     for (i = 0; i < count; i++) {
@@ -83,7 +84,7 @@ float get_size_divergence(struct flow_t *vectors, int count, int n_samples)
       }
     }
   } else {
-    divs = (float *) malloc(sizeof(float) * n_samples);
+    divs = (float *) frame_arena_alloc(arena, sizeof(float) * n_samples);
 
     // take random samples:
     for (uint16_t sample = 0; sample < n_samples; sample++) {
@@ -118,7 +119,7 @@ float get_size_divergence(struct flow_t *vectors, int count, int n_samples)
   float mean_divergence = mean_f(divs, used_samples);
 
   // free the memory of divs:
-  free(divs);
+  frame_arena_release(arena, divs);
 
   // return the calculated divergence:
   return mean_divergence;
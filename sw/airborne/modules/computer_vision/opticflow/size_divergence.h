@@ -30,11 +30,12 @@
  */
 
 #include "lib/vision/image.h"
+#include "lib/vision/frame_arena.h"
 
 #ifndef SIZE_DIVERGENCE
 #define SIZE_DIVERGENCE
 
-float get_size_divergence(struct flow_t *vectors, int count, int n_samples);
+float get_size_divergence(struct flow_t *vectors, int count, int n_samples, struct frame_arena_t *arena);
 float get_mean(float *numbers, int n_elements);
 
 #endif
@@ -185,6 +185,11 @@ static bool initialize_camera(struct video_config_t *camera)
     return false;
   }
 
+  // Limit the amount of buffers shared with asynchronous listeners (never more than the default)
+  if (camera->max_frames_held > 0 && camera->max_frames_held < camera->thread.dev->buffers_held_max) {
+    camera->thread.dev->buffers_held_max = camera->max_frames_held;
+  }
+
   // Initialize OK
   return true;
 }
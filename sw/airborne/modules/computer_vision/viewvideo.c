@@ -66,6 +66,12 @@ PRINT_CONFIG_VAR(VIEWVIDEO_QUALITY_FACTOR)
 #endif
 PRINT_CONFIG_VAR(VIEWVIDEO_FPS)
 
+// Amount of 8 pixel rows per JPEG restart interval, which are encoded in parallel (0 = no restart intervals)
+#ifndef VIEWVIDEO_RESTART_ROWS
+#define VIEWVIDEO_RESTART_ROWS 0
+#endif
+PRINT_CONFIG_VAR(VIEWVIDEO_RESTART_ROWS)
+
 // Define stream priority
 #ifndef VIEWVIDEO_NICE_LEVEL
 #define VIEWVIDEO_NICE_LEVEL 5
@@ -106,39 +112,64 @@ struct viewvideo_t viewvideo = {
 #endif
 };
 
+/**
+ * Buffers of one video stream, kept between the frames
+ */
+struct viewvideo_buffers_t {
+  struct image_t img_small;   ///< Downsized image
+  struct image_t img_jpeg;    ///< JPEG encoded image
+};
+
+/**
+ * (Re)create an image buffer only when its size changed
+ * @param[in,out] *img The image, with a NULL buffer when not created yet
+ * @param[in] width The needed width
+ * @param[in] height The needed height
+ * @param[in] type The type of the image
+ */
+static void viewvideo_image_check(struct image_t *img, uint16_t width, uint16_t height, enum image_type type)
+{
+  if (img->buf != NULL && img->w == width && img->h == height) {
+    return;
+  }
+  if (img->buf != NULL) {
+    image_free(img);
+  }
+  image_create(img, width, height, type);
+}
+
 /**
  * Handles all the video streaming and saving of the image shots
  * This is a separate thread, so it needs to be thread safe!
  */
-static struct image_t *viewvideo_function(struct UdpSocket *viewvideo_socket, struct image_t *img, uint16_t *rtp_packet_nr, uint32_t *rtp_frame_time)
+static struct image_t *viewvideo_function(struct UdpSocket *viewvideo_socket, struct image_t *img,
+    struct viewvideo_buffers_t *buffers, uint16_t *rtp_packet_nr, uint32_t *rtp_frame_time)
 {
-  // Resize image if needed
-  struct image_t img_small;
-  image_create(&img_small,
-               img->w / viewvideo.downsize_factor,
-               img->h / viewvideo.downsize_factor,
-               IMAGE_YUV422);
-
-  // Create the JPEG encoded image
-  struct image_t img_jpeg;
-  image_create(&img_jpeg, img_small.w, img_small.h, IMAGE_JPEG);
-
 #if VIEWVIDEO_USE_NETCAT
   char nc_cmd[64];
   sprintf(nc_cmd, "nc %s %d 2>/dev/null", STRINGIFY(VIEWVIDEO_HOST), VIEWVIDEO_PORT_OUT);
 #endif
 
   if (viewvideo.is_streaming) {
+    struct image_t *img_in = img;
+    struct image_t *img_jpeg = &buffers->img_jpeg;
 
     // Only resize when needed
     if (viewvideo.downsize_factor != 1) {
-      image_yuv422_downsample(img, &img_small, viewvideo.downsize_factor);
-      jpeg_encode_image(&img_small, &img_jpeg, VIEWVIDEO_QUALITY_FACTOR, VIEWVIDEO_USE_NETCAT);
-    } else {
-      jpeg_encode_image(img, &img_jpeg, VIEWVIDEO_QUALITY_FACTOR, VIEWVIDEO_USE_NETCAT);
+      viewvideo_image_check(&buffers->img_small, img->w / viewvideo.downsize_factor, img->h / viewvideo.downsize_factor,
+                            IMAGE_YUV422);
+      image_yuv422_downsample(img, &buffers->img_small, viewvideo.downsize_factor);
+      img_in = &buffers->img_small;
     }
 
+    // The JPEG buffer is reused as long as the stream size does not change
+    viewvideo_image_check(img_jpeg, img_in->w, img_in->h, IMAGE_JPEG);
+    uint16_t restart_interval = jpeg_encode_image_restart(img_in, img_jpeg, VIEWVIDEO_QUALITY_FACTOR,
+                                VIEWVIDEO_USE_NETCAT, VIEWVIDEO_RESTART_ROWS);
+
 #if VIEWVIDEO_USE_NETCAT
+    (void) restart_interval; // The DRI marker is in the JPEG header
+
     // Open process to send using netcat (in a fork because sometimes kills itself???)
     pid_t pid = fork();
 
@@ -148,7 +179,7 @@ static struct image_t *viewvideo_function(struct UdpSocket *viewvideo_socket, st
       // We are the child and want to send the image
       FILE *netcat = popen(nc_cmd, "w");
       if (netcat != NULL) {
-        fwrite(img_jpeg.buf, sizeof(uint8_t), img_jpeg.buf_size, netcat);
+        fwrite(img_jpeg->buf, sizeof(uint8_t), img_jpeg->buf_size, netcat);
         pclose(netcat); // Ignore output, because it is too much when not connected
       } else {
         printf("[viewvideo] Failed to open netcat process.\n");
@@ -165,10 +196,10 @@ static struct image_t *viewvideo_function(struct UdpSocket *viewvideo_socket, st
       // Send image with RTP
       rtp_frame_send(
         viewvideo_socket,         // UDP socket
-        &img_jpeg,
+        img_jpeg,
         0,                        // Format 422
         VIEWVIDEO_QUALITY_FACTOR, // Jpeg-Quality
-        0,                        // DRI Header
+        restart_interval,         // Restart interval in MCUs (0 = none)
         VIEWVIDEO_FPS,
         //(img->ts.tv_sec * 1000000 + img->ts.tv_usec),
         rtp_packet_nr,
@@ -178,9 +209,6 @@ static struct image_t *viewvideo_function(struct UdpSocket *viewvideo_socket, st
 #endif
   }
 
-  // Free all buffers
-  image_free(&img_jpeg);
-  image_free(&img_small);
   return NULL; // No new images were created
 }
 
@@ -189,7 +217,8 @@ static struct image_t *viewvideo_function1(struct image_t *img)
 {
   static uint16_t rtp_packet_nr = 0;
   static uint32_t rtp_frame_time = 0;
-  return viewvideo_function(&video_sock1, img, &rtp_packet_nr, &rtp_frame_time);
+  static struct viewvideo_buffers_t buffers;
+  return viewvideo_function(&video_sock1, img, &buffers, &rtp_packet_nr, &rtp_frame_time);
 }
 #endif
 
@@ -198,7 +227,8 @@ static struct image_t *viewvideo_function2(struct image_t *img)
 {
   static uint16_t rtp_packet_nr = 0;
   static uint32_t rtp_frame_time = 0;
-  return viewvideo_function(&video_sock2, img, &rtp_packet_nr, &rtp_frame_time);
+  static struct viewvideo_buffers_t buffers;
+  return viewvideo_function(&video_sock2, img, &buffers, &rtp_packet_nr, &rtp_frame_time);
 }
 #endif
 
@@ -36,6 +36,50 @@
 /** Global system monitor data (averaged over 1 sec) */
 struct SysMon sys_mon;
 
+#if SYS_TIME_TIMER_STATS && PERIODIC_TELEMETRY
+#include "subsystems/datalink/telemetry.h"
+
+#define TIMER_STATS_NB_VALUES (9 + SYS_TIME_STATS_HIST_NB)
+
+/**
+ * Send the statistics of one sys_time timer per call, in turn,
+ * and start a new statistics window for this timer.
+ * PAYLOAD_FLOAT values, in this order: [0] id, [1] period, [2] runs, [3] missed,
+ * [4] overruns, [5] latency mean, [6] latency max, [7] run time mean,
+ * [8] run time max (times in usec), [9..] run time histogram.
+ */
+static void send_timer_stats(struct transport_tx *trans, struct link_device *dev)
+{
+  static tid_t id = 0;
+  for (int i = 0; i < SYS_TIME_NB_TIMER && !sys_time.timer[id].in_use; i++) {
+    id = (id + 1) % SYS_TIME_NB_TIMER;
+  }
+  if (!sys_time.timer[id].in_use) {
+    return;
+  }
+
+  struct sys_time_timer_stats window;
+  struct sys_time_timer_stats *stats = &window;
+  sys_time_timer_stats_take(id, stats);
+  float values[TIMER_STATS_NB_VALUES];
+  values[0] = id;
+  values[1] = 1e6f * sec_of_sys_time_ticks(sys_time.timer[id].duration);
+  values[2] = stats->nb_runs;
+  values[3] = stats->nb_missed;
+  values[4] = stats->nb_overruns;
+  values[5] = stats->nb_runs > 0 ? (float)stats->latency_sum / stats->nb_runs : 0.f;
+  values[6] = stats->latency_max;
+  values[7] = stats->nb_done > 0 ? (float)stats->run_sum / stats->nb_done : 0.f;
+  values[8] = stats->run_max;
+  for (int i = 0; i < SYS_TIME_STATS_HIST_NB; i++) {
+    values[9 + i] = stats->run_hist[i];
+  }
+  pprz_msg_send_PAYLOAD_FLOAT(trans, dev, AC_ID, TIMER_STATS_NB_VALUES, values);
+
+  id = (id + 1) % SYS_TIME_NB_TIMER;
+}
+#endif
+
 /* Local vars */
 static uint16_t n_periodic;
 static uint16_t n_event;
@@ -68,6 +112,10 @@ void init_sysmon(void)
   min_time_event = ~0;
   sum_n_event = 0;
   periodic_timer = 0;
+
+#if SYS_TIME_TIMER_STATS && PERIODIC_TELEMETRY
+  register_periodic_telemetry(DefaultPeriodic, PPRZ_MSG_ID_PAYLOAD_FLOAT, send_timer_stats);
+#endif
 }
 
 void periodic_report_sysmon(void)
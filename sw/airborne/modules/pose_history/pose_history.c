@@ -20,63 +20,130 @@
 /**
  * @file "modules/pose_history/pose_history.c"
  * @author Roland Meertens
- * Ask this module for the pose the drone had closest to a given timestamp
+ * Ask this module for the pose the drone had at a given timestamp (interpolated between the recorded poses)
  */
 
 #include "modules/pose_history/pose_history.h"
 #include <sys/time.h>
 #include "mcu_periph/sys_time.h"
 #include "state.h"
-#ifdef __linux__
-#include <pthread.h>
-#endif
 
 #ifndef POSE_HISTORY_SIZE
 #define POSE_HISTORY_SIZE 1024
 #endif
 
+/** Pose sample as stored in the history */
+struct pose_sample_t {
+  uint32_t timestamp;           ///< Time of the sample in pprz usec
+  struct FloatQuat quat;        ///< NED to body attitude
+  struct FloatRates rates;      ///< Body rates
+};
+
+/**
+ * Ring buffer with a single producer (pose_periodic) and multiple consumers.
+ * Instead of a mutex it uses a sequence lock: the producer makes the sequence odd while writing,
+ * consumers retry when the sequence was odd or changed during their read. This way the producer
+ * (the AP thread) is never blocked by a (vision) thread looking up a pose.
+ */
 struct rotation_history_ring_buffer_t {
-  uint32_t ring_index;
-  uint32_t ring_size;
-  struct pose_t ring_data[POSE_HISTORY_SIZE];
+  volatile uint32_t seq;        ///< Sequence counter, odd while a sample is written
+  uint32_t ring_index;          ///< Index the next sample is written to
+  uint32_t ring_count;          ///< Amount of samples in the buffer
+  struct pose_sample_t ring_data[POSE_HISTORY_SIZE];
 };
 
 struct rotation_history_ring_buffer_t location_history;
 
-#ifdef __linux__
-pthread_mutex_t pose_mutex;
-#endif
+/**
+ * Start reading from the history, waits while the producer is writing
+ * @return The sequence to pass to pose_read_retry
+ */
+static inline uint32_t pose_read_begin(void)
+{
+  uint32_t seq;
+  do {
+    seq = location_history.seq;
+  } while (seq & 1);
+  __sync_synchronize();
+  return seq;
+}
 
 /**
- * Given a pprz timestamp in used (obtained with get_sys_time_usec) we return the pose in FloatEulers closest to that time.
+ * Check if the history was modified while reading
+ * @param[in] seq The sequence returned by pose_read_begin
+ * @return True if the data that was read is inconsistent and has to be read again
+ */
+static inline bool pose_read_retry(uint32_t seq)
+{
+  __sync_synchronize();
+  return location_history.seq != seq;
+}
+
+/**
+ * Sample of the history, counted from the oldest sample
+ */
+static inline struct pose_sample_t *pose_sample(uint32_t idx)
+{
+  return &location_history.ring_data[(location_history.ring_index + POSE_HISTORY_SIZE - location_history.ring_count + idx)
+                                     % POSE_HISTORY_SIZE];
+}
+
+/**
+ * Given a pprz timestamp in used (obtained with get_sys_time_usec) we return the pose in FloatEulers at that time.
+ * The attitude is interpolated (slerp) and the rates linearly interpolated between the samples just before and after
+ * the timestamp. Outside of the history the oldest or the newest pose is returned.
  */
 struct pose_t get_rotation_at_timestamp(uint32_t timestamp)
 {
-#ifdef __linux__
-  pthread_mutex_lock(&pose_mutex);
-#endif
-  uint32_t index_history = 0;
-  uint32_t closestTimeDiff = abs(timestamp - location_history.ring_data[0].timestamp);
-  uint32_t closestIndex = 0;
-
-  // Seach for the timestamp closes to the timestamp argument of this function.
-  for (index_history = 0; index_history < location_history.ring_size; index_history++) {
-    uint32_t diff = abs(timestamp - location_history.ring_data[index_history].timestamp);
-    if (diff < closestTimeDiff) {
-      closestIndex = index_history;
-      closestTimeDiff = diff;
+  struct pose_sample_t before, after;
+  uint32_t count, seq;
+
+  do {
+    seq = pose_read_begin();
+    count = location_history.ring_count;
+    if (count == 0) {
+      break;
+    }
+
+    // Binary search for the first sample not before the timestamp, the timestamps are increasing from the
+    // oldest sample on (compared relative to the timestamp so that the wrap around of the time is handled)
+    uint32_t lo = 0, hi = count;
+    while (lo < hi) {
+      uint32_t mid = lo + (hi - lo) / 2;
+      if ((int32_t)(pose_sample(mid)->timestamp - timestamp) < 0) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
     }
+
+    after = *pose_sample(Min(lo, count - 1));
+    before = *pose_sample((lo > 0) ? lo - 1 : 0);
+  } while (pose_read_retry(seq));
+
+  struct pose_t pose;
+  pose.timestamp = timestamp;
+  if (count == 0) {
+    FLOAT_EULERS_ZERO(pose.eulers);
+    FLOAT_RATES_ZERO(pose.rates);
+    return pose;
   }
 
-  // Save the pose closest to the given timestamp and return this
-  struct pose_t closest_pose;
-  closest_pose.eulers = location_history.ring_data[closestIndex].eulers;
-  closest_pose.rates = location_history.ring_data[closestIndex].rates;
+  // Interpolation factor between the two samples (0 when before the oldest or after the newest sample)
+  float t = 0.f;
+  int32_t dt = (int32_t)(after.timestamp - before.timestamp);
+  if (dt > 0) {
+    t = (float)(int32_t)(timestamp - before.timestamp) / dt;
+    Bound(t, 0.f, 1.f);
+  }
 
-#ifdef __linux__
-  pthread_mutex_unlock(&pose_mutex);
-#endif
-  return closest_pose;
+  struct FloatQuat quat;
+  float_quat_slerp(&quat, &before.quat, &after.quat, t);
+  float_eulers_of_quat(&pose.eulers, &quat);
+  pose.rates.p = before.rates.p + t * (after.rates.p - before.rates.p);
+  pose.rates.q = before.rates.q + t * (after.rates.q - before.rates.q);
+  pose.rates.r = before.rates.r + t * (after.rates.r - before.rates.r);
+  return pose;
 }
 
 /**
@@ -84,8 +151,9 @@ struct pose_t get_rotation_at_timestamp(uint32_t timestamp)
  */
 void pose_init()
 {
+  location_history.seq = 0;
   location_history.ring_index = 0;
-  location_history.ring_size = POSE_HISTORY_SIZE;
+  location_history.ring_count = 0;
 }
 
 
@@ -95,21 +163,22 @@ void pose_init()
 void pose_periodic()
 {
   uint32_t now_ts = get_sys_time_usec();
-#ifdef __linux__
-  pthread_mutex_lock(&pose_mutex);
-#endif
-  struct pose_t *current_time_and_rotation = &location_history.ring_data[location_history.ring_index];
-  current_time_and_rotation->eulers = *stateGetNedToBodyEulers_f();
-  current_time_and_rotation->rates = *stateGetBodyRates_f();
 
+  // Start writing, readers will retry until the sequence is even again
+  location_history.seq++;
+  __sync_synchronize();
+
+  struct pose_sample_t *current_time_and_rotation = &location_history.ring_data[location_history.ring_index];
+  current_time_and_rotation->quat = *stateGetNedToBodyQuat_f();
+  current_time_and_rotation->rates = *stateGetBodyRates_f();
   current_time_and_rotation->timestamp = now_ts;
 
   // increase index location history
-  location_history.ring_index = (location_history.ring_index + 1) % location_history.ring_size;
+  location_history.ring_index = (location_history.ring_index + 1) % POSE_HISTORY_SIZE;
+  if (location_history.ring_count < POSE_HISTORY_SIZE) {
+    location_history.ring_count++;
+  }
 
-#ifdef __linux__
-  pthread_mutex_unlock(&pose_mutex);
-#endif
+  __sync_synchronize();
+  location_history.seq++;
 }
-
-
@@ -20,7 +20,7 @@
 /**
  * @file "modules/pose_history/pose_history.h"
  * @author Roland Meertens
- * Ask this module for the pose the drone had closest to a given timestamp
+ * Ask this module for the pose the drone had at a given timestamp (interpolated between the recorded poses)
  */
 
 #ifndef POSE_HISTORY_H
@@ -50,6 +50,7 @@ struct video_config_t {
   uint32_t format;          ///< Video format
   uint32_t subdev_format;   ///< Subdevice video format
   uint8_t buf_cnt;          ///< Amount of V4L2 video device buffers
+  uint8_t max_frames_held;  ///< Maximum amount of V4L2 buffers shared with asynchronous listeners (0 for the default)
   uint8_t filters;          ///< filters to use (bitfield with VIDEO_FILTER_x)
   struct video_thread_t thread; ///< Information about the thread this camera is running on
   struct video_listener *cv_listener; ///< The first computer vision listener in the linked list for this video device
@@ -56,6 +56,20 @@ void stateInit(void)
   state.utm_origin_f.zone = 0;
 }
 
+/**
+ * UTM of the float LLA position.
+ * When a UTM origin is set, the position is projected in the zone of the
+ * origin, so that the local position is the difference with the origin even
+ * across a zone border.
+ */
+static inline void state_utm_of_lla_f(void)
+{
+  if (state.utm_initialized_f) {
+    state.utm_pos_f.zone = state.utm_origin_f.zone;
+  }
+  utm_of_lla_f(&state.utm_pos_f, &state.lla_pos_f);
+}
+
 
 /*******************************************************************************
  *                                                                             *
@@ -65,6 +79,28 @@ void stateInit(void)
 /** @addtogroup state_position
  *  @{ */
 
+/**
+ * Rotate a local float NED vector to ECEF.
+ * Same double precision computation as ecef_of_ned_vect_f, but with the
+ * rotation precomputed when the local origin is set.
+ */
+static inline void state_ecef_of_ned_vect_f(struct EcefCoor_f *ecef, struct NedCoor_f *ned)
+{
+  struct DoubleVect3 enu_d = { (double)ned->y, (double)ned->x, -(double)ned->z };
+  struct DoubleVect3 ecef_d;
+  MAT33_VECT3_TRANSP_MUL(ecef_d, state.ned_origin_ltp_of_ecef_d, enu_d);
+  ecef->x = (float)ecef_d.x;
+  ecef->y = (float)ecef_d.y;
+  ecef->z = (float)ecef_d.z;
+}
+
+/// ECEF of a local float NED point, see state_ecef_of_ned_vect_f.
+static inline void state_ecef_of_ned_point_f(struct EcefCoor_f *ecef, struct NedCoor_f *ned)
+{
+  state_ecef_of_ned_vect_f(ecef, ned);
+  VECT3_ADD(*ecef, state.ned_origin_f.ecef);
+}
+
 void stateCalcPositionEcef_i(void)
 {
   if (bit_is_set(state.pos_status, POS_ECEF_I)) {
@@ -77,7 +113,7 @@ void stateCalcPositionEcef_i(void)
     ecef_of_ned_pos_i(&state.ecef_pos_i, &state.ned_origin_i, &state.ned_pos_i);
   } else if (bit_is_set(state.pos_status, POS_NED_F) && state.ned_initialized_f) {
     /* transform ned_f to ecef_f, set status bit, then convert to int */
-    ecef_of_ned_point_f(&state.ecef_pos_f, &state.ned_origin_f, &state.ned_pos_f);
+    state_ecef_of_ned_point_f(&state.ecef_pos_f, &state.ned_pos_f);
     SetBit(state.pos_status, POS_ECEF_F);
     ECEF_BFP_OF_REAL(state.ecef_pos_i, state.ecef_pos_f);
   } else if (bit_is_set(state.pos_status, POS_LLA_I)) {
@@ -147,7 +183,7 @@ void stateCalcPositionNed_i(void)
       NED_BFP_OF_REAL(state.ned_pos_i, state.ned_pos_f);
     } else if (bit_is_set(state.pos_status, POS_LLA_F)) {
       /* transform lla_f -> utm_f -> ned_f -> ned_i, set status bits */
-      utm_of_lla_f(&state.utm_pos_f, &state.lla_pos_f);
+      state_utm_of_lla_f();
       SetBit(state.pos_status, POS_UTM_F);
       NED_OF_UTM_DIFF(state.ned_pos_f, state.utm_pos_f, state.utm_origin_f);
       SetBit(state.pos_status, POS_NED_F);
@@ -156,7 +192,7 @@ void stateCalcPositionNed_i(void)
       /* transform lla_i -> lla_f -> utm_f -> ned_f -> ned_i, set status bits */
       LLA_FLOAT_OF_BFP(state.lla_pos_f, state.lla_pos_i);
       SetBit(state.pos_status, POS_LLA_F);
-      utm_of_lla_f(&state.utm_pos_f, &state.lla_pos_f);
+      state_utm_of_lla_f();
       SetBit(state.pos_status, POS_UTM_F);
       NED_OF_UTM_DIFF(state.ned_pos_f, state.utm_pos_f, state.utm_origin_f);
       SetBit(state.pos_status, POS_NED_F);
@@ -226,7 +262,7 @@ void stateCalcPositionEnu_i(void)
       ENU_BFP_OF_REAL(state.enu_pos_i, state.enu_pos_f);
     } else if (bit_is_set(state.pos_status, POS_LLA_F)) {
       /* transform lla_f -> utm_f -> enu_f -> enu_i , set status bits */
-      utm_of_lla_f(&state.utm_pos_f, &state.lla_pos_f);
+      state_utm_of_lla_f();
       SetBit(state.pos_status, POS_UTM_F);
       ENU_OF_UTM_DIFF(state.enu_pos_f, state.utm_pos_f, state.utm_origin_f);
       SetBit(state.pos_status, POS_ENU_F);
@@ -235,7 +271,7 @@ void stateCalcPositionEnu_i(void)
       /* transform lla_i -> lla_f -> utm_f -> enu_f -> enu_i , set status bits */
       LLA_FLOAT_OF_BFP(state.lla_pos_f, state.lla_pos_i);
       SetBit(state.pos_status, POS_LLA_F);
-      utm_of_lla_f(&state.utm_pos_f, &state.lla_pos_f);
+      state_utm_of_lla_f();
       SetBit(state.pos_status, POS_UTM_F);
       ENU_OF_UTM_DIFF(state.enu_pos_f, state.utm_pos_f, state.utm_origin_f);
       SetBit(state.pos_status, POS_ENU_F);
@@ -320,12 +356,12 @@ void stateCalcPositionUtm_f(void)
   }
 
   if (bit_is_set(state.pos_status, POS_LLA_F)) {
-    utm_of_lla_f(&state.utm_pos_f, &state.lla_pos_f);
+    state_utm_of_lla_f();
   } else if (bit_is_set(state.pos_status, POS_LLA_I)) {
     /* transform lla_i -> lla_f -> utm_f, set status bits */
     LLA_FLOAT_OF_BFP(state.lla_pos_f, state.lla_pos_i);
     SetBit(state.pos_status, POS_LLA_F);
-    utm_of_lla_f(&state.utm_pos_f, &state.lla_pos_f);
+    state_utm_of_lla_f();
   } else if (state.utm_initialized_f) {
     if (bit_is_set(state.pos_status, POS_ENU_F)) {
       UTM_OF_ENU_ADD(state.utm_pos_f, state.enu_pos_f, state.utm_origin_f);
@@ -358,7 +394,7 @@ void stateCalcPositionEcef_f(void)
   if (bit_is_set(state.pos_status, POS_ECEF_I)) {
     ECEF_FLOAT_OF_BFP(state.ecef_pos_f, state.ecef_pos_i);
   } else if (bit_is_set(state.pos_status, POS_NED_F) && state.ned_initialized_f) {
-    ecef_of_ned_point_f(&state.ecef_pos_f, &state.ned_origin_f, &state.ned_pos_f);
+    state_ecef_of_ned_point_f(&state.ecef_pos_f, &state.ned_pos_f);
   } else if (bit_is_set(state.pos_status, POS_NED_I) && state.ned_initialized_i) {
     /* transform ned_i -> ecef_i -> ecef_f, set status bits */
     ecef_of_ned_pos_i(&state.ecef_pos_i, &state.ned_origin_i, &state.ned_pos_i);
@@ -397,7 +433,10 @@ void stateCalcPositionNed_f(void)
       SetBit(state.pos_status, POS_NED_I);
       NED_FLOAT_OF_BFP(state.ned_pos_f, state.ned_pos_i);
     } else if (bit_is_set(state.pos_status, POS_LLA_F)) {
-      ned_of_lla_point_f(&state.ned_pos_f, &state.ned_origin_f, &state.lla_pos_f);
+      /* transform lla_f -> ecef_f -> ned_f, set status bits */
+      ecef_of_lla_f(&state.ecef_pos_f, &state.lla_pos_f);
+      SetBit(state.pos_status, POS_ECEF_F);
+      ned_of_ecef_point_f(&state.ned_pos_f, &state.ned_origin_f, &state.ecef_pos_f);
     } else if (bit_is_set(state.pos_status, POS_LLA_I)) {
       /* transform lla_i -> ecef_i -> ned_i -> ned_f, set status bits */
       ecef_of_lla_i(&state.ecef_pos_i, &state.lla_pos_i); /* converts to doubles internally */
@@ -421,14 +460,14 @@ void stateCalcPositionNed_f(void)
       NED_OF_UTM_DIFF(state.ned_pos_f, state.utm_pos_f, state.utm_origin_f);
     } else if (bit_is_set(state.pos_status, POS_LLA_F)) {
       /* transform lla_f -> utm_f -> ned, set status bits */
-      utm_of_lla_f(&state.utm_pos_f, &state.lla_pos_f);
+      state_utm_of_lla_f();
       SetBit(state.pos_status, POS_UTM_F);
       NED_OF_UTM_DIFF(state.ned_pos_f, state.utm_pos_f, state.utm_origin_f);
     } else if (bit_is_set(state.pos_status, POS_LLA_I)) {
       /* transform lla_i -> lla_f -> utm_f -> ned, set status bits */
       LLA_FLOAT_OF_BFP(state.lla_pos_f, state.lla_pos_i);
       SetBit(state.pos_status, POS_LLA_F);
-      utm_of_lla_f(&state.utm_pos_f, &state.lla_pos_f);
+      state_utm_of_lla_f();
       SetBit(state.pos_status, POS_UTM_F);
       NED_OF_UTM_DIFF(state.ned_pos_f, state.utm_pos_f, state.utm_origin_f);
     } else { /* could not get this representation,  set errno */
@@ -469,7 +508,10 @@ void stateCalcPositionEnu_f(void)
       SetBit(state.pos_status, POS_ENU_I);
       ENU_FLOAT_OF_BFP(state.enu_pos_f, state.enu_pos_i);
     } else if (bit_is_set(state.pos_status, POS_LLA_F)) {
-      enu_of_lla_point_f(&state.enu_pos_f, &state.ned_origin_f, &state.lla_pos_f);
+      /* transform lla_f -> ecef_f -> enu_f, set status bits */
+      ecef_of_lla_f(&state.ecef_pos_f, &state.lla_pos_f);
+      SetBit(state.pos_status, POS_ECEF_F);
+      enu_of_ecef_point_f(&state.enu_pos_f, &state.ned_origin_f, &state.ecef_pos_f);
     } else if (bit_is_set(state.pos_status, POS_LLA_I)) {
       /* transform lla_i -> ecef_i -> enu_i -> enu_f, set status bits */
       ecef_of_lla_i(&state.ecef_pos_i, &state.lla_pos_i); /* converts to doubles internally */
@@ -493,14 +535,14 @@ void stateCalcPositionEnu_f(void)
       ENU_OF_UTM_DIFF(state.enu_pos_f, state.utm_pos_f, state.utm_origin_f);
     } else if (bit_is_set(state.pos_status, POS_LLA_F)) {
       /* transform lla_f -> utm_f -> enu, set status bits */
-      utm_of_lla_f(&state.utm_pos_f, &state.lla_pos_f);
+      state_utm_of_lla_f();
       SetBit(state.pos_status, POS_UTM_F);
       ENU_OF_UTM_DIFF(state.enu_pos_f, state.utm_pos_f, state.utm_origin_f);
     } else if (bit_is_set(state.pos_status, POS_LLA_I)) {
       /* transform lla_i -> lla_f -> utm_f -> enu, set status bits */
       LLA_FLOAT_OF_BFP(state.lla_pos_f, state.lla_pos_i);
       SetBit(state.pos_status, POS_LLA_F);
-      utm_of_lla_f(&state.utm_pos_f, &state.lla_pos_f);
+      state_utm_of_lla_f();
       SetBit(state.pos_status, POS_UTM_F);
       ENU_OF_UTM_DIFF(state.enu_pos_f, state.utm_pos_f, state.utm_origin_f);
     } else { /* could not get this representation,  set errno */
@@ -524,7 +566,7 @@ void stateCalcPositionLla_f(void)
   }
 
   if (bit_is_set(state.pos_status, POS_LLA_I)) {
-    LLA_FLOAT_OF_BFP(state.lla_pos_f, state.lla_pos_f);
+    LLA_FLOAT_OF_BFP(state.lla_pos_f, state.lla_pos_i);
   } else if (bit_is_set(state.pos_status, POS_ECEF_F)) {
     lla_of_ecef_f(&state.lla_pos_f, &state.ecef_pos_f);
   } else if (bit_is_set(state.pos_status, POS_ECEF_I)) {
@@ -534,14 +576,14 @@ void stateCalcPositionLla_f(void)
     lla_of_ecef_f(&state.lla_pos_f, &state.ecef_pos_f);
   } else if (bit_is_set(state.pos_status, POS_NED_F) && state.ned_initialized_f) {
     /* transform ned_f -> ecef_f -> lla_f, set status bits */
-    ecef_of_ned_point_f(&state.ecef_pos_f, &state.ned_origin_f, &state.ned_pos_f);
+    state_ecef_of_ned_point_f(&state.ecef_pos_f, &state.ned_pos_f);
     SetBit(state.pos_status, POS_ECEF_F);
     lla_of_ecef_f(&state.lla_pos_f, &state.ecef_pos_f);
   } else if (bit_is_set(state.pos_status, POS_NED_I) && state.ned_initialized_f) {
     /* transform ned_i -> ned_f -> ecef_f -> lla_f, set status bits */
     NED_FLOAT_OF_BFP(state.ned_pos_f, state.ned_pos_i);
     SetBit(state.pos_status, POS_NED_F);
-    ecef_of_ned_point_f(&state.ecef_pos_f, &state.ned_origin_f, &state.ned_pos_f);
+    state_ecef_of_ned_point_f(&state.ecef_pos_f, &state.ned_pos_f);
     SetBit(state.pos_status, POS_ECEF_F);
     lla_of_ecef_f(&state.lla_pos_f, &state.ecef_pos_f);
   } else if (bit_is_set(state.pos_status, POS_UTM_F)) {
@@ -554,6 +596,82 @@ void stateCalcPositionLla_f(void)
   /* set bit to indicate this representation is computed */
   SetBit(state.pos_status, POS_LLA_F);
 }
+
+/**
+ * Calculate several position representations at once.
+ * The representations are computed in an order in which the expensive
+ * geodetic conversions are done once and the others derive from their result,
+ * e.g. from a NED position with a UTM origin: NED -> UTM -> LLA,
+ * or from a LLA position: LLA -> ECEF -> NED -> ENU.
+ * Use it before reading three or more representations of the same position.
+ * @param mask the representations to compute, bits (1 << POS_xxx)
+ */
+void stateCalcPositions(uint16_t mask)
+{
+  /* only the representations which are not computed yet */
+  mask &= ~state.pos_status;
+  if (mask == 0) {
+    return;
+  }
+
+  /* with a NED origin the integer global positions first, they keep their higher precision
+   * path from the local position and the float ones become copies of them */
+  if (state.ned_initialized_i) {
+    if (bit_is_set(mask, POS_LLA_I)) {
+      stateCalcPositionLla_i();
+    }
+    if (bit_is_set(mask, POS_ECEF_I)) {
+      stateCalcPositionEcef_i();
+    }
+  }
+
+  /* local frame: from a global position this also keeps the ECEF intermediate */
+  if (bit_is_set(mask, POS_NED_F)) {
+    stateCalcPositionNed_f();
+  }
+  if (bit_is_set(mask, POS_ENU_F)) {
+    stateCalcPositionEnu_f();
+  }
+
+  /* UTM before LLA, it is a translation of the local position with a UTM origin */
+  if (bit_is_set(mask, POS_UTM_F)) {
+    if (!state.utm_initialized_f) {
+      stateCalcPositionLla_f();
+    }
+    stateCalcPositionUtm_f();
+  }
+
+  /* with a NED origin ECEF is a rotation of the local position, otherwise it follows from LLA */
+  if (state.ned_initialized_f) {
+    if (bit_is_set(mask, POS_ECEF_F)) {
+      stateCalcPositionEcef_f();
+    }
+    if (bit_is_set(mask, POS_LLA_F)) {
+      stateCalcPositionLla_f();
+    }
+  } else {
+    if (mask & ((1 << POS_ECEF_F) | (1 << POS_LLA_F))) {
+      stateCalcPositionLla_f();
+    }
+    if (bit_is_set(mask, POS_ECEF_F)) {
+      stateCalcPositionEcef_f();
+    }
+  }
+
+  /* remaining integer representations, mostly fixed-point copies of the float ones */
+  if (bit_is_set(mask, POS_ECEF_I)) {
+    stateCalcPositionEcef_i();
+  }
+  if (bit_is_set(mask, POS_NED_I)) {
+    stateCalcPositionNed_i();
+  }
+  if (bit_is_set(mask, POS_ENU_I)) {
+    stateCalcPositionEnu_i();
+  }
+  if (bit_is_set(mask, POS_LLA_I)) {
+    stateCalcPositionLla_i();
+  }
+}
 /** @}*/
 
 
@@ -874,12 +992,12 @@ void stateCalcSpeedEcef_f(void)
   if (bit_is_set(state.speed_status, SPEED_ECEF_I)) {
     SPEEDS_FLOAT_OF_BFP(state.ecef_speed_f, state.ned_speed_i);
   } else if (bit_is_set(state.speed_status, SPEED_NED_F)) {
-    ecef_of_ned_vect_f(&state.ecef_speed_f, &state.ned_origin_f, &state.ned_speed_f);
+    state_ecef_of_ned_vect_f(&state.ecef_speed_f, &state.ned_speed_f);
   } else if (bit_is_set(state.speed_status, SPEED_NED_I)) {
     /* transform ned_f -> ned_i -> ecef_i , set status bits */
     SPEEDS_FLOAT_OF_BFP(state.ned_speed_f, state.ned_speed_i);
     SetBit(state.speed_status, SPEED_NED_F);
-    ecef_of_ned_vect_f(&state.ecef_speed_f, &state.ned_origin_f, &state.ned_speed_f);
+    state_ecef_of_ned_vect_f(&state.ecef_speed_f, &state.ned_speed_f);
   } else {
     /* could not get this representation,  set errno */
     //struct EcefCoor_f _ecef_zero = {0.0f};
@@ -1056,12 +1174,12 @@ void stateCalcAccelEcef_f(void)
   }
   else if (state.ned_initialized_f) {
     if (bit_is_set(state.accel_status, ACCEL_NED_F)) {
-      ecef_of_ned_vect_f(&state.ecef_accel_f, &state.ned_origin_f, &state.ned_accel_f);
+      state_ecef_of_ned_vect_f(&state.ecef_accel_f, &state.ned_accel_f);
     } else if (bit_is_set(state.accel_status, ACCEL_NED_I)) {
       /* transform ned_f -> ned_i -> ecef_i , set status bits */
       ACCELS_FLOAT_OF_BFP(state.ned_accel_f, state.ned_accel_i);
       SetBit(state.accel_status, ACCEL_NED_F);
-      ecef_of_ned_vect_f(&state.ecef_accel_f, &state.ned_origin_f, &state.ned_accel_f);
+      state_ecef_of_ned_vect_f(&state.ecef_accel_f, &state.ned_accel_f);
     } else {
       /* could not get this representation,  set errno */
       errno = 1;
@@ -33,6 +33,7 @@
 
 #include "math/pprz_algebra_int.h"
 #include "math/pprz_algebra_float.h"
+#include "math/pprz_algebra_double.h"
 #include "math/pprz_geodetic_int.h"
 #include "math/pprz_geodetic_float.h"
 #include "math/pprz_orientation_conversion.h"
@@ -222,6 +223,14 @@ struct State {
   /// True if local float coordinate frame is initialsed
   bool ned_initialized_f;
 
+  /**
+   * Rotation from ECEF to the local float frame in double precision.
+   * Precomputed from ned_origin_f when the origin is set, so the ECEF of
+   * local conversions do not convert the matrix at every call.
+   * The sine and cosine of the origin latitude and longitude are its entries.
+   */
+  struct DoubleRMat ned_origin_ltp_of_ecef_d;
+
   /**
    * Definition of the origin of Utm coordinate system.
    * Defines the origin of the local NorthEastDown coordinate system
@@ -462,6 +471,9 @@ static inline void stateSetLocalOrigin_i(struct LtpDef_i *ltp_def)
   LLA_FLOAT_OF_BFP(state.ned_origin_f.lla, state.ned_origin_i.lla);
   HIGH_RES_RMAT_FLOAT_OF_BFP(state.ned_origin_f.ltp_of_ecef, state.ned_origin_i.ltp_of_ecef);
   state.ned_origin_f.hmsl = M_OF_MM(state.ned_origin_i.hmsl);
+  for (uint8_t i = 0; i < 9; i++) {
+    state.ned_origin_ltp_of_ecef_d.m[i] = (double)state.ned_origin_f.ltp_of_ecef.m[i];
+  }
 
   /* clear bits for all local frame representations */
   state.pos_status &= ~(POS_LOCAL_COORD);
@@ -501,6 +513,7 @@ extern void stateCalcPositionEcef_f(void);
 extern void stateCalcPositionNed_f(void);
 extern void stateCalcPositionEnu_f(void);
 extern void stateCalcPositionLla_f(void);
+extern void stateCalcPositions(uint16_t mask);
 
 /*********************** validity test functions ******************/
 
@@ -1144,6 +1157,18 @@ static inline struct FloatEulers *stateGetNedToBodyEulers_f(void)
 {
   return orientationGetEulers_f(&state.ned_to_body_orientation);
 }
+
+/// Compute several body attitude representations at once (mask of 1 << ORREP_*).
+static inline void stateCalcNedToBody(uint8_t mask)
+{
+  orientationCalcReps(&state.ned_to_body_orientation, mask);
+}
+
+/// Generation of the body attitude, incremented at every update.
+static inline uint32_t stateGetNedToBodyGeneration(void)
+{
+  return state.ned_to_body_orientation.gen;
+}
 /** @}*/
 
 
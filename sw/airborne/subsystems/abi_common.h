@@ -73,5 +73,88 @@ typedef struct abi_struct abi_event;
 #define ABI_FOREACH(head,el) for(el=head; el; el=el->next)
 #define ABI_PREPEND(head,add) { (add)->next = head; head = add; }
 
+/** Queued delivery.
+ *
+ * AbiSendMsg* calls the callbacks in the context of the sender. When a message
+ * is produced by another thread (e.g. a vision thread on Linux), it can instead
+ * be sent with AbiQueueMsg*, which copies it to a single producer single consumer
+ * ring of its message type. The rings are drained by AbiQueueEvent() in the event
+ * loop of the autopilot, where the callbacks are called as with AbiSendMsg*.
+ * Only one thread may queue a given message type, and the consumer side must not
+ * queue it itself.
+ *
+ * Fields passed as a pointer to a struct are copied by value in the ring, messages
+ * with other pointer fields (arrays, strings) can not be queued.
+ */
+#ifndef ABI_USE_QUEUE
+#define ABI_USE_QUEUE FALSE
+#endif
+
+/** Number of messages in the ring of each message type, power of 2 up to 128 */
+#ifndef ABI_QUEUE_SIZE
+#define ABI_QUEUE_SIZE 8
+#endif
+
+#if ABI_USE_QUEUE
+#if (ABI_QUEUE_SIZE & (ABI_QUEUE_SIZE - 1)) || ABI_QUEUE_SIZE > 128
+#error "ABI_QUEUE_SIZE must be a power of 2 up to 128"
+#endif
+
+/** Ring indexes and statistics of a message type
+ *
+ * The indexes are free running, the insert index is only written by the producer
+ * and the extract index by the consumer, with release stores so no lock is needed.
+ */
+struct abi_ring {
+  uint8_t insert_idx;   ///< next slot written by the producer
+  uint8_t extract_idx;  ///< next slot read by the consumer
+  uint8_t max_depth;    ///< highest number of pending messages
+  uint32_t sent;        ///< number of queued messages
+  uint32_t dropped;     ///< number of messages dropped because the ring was full
+};
+
+/** Get the slot to write for the producer
+ * @return false if the ring is full, the message is then counted as dropped
+ */
+static inline bool abi_ring_insert_slot(struct abi_ring *r, uint8_t *slot)
+{
+  uint8_t depth = r->insert_idx - __atomic_load_n(&r->extract_idx, __ATOMIC_ACQUIRE);
+  if (depth >= ABI_QUEUE_SIZE) {
+    r->dropped++;
+    return false;
+  }
+  if (depth >= r->max_depth) {
+    r->max_depth = depth + 1;
+  }
+  *slot = r->insert_idx & (ABI_QUEUE_SIZE - 1);
+  return true;
+}
+
+/** Publish the slot written by the producer */
+static inline void abi_ring_insert_done(struct abi_ring *r)
+{
+  r->sent++;
+  __atomic_store_n(&r->insert_idx, (uint8_t)(r->insert_idx + 1), __ATOMIC_RELEASE);
+}
+
+/** Get the oldest pending slot for the consumer
+ * @return false if the ring is empty
+ */
+static inline bool abi_ring_extract_slot(struct abi_ring *r, uint8_t *slot)
+{
+  if (__atomic_load_n(&r->insert_idx, __ATOMIC_ACQUIRE) == r->extract_idx) {
+    return false;
+  }
+  *slot = r->extract_idx & (ABI_QUEUE_SIZE - 1);
+  return true;
+}
+
+/** Release the slot read by the consumer, it can then be overwritten by the producer */
+static inline void abi_ring_extract_done(struct abi_ring *r)
+{
+  __atomic_store_n(&r->extract_idx, (uint8_t)(r->extract_idx + 1), __ATOMIC_RELEASE);
+}
+#endif /* ABI_USE_QUEUE */
+
 #endif /* ABI_COMMON_H */
 
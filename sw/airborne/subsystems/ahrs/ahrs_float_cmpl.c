@@ -30,6 +30,7 @@
 #include "subsystems/ahrs/ahrs_float_cmpl.h"
 #include "subsystems/ahrs/ahrs_float_utils.h"
 #include "math/pprz_algebra_float.h"
+#include "math/pprz_approx_float.h"
 #include "math/pprz_algebra_int.h"
 #include "math/pprz_simple_matrix.h"
 #include "generated/airframe.h"
@@ -375,10 +376,9 @@ void ahrs_fc_update_mag_2d_dumb(struct FloatVect3 *mag)
   struct FloatEulers ltp_to_imu_euler;
   float_eulers_of_rmat(&ltp_to_imu_euler, &ahrs_fc.ltp_to_imu_rmat);
 
-  const float cphi   = cosf(ltp_to_imu_euler.phi);
-  const float sphi   = sinf(ltp_to_imu_euler.phi);
-  const float ctheta = cosf(ltp_to_imu_euler.theta);
-  const float stheta = sinf(ltp_to_imu_euler.theta);
+  float sphi, cphi, stheta, ctheta;
+  pprz_sincosf(ltp_to_imu_euler.phi, &sphi, &cphi);
+  pprz_sincosf(ltp_to_imu_euler.theta, &stheta, &ctheta);
   const float mn = ctheta * mag->x + sphi * stheta * mag->y + cphi * stheta * mag->z;
   const float me =     0. * mag->x + cphi          * mag->y - sphi          * mag->z;
 
@@ -442,10 +442,12 @@ void ahrs_fc_update_heading(float heading)
   };
 
   // expected_heading cross measured_heading
+  float sheading, cheading;
+  pprz_sincosf(heading, &sheading, &cheading);
   struct FloatVect3 residual_ltp = {
     0,
     0,
-    expected_ltp.x * sinf(heading) - expected_ltp.y * cosf(heading)
+    expected_ltp.x * sheading - expected_ltp.y * cheading
   };
 
   struct FloatVect3 residual_imu;
@@ -478,8 +480,7 @@ void ahrs_fc_realign_heading(float heading)
   struct FloatQuat q_h_new;
   q_h_new.qx = 0.0;
   q_h_new.qy = 0.0;
-  q_h_new.qz = sinf(heading / 2.0);
-  q_h_new.qi = cosf(heading / 2.0);
+  pprz_sincosf(heading / 2.f, &q_h_new.qz, &q_h_new.qi);
 
   ahrs_fc_recompute_ltp_to_body();
   struct FloatQuat *ltp_to_body_quat = orientationGetQuat_f(&ahrs_fc.ltp_to_body);
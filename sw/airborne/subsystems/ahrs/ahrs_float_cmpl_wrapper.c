@@ -127,8 +127,26 @@ PRINT_CONFIG_VAR(AHRS_FC_MAG_ID)
 #define AHRS_FC_GPS_ID GPS_MULTI_ID
 #endif
 PRINT_CONFIG_VAR(AHRS_FC_GPS_ID)
+
+/** Use the pre-integrated IMU deltas (IMU_DELTA_INT32 ABI message) instead
+ * of the gyro and accel samples, see IMU_PREINTEGRATION
+ */
+#ifndef AHRS_FC_USE_IMU_DELTA
+#define AHRS_FC_USE_IMU_DELTA FALSE
+#endif
+PRINT_CONFIG_VAR(AHRS_FC_USE_IMU_DELTA)
+
+#if AHRS_FC_USE_IMU_DELTA && !IMU_PREINTEGRATION
+#error "AHRS_FC_USE_IMU_DELTA needs IMU_PREINTEGRATION to be TRUE"
+#endif
+
+#if AHRS_FC_USE_IMU_DELTA
+#include "subsystems/imu.h"
+static abi_event delta_ev;
+#else
 static abi_event gyro_ev;
 static abi_event accel_ev;
+#endif
 static abi_event mag_ev;
 static abi_event aligner_ev;
 static abi_event body_to_imu_ev;
@@ -136,6 +154,32 @@ static abi_event geo_mag_ev;
 static abi_event gps_ev;
 
 
+#if AHRS_FC_USE_IMU_DELTA
+/** Propagate and correct with the mean rate and specific force over the pre-integration interval */
+static void delta_cb(uint8_t __attribute__((unused)) sender_id,
+                     uint32_t stamp, float dt,
+                     struct Int32Vect3 *delta_angle, struct Int32Vect3 *delta_vel)
+{
+  ahrs_fc_last_stamp = stamp;
+  if (ahrs_fc.is_aligned && dt > 0.f) {
+    const float inv_dt = 1.f / dt;
+    struct FloatRates gyro_f = {
+      FLOAT_OF_BFP(delta_angle->x, IMU_DELTA_ANGLE_FRAC) * inv_dt,
+      FLOAT_OF_BFP(delta_angle->y, IMU_DELTA_ANGLE_FRAC) * inv_dt,
+      FLOAT_OF_BFP(delta_angle->z, IMU_DELTA_ANGLE_FRAC) * inv_dt
+    };
+    struct FloatVect3 accel_f = {
+      FLOAT_OF_BFP(delta_vel->x, IMU_DELTA_VEL_FRAC) * inv_dt,
+      FLOAT_OF_BFP(delta_vel->y, IMU_DELTA_VEL_FRAC) * inv_dt,
+      FLOAT_OF_BFP(delta_vel->z, IMU_DELTA_VEL_FRAC) * inv_dt
+    };
+    ahrs_fc_propagate(&gyro_f, dt);
+    ahrs_fc_update_accel(&accel_f, dt);
+    compute_body_orientation_and_rates();
+  }
+}
+#else
+
 static void gyro_cb(uint8_t __attribute__((unused)) sender_id,
                     uint32_t stamp, struct Int32Rates *gyro)
 {
@@ -189,6 +233,7 @@ static void accel_cb(uint8_t __attribute__((unused)) sender_id,
   }
 #endif
 }
+#endif /* AHRS_FC_USE_IMU_DELTA */
 
 static void mag_cb(uint8_t __attribute__((unused)) sender_id,
                    uint32_t __attribute__((unused)) stamp,
@@ -289,8 +334,12 @@ void ahrs_fc_register(void)
   /*
    * Subscribe to scaled IMU measurements and attach callbacks
    */
+#if AHRS_FC_USE_IMU_DELTA
+  AbiBindMsgIMU_DELTA_INT32(AHRS_FC_IMU_ID, &delta_ev, delta_cb);
+#else
   AbiBindMsgIMU_GYRO_INT32(AHRS_FC_IMU_ID, &gyro_ev, gyro_cb);
   AbiBindMsgIMU_ACCEL_INT32(AHRS_FC_IMU_ID, &accel_ev, accel_cb);
+#endif
   AbiBindMsgIMU_MAG_INT32(AHRS_FC_MAG_ID, &mag_ev, mag_cb);
   AbiBindMsgIMU_LOWPASSED(ABI_BROADCAST, &aligner_ev, aligner_cb);
   AbiBindMsgBODY_TO_IMU_QUAT(ABI_BROADCAST, &body_to_imu_ev, body_to_imu_cb);
@@ -33,6 +33,7 @@
 
 #include "subsystems/ahrs/ahrs_float_dcm_algebra.h"
 #include "math/pprz_algebra_float.h"
+#include "math/pprz_approx_float.h"
 
 #if USE_GPS
 #include "subsystems/gps.h"
@@ -228,10 +229,8 @@ MESSAGE("MAGNETOMETER FEEDBACK NOT TESTED YET")
   float cos_pitch;
   float sin_pitch;
 
-  cos_roll = cosf(ahrs_dcm.ltp_to_imu_euler.phi);
-  sin_roll = sinf(ahrs_dcm.ltp_to_imu_euler.phi);
-  cos_pitch = cosf(ahrs_dcm.ltp_to_imu_euler.theta);
-  sin_pitch = sinf(ahrs_dcm.ltp_to_imu_euler.theta);
+  pprz_sincosf(ahrs_dcm.ltp_to_imu_euler.phi, &sin_roll, &cos_roll);
+  pprz_sincosf(ahrs_dcm.ltp_to_imu_euler.theta, &sin_pitch, &cos_pitch);
 
 
   // Pitch&Roll Compensation:
@@ -304,7 +303,7 @@ void Normalize(void)
   if (renorm < 1.5625f && renorm > 0.64f) {
     renorm = .5 * (3 - renorm);                                       //eq.21
   } else if (renorm < 100.0f && renorm > 0.01f) {
-    renorm = 1. / sqrt(renorm);
+    renorm = 1.f / pprz_sqrtf(renorm);
 #if PERFORMANCE_REPORTING == 1
     renorm_sqrt_count++;
 #endif
@@ -321,7 +320,7 @@ void Normalize(void)
   if (renorm < 1.5625f && renorm > 0.64f) {
     renorm = .5 * (3 - renorm);                                              //eq.21
   } else if (renorm < 100.0f && renorm > 0.01f) {
-    renorm = 1. / sqrt(renorm);
+    renorm = 1.f / pprz_sqrtf(renorm);
 #if PERFORMANCE_REPORTING == 1
     renorm_sqrt_count++;
 #endif
@@ -338,7 +337,7 @@ void Normalize(void)
   if (renorm < 1.5625f && renorm > 0.64f) {
     renorm = .5 * (3 - renorm);                                              //eq.21
   } else if (renorm < 100.0f && renorm > 0.01f) {
-    renorm = 1. / sqrt(renorm);
+    renorm = 1.f / pprz_sqrtf(renorm);
 #if PERFORMANCE_REPORTING == 1
     renorm_sqrt_count++;
 #endif
@@ -375,7 +374,7 @@ void Drift_correction()
   //*****Roll and Pitch***************
 
   // Calculate the magnitude of the accelerometer vector
-  Accel_magnitude = sqrtf(accel_float.x * accel_float.x + accel_float.y * accel_float.y + accel_float.z * accel_float.z);
+  Accel_magnitude = pprz_sqrtf(accel_float.x * accel_float.x + accel_float.y * accel_float.y + accel_float.z * accel_float.z);
   Accel_magnitude = Accel_magnitude / GRAVITY; // Scale to gravity.
   // Dynamic weighting of accelerometer info (reliability filter)
   // Weight for accelerometer info (<0.5G = 0.0, 1G = 1.0 , >1.5G = 0.0)
@@ -419,8 +418,8 @@ void Drift_correction()
 
   if (ahrs_dcm.gps_course_valid) {
     float course = ahrs_dcm.gps_course - M_PI; //This is the runaway direction of you "plane" in rad
-    float COGX = cosf(course); //Course overground X axis
-    float COGY = sinf(course); //Course overground Y axis
+    float COGX, COGY; //Course overground X and Y axis
+    pprz_sincosf(course, &COGY, &COGX);
 
     errorCourse = (DCM_Matrix[0][0] * COGY) - (DCM_Matrix[1][0] * COGX); //Calculating YAW error
     //Applys the yaw correction to the XYZ rotation of the aircraft, depeding the position.
@@ -450,7 +449,7 @@ void Drift_correction()
 #endif
 
   //  Here we will place a limit on the integrator so that the integrator cannot ever exceed half the saturation limit of the gyros
-  Integrator_magnitude = sqrt(Vector_Dot_Product(Omega_I, Omega_I));
+  Integrator_magnitude = pprz_sqrtf(Vector_Dot_Product(Omega_I, Omega_I));
   if (Integrator_magnitude > RadOfDeg(300)) {
     Vector_Scale(Omega_I, Omega_I, 0.5f * RadOfDeg(300) / Integrator_magnitude);
   }
@@ -498,13 +497,13 @@ void Matrix_update(float dt)
 static void compute_ahrs_representations(void)
 {
 #if (OUTPUTMODE==2)         // Only accelerometer info (debugging purposes)
-  ahrs_dcm.ltp_to_imu_euler.phi = atan2(accel_float.y, accel_float.z);   // atan2(acc_y,acc_z)
-  ahrs_dcm.ltp_to_imu_euler.theta = -asin((accel_float.x) / GRAVITY); // asin(acc_x)
+  ahrs_dcm.ltp_to_imu_euler.phi = pprz_atan2f(accel_float.y, accel_float.z);   // atan2(acc_y,acc_z)
+  ahrs_dcm.ltp_to_imu_euler.theta = -pprz_asinf((accel_float.x) / GRAVITY); // asin(acc_x)
   ahrs_dcm.ltp_to_imu_euler.psi = 0;
 #else
-  ahrs_dcm.ltp_to_imu_euler.phi = atan2(DCM_Matrix[2][1], DCM_Matrix[2][2]);
-  ahrs_dcm.ltp_to_imu_euler.theta = -asin(DCM_Matrix[2][0]);
-  ahrs_dcm.ltp_to_imu_euler.psi = atan2(DCM_Matrix[1][0], DCM_Matrix[0][0]);
+  ahrs_dcm.ltp_to_imu_euler.phi = pprz_atan2f(DCM_Matrix[2][1], DCM_Matrix[2][2]);
+  ahrs_dcm.ltp_to_imu_euler.theta = -pprz_asinf(DCM_Matrix[2][0]);
+  ahrs_dcm.ltp_to_imu_euler.psi = pprz_atan2f(DCM_Matrix[1][0], DCM_Matrix[0][0]);
   ahrs_dcm.ltp_to_imu_euler.psi += M_PI; // Rotating the angle 180deg to fit for PPRZ
 #endif
 }
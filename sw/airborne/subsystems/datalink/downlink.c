@@ -32,6 +32,10 @@
 #include "subsystems/datalink/datalink.h"
 #endif
 
+#if DOWNLINK_FRAME
+struct FrameDevice downlink_frame;
+#endif
+
 #if PERIODIC_TELEMETRY
 #include "subsystems/datalink/telemetry.h"
 #include "mcu_periph/sys_time.h"
@@ -62,10 +66,33 @@ static void send_downlink(struct transport_tx *trans, struct link_device *dev)
                                   &up_rate, &dev->nb_ovrn);
   }
 }
+
+#if TELEMETRY_STATS
+/**
+ * Send the counters of one periodic message per call, in turn.
+ * PAYLOAD_FLOAT values, in this order: [0] message id, [1] number of calls,
+ * [2] number of bytes sent, since boot.
+ */
+static void send_telemetry_stats(struct transport_tx *trans, struct link_device *dev)
+{
+  static uint8_t idx = 0;
+  if (idx >= DefaultPeriodic->nb) {
+    idx = 0;
+  }
+  struct telemetry_cb_slots *cbs = &DefaultPeriodic->cbs[idx];
+  float values[3] = { cbs->id, cbs->nb_calls, cbs->nb_bytes };
+  pprz_msg_send_PAYLOAD_FLOAT(trans, dev, AC_ID, 3, values);
+  idx++;
+}
+#endif
 #endif
 
 void downlink_init(void)
 {
+#if DOWNLINK_FRAME
+  frame_device_init(&downlink_frame, &(DOWNLINK_DEVICE).device);
+#endif
+
   // Set initial counters
   (DefaultDevice).device.nb_ovrn = 0;
   (DefaultDevice).device.nb_bytes = 0;
@@ -77,6 +104,9 @@ void downlink_init(void)
 
 #if PERIODIC_TELEMETRY
   register_periodic_telemetry(DefaultPeriodic, PPRZ_MSG_ID_DATALINK_REPORT, send_downlink);
+#if TELEMETRY_STATS
+  register_periodic_telemetry(DefaultPeriodic, PPRZ_MSG_ID_PAYLOAD_FLOAT, send_telemetry_stats);
+#endif
 #endif
 }
 
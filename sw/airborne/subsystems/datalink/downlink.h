@@ -42,6 +42,21 @@
 #define DefaultChannel DOWNLINK_TRANSPORT
 #endif
 
+/** Serialize the downlink messages in a buffer and send them as whole frames
+ * to DOWNLINK_DEVICE, see subsystems/datalink/frame_device.h
+ */
+#ifndef DOWNLINK_FRAME
+#define DOWNLINK_FRAME FALSE
+#endif
+
+#if DOWNLINK_FRAME
+#include "subsystems/datalink/frame_device.h"
+extern struct FrameDevice downlink_frame;
+#ifndef DefaultDevice
+#define DefaultDevice downlink_frame
+#endif
+#endif
+
 #ifndef DefaultDevice
 #define DefaultDevice DOWNLINK_DEVICE
 #endif
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file subsystems/datalink/frame_device.c
+ *
+ * Link device serializing the messages in a contiguous buffer.
+ */
+
+#include "subsystems/datalink/frame_device.h"
+#include <string.h>
+
+// Functions for the generic link device API
+static int frame_device_check_free_space(struct FrameDevice *p, long *fd, uint16_t len)
+{
+  if (len > FRAME_DEVICE_SIZE || !p->dev->check_free_space(p->dev->periph, fd, len)) {
+    return false; // counted as an overrun by the transport
+  }
+  // start a new frame
+  p->len = 0;
+  return true;
+}
+
+static void frame_device_put_byte(struct FrameDevice *p, long fd __attribute__((unused)), uint8_t byte)
+{
+  if (p->len < FRAME_DEVICE_SIZE) {
+    p->buf[p->len++] = byte;
+  }
+}
+
+static void frame_device_put_buffer(struct FrameDevice *p, long fd __attribute__((unused)),
+                                    const uint8_t *data, uint16_t len)
+{
+  if (len > FRAME_DEVICE_SIZE - p->len) {
+    len = FRAME_DEVICE_SIZE - p->len;
+  }
+  memcpy(&p->buf[p->len], data, len);
+  p->len += len;
+}
+
+static void frame_device_send_message(struct FrameDevice *p, long fd)
+{
+  p->dev->put_buffer(p->dev->periph, fd, p->buf, p->len);
+  p->dev->send_message(p->dev->periph, fd);
+  p->len = 0;
+}
+
+static int frame_device_char_available(struct FrameDevice *p)
+{
+  return p->dev->char_available(p->dev->periph);
+}
+
+static uint8_t frame_device_get_byte(struct FrameDevice *p)
+{
+  return p->dev->get_byte(p->dev->periph);
+}
+
+static void frame_device_set_baudrate(struct FrameDevice *p, uint32_t baudrate)
+{
+  if (p->dev->set_baudrate != NULL) {
+    p->dev->set_baudrate(p->dev->periph, baudrate);
+  }
+}
+
+/** Init a frame device
+ * @param p frame device
+ * @param dev underlying device, must provide put_buffer
+ */
+void frame_device_init(struct FrameDevice *p, struct link_device *dev)
+{
+  p->dev = dev;
+  p->len = 0;
+
+  // Configure generic link device
+  p->device.periph            = (void *)(p);
+  p->device.check_free_space  = (check_free_space_t) frame_device_check_free_space;
+  p->device.put_byte          = (put_byte_t) frame_device_put_byte;
+  p->device.put_buffer        = (put_buffer_t) frame_device_put_buffer;
+  p->device.send_message      = (send_message_t) frame_device_send_message;
+  p->device.char_available    = (char_available_t) frame_device_char_available;
+  p->device.get_byte          = (get_byte_t) frame_device_get_byte;
+  p->device.set_baudrate      = (set_baudrate_t) frame_device_set_baudrate;
+  p->device.nb_msgs = 0;
+  p->device.nb_ovrn = 0;
+  p->device.nb_bytes = 0;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file subsystems/datalink/frame_device.h
+ *
+ * Link device serializing the messages in a contiguous buffer.
+ *
+ * The transport still writes the message byte by byte, but in a RAM buffer,
+ * and the whole frame is given to the underlying device with a single
+ * put_buffer call when the message is sent.
+ * This only pays off when the underlying device implements put_buffer as a
+ * block copy: the STM32 (libopencm3) UART copies the frame in its queue and
+ * toggles its TX interrupt once per frame, the ChibiOS serial driver writes it
+ * with sdWrite. Devices using the default byte by byte put_buffer
+ * (mcu_periph/uart.c) only get an extra copy. No DMA is used.
+ *
+ * The message, byte and overrun counters are those of the frame device
+ * (filled by the transport), they are sent with DATALINK_REPORT.
+ *
+ * The frame buffer is used between check_free_space and send_message, so it
+ * is protected by the lock of the underlying device when it has one.
+ */
+
+#ifndef FRAME_DEVICE_H
+#define FRAME_DEVICE_H
+
+#include "std.h"
+#include "pprzlink/pprzlink_device.h"
+
+/** Size of the frame buffer, longest message that can be sent */
+#ifndef FRAME_DEVICE_SIZE
+#define FRAME_DEVICE_SIZE 256
+#endif
+
+struct FrameDevice {
+  struct link_device device;    ///< device given to the transport
+  struct link_device *dev;      ///< underlying device
+  uint8_t buf[FRAME_DEVICE_SIZE]; ///< frame being serialized
+  uint16_t len;                 ///< number of bytes in the frame
+};
+
+extern void frame_device_init(struct FrameDevice *p, struct link_device *dev);
+
+#endif /* FRAME_DEVICE_H */
@@ -66,6 +66,118 @@ int8_t register_periodic_telemetry(struct periodic_telemetry *_pt, uint8_t _id,
   return -1;
 }
 
+#if TELEMETRY_ADAPTIVE
+
+/** Decimation of a message at a given level */
+static inline uint8_t telemetry_adaptive_shift(struct telemetry_adaptive_msg *msg, uint8_t level)
+{
+  if (msg->priority >= TELEMETRY_PRIORITY_MAX || level <= msg->priority) {
+    return 0;
+  }
+  return Min(level - msg->priority, TELEMETRY_ADAPTIVE_MAX_SHIFT);
+}
+
+/** Time between two probes of the lower level after a successful probe, in seconds */
+#define TELEMETRY_ADAPTIVE_PROBE_MIN Min(4, TELEMETRY_ADAPTIVE_PROBE_MAX)
+
+/** Highest decimation level */
+#define TELEMETRY_ADAPTIVE_LEVEL_MAX (TELEMETRY_PRIORITY_MAX + TELEMETRY_ADAPTIVE_MAX_SHIFT)
+
+/** Expected load of the messages of a process at a given level, in bytes per window */
+static uint32_t telemetry_adaptive_load(struct telemetry_adaptive *ta, uint8_t level)
+{
+  uint32_t load = 0;
+  for (uint8_t i = 0; i < ta->nb; i++) {
+    load += ((uint32_t)ta->msgs[i].size * ta->msgs[i].calls) >> telemetry_adaptive_shift(&ta->msgs[i], level);
+  }
+  return load;
+}
+
+/** Update the budget and the decimations once per second
+ *
+ * The budget is the number of bytes the link accepted during the last window
+ * when some messages could not be sent, minus a margin. On overruns the level
+ * is raised until the expected load of the messages of the process, from their
+ * size and number of periods in the window, fits in the budget.
+ *
+ * The level is only lowered when the load of the lower level fits in the
+ * budget with #TELEMETRY_ADAPTIVE_HEADROOM. Otherwise the lower level is
+ * probed for one window, every 4 s at first and up to every
+ * #TELEMETRY_ADAPTIVE_PROBE_MAX s while the probes end with overruns: a
+ * failed probe is the only time the messages of highest priority can be lost
+ * once the budget is known.
+ *
+ * @param ta adaptive state of the telemetry process
+ * @param dev device of the telemetry process, nothing is done if NULL
+ * @param freq frequency of the calls in Hz
+ */
+void telemetry_adaptive_periodic(struct telemetry_adaptive *ta, struct link_device *dev, uint16_t freq)
+{
+  uint8_t i;
+  if (dev == NULL) {
+    return;
+  }
+  if (ta->cnt == 0 && ta->budget == 0) {
+    // first call, no limit until overruns are seen
+    ta->budget = UINT32_MAX;
+    ta->probe = TELEMETRY_ADAPTIVE_PROBE_MIN;
+    ta->nb_bytes = dev->nb_bytes;
+    ta->nb_ovrn = dev->nb_ovrn;
+  }
+  ta->cnt++;
+  if (ta->cnt < freq) {
+    return;
+  }
+  ta->cnt = 0;
+
+  uint32_t bytes = dev->nb_bytes - ta->nb_bytes;
+  uint8_t ovrn = dev->nb_ovrn - ta->nb_ovrn;
+  ta->nb_bytes = dev->nb_bytes;
+  ta->nb_ovrn = dev->nb_ovrn;
+  bool probed = ta->probing;
+  ta->probing = false;
+  if (ovrn > 0) {
+    // the link is saturated
+    ta->budget = bytes - bytes / 8 + 1;
+    ta->hold = 0;
+    if (probed) {
+      // back to the previous level, and probe less often
+      ta->level++;
+      ta->probe = Min(2 * ta->probe, TELEMETRY_ADAPTIVE_PROBE_MAX);
+    }
+    while (ta->level < TELEMETRY_ADAPTIVE_LEVEL_MAX && telemetry_adaptive_load(ta, ta->level) > ta->budget) {
+      ta->level++;
+    }
+  } else {
+    if (probed) {
+      // the link accepted the lower level
+      ta->budget = Max(ta->budget, bytes);
+      ta->probe = TELEMETRY_ADAPTIVE_PROBE_MIN;
+    }
+    if (ta->hold < UINT8_MAX) {
+      ta->hold++;
+    }
+    if (ta->level > 0) {
+      if (telemetry_adaptive_load(ta, ta->level - 1) <= ta->budget - ta->budget / TELEMETRY_ADAPTIVE_HEADROOM) {
+        ta->level--;
+      } else if (TELEMETRY_ADAPTIVE_PROBE_MAX > 0 && ta->hold >= ta->probe) {
+        ta->level--;
+        ta->probing = true;
+        ta->hold = 0;
+      }
+    }
+  }
+
+  for (i = 0; i < ta->nb; i++) {
+    ta->msgs[i].shift = telemetry_adaptive_shift(&ta->msgs[i], ta->level);
+    ta->msgs[i].rate = ta->msgs[i].sent;
+    ta->msgs[i].calls = 0;
+    ta->msgs[i].sent = 0;
+  }
+}
+
+#endif
+
 #if USE_PERIODIC_TELEMETRY_REPORT
 
 #include "subsystems/datalink/downlink.h"
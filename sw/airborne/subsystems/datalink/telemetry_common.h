@@ -46,9 +46,60 @@ typedef const char telemetry_msg[64];
 /** number of callbacks that can be registered per msg */
 #define TELEMETRY_NB_CBS 4
 
+/** Count the number of calls and bytes sent for each periodic message.
+ * The counters are kept in the callback table (telemetry_cbs), the ones of the
+ * default process are sent in turn with PAYLOAD_FLOAT (see downlink.c).
+ * No bytes are counted for the processes without link device (e.g. Mavlink).
+ */
+#ifndef TELEMETRY_STATS
+#define TELEMETRY_STATS FALSE
+#endif
+
+/** Adapt the periods of the periodic messages to the throughput of the link.
+ * When the transport lacks room in the device (overruns), the throughput
+ * measured during the last second is taken as the budget of the link, and the
+ * messages of lower priority are sent once every 2, 4, ... periods until the
+ * expected load, from their measured size, fits in the budget.
+ * The decimation is only reduced when the load of the lower level fits in the
+ * budget with #TELEMETRY_ADAPTIVE_HEADROOM, otherwise the lower level is tried
+ * for one second, less and less often while these probes fail.
+ */
+#ifndef TELEMETRY_ADAPTIVE
+#define TELEMETRY_ADAPTIVE FALSE
+#endif
+
+/** Priority of the messages that are never decimated,
+ * the priority is set with the priority attribute of the messages in the telemetry file
+ */
+#define TELEMETRY_PRIORITY_MAX 4
+
+/** Maximum decimation of a message (period multiplied by 2^TELEMETRY_ADAPTIVE_MAX_SHIFT) */
+#ifndef TELEMETRY_ADAPTIVE_MAX_SHIFT
+#define TELEMETRY_ADAPTIVE_MAX_SHIFT 3
+#endif
+
+/** Margin to reduce the decimation, the load of the lower level must fit
+ * in the budget minus 1/TELEMETRY_ADAPTIVE_HEADROOM of it
+ */
+#ifndef TELEMETRY_ADAPTIVE_HEADROOM
+#define TELEMETRY_ADAPTIVE_HEADROOM 8
+#endif
+
+/** Maximum time between two probes of the lower level in seconds,
+ * the time is doubled after each failed probe from 4 s. 0 disables the probes,
+ * the decimation is then only reduced when the budget allows it.
+ */
+#ifndef TELEMETRY_ADAPTIVE_PROBE_MAX
+#define TELEMETRY_ADAPTIVE_PROBE_MAX 64
+#endif
+
 struct telemetry_cb_slots {
   uint8_t id;  ///< id of telemetry message
   telemetry_cb slots[TELEMETRY_NB_CBS];
+#if TELEMETRY_STATS
+  uint32_t nb_calls;  ///< number of times the message was scheduled
+  uint32_t nb_bytes;  ///< number of bytes sent by the callbacks (from the nb_bytes counter of the device)
+#endif
 };
 
 /** Periodic telemetry structure.
@@ -74,6 +125,69 @@ static inline int8_t register_periodic_telemetry(struct periodic_telemetry *_pt
     uint8_t _id __attribute__((unused)), telemetry_cb _cb __attribute__((unused))) { return -1; }
 #endif
 
+#if TELEMETRY_ADAPTIVE
+/** Adaptive scheduler state of a message in a telemetry process */
+struct telemetry_adaptive_msg {
+  uint8_t priority;   ///< from 0 (decimated first) to #TELEMETRY_PRIORITY_MAX (never decimated)
+  uint8_t shift;      ///< the message is sent once every 2^shift periods
+  uint8_t cnt;        ///< periods since the message was last sent
+  uint16_t size;      ///< number of bytes sent by the callbacks the last time
+  uint16_t calls;     ///< number of periods in the current window
+  uint16_t sent;      ///< number of times sent in the current window
+  uint16_t rate;      ///< number of times sent in the last window, i.e. achieved rate in Hz
+};
+
+#define TELEMETRY_ADAPTIVE_MSG(_p) { .priority = _p }
+
+/** Adaptive scheduler state of a telemetry process.
+ * Each process has its own state and messages, generated as
+ * telemetry_adaptive_<process> and telemetry_adaptive_msgs_<process> in the
+ * order of the messages of the process in the telemetry file, so that the
+ * processes on different devices do not interfere.
+ */
+struct telemetry_adaptive {
+  struct telemetry_adaptive_msg *msgs;  ///< messages of the process
+  uint8_t nb;         ///< number of messages of the process
+  uint16_t cnt;       ///< number of calls in the current window
+  uint32_t nb_bytes;  ///< nb_bytes of the device at the start of the window
+  uint8_t nb_ovrn;    ///< nb_ovrn of the device at the start of the window
+  uint32_t budget;    ///< estimated throughput of the link in bytes per window
+  uint8_t level;      ///< decimation level, messages with a lower priority are decimated
+  uint8_t probe;      ///< time between two probes of the lower level in seconds
+  uint8_t hold;       ///< time since the last probe or overrun in seconds
+  bool probing;       ///< the lower level is being tried in the current window
+};
+
+/** Check if a message should be sent in this period, to be called on each of its periods */
+static inline bool telemetry_adaptive_send(struct telemetry_adaptive_msg *msg)
+{
+  msg->calls++;
+  msg->cnt++;
+  if (msg->cnt < (1 << msg->shift)) {
+    return false;
+  }
+  msg->cnt = 0;
+  msg->sent++;
+  return true;
+}
+
+/** Update the size of a message after sending it
+ * @param bytes number of bytes sent, 0 if the message was not sent
+ */
+static inline void telemetry_adaptive_size(struct telemetry_adaptive_msg *msg, uint32_t bytes)
+{
+  if (bytes > 0) {
+    msg->size = bytes;
+  }
+}
+
+/** Update the budget and the decimations once per second
+ * @param dev device of the process, nothing is done if NULL
+ * @param freq frequency of the calls in Hz
+ */
+extern void telemetry_adaptive_periodic(struct telemetry_adaptive *ta, struct link_device *dev, uint16_t freq);
+#endif
+
 #if USE_PERIODIC_TELEMETRY_REPORT
 /** Send an error report when trying to send message that as not been register
  * @param _process telemetry process id
@@ -107,6 +107,51 @@ static void send_mag(struct transport_tx *trans, struct link_device *dev)
 
 struct Imu imu;
 
+/** Pre-integrate the gyro and accel samples and send the deltas at a lower rate
+ * with the IMU_DELTA_INT32 ABI message
+ */
+#ifndef IMU_PREINTEGRATION
+#define IMU_PREINTEGRATION FALSE
+#endif
+
+#if IMU_PREINTEGRATION
+/** ABI binding for the IMU samples to pre-integrate */
+#ifndef IMU_PREINT_IMU_ID
+#define IMU_PREINT_IMU_ID ABI_BROADCAST
+#endif
+PRINT_CONFIG_VAR(IMU_PREINT_IMU_ID)
+
+/** Frequency of the deltas, the propagation frequency of the filters by default */
+#ifndef IMU_PREINT_FREQUENCY
+#ifdef AHRS_PROPAGATE_FREQUENCY
+#define IMU_PREINT_FREQUENCY AHRS_PROPAGATE_FREQUENCY
+#else
+#define IMU_PREINT_FREQUENCY PERIODIC_FREQUENCY
+#endif
+#endif
+PRINT_CONFIG_VAR(IMU_PREINT_FREQUENCY)
+
+static struct ImuPreint imu_preint;
+static abi_event imu_preint_gyro_ev;
+static abi_event imu_preint_accel_ev;
+
+static void imu_preint_gyro_cb(uint8_t sender_id __attribute__((unused)),
+                               uint32_t stamp, struct Int32Rates *gyro)
+{
+  imu_preint_gyro(&imu_preint, stamp, gyro);
+}
+
+static void imu_preint_accel_cb(uint8_t sender_id, uint32_t stamp, struct Int32Vect3 *accel)
+{
+  if (imu_preint_accel(&imu_preint, stamp, accel)) {
+    struct Int32Vect3 delta_angle, delta_vel;
+    float dt;
+    imu_preint_get(&imu_preint, &delta_angle, &delta_vel, &dt);
+    AbiSendMsgIMU_DELTA_INT32(sender_id, stamp, dt, &delta_angle, &delta_vel);
+  }
+}
+#endif
+
 void imu_init(void)
 {
 
@@ -133,6 +178,12 @@ void imu_init(void)
   {IMU_BODY_TO_IMU_PHI, IMU_BODY_TO_IMU_THETA, IMU_BODY_TO_IMU_PSI};
   orientationSetEulers_f(&imu.body_to_imu, &body_to_imu_eulers);
 
+#if IMU_PREINTEGRATION
+  imu_preint_init(&imu_preint, 1000000 / IMU_PREINT_FREQUENCY);
+  AbiBindMsgIMU_GYRO_INT32(IMU_PREINT_IMU_ID, &imu_preint_gyro_ev, imu_preint_gyro_cb);
+  AbiBindMsgIMU_ACCEL_INT32(IMU_PREINT_IMU_ID, &imu_preint_accel_ev, imu_preint_accel_cb);
+#endif
+
 #if PERIODIC_TELEMETRY
   register_periodic_telemetry(DefaultPeriodic, PPRZ_MSG_ID_IMU_ACCEL_RAW, send_accel_raw);
   register_periodic_telemetry(DefaultPeriodic, PPRZ_MSG_ID_IMU_ACCEL_SCALED, send_accel_scaled);
@@ -31,6 +31,7 @@
 #include "math/pprz_algebra_float.h"
 #include "math/pprz_orientation_conversion.h"
 #include "generated/airframe.h"
+#include "subsystems/imu/imu_preint.h"
 
 
 /** abstract IMU interface providing fixed point interface  */
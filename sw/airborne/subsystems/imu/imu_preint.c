@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file subsystems/imu/imu_preint.c
+ *
+ * Pre-integration of the IMU samples
+ *
+ * Between two propagation steps, the gyro samples are integrated to the
+ * angle alpha and the accel samples to the velocity nu, in the IMU frame at
+ * the start of the interval. The rotation during the interval is accounted
+ * for with the usual corrections (Savage, Strapdown Inertial Navigation
+ * Integration Algorithm Design):
+ *  - coning: beta = 1/2 sum(alpha_{k-1} x dalpha_k)
+ *  - sculling: 1/2 sum(alpha_{k-1} x dv_k + nu_{k-1} x dalpha_k)
+ *  - rotation of the velocity: 1/2 alpha x nu
+ * The increments of a sample are computed in 64 bits fixed point, the time
+ * step in s with 24 bits of fractional part.
+ */
+
+#include "subsystems/imu/imu_preint.h"
+
+/** A sample is considered lost when the time since the previous one is
+ * larger than IMU_PREINT_GAP_RATIO times the estimated sample period
+ */
+#ifndef IMU_PREINT_GAP_RATIO
+#define IMU_PREINT_GAP_RATIO 3
+#endif
+
+/** time step in usec to s with 24 bits of fractional part, 2^24 / 10^6 ~ 274878 / 2^14 */
+#define IMU_PREINT_DT_FRAC 24
+#define IMU_PREINT_DT_OF_USEC(_us) (((int64_t)(_us) * 274878) >> 14)
+
+/** c += (a x b) >> shift */
+static inline void imu_preint_cross_add(int64_t *c, const int64_t *a, const int64_t *b, uint8_t shift)
+{
+  c[0] += (a[1] * b[2] - a[2] * b[1]) >> shift;
+  c[1] += (a[2] * b[0] - a[0] * b[2]) >> shift;
+  c[2] += (a[0] * b[1] - a[1] * b[0]) >> shift;
+}
+
+/** Check the time since the previous sample against the sample period
+ * @param sample_dt estimated sample period in usec, 0 if unknown, updated
+ * @param dt time since the previous sample in usec
+ * @param period integration period in usec, bound of dt while the sample period is unknown
+ * @return true if samples were lost
+ */
+static bool imu_preint_gap(uint32_t *sample_dt, uint32_t dt, uint32_t period)
+{
+  if (*sample_dt == 0) {
+    if (dt > period) {
+      return true;
+    }
+    *sample_dt = dt;
+  } else if (dt > IMU_PREINT_GAP_RATIO * *sample_dt) {
+    // estimate the sample period again, in case it changed
+    *sample_dt = 0;
+    return true;
+  } else {
+    // first order low pass filter of the sample period
+    *sample_dt += ((int32_t)dt - (int32_t)*sample_dt) / 8;
+  }
+  return false;
+}
+
+/** Init the pre-integration
+ * @param period integration period in usec
+ */
+void imu_preint_init(struct ImuPreint *preint, uint32_t period)
+{
+  preint->period = period;
+  preint->gyro_sample_dt = 0;
+  preint->accel_sample_dt = 0;
+  preint->nb_resets = 0;
+  preint->gyro_init = false;
+  preint->accel_init = false;
+  imu_preint_reset(preint);
+}
+
+/** Start a new integration interval */
+void imu_preint_reset(struct ImuPreint *preint)
+{
+  for (int i = 0; i < 3; i++) {
+    preint->alpha[i] = 0;
+    preint->coning[i] = 0;
+    preint->nu[i] = 0;
+    preint->sculling[i] = 0;
+    preint->alpha_prev[i] = 0;
+    preint->dalpha[i] = 0;
+  }
+  preint->dt = 0;
+}
+
+/** Integrate a gyro sample over the time since the previous one
+ * @param stamp time of the sample in usec
+ * @param gyro rates in rad/s with #INT32_RATE_FRAC
+ */
+void imu_preint_gyro(struct ImuPreint *preint, uint32_t stamp, struct Int32Rates *gyro)
+{
+  uint32_t dt = stamp - preint->gyro_stamp;
+  preint->gyro_stamp = stamp;
+  if (!preint->gyro_init) {
+    preint->gyro_init = true;
+    imu_preint_reset(preint);
+    return;
+  }
+  if (imu_preint_gap(&preint->gyro_sample_dt, dt, preint->period)) {
+    // samples lost, start again
+    preint->nb_resets++;
+    imu_preint_reset(preint);
+    return;
+  }
+  int64_t dt_bfp = IMU_PREINT_DT_OF_USEC(dt);
+  const uint8_t shift = INT32_RATE_FRAC + IMU_PREINT_DT_FRAC - IMU_DELTA_ANGLE_FRAC;
+  preint->dalpha[0] = (gyro->p * dt_bfp) >> shift;
+  preint->dalpha[1] = (gyro->q * dt_bfp) >> shift;
+  preint->dalpha[2] = (gyro->r * dt_bfp) >> shift;
+  imu_preint_cross_add(preint->coning, preint->alpha, preint->dalpha, IMU_DELTA_ANGLE_FRAC + 1);
+  for (int i = 0; i < 3; i++) {
+    preint->alpha_prev[i] = preint->alpha[i];
+    preint->alpha[i] += preint->dalpha[i];
+  }
+}
+
+/** Integrate an accel sample over the time since the previous one
+ * @param stamp time of the sample in usec
+ * @param accel specific force in m/s^2 with #INT32_ACCEL_FRAC
+ * @return true if the integration period is over, the deltas can then be read with imu_preint_get()
+ */
+bool imu_preint_accel(struct ImuPreint *preint, uint32_t stamp, struct Int32Vect3 *accel)
+{
+  uint32_t dt = stamp - preint->accel_stamp;
+  preint->accel_stamp = stamp;
+  if (!preint->accel_init) {
+    preint->accel_init = true;
+    return false;
+  }
+  if (imu_preint_gap(&preint->accel_sample_dt, dt, preint->period)) {
+    preint->nb_resets++;
+    imu_preint_reset(preint);
+    return false;
+  }
+  int64_t dt_bfp = IMU_PREINT_DT_OF_USEC(dt);
+  const uint8_t shift = INT32_ACCEL_FRAC + IMU_PREINT_DT_FRAC - IMU_DELTA_VEL_FRAC;
+  int64_t dv[3] = {
+    (accel->x * dt_bfp) >> shift,
+    (accel->y * dt_bfp) >> shift,
+    (accel->z * dt_bfp) >> shift
+  };
+  imu_preint_cross_add(preint->sculling, preint->alpha_prev, dv, IMU_DELTA_ANGLE_FRAC + 1);
+  imu_preint_cross_add(preint->sculling, preint->nu, preint->dalpha, IMU_DELTA_ANGLE_FRAC + 1);
+  for (int i = 0; i < 3; i++) {
+    preint->nu[i] += dv[i];
+  }
+  preint->dt += dt;
+  // the interval ends at the sample closest to the period
+  return preint->dt + dt / 2 >= preint->period;
+}
+
+/** Get the corrected deltas and start a new integration interval
+ * @param delta_angle rotation vector in rad with #IMU_DELTA_ANGLE_FRAC
+ * @param delta_vel velocity increment in m/s with #IMU_DELTA_VEL_FRAC
+ * @param dt integration time in s
+ */
+void imu_preint_get(struct ImuPreint *preint, struct Int32Vect3 *delta_angle,
+                    struct Int32Vect3 *delta_vel, float *dt)
+{
+  int64_t vel[3] = { preint->nu[0], preint->nu[1], preint->nu[2] };
+  imu_preint_cross_add(vel, preint->alpha, preint->nu, IMU_DELTA_ANGLE_FRAC + 1);
+  delta_angle->x = (int32_t)(preint->alpha[0] + preint->coning[0]);
+  delta_angle->y = (int32_t)(preint->alpha[1] + preint->coning[1]);
+  delta_angle->z = (int32_t)(preint->alpha[2] + preint->coning[2]);
+  delta_vel->x = (int32_t)(vel[0] + preint->sculling[0]);
+  delta_vel->y = (int32_t)(vel[1] + preint->sculling[1]);
+  delta_vel->z = (int32_t)(vel[2] + preint->sculling[2]);
+  *dt = (float)preint->dt * 1e-6f;
+  imu_preint_reset(preint);
+}
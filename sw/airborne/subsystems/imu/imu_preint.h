@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file subsystems/imu/imu_preint.h
+ *
+ * Pre-integration of the gyro and accel samples to coning and sculling
+ * corrected delta angle and delta velocity.
+ */
+
+#ifndef IMU_PREINT_H
+#define IMU_PREINT_H
+
+#include "std.h"
+#include "math/pprz_algebra_int.h"
+
+/** Fixed point format of the pre-integrated delta angle in rad */
+#define IMU_DELTA_ANGLE_FRAC 20
+/** Fixed point format of the pre-integrated delta velocity in m/s */
+#define IMU_DELTA_VEL_FRAC 16
+
+/** Pre-integration of the gyro and accel samples between two propagation steps.
+ * Accumulators in BFP on 64 bits, time in usec.
+ */
+struct ImuPreint {
+  int64_t alpha[3];         ///< integrated angle with #IMU_DELTA_ANGLE_FRAC
+  int64_t coning[3];        ///< coning correction with #IMU_DELTA_ANGLE_FRAC
+  int64_t nu[3];            ///< integrated specific force with #IMU_DELTA_VEL_FRAC
+  int64_t sculling[3];      ///< sculling correction with #IMU_DELTA_VEL_FRAC
+  int64_t alpha_prev[3];    ///< integrated angle before the last gyro sample
+  int64_t dalpha[3];        ///< angle increment of the last gyro sample
+  uint32_t gyro_stamp;      ///< time of the last gyro sample
+  uint32_t accel_stamp;     ///< time of the last accel sample
+  uint32_t dt;              ///< integration time of the accel samples
+  uint32_t period;          ///< integration period in usec
+  uint32_t gyro_sample_dt;  ///< estimated gyro sample period in usec, 0 if unknown
+  uint32_t accel_sample_dt; ///< estimated accel sample period in usec, 0 if unknown
+  uint32_t nb_resets;       ///< number of lost samples detected, on the gyro and on the accel
+  bool gyro_init;           ///< a first gyro sample was received
+  bool accel_init;          ///< a first accel sample was received
+};
+
+extern void imu_preint_init(struct ImuPreint *preint, uint32_t period);
+extern void imu_preint_reset(struct ImuPreint *preint);
+extern void imu_preint_gyro(struct ImuPreint *preint, uint32_t stamp, struct Int32Rates *gyro);
+extern bool imu_preint_accel(struct ImuPreint *preint, uint32_t stamp, struct Int32Vect3 *accel);
+extern void imu_preint_get(struct ImuPreint *preint, struct Int32Vect3 *delta_angle,
+                           struct Int32Vect3 *delta_vel, float *dt);
+
+#endif /* IMU_PREINT_H */
@@ -79,6 +79,21 @@ bool log_started = false;
  *
  *------------------------------------------------------*/
 
+/** Integration of the model at each propagation step:
+ *  - INS_FINV_RK4: fourth order Runge-Kutta, 4 evaluations of the model (default)
+ *  - INS_FINV_RK2: second order Runge-Kutta (mid-point), 2 evaluations
+ *  - INS_FINV_EXP: closed form attitude rotation with the unbiased rates, the
+ *    correction terms and the rotated accel are evaluated once per step and the
+ *    position is integrated to the second order
+ */
+#define INS_FINV_RK4 0
+#define INS_FINV_RK2 1
+#define INS_FINV_EXP 2
+
+#ifndef INS_FINV_INTEGRATION
+#define INS_FINV_INTEGRATION INS_FINV_RK4
+#endif
+
 // Default values for the tuning gains
 // Tuning parameter of speed error on attitude (e-2)
 #ifndef INS_INV_LV
@@ -155,6 +170,11 @@ static inline void error_output(struct InsFloatInv *_ins);
 /* propagation model (called by runge-kutta library) */
 static inline void invariant_model(float *o, const float *x, const int n, const float *u, const int m);
 
+#if INS_FINV_INTEGRATION == INS_FINV_EXP
+/* closed form propagation */
+static inline void invariant_propagate_exp(struct inv_state *s, struct inv_command *c, float dt);
+#endif
+
 
 /** Right multiplication by a quaternion.
  * vi * q
@@ -343,12 +363,23 @@ void ins_float_invariant_propagate(struct FloatRates* gyro, struct FloatVect3* a
   error_output(&ins_float_inv);
 
   // propagate model
+#if INS_FINV_INTEGRATION == INS_FINV_EXP
+  invariant_propagate_exp(&ins_float_inv.state, &ins_float_inv.cmd, dt);
+#else
   struct inv_state new_state;
+#if INS_FINV_INTEGRATION == INS_FINV_RK2
+  runge_kutta_2_float((float *)&new_state,
+                      (float *)&ins_float_inv.state, INV_STATE_DIM,
+                      (float *)&ins_float_inv.cmd, INV_COMMAND_DIM,
+                      invariant_model, dt);
+#else
   runge_kutta_4_float((float *)&new_state,
                       (float *)&ins_float_inv.state, INV_STATE_DIM,
                       (float *)&ins_float_inv.cmd, INV_COMMAND_DIM,
                       invariant_model, dt);
+#endif
   ins_float_inv.state = new_state;
+#endif
 
   // normalize quaternion
   float_quat_normalize(&ins_float_inv.state.quat);
@@ -364,7 +395,8 @@ void ins_float_invariant_propagate(struct FloatRates* gyro, struct FloatVect3* a
   float_quat_invert(&q_b2n, &ins_float_inv.state.quat);
   struct FloatVect3 accel_n;
   float_quat_vmult(&accel_n, &q_b2n, &ins_float_inv.cmd.accel);
-  VECT3_SMUL(accel_n, accel_n, 1. / (ins_float_inv.state.as));
+  const float inv_as = 1.f / ins_float_inv.state.as;
+  VECT3_SMUL(accel_n, accel_n, inv_as);
   VECT3_ADD(accel_n, A);
   stateSetAccelNed_f((struct NedCoor_f *)&accel_n);
 
@@ -533,7 +565,7 @@ static inline void invariant_model(float *o, const float *x, const int n, const
   struct FloatQuat tmp_quat;
 
   // test accel sensitivity
-  if (fabs(s->as) < 0.1) {
+  if (fabsf(s->as) < 0.1f) {
     // too small, return x_dot = 0 to avoid division by 0
     float_vect_zero(o, n);
     // TODO set ins state to error
@@ -548,7 +580,7 @@ static inline void invariant_model(float *o, const float *x, const int n, const
   float_quat_vmul_right(&tmp_quat, &(s->quat), &ins_float_inv.corr.LE);
   QUAT_ADD(s_dot.quat, tmp_quat);
 
-  float norm2_r = 1. - FLOAT_QUAT_NORM2(s->quat);
+  float norm2_r = 1.f - FLOAT_QUAT_NORM2(s->quat);
   QUAT_SMUL(tmp_quat, s->quat, norm2_r);
   QUAT_ADD(s_dot.quat, tmp_quat);
 
@@ -556,7 +588,8 @@ static inline void invariant_model(float *o, const float *x, const int n, const
   struct FloatQuat q_b2n;
   float_quat_invert(&q_b2n, &(s->quat));
   float_quat_vmult((struct FloatVect3 *)&s_dot.speed, &q_b2n, &(c->accel));
-  VECT3_SMUL(s_dot.speed, s_dot.speed, 1. / (s->as));
+  const float inv_as = 1.f / s->as;
+  VECT3_SMUL(s_dot.speed, s_dot.speed, inv_as);
   VECT3_ADD(s_dot.speed, A);
   VECT3_ADD(s_dot.speed, ins_float_inv.corr.ME);
 
@@ -577,6 +610,63 @@ static inline void invariant_model(float *o, const float *x, const int n, const
   memcpy(o, &s_dot, n * sizeof(float));
 }
 
+#if INS_FINV_INTEGRATION == INS_FINV_EXP
+/** Propagate the state over dt in closed form
+ *
+ * The attitude is rotated exactly by the unbiased rates, the other terms of
+ * the model are constant over the step:
+ *  q+ = q * exp(0.5 * (rates - bias) * dt) + dt * q * LE
+ *  a = A + (1/as) * (q * am * q-1) + ME
+ *  V+ = V + a * dt
+ *  X+ = X + (V + NE) * dt + 0.5 * a * dt^2
+ *  bias+ = bias + (q-1 * OE * q) * dt
+ *  as+ = as * (1 + RE * dt)
+ *  hb+ = hb + SE * dt
+ * The quaternion is normalized after the propagation.
+ */
+static inline void invariant_propagate_exp(struct inv_state *s, struct inv_command *c, float dt)
+{
+  // test accel sensitivity
+  if (fabsf(s->as) < 0.1f) {
+    // too small, don't propagate to avoid division by 0
+    return;
+  }
+
+  /* terms evaluated at the beginning of the step */
+  struct FloatQuat q_b2n, q_corr;
+  struct FloatVect3 accel_n, bias_dot;
+  float_quat_invert(&q_b2n, &(s->quat));
+  float_quat_vmult(&accel_n, &q_b2n, &(c->accel));
+  const float inv_as = 1.f / s->as;
+  VECT3_SMUL(accel_n, accel_n, inv_as);
+  VECT3_ADD(accel_n, A);
+  VECT3_ADD(accel_n, ins_float_inv.corr.ME);
+  float_quat_vmul_right(&q_corr, &(s->quat), &ins_float_inv.corr.LE);
+  float_quat_vmult(&bias_dot, &(s->quat), &ins_float_inv.corr.OE);
+
+  /* attitude */
+  struct FloatRates rates_unbiased;
+  RATES_DIFF(rates_unbiased, c->rates, s->bias);
+  float_quat_integrate(&(s->quat), &rates_unbiased, dt);
+  QUAT_SMUL(q_corr, q_corr, dt);
+  QUAT_ADD(s->quat, q_corr);
+
+  /* position and speed */
+  const float half_dt2 = 0.5f * dt * dt;
+  s->pos.x += (s->speed.x + ins_float_inv.corr.NE.x) * dt + accel_n.x * half_dt2;
+  s->pos.y += (s->speed.y + ins_float_inv.corr.NE.y) * dt + accel_n.y * half_dt2;
+  s->pos.z += (s->speed.z + ins_float_inv.corr.NE.z) * dt + accel_n.z * half_dt2;
+  VECT3_ADD_SCALED(s->speed, accel_n, dt);
+
+  /* biases */
+  s->bias.p += bias_dot.x * dt;
+  s->bias.q += bias_dot.y * dt;
+  s->bias.r += bias_dot.z * dt;
+  s->as += s->as * ins_float_inv.corr.RE * dt;
+  s->hb += ins_float_inv.corr.SE * dt;
+}
+#endif
+
 /** Compute correction vectors
  * E = ( ŷ - y )
  * LE, ME, NE, OE : ( gain matrix * error )
@@ -589,7 +679,7 @@ static inline void error_output(struct InsFloatInv *_ins)
   float temp;
 
   // test accel sensitivity
-  if (fabs(_ins->state.as) < 0.1) {
+  if (fabsf(_ins->state.as) < 0.1f) {
     // too small, don't do anything to avoid division by 0
     return;
   }
@@ -600,7 +690,8 @@ static inline void error_output(struct InsFloatInv *_ins)
   float_quat_vmult(&YBt, &q_b2n, &(_ins->meas.mag));
 
   float_quat_vmult(&I, &q_b2n, &(_ins->cmd.accel));
-  VECT3_SMUL(I, I, 1. / (_ins->state.as));
+  const float inv_as = 1.f / _ins->state.as;
+  VECT3_SMUL(I, I, inv_as);
 
   /*--------- E = ( ŷ - y ) ----------*/
   /* Eb = ( B - YBt ) */
@@ -629,34 +720,34 @@ static inline void error_output(struct InsFloatInv *_ins)
   /*--------------Gains--------------*/
 
   /**** LvEv + LbEb = -lvIa x Ev +  lb < B x Eb, Ia > Ia *****/
-  VECT3_SMUL(Itemp, I, -_ins->gains.lv / 100.);
+  VECT3_SMUL(Itemp, I, -_ins->gains.lv / 100.f);
   VECT3_CROSS_PRODUCT(Evtemp, Itemp, Ev);
 
   VECT3_CROSS_PRODUCT(Ebtemp, B, Eb);
   temp = VECT3_DOT_PRODUCT(Ebtemp, I);
-  temp = (_ins->gains.lb / 100.) * temp;
+  temp = (_ins->gains.lb / 100.f) * temp;
 
   VECT3_SMUL(Ebtemp, I, temp);
   VECT3_ADD(Evtemp, Ebtemp);
   VECT3_COPY(_ins->corr.LE, Evtemp);
 
   /***** MvEv + MhEh = -mv * Ev + (-mh * <Eh,e3>)********/
-  _ins->corr.ME.x = (-_ins->gains.mv) * Ev.x + 0.;
-  _ins->corr.ME.y = (-_ins->gains.mv) * Ev.y + 0.;
+  _ins->corr.ME.x = (-_ins->gains.mv) * Ev.x + 0.f;
+  _ins->corr.ME.y = (-_ins->gains.mv) * Ev.y + 0.f;
   _ins->corr.ME.z = ((-_ins->gains.mvz) * Ev.z) + ((-_ins->gains.mh) * Eh);
 
   /****** NxEx + NhEh = -nx * Ex + (-nh * <Eh, e3>) ********/
-  _ins->corr.NE.x = (-_ins->gains.nx) * Ex.x + 0.;
-  _ins->corr.NE.y = (-_ins->gains.nx) * Ex.y + 0.;
+  _ins->corr.NE.x = (-_ins->gains.nx) * Ex.x + 0.f;
+  _ins->corr.NE.y = (-_ins->gains.nx) * Ex.y + 0.f;
   _ins->corr.NE.z = ((-_ins->gains.nxz) * Ex.z) + ((-_ins->gains.nh) * Eh);
 
   /****** OvEv + ObEb = ovIa x Ev - ob < B x Eb, Ia > Ia ********/
-  VECT3_SMUL(Itemp, I, _ins->gains.ov / 1000.);
+  VECT3_SMUL(Itemp, I, _ins->gains.ov / 1000.f);
   VECT3_CROSS_PRODUCT(Evtemp, Itemp, Ev);
 
   VECT3_CROSS_PRODUCT(Ebtemp, B, Eb);
   temp = VECT3_DOT_PRODUCT(Ebtemp, I);
-  temp = (-_ins->gains.ob / 1000.) * temp;
+  temp = (-_ins->gains.ob / 1000.f) * temp;
 
   VECT3_SMUL(Ebtemp, I, temp);
   VECT3_ADD(Evtemp, Ebtemp);
@@ -664,7 +755,7 @@ static inline void error_output(struct InsFloatInv *_ins)
 
   /* a scalar */
   /****** RvEv + RhEh = rv < Ia, Ev > + (-rhEh) **************/
-  _ins->corr.RE = ((_ins->gains.rv / 100.) * VECT3_DOT_PRODUCT(Ev, I)) + ((-_ins->gains.rh / 10000.) * Eh);
+  _ins->corr.RE = ((_ins->gains.rv / 100.f) * VECT3_DOT_PRODUCT(Ev, I)) + ((-_ins->gains.rh / 10000.f) * Eh);
 
   /****** ShEh ******/
   _ins->corr.SE = (_ins->gains.sh) * Eh;
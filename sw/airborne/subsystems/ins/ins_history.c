@@ -0,0 +1,288 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file subsystems/ins/ins_history.c
+ *
+ * State and input history for the fusion of delayed measurements.
+ */
+
+#include "subsystems/ins/ins_history.h"
+#include <string.h>
+
+/** Index in the buffers of the i-th saved step, 0 being the oldest one */
+static inline uint16_t ins_history_index(struct InsHistory *h, uint16_t i)
+{
+  return (h->head + h->size - h->count + i) % h->size;
+}
+
+/** Position of a buffer index in the saved steps, 0 being the oldest one */
+static inline uint16_t ins_history_position(struct InsHistory *h, uint16_t idx)
+{
+  return (idx + h->size + h->count - h->head) % h->size;
+}
+
+/** Latest saved step taken at or before stamp
+ * @return its position, or -1 if stamp is older than the history
+ */
+static int32_t ins_history_find(struct InsHistory *h, uint32_t stamp)
+{
+  if (h->count == 0 || (int32_t)(h->stamps[ins_history_index(h, 0)] - stamp) > 0) {
+    return -1;
+  }
+  // binary search, the stamps are increasing (with wrap around)
+  uint16_t lo = 0, hi = h->count - 1;
+  while (lo < hi) {
+    uint16_t mid = (lo + hi + 1) / 2;
+    if ((int32_t)(h->stamps[ins_history_index(h, mid)] - stamp) <= 0) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return lo;
+}
+
+/** End of the step at index idx, i.e. time of the next saved state */
+static inline uint32_t ins_history_step_end(struct InsHistory *h, uint16_t idx)
+{
+  uint16_t next = (idx + 1) % h->size;
+  return next == h->head ? h->now : h->stamps[next];
+}
+
+/** Fuse the measurements taken from start, and before end if bounded */
+static void ins_history_correct_from(struct InsHistory *h, void *state, uint32_t start, uint32_t end, bool bounded)
+{
+  for (uint16_t i = 0; i < h->meas_nb; i++) {
+    struct InsHistoryMeas *m = &h->meas[i];
+    if ((int32_t)(m->stamp - start) >= 0 && (!bounded || (int32_t)(m->stamp - end) < 0)) {
+      h->correct(state, m->type, m->values);
+    }
+  }
+}
+
+/** Keep a measurement to fuse it again in the replays passing its time */
+static void ins_history_keep(struct InsHistory *h, uint32_t stamp, uint8_t type, const float *values)
+{
+  if (h->meas_size == 0) {
+    h->meas_lost++;
+    return;
+  }
+  // forget the measurements older than the history, they are in the saved states
+  uint32_t oldest = h->stamps[ins_history_index(h, 0)];
+  uint16_t nb = 0;
+  for (uint16_t i = 0; i < h->meas_nb; i++) {
+    if ((int32_t)(h->meas[i].stamp - oldest) >= 0) {
+      h->meas[nb++] = h->meas[i];
+    }
+  }
+  h->meas_nb = nb;
+  if (h->meas_nb == h->meas_size) {
+    // drop the oldest measurement, it is lost for the replays starting before it
+    uint16_t k = 0;
+    for (uint16_t i = 1; i < h->meas_nb; i++) {
+      if ((int32_t)(h->meas[i].stamp - h->meas[k].stamp) < 0) {
+        k = i;
+      }
+    }
+    for (uint16_t i = k; i < h->meas_nb - 1; i++) {
+      h->meas[i] = h->meas[i + 1];
+    }
+    h->meas_nb--;
+    h->meas_lost++;
+  }
+  struct InsHistoryMeas *m = &h->meas[h->meas_nb++];
+  m->stamp = stamp;
+  m->type = type;
+  memcpy(m->values, values, sizeof(m->values));
+}
+
+/** End of a replay, the corrected state replaces the current one */
+static void ins_history_replay_done(struct InsHistory *h, void *state)
+{
+  // measurements without delay, fused in the current state meanwhile
+  ins_history_correct_from(h, h->replay_state, h->now, 0, false);
+  memcpy(state, h->replay_state, h->state_size);
+  h->replaying = false;
+}
+
+void ins_history_init(struct InsHistory *h, void *states, uint16_t state_size,
+                      float *inputs, uint8_t input_nb, uint32_t *stamps, float *dts, uint16_t size,
+                      void *replay_state, ins_history_propagate propagate, uint16_t replay_max_steps,
+                      struct InsHistoryMeas *meas, uint16_t meas_size, ins_history_correct correct)
+{
+  h->states = (uint8_t *)states;
+  h->state_size = state_size;
+  h->inputs = inputs;
+  h->input_nb = input_nb;
+  h->stamps = stamps;
+  h->dts = dts;
+  h->size = size;
+  h->replay_state = replay_state;
+  h->propagate = propagate;
+  h->replay_max_steps = replay_max_steps;
+  h->meas = meas;
+  h->meas_size = meas_size;
+  h->correct = correct;
+  h->rewinds = 0;
+  h->too_old = 0;
+  h->replay_steps = 0;
+  h->aborted = 0;
+  h->meas_lost = 0;
+  ins_history_reset(h);
+}
+
+/** Forget the saved steps and measurements, e.g. after a reset of the filter */
+void ins_history_reset(struct InsHistory *h)
+{
+  h->head = 0;
+  h->count = 0;
+  h->now = 0;
+  h->replay_idx = 0;
+  h->replaying = false;
+  h->meas_nb = 0;
+}
+
+/** Save the state before a propagation step
+ * @param stamp time of the state in usec
+ * @param state state before the propagation
+ * @param input inputs of the propagation step
+ * @param dt duration of the propagation step
+ */
+void ins_history_push(struct InsHistory *h, uint32_t stamp, const void *state, const float *input, float dt)
+{
+  if (h->count == h->size) {
+    // the oldest step is overwritten
+    if (h->replaying && h->replay_idx == h->head) {
+      h->replaying = false;
+      h->aborted++;
+    }
+  } else {
+    h->count++;
+  }
+  memcpy(&h->states[h->head * h->state_size], state, h->state_size);
+  memcpy(&h->inputs[h->head * h->input_nb], input, h->input_nb * sizeof(float));
+  h->stamps[h->head] = stamp;
+  h->dts[h->head] = dt;
+  h->head = (h->head + 1) % h->size;
+  h->now = stamp + (uint32_t)(dt * 1e6f + 0.5f);
+}
+
+/** Saved state at a past time
+ * @return the latest state saved at or before stamp, NULL if stamp is older than the history
+ */
+void *ins_history_state_at(struct InsHistory *h, uint32_t stamp)
+{
+  int32_t pos = ins_history_find(h, stamp);
+  if (pos < 0) {
+    return NULL;
+  }
+  return &h->states[ins_history_index(h, pos) * h->state_size];
+}
+
+/** Fuse a measurement taken at a given time
+ *
+ * A measurement taken during a saved step is fused in the state saved at the
+ * start of that step, which is then propagated again to the present by
+ * ins_history_replay(). If a replay is running and has not reached that step
+ * yet, the measurement is fused when the replay passes it. A measurement
+ * older than the history, or taken at the present time, is fused in the
+ * current state right away.
+ *
+ * The measurement is kept and fused again by the next replays passing its
+ * time, so that a replay starting before it does not erase it.
+ *
+ * @param state current state of the filter
+ * @param stamp time of the measurement in usec
+ * @param type type of the measurement, given to the correct function
+ * @param values INS_HISTORY_MEAS_VALUES values of the measurement
+ */
+void ins_history_fuse(struct InsHistory *h, void *state, uint32_t stamp, uint8_t type, const float *values)
+{
+  int32_t pos = ins_history_find(h, stamp);
+  if (pos < 0) {
+    if (h->count > 0) {
+      h->too_old++;
+    }
+    h->correct(state, type, values);
+    return;
+  }
+  ins_history_keep(h, stamp, type, values);
+  if ((int32_t)(stamp - h->now) >= 0) {
+    // no delay, fused in the state being propagated again at the end of the replay
+    h->correct(state, type, values);
+    return;
+  }
+  if (h->replaying && pos >= ins_history_position(h, h->replay_idx)) {
+    return;
+  }
+  // propagate again from the step of the measurement,
+  // the saved state already has the other measurements of that step
+  uint16_t idx = ins_history_index(h, pos);
+  memcpy(h->replay_state, &h->states[idx * h->state_size], h->state_size);
+  h->correct(h->replay_state, type, values);
+  memcpy(&h->states[idx * h->state_size], h->replay_state, h->state_size);
+  h->propagate(h->replay_state, &h->inputs[idx * h->input_nb], h->dts[idx]);
+  h->replay_idx = (idx + 1) % h->size;
+  h->replaying = true;
+  h->rewinds++;
+  h->replay_steps++;
+  if (h->replay_idx == h->head) {
+    ins_history_replay_done(h, state);
+  }
+}
+
+/** Fuse a measurement taken at the time of the current state */
+void ins_history_fuse_now(struct InsHistory *h, void *state, uint8_t type, const float *values)
+{
+  ins_history_fuse(h, state, h->now, type, values);
+}
+
+/** Propagate the corrected state towards the present
+ *
+ * At most replay_max_steps steps are propagated per call, the measurements
+ * of each step are fused on the way and the corrected states replace the
+ * saved ones. To be called after each push.
+ *
+ * @param state current state of the filter, replaced by the corrected one
+ *        once it is propagated up to the present
+ * @return true if the current state was replaced
+ */
+bool ins_history_replay(struct InsHistory *h, void *state)
+{
+  if (!h->replaying) {
+    return false;
+  }
+  uint16_t steps = 0;
+  while (h->replay_idx != h->head && steps < h->replay_max_steps) {
+    uint16_t idx = h->replay_idx;
+    ins_history_correct_from(h, h->replay_state, h->stamps[idx], ins_history_step_end(h, idx), true);
+    memcpy(&h->states[idx * h->state_size], h->replay_state, h->state_size);
+    h->propagate(h->replay_state, &h->inputs[idx * h->input_nb], h->dts[idx]);
+    h->replay_idx = (idx + 1) % h->size;
+    steps++;
+  }
+  h->replay_steps += steps;
+  if (h->replay_idx != h->head) {
+    return false;
+  }
+  ins_history_replay_done(h, state);
+  return true;
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file subsystems/ins/ins_history.h
+ *
+ * State and input history for the fusion of delayed measurements.
+ *
+ * A filter pushes its state and the inputs (e.g. accel) before every
+ * propagation step, and gives its measurements to ins_history_fuse() with
+ * their time. A measurement taken at a past time is fused in the state saved
+ * at that time, and the corrected state is propagated again with the saved
+ * inputs up to the present by ins_history_replay(), a limited number of steps
+ * per call. The corrected states replace the saved ones on the way.
+ *
+ * The measurements are kept as long as their time is in the history: when a
+ * replay passes the time of a measurement, it is fused again in the state
+ * being propagated. A measurement received during a replay is then fused at
+ * its own time, and a later measurement older than the ones already fused
+ * does not erase them. Measurements taken at the present time are fused in
+ * the current state right away.
+ *
+ * The memory is given by the filter at init, the history does not depend on
+ * the type of the state:
+ * @code
+ * static struct MyState my_states[N];
+ * static float my_inputs[N][2];
+ * static uint32_t my_stamps[N];
+ * static float my_dts[N];
+ * static struct MyState my_replay;
+ * static struct InsHistoryMeas my_meas[M];
+ * ins_history_init(&h, my_states, sizeof(struct MyState), my_inputs[0], 2, my_stamps, my_dts, N,
+ *                  &my_replay, my_propagate, 8, my_meas, M, my_correct);
+ * @endcode
+ */
+
+#ifndef INS_HISTORY_H
+#define INS_HISTORY_H
+
+#include "std.h"
+
+/** Propagate a state over dt with the saved inputs */
+typedef void (*ins_history_propagate)(void *state, const float *input, float dt);
+
+/** Fuse a measurement of the given type in a state */
+typedef void (*ins_history_correct)(void *state, uint8_t type, const float *values);
+
+/** Number of values of a measurement */
+#ifndef INS_HISTORY_MEAS_VALUES
+#define INS_HISTORY_MEAS_VALUES 2
+#endif
+
+struct InsHistoryMeas {
+  uint32_t stamp;         ///< time of the measurement in usec
+  uint8_t type;           ///< type of the measurement, given to the correct function
+  float values[INS_HISTORY_MEAS_VALUES];
+};
+
+struct InsHistory {
+  uint8_t *states;        ///< state before each propagation step, state_size bytes each
+  float *inputs;          ///< inputs of each propagation step, input_nb floats each
+  uint32_t *stamps;       ///< time of the saved states in usec
+  float *dts;             ///< duration of each propagation step in s
+  uint16_t state_size;    ///< size of a state in bytes
+  uint8_t input_nb;       ///< number of inputs per step
+  uint16_t size;          ///< number of steps in the history
+  uint16_t head;          ///< index of the next step to write
+  uint16_t count;         ///< number of saved steps
+  uint32_t now;           ///< time of the current state in usec, at the end of the last step
+
+  void *replay_state;     ///< state being propagated again
+  ins_history_propagate propagate;
+  uint16_t replay_max_steps;  ///< maximum number of steps propagated per call of ins_history_replay
+  uint16_t replay_idx;    ///< index of the next step to propagate again
+  bool replaying;         ///< a corrected state is being propagated to the present
+
+  struct InsHistoryMeas *meas;  ///< measurements taken during the saved steps
+  ins_history_correct correct;
+  uint16_t meas_size;     ///< maximum number of measurements
+  uint16_t meas_nb;       ///< number of measurements, in the order of reception
+
+  /* statistics */
+  uint32_t rewinds;       ///< number of delayed measurements fused in a past state
+  uint32_t too_old;       ///< number of measurements older than the history
+  uint32_t replay_steps;  ///< number of steps propagated again
+  uint32_t aborted;       ///< number of replays overwritten before catching up with the present
+  uint32_t meas_lost;     ///< number of measurements dropped from a full buffer
+};
+
+extern void ins_history_init(struct InsHistory *h, void *states, uint16_t state_size,
+                             float *inputs, uint8_t input_nb, uint32_t *stamps, float *dts, uint16_t size,
+                             void *replay_state, ins_history_propagate propagate, uint16_t replay_max_steps,
+                             struct InsHistoryMeas *meas, uint16_t meas_size, ins_history_correct correct);
+extern void ins_history_reset(struct InsHistory *h);
+extern void ins_history_push(struct InsHistory *h, uint32_t stamp, const void *state, const float *input, float dt);
+extern void *ins_history_state_at(struct InsHistory *h, uint32_t stamp);
+extern void ins_history_fuse(struct InsHistory *h, void *state, uint32_t stamp, uint8_t type, const float *values);
+extern void ins_history_fuse_now(struct InsHistory *h, void *state, uint8_t type, const float *values);
+extern bool ins_history_replay(struct InsHistory *h, void *state);
+
+#endif /* INS_HISTORY_H */
@@ -156,6 +156,137 @@ static void pos_est_cb(uint8_t sender_id,
                        float x, float y, float z,
                        float noise_x, float noise_y, float noise_z);
 
+/** Fusion of the delayed measurements in the vertical filter.
+ * The vff states are saved, the GPS and the position and velocity estimates
+ * are fused in the state at their measurement time and propagated again
+ * to the present. The baro and sonar are fused in the current state, and
+ * kept in the history with the other measurements so that the replays
+ * passing their time fuse them again.
+ */
+#ifndef INS_INT_DELAYED_FUSION
+#define INS_INT_DELAYED_FUSION FALSE
+#endif
+
+#if INS_INT_DELAYED_FUSION
+#include "subsystems/ins/ins_history.h"
+#include "mcu_periph/sys_time.h"
+
+/** number of propagation steps saved, should cover the largest measurement delay */
+#ifndef INS_INT_HISTORY_SIZE
+#define INS_INT_HISTORY_SIZE 128
+#endif
+
+/** number of measurements kept in the history */
+#ifndef INS_INT_HISTORY_MEAS_SIZE
+#define INS_INT_HISTORY_MEAS_SIZE 32
+#endif
+
+/** maximum number of past steps propagated again per propagation */
+#ifndef INS_INT_HISTORY_REPLAY_STEPS
+#define INS_INT_HISTORY_REPLAY_STEPS 8
+#endif
+
+/** GPS measurement delay in seconds */
+#ifndef INS_INT_GPS_DELAY
+#ifdef GPS_LAG
+#define INS_INT_GPS_DELAY GPS_LAG
+#else
+#define INS_INT_GPS_DELAY 0.
+#endif
+#endif
+
+#if USE_VFF_EXTENDED
+typedef struct VffExtended ins_vff_state;
+#else
+typedef struct Vff ins_vff_state;
+#endif
+
+static struct InsHistory ins_vff_history;
+static ins_vff_state ins_vff_states[INS_INT_HISTORY_SIZE];
+static float ins_vff_accels[INS_INT_HISTORY_SIZE];
+static uint32_t ins_vff_stamps[INS_INT_HISTORY_SIZE];
+static float ins_vff_dts[INS_INT_HISTORY_SIZE];
+static ins_vff_state ins_vff_replay;
+static struct InsHistoryMeas ins_vff_meas[INS_INT_HISTORY_MEAS_SIZE];
+static uint32_t ins_vff_stamp; ///< time of the current vff state in usec
+#endif
+
+/** Measurements of the vertical filter */
+enum ins_vff_meas_type {
+  INS_VFF_BARO,       ///< baro height
+  INS_VFF_Z_CONF,     ///< height and its noise
+  INS_VFF_VZ_CONF,    ///< vertical speed and its noise
+  INS_VFF_OFFSET      ///< baro offset
+};
+
+static void ins_vff_update(uint8_t type, const float *meas)
+{
+  switch (type) {
+    case INS_VFF_BARO:
+#if USE_VFF_EXTENDED
+      vff_update_baro(meas[0]);
+#else
+      vff_update(meas[0]);
+#endif
+      break;
+    case INS_VFF_Z_CONF:
+      vff_update_z_conf(meas[0], meas[1]);
+      break;
+    case INS_VFF_VZ_CONF:
+      vff_update_vz_conf(meas[0], meas[1]);
+      break;
+#if USE_VFF_EXTENDED
+    case INS_VFF_OFFSET:
+      vff_update_offset(meas[0]);
+      break;
+#endif
+    default:
+      break;
+  }
+}
+
+#if INS_INT_DELAYED_FUSION
+static void ins_vff_propagate_past(void *state, const float *accel, float dt)
+{
+  ins_vff_state now = vff;
+  vff = *(ins_vff_state *)state;
+  vff_propagate(accel[0], dt);
+  *(ins_vff_state *)state = vff;
+  vff = now;
+}
+
+static void ins_vff_correct_past(void *state, uint8_t type, const float *meas)
+{
+  if (state == &vff) {
+    ins_vff_update(type, meas);
+    return;
+  }
+  ins_vff_state now = vff;
+  vff = *(ins_vff_state *)state;
+  ins_vff_update(type, meas);
+  *(ins_vff_state *)state = vff;
+  vff = now;
+}
+
+/** Fuse a vff measurement at its time */
+#define INS_VFF_UPDATE_AT(_stamp, _type, _v, _r) {                            \
+    float _meas[INS_HISTORY_MEAS_VALUES] = { _v, _r };                        \
+    ins_history_fuse(&ins_vff_history, &vff, _stamp, _type, _meas);           \
+  }
+
+/** Fuse a vff measurement without delay */
+#define INS_VFF_UPDATE_NOW(_type, _v, _r) {                                   \
+    float _meas[INS_HISTORY_MEAS_VALUES] = { _v, _r };                        \
+    ins_history_fuse_now(&ins_vff_history, &vff, _type, _meas);               \
+  }
+#else
+#define INS_VFF_UPDATE_AT(_stamp, _type, _v, _r) {                            \
+    float _meas[2] = { _v, _r };                                              \
+    ins_vff_update(_type, _meas);                                             \
+  }
+#define INS_VFF_UPDATE_NOW(_type, _v, _r) INS_VFF_UPDATE_AT(0, _type, _v, _r)
+#endif
+
 struct InsInt ins_int;
 
 #if PERIODIC_TELEMETRY
@@ -221,6 +352,12 @@ void ins_int_init(void)
 
   /* init vertical and horizontal filters */
   vff_init_zero();
+#if INS_INT_DELAYED_FUSION
+  ins_history_init(&ins_vff_history, ins_vff_states, sizeof(ins_vff_state), ins_vff_accels, 1,
+                   ins_vff_stamps, ins_vff_dts, INS_INT_HISTORY_SIZE,
+                   &ins_vff_replay, ins_vff_propagate_past, INS_INT_HISTORY_REPLAY_STEPS,
+                   ins_vff_meas, INS_INT_HISTORY_MEAS_SIZE, ins_vff_correct_past);
+#endif
 #if USE_HFF
   hff_init(0., 0., 0., 0.);
 #endif
@@ -301,7 +438,14 @@ void ins_int_propagate(struct Int32Vect3 *accel, float dt)
    * and there is no gps fix yet...
    */
   if (ins_int.propagation_cnt < INS_MAX_PROPAGATION_STEPS) {
+#if INS_INT_DELAYED_FUSION
+    ins_history_push(&ins_vff_history, ins_vff_stamp, &vff, &z_accel_meas_float, dt);
     vff_propagate(z_accel_meas_float, dt);
+    // replace the state once the corrections of delayed measurements are propagated to the present
+    ins_history_replay(&ins_vff_history, &vff);
+#else
+    vff_propagate(z_accel_meas_float, dt);
+#endif
     ins_update_from_vff();
   } else {
     // feed accel from the sensors
@@ -341,6 +485,9 @@ static void baro_cb(uint8_t __attribute__((unused)) sender_id, float pressure)
       ins_int.vf_reset = false;
       ins_int.qfe = pressure;
       vff_realign(0.);
+#if INS_INT_DELAYED_FUSION
+      ins_history_reset(&ins_vff_history);
+#endif
       ins_update_from_vff();
     } else {
       float baro_up = pprz_isa_height_of_pressure(pressure, ins_int.qfe);
@@ -356,11 +503,7 @@ static void baro_cb(uint8_t __attribute__((unused)) sender_id, float pressure)
       // The VFF will update in the NED frame
       ins_int.baro_z = -(baro_up - height_correction);
 
-#if USE_VFF_EXTENDED
-      vff_update_baro(ins_int.baro_z);
-#else
-      vff_update(ins_int.baro_z);
-#endif
+      INS_VFF_UPDATE_NOW(INS_VFF_BARO, ins_int.baro_z, 0.f);
     }
     ins_ned_to_state();
 
@@ -404,11 +547,14 @@ void ins_int_update_gps(struct GpsState *gps_s)
   struct NedCoor_i gps_speed_cm_s_ned;
   ned_of_ecef_vect_i(&gps_speed_cm_s_ned, &ins_int.ltp_def, &gps_s->ecef_vel);
 
+#if INS_INT_DELAYED_FUSION && (INS_USE_GPS_ALT || INS_USE_GPS_ALT_SPEED)
+  uint32_t gps_stamp = get_sys_time_usec() - (uint32_t)(INS_INT_GPS_DELAY * 1e6);
+#endif
 #if INS_USE_GPS_ALT
-  vff_update_z_conf(((float)gps_pos_cm_ned.z) / 100.0, INS_VFF_R_GPS);
+  INS_VFF_UPDATE_AT(gps_stamp, INS_VFF_Z_CONF, ((float)gps_pos_cm_ned.z) / 100.0, INS_VFF_R_GPS);
 #endif
 #if INS_USE_GPS_ALT_SPEED
-  vff_update_vz_conf(((float)gps_speed_cm_s_ned.z) / 100.0, INS_VFF_VZ_R_GPS);
+  INS_VFF_UPDATE_AT(gps_stamp, INS_VFF_VZ_CONF, ((float)gps_speed_cm_s_ned.z) / 100.0, INS_VFF_VZ_R_GPS);
   ins_int.propagation_cnt = 0;
 #endif
 
@@ -464,11 +610,11 @@ static void sonar_cb(uint8_t __attribute__((unused)) sender_id, float distance)
 #endif
       && ins_int.update_on_agl
       && ins_int.baro_initialized) {
-    vff_update_z_conf(-(distance), VFF_R_SONAR_0 + VFF_R_SONAR_OF_M * fabsf(distance));
+    INS_VFF_UPDATE_NOW(INS_VFF_Z_CONF, -(distance), VFF_R_SONAR_0 + VFF_R_SONAR_OF_M * fabsf(distance));
     last_offset = vff.offset;
   } else {
     /* update offset with last value to avoid divergence */
-    vff_update_offset(last_offset);
+    INS_VFF_UPDATE_NOW(INS_VFF_OFFSET, last_offset, 0.f);
   }
 
   /* reset the counter to indicate we just had a measurement update */
@@ -521,6 +667,9 @@ static void accel_cb(uint8_t sender_id __attribute__((unused)),
 
   if (last_stamp > 0) {
     float dt = (float)(stamp - last_stamp) * 1e-6;
+#if INS_INT_DELAYED_FUSION
+    ins_vff_stamp = last_stamp;
+#endif
     ins_int_propagate(accel, dt);
   }
   last_stamp = stamp;
@@ -588,7 +737,7 @@ static void vel_est_cb(uint8_t sender_id __attribute__((unused)),
 #endif
 
   // abi message contains an update to the vertical velocity estimate
-  vff_update_vz_conf(vel_ned.z, noise_z);
+  INS_VFF_UPDATE_AT(stamp, INS_VFF_VZ_CONF, vel_ned.z, noise_z);
 
   ins_ned_to_state();
 
@@ -621,7 +770,7 @@ static void pos_est_cb(uint8_t sender_id __attribute__((unused)),
   }
 #endif
 
-  vff_update_z_conf(z, noise_z);
+  INS_VFF_UPDATE_AT(stamp, INS_VFF_Z_CONF, z, noise_z);
 
   ins_ned_to_state();
 
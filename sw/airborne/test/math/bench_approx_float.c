@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/math/bench_approx_float.c
+ *
+ * Throughput of the float approximations (pprz_approx_float.h) against libm.
+ *
+ * Prints one CSV line per function:
+ *   function,libm_ns,precise_ns,fast_ns
+ * in ns per call, over a buffer of inputs in the range used by the filters.
+ * eulers_of_quat is the atan2/asin part of float_eulers_of_quat.
+ *
+ * Usage: bench_approx_float [calls]
+ *
+ * The functions only depend on libm, so the same file can be built for a
+ * Cortex-M4 board by replacing bench_now() with the DWT cycle counter.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "math/pprz_approx_float.h"
+
+#define BENCH_N 1024
+
+/* keep the compiler from moving the computation out of the timing loop */
+#define BENCH_BARRIER() __asm__ volatile("" ::: "memory")
+
+static float in_x[BENCH_N], in_y[BENCH_N], in_u[BENCH_N], in_p[BENCH_N];
+static volatile float sink;
+
+static double bench_now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/** Time _calls evaluations of _expr over the inputs, in ns per evaluation */
+#define BENCH_TIME(_calls, _expr) ({                        \
+    float _acc = 0.f;                                       \
+    double _start = bench_now();                            \
+    for (uint32_t _c = 0; _c < (_calls) / BENCH_N; _c++) {  \
+      for (int i = 0; i < BENCH_N; i++) {                   \
+        _acc += _expr;                                      \
+      }                                                     \
+      BENCH_BARRIER();                                      \
+    }                                                       \
+    sink = _acc;                                            \
+    (bench_now() - _start) * 1e9 / (_calls);                \
+  })
+
+static float libm_sincos(float x)
+{
+  float s, c;
+  float_libm_sincos(x, &s, &c);
+  return s + c;
+}
+
+static float approx_sincos(float x)
+{
+  float s, c;
+  float_approx_sincos(x, &s, &c);
+  return s + c;
+}
+
+static float approx_sincos_fast(float x)
+{
+  float s, c;
+  float_approx_sincos_fast(x, &s, &c);
+  return s + c;
+}
+
+#define EULERS(_atan2, _asin, _i) \
+  (_atan2(in_y[_i], in_x[_i]) - _asin(in_u[_i]) + _atan2(in_x[_i], in_y[_i]))
+
+int main(int argc, char **argv)
+{
+  uint32_t calls = (argc > 1) ? atoi(argv[1]) : 10000000;
+
+  srand(42);
+  for (int i = 0; i < BENCH_N; i++) {
+    in_x[i] = 2.f * rand() / (float)RAND_MAX - 1.f;
+    in_y[i] = 2.f * rand() / (float)RAND_MAX - 1.f;
+    in_u[i] = 0.99f * (2.f * rand() / (float)RAND_MAX - 1.f);
+    in_p[i] = 100.f * rand() / (float)RAND_MAX;
+  }
+
+  printf("function,libm_ns,precise_ns,fast_ns\n");
+  printf("sincos,%.2f,%.2f,%.2f\n",
+         BENCH_TIME(calls, libm_sincos(4.f * in_x[i])),
+         BENCH_TIME(calls, approx_sincos(4.f * in_x[i])),
+         BENCH_TIME(calls, approx_sincos_fast(4.f * in_x[i])));
+  printf("atan2,%.2f,%.2f,%.2f\n",
+         BENCH_TIME(calls, atan2f(in_y[i], in_x[i])),
+         BENCH_TIME(calls, float_approx_atan2(in_y[i], in_x[i])),
+         BENCH_TIME(calls, float_approx_atan2_fast(in_y[i], in_x[i])));
+  printf("asin,%.2f,%.2f,%.2f\n",
+         BENCH_TIME(calls, asinf(in_u[i])),
+         BENCH_TIME(calls, float_approx_asin(in_u[i])),
+         BENCH_TIME(calls, float_approx_asin_fast(in_u[i])));
+  printf("sqrt,%.2f,%.2f,%.2f\n",
+         BENCH_TIME(calls, sqrtf(in_p[i])),
+         BENCH_TIME(calls, float_approx_sqrt(in_p[i])),
+         BENCH_TIME(calls, float_approx_sqrt_fast(in_p[i])));
+  printf("eulers_of_quat,%.2f,%.2f,%.2f\n",
+         BENCH_TIME(calls, EULERS(atan2f, asinf, i)),
+         BENCH_TIME(calls, EULERS(float_approx_atan2, float_approx_asin, i)),
+         BENCH_TIME(calls, EULERS(float_approx_atan2_fast, float_approx_asin_fast, i)));
+
+  return 0;
+}
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/math/bench_matrix_fixed.c
+ *
+ * Micro-benchmark of the fixed size matrix kernels (pprz_matrix_fixed_float.h)
+ * against the code they would replace: the generic float ** functions and the
+ * MAT_MUL macros.
+ *
+ * Prints one CSV line per kernel, size and baseline:
+ *   kernel,size,baseline,baseline_ns,fixed_ns,speedup
+ * where speedup is baseline_ns / fixed_ns, below 1 when the kernel is slower.
+ * Each time is the best of several runs to filter out the host noise.
+ *
+ * Usage: bench_matrix_fixed [calls]
+ *
+ * The kernels only depend on libm, so the same file can be built for a
+ * Cortex-M4 board by replacing bench_now() with the DWT cycle counter.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "math/pprz_algebra_float.h"
+#include "math/pprz_simple_matrix.h"
+#include "math/pprz_matrix_decomp_float.h"
+#include "math/pprz_matrix_fixed_float.h"
+
+/* keep the compiler from moving the computation out of the timing loop */
+#define BENCH_BARRIER() __asm__ volatile("" ::: "memory")
+
+static double bench_now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void rand_mat(float *a, int n)
+{
+  for (int i = 0; i < n; i++) {
+    a[i] = 2.f * rand() / (float)RAND_MAX - 1.f;
+  }
+}
+
+#define BENCH_RUNS 10
+
+/** Time _calls executions of _code in ns per call, best of BENCH_RUNS */
+#define BENCH_TIME(_calls, _code) ({                  \
+    double _best = 1e30;                              \
+    for (int _r = 0; _r < BENCH_RUNS; _r++) {         \
+      double _start = bench_now();                    \
+      for (uint32_t _c = 0; _c < (_calls); _c++) {    \
+        _code;                                        \
+        BENCH_BARRIER();                              \
+      }                                               \
+      double _t = (bench_now() - _start) * 1e9 / (_calls); \
+      _best = (_t < _best) ? _t : _best;              \
+    }                                                 \
+    _best;                                            \
+  })
+
+static void bench_print(const char *kernel, const char *size, const char *baseline, double base, double fixed)
+{
+  printf("%s,%s,%s,%.1f,%.1f,%.2f\n", kernel, size, baseline, base, fixed, base / fixed);
+}
+
+#define BENCH_SQUARE(_n)                                                                            \
+  static void bench_##_n(uint32_t calls)                                                            \
+  {                                                                                                 \
+    float a[_n][_n], b[_n][_n], o[_n][_n], s[_n][_n], w[_n], v[_n][_n], u[_n][_n];                  \
+    rand_mat(a[0], _n * _n);                                                                        \
+    rand_mat(b[0], _n * _n);                                                                        \
+    MAKE_MATRIX_PTR(a_ptr, a, _n);                                                                  \
+    MAKE_MATRIX_PTR(b_ptr, b, _n);                                                                  \
+    MAKE_MATRIX_PTR(o_ptr, o, _n);                                                                  \
+    MAKE_MATRIX_PTR(s_ptr, s, _n);                                                                  \
+    MAKE_MATRIX_PTR(v_ptr, v, _n);                                                                  \
+    MAKE_MATRIX_PTR(u_ptr, u, _n);                                                                  \
+    const char *size = #_n "x" #_n;                                                                 \
+                                                                                                    \
+    double fixed = BENCH_TIME(calls, float_mat_fixed_mul(o[0], a[0], b[0], _n, _n, _n));                                 \
+    bench_print("mul", size, "float_mat_mul",                                                       \
+                BENCH_TIME(calls, float_mat_mul(o_ptr, a_ptr, b_ptr, _n, _n, _n)), fixed);          \
+    bench_print("mul", size, "MAT_MUL", BENCH_TIME(calls, MAT_MUL(_n, _n, _n, o, a, b)), fixed);    \
+                                                                                                    \
+    /* symmetric positive definite matrix for the Cholesky decomposition */                         \
+    MAT_MUL_T(_n, _n, _n, s, a, a);                                                                 \
+    for (int i = 0; i < _n; i++) {                                                                  \
+      s[i][i] += _n;                                                                                \
+    }                                                                                               \
+    bench_print("cholesky", size, "pprz_cholesky_float",                                            \
+                BENCH_TIME(calls, pprz_cholesky_float(o_ptr, s_ptr, _n)),                           \
+                BENCH_TIME(calls, float_mat_fixed_cholesky(o[0], s[0], _n)));                                 \
+                                                                                                    \
+    /* the SVD works in place, start from the same matrix at every call */                          \
+    bench_print("svd", size, "pprz_svd_float",                                                      \
+                BENCH_TIME(calls / 10, (memcpy(u, a, sizeof(u)), pprz_svd_float(u_ptr, w, v_ptr, _n, _n))),     \
+                BENCH_TIME(calls / 10, (memcpy(u, a, sizeof(u)), float_mat_fixed_svd(u[0], w, v[0], _n, _n)))); \
+  }
+
+BENCH_SQUARE(3)
+BENCH_SQUARE(4)
+BENCH_SQUARE(6)
+BENCH_SQUARE(9)
+
+/** Products of ahrs_float_mlkf, [m x n] * [n x l] */
+#define BENCH_MUL(_m, _n, _l, _calls) {                                                             \
+    float a[_m][_n], b[_n][_l], o[_m][_l];                                                          \
+    rand_mat(a[0], _m * _n);                                                                        \
+    rand_mat(b[0], _n * _l);                                                                        \
+    bench_print("mul", #_m "x" #_n "x" #_l, "MAT_MUL",                                              \
+                BENCH_TIME(_calls, MAT_MUL(_m, _n, _l, o, a, b)),                                   \
+                BENCH_TIME(_calls, float_mat_fixed_mul(o[0], a[0], b[0], _m, _n, _l)));             \
+  }
+
+int main(int argc, char **argv)
+{
+  uint32_t calls = (argc > 1) ? atoi(argv[1]) : 100000;
+
+  srand(42);
+  printf("kernel,size,baseline,baseline_ns,fixed_ns,speedup\n");
+  bench_3(calls);
+  bench_4(calls);
+  bench_6(calls);
+  bench_9(calls);
+  BENCH_MUL(3, 6, 6, calls);
+  BENCH_MUL(6, 3, 3, calls);
+  BENCH_MUL(6, 3, 6, calls);
+
+  return 0;
+}
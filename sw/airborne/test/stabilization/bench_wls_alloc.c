@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/stabilization/bench_wls_alloc.c
+ *
+ * Host micro-benchmark of the WLS control allocation.
+ *
+ * Solves random multirotor allocation problems (INDI weights) and prints one
+ * CSV line per scenario:
+ *   scenario,n_u,calls,mean_us,max_us,mean_iter,max_iter,max_us_per_iter,worst_case_us,allocs_per_call
+ *
+ * - cold: independent problems, without working set
+ * - warm: slowly varying objective, warm started from the previous working set
+ * - saturated: large objectives, most actuators end at a limit
+ * - qr_solve: one full factorization with the generic qr_solve, as done at every iteration before
+ *
+ * Every problem is solved BENCH_REPEAT times and the fastest time is kept, so
+ * that the maximum is not the scheduling jitter of the host.
+ * worst_case_us is the maximum number of iterations of INDI (10) times the
+ * largest time of one iteration, which bounds the time of one allocation.
+ *
+ * Usage: bench_wls_alloc [-n calls]
+ *
+ * Allocations are counted by wrapping malloc/calloc/realloc at link time
+ * (-Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+
+#include "std.h"
+#include "firmwares/rotorcraft/stabilization/wls/wls_alloc.h"
+
+#define BENCH_GAMMA_SQ 10000
+#define BENCH_IMAX 10
+#define BENCH_MAX_PPRZ 9600
+#define BENCH_REPEAT 5
+
+/* Allocation counting */
+static volatile uint32_t bench_allocs = 0;
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+  bench_allocs++;
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size)
+{
+  bench_allocs++;
+  return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+  bench_allocs++;
+  return __real_realloc(ptr, size);
+}
+
+enum bench_scenario {
+  BENCH_COLD,
+  BENCH_WARM,
+  BENCH_SATURATED,
+  BENCH_QR_SOLVE
+};
+
+static const char *bench_names[] = {"cold", "warm", "saturated", "qr_solve"};
+
+/* Allocation problem and working set of the previous call */
+struct bench_problem {
+  int n_u;
+  float B[WLS_N_V][WLS_N_U];
+  float *B_ptr[WLS_N_V];
+  float v[WLS_N_V];
+  float v0[WLS_N_V];
+  float umin[WLS_N_U];
+  float umax[WLS_N_U];
+  float up[WLS_N_U];
+  float W[WLS_N_U];
+};
+
+static float Wv[WLS_N_V] = {1000, 1000, 1, 100};
+
+static double bench_now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static float randu(float min, float max)
+{
+  return min + (max - min) * rand() / (float)RAND_MAX;
+}
+
+/** Multirotor with n_u rotors in a circle, alternating yaw direction */
+static void bench_problem_init(struct bench_problem *p, int n_u, float v_scale)
+{
+  p->n_u = n_u;
+  for (int i = 0; i < n_u; i++) {
+    float angle = 2 * M_PI * (i + 0.5) / n_u;
+    p->B[0][i] = -0.003 * sinf(angle) * randu(0.8, 1.2);
+    p->B[1][i] = 0.003 * cosf(angle) * randu(0.8, 1.2);
+    p->B[2][i] = ((i % 2) ? 0.0005 : -0.0005) * randu(0.8, 1.2);
+    p->B[3][i] = -0.001 * randu(0.8, 1.2);
+    float state = randu(0, BENCH_MAX_PPRZ);
+    p->umin[i] = -state;
+    p->umax[i] = BENCH_MAX_PPRZ - state;
+    p->up[i] = -state;
+    p->W[i] = 0;
+  }
+  for (int i = 0; i < WLS_N_V; i++) {
+    p->B_ptr[i] = p->B[i];
+  }
+  p->v0[0] = randu(-40, 40) * v_scale;
+  p->v0[1] = randu(-40, 40) * v_scale;
+  p->v0[2] = randu(-10, 10) * v_scale;
+  p->v0[3] = randu(-5, 5) * v_scale;
+  memcpy(p->v, p->v0, sizeof(p->v));
+}
+
+/** One full factorization of the unconstrained problem with the generic qr_solve */
+static void bench_qr_solve(struct bench_problem *p, float *u)
+{
+  float A[WLS_N_C][WLS_N_U], d[WLS_N_C];
+  float *A_ptr[WLS_N_C];
+  for (int i = 0; i < p->n_u + WLS_N_V; i++) {
+    A_ptr[i] = A[i];
+    for (int j = 0; j < p->n_u; j++) {
+      A[i][j] = (i < WLS_N_V) ? BENCH_GAMMA_SQ * Wv[i] * p->B[i][j] : (i - WLS_N_V == j);
+    }
+    d[i] = (i < WLS_N_V) ? BENCH_GAMMA_SQ * Wv[i] * p->v[i] : p->up[i - WLS_N_V];
+  }
+  qr_solve_wrapper(p->n_u + WLS_N_V, p->n_u, A_ptr, d, u);
+}
+
+static void bench_run(enum bench_scenario scenario, int n_u, uint32_t calls)
+{
+  struct bench_problem p;
+  float u[WLS_N_U];
+  double t_total = 0, t_max = 0, t_iter_max = 0;
+  uint32_t iter_total = 0, failed = 0;
+  int iter_max = 0;
+
+  srand(42);
+  bench_problem_init(&p, n_u, 1);
+  uint32_t allocs_start = bench_allocs;
+  for (uint32_t n = 0; n < calls; n++) {
+    if (scenario == BENCH_WARM) {
+      for (int i = 0; i < WLS_N_V; i++) {
+        p.v[i] = p.v0[i] * (1 + sinf(n * 0.01 + i));
+      }
+    } else {
+      bench_problem_init(&p, n_u, (scenario == BENCH_SATURATED) ? 5 : 1);
+    }
+
+    // the fastest of a few repetitions, to remove the jitter of the host
+    int iter = 1;
+    double t = INFINITY;
+    float W[WLS_N_U];
+    memcpy(W, p.W, sizeof(W));
+    for (int r = 0; r < BENCH_REPEAT; r++) {
+      memcpy(p.W, W, sizeof(W));
+      double t_start = bench_now();
+      if (scenario == BENCH_QR_SOLVE) {
+        bench_qr_solve(&p, u);
+      } else {
+        iter = wls_alloc(u, p.v, p.umin, p.umax, p.B_ptr, n_u, WLS_N_V, 0, (scenario == BENCH_WARM) ? p.W : 0, Wv, 0,
+                         p.up, BENCH_GAMMA_SQ, BENCH_IMAX);
+      }
+      double t_call = bench_now() - t_start;
+      t = (t_call < t) ? t_call : t;
+    }
+
+    if (iter < 0) {
+      failed++;
+      iter = BENCH_IMAX;
+    }
+    t_total += t;
+    iter_total += iter;
+    t_max = (t > t_max) ? t : t_max;
+    iter_max = (iter > iter_max) ? iter : iter_max;
+    t_iter_max = (t / iter > t_iter_max) ? t / iter : t_iter_max;
+  }
+  uint32_t allocs = bench_allocs - allocs_start;
+
+  printf("%s,%d,%u,%.3f,%.3f,%.2f,%d,%.3f,%.3f,%.2f\n", bench_names[scenario], n_u, calls, t_total * 1e6 / calls,
+         t_max * 1e6, (double)iter_total / calls, iter_max, t_iter_max * 1e6, t_iter_max * 1e6 * BENCH_IMAX,
+         (double)allocs / calls);
+  if (failed) {
+    fprintf(stderr, "%s with %d actuators: %u calls reached the maximum number of iterations\n",
+            bench_names[scenario], n_u, failed);
+  }
+  fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t calls = 100000;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:")) != -1) {
+    switch (opt) {
+      case 'n': calls = atoi(optarg); break;
+      default:
+        fprintf(stderr, "Usage: %s [-n calls]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  printf("scenario,n_u,calls,mean_us,max_us,mean_iter,max_iter,max_us_per_iter,worst_case_us,allocs_per_call\n");
+  for (int n_u = 4; n_u <= WLS_N_U; n_u += 2) {
+    for (int s = BENCH_COLD; s <= BENCH_QR_SOLVE; s++) {
+      bench_run(s, n_u, calls);
+    }
+  }
+
+  return 0;
+}
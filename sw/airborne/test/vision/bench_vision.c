@@ -0,0 +1,404 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/vision/bench_vision.c
+ *
+ * Host micro-benchmark of the computer vision library (lib/vision, lib/encoding and blob).
+ *
+ * Runs every kernel on recorded UYVY (YUV422) frames for a sweep of resolutions and
+ * thresholds and prints one CSV line per run:
+ *   kernel,width,height,param,calls,ns_per_pixel,fps,allocs_per_call
+ *
+ * Usage: bench_vision [-w width] [-h height] [-t min_time_s] [frames.yuv ...]
+ * A .yuv file contains one or more raw UYVY frames of width x height pixels
+ * (e.g. recorded with video_usb_logger or 'ffmpeg -pix_fmt uyvy422 -f rawvideo').
+ * Without files a synthetic textured sequence is used.
+ *
+ * Allocations are counted by wrapping malloc/calloc/realloc at link time
+ * (-Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "lib/vision/image.h"
+#include "lib/vision/fast_rosten.h"
+#include "lib/vision/act_fast.h"
+#include "lib/vision/lucas_kanade.h"
+#include "lib/vision/frame_arena.h"
+#include "lib/vision/edge_flow.h"
+#include "lib/encoding/jpeg.h"
+#include "blob/blob_finder.h"
+
+#define BENCH_MAX_FRAMES 16
+#define BENCH_MAX_CORNERS 512
+
+/* Allocation counting */
+static volatile uint32_t bench_allocs = 0;
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+  bench_allocs++;
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size)
+{
+  bench_allocs++;
+  return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+  bench_allocs++;
+  return __real_realloc(ptr, size);
+}
+
+/* Benchmark state, shared by the kernel functions */
+struct bench_t {
+  struct image_t *frames;         ///< YUV422 frames at the current resolution
+  struct image_t *gray;           ///< Grayscale versions of the frames
+  uint16_t frames_cnt;            ///< Number of frames
+  uint16_t idx;                   ///< Current frame index
+  uint16_t param;                 ///< Kernel parameter (threshold, quality, ...)
+  struct point_t *corners;        ///< Corner buffer
+  uint16_t corners_size;          ///< Size of the corner buffer
+  struct image_t out;             ///< Output image (JPEG or labels)
+  struct point_t flow_corners[BENCH_MAX_FRAMES][BENCH_MAX_CORNERS]; ///< Corners to track per frame
+  uint16_t flow_corners_cnt[BENCH_MAX_FRAMES];  ///< Number of corners to track per frame
+  struct image_t pyramid[2][4];   ///< Persistent pyramids of the previous and next frame
+  uint16_t pyramid_idx;           ///< Frame index of the previous frame pyramid
+  struct frame_arena_t arena;     ///< Scratch memory of the optical flow, reset for every call
+};
+
+typedef void (*bench_kernel)(struct bench_t *bench);
+
+static double bench_now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void kernel_fast9(struct bench_t *b)
+{
+  uint16_t num_corners = 0;
+  fast9_detect(&b->gray[b->idx], b->param, 10, 20, 20, &num_corners, &b->corners_size, &b->corners, NULL);
+}
+
+static void kernel_act_fast(struct bench_t *b)
+{
+  uint16_t num_corners = 0;
+  act_fast(&b->gray[b->idx], b->param, &num_corners, &b->corners, 25, 10, 10, 2, 10, 1);
+}
+
+static void kernel_lucas_kanade(struct bench_t *b)
+{
+  uint16_t next = (b->idx + 1) % b->frames_cnt;
+  uint16_t points_cnt = b->flow_corners_cnt[b->idx];
+  struct flow_t *vectors = opticFlowLK(&b->gray[next], &b->gray[b->idx], b->flow_corners[b->idx], &points_cnt, 5, 10,
+                                       10, 2, 25, b->param, NULL);
+  free(vectors);
+}
+
+static void kernel_lucas_kanade_arena(struct bench_t *b)
+{
+  uint16_t next = (b->idx + 1) % b->frames_cnt;
+  uint16_t points_cnt = b->flow_corners_cnt[b->idx];
+  frame_arena_reset(&b->arena);
+  opticFlowLK(&b->gray[next], &b->gray[b->idx], b->flow_corners[b->idx], &points_cnt, 5, 10, 10, 2, 25, b->param,
+              &b->arena);
+}
+
+static void kernel_lucas_kanade_pyramid(struct bench_t *b)
+{
+  uint16_t next = (b->idx + 1) % b->frames_cnt;
+  uint16_t points_cnt = b->flow_corners_cnt[b->idx];
+  uint16_t border = opticFlowLK_border_size(5);
+
+  // Only build the pyramid of the next frame, the previous one is kept from the last call
+  if (b->pyramid_idx != b->idx) {
+    pyramid_update(&b->gray[b->idx], b->pyramid[0], b->param, border);
+  }
+  pyramid_update(&b->gray[next], b->pyramid[1], b->param, border);
+  frame_arena_reset(&b->arena);
+  opticFlowLK_pyramid(b->pyramid[1], b->pyramid[0], b->flow_corners[b->idx], &points_cnt, 5, 10, 10, 2, 25, b->param,
+                      &b->arena);
+
+  struct image_t tmp[4];
+  memcpy(tmp, b->pyramid[0], sizeof(tmp));
+  memcpy(b->pyramid[0], b->pyramid[1], sizeof(tmp));
+  memcpy(b->pyramid[1], tmp, sizeof(tmp));
+  b->pyramid_idx = next;
+}
+
+static void kernel_edge_histogram(struct bench_t *b)
+{
+  static int32_t hist_x[2048], hist_y[2048];
+  calculate_edge_histogram(&b->gray[b->idx], hist_x, 'x', b->param);
+  calculate_edge_histogram(&b->gray[b->idx], hist_y, 'y', b->param);
+}
+
+static void kernel_jpeg(struct bench_t *b)
+{
+  jpeg_encode_image(&b->frames[b->idx], &b->out, b->param, false);
+}
+
+/** Restart intervals of 2 MCU rows, encoded with param threads */
+static void kernel_jpeg_restart(struct bench_t *b)
+{
+  jpeg_num_threads = b->param;
+  jpeg_encode_image_restart(&b->frames[b->idx], &b->out, 50, false, 2);
+  jpeg_num_threads = 1;
+}
+
+static void kernel_labeling(struct bench_t *b)
+{
+  struct image_filter_t filter = { 0, 255, 0, b->param, 0, b->param };
+  static struct image_label_t labels[512];
+  uint16_t labels_cnt = 512;
+  image_labeling(&b->frames[b->idx], &b->out, &filter, 1, labels, &labels_cnt);
+}
+
+/**
+ * Run a kernel until min_time has passed (and at least 3 calls) and print the results
+ */
+static void bench_run(struct bench_t *b, const char *name, bench_kernel kernel, double min_time,
+                      enum image_type out_type)
+{
+  struct image_t *img = &b->frames[0];
+  if (out_type != IMAGE_GRAYSCALE) {
+    image_create(&b->out, img->w, img->h, out_type);
+  }
+
+  // Warm up (first call may allocate buffers)
+  b->idx = 0;
+  kernel(b);
+
+  uint32_t calls = 0;
+  uint32_t allocs_start = bench_allocs;
+  double t_start = bench_now(), t_end;
+  do {
+    b->idx = calls % b->frames_cnt;
+    kernel(b);
+    calls++;
+    t_end = bench_now();
+  } while (t_end - t_start < min_time || calls < 3);
+  uint32_t allocs = bench_allocs - allocs_start;
+
+  double t_call = (t_end - t_start) / calls;
+  printf("%s,%d,%d,%d,%u,%.3f,%.1f,%.2f\n", name, img->w, img->h, b->param, calls,
+         t_call * 1e9 / (img->w * img->h), 1. / t_call, (double)allocs / calls);
+  fflush(stdout);
+
+  if (out_type != IMAGE_GRAYSCALE) {
+    image_free(&b->out);
+  }
+}
+
+/**
+ * Load raw UYVY frames from a file
+ */
+static uint16_t bench_load_frames(const char *filename, struct image_t *frames, uint16_t cnt, uint16_t w, uint16_t h)
+{
+  FILE *fp = fopen(filename, "rb");
+  if (fp == NULL) {
+    fprintf(stderr, "Could not open %s\n", filename);
+    return cnt;
+  }
+
+  while (cnt < BENCH_MAX_FRAMES) {
+    image_create(&frames[cnt], w, h, IMAGE_YUV422);
+    if (fread(frames[cnt].buf, frames[cnt].buf_size, 1, fp) != 1) {
+      image_free(&frames[cnt]);
+      break;
+    }
+    cnt++;
+  }
+
+  fclose(fp);
+  return cnt;
+}
+
+/**
+ * Create a synthetic textured sequence moving 2 pixels per frame
+ */
+static uint16_t bench_synthetic_frames(struct image_t *frames, uint16_t cnt, uint16_t w, uint16_t h)
+{
+  uint16_t tex_w = w + 2 * cnt;
+  uint16_t blocks_w = tex_w / 16 + 1;
+  uint8_t *tex = malloc(tex_w * h);
+  uint8_t *blocks = malloc(blocks_w * (h / 16 + 1));
+  srand(42);
+  for (uint32_t i = 0; i < (uint32_t)blocks_w * (h / 16 + 1); i++) {
+    blocks[i] = rand() & 0xFF;
+  }
+
+  // Blocks of random intensity with some noise give corners and edges
+  for (uint16_t y = 0; y < h; y++) {
+    for (uint16_t x = 0; x < tex_w; x++) {
+      tex[y * tex_w + x] = Min(blocks[(y / 16) * blocks_w + x / 16] + (rand() & 0x0F), 255);
+    }
+  }
+  free(blocks);
+
+  for (uint16_t i = 0; i < cnt; i++) {
+    image_create(&frames[i], w, h, IMAGE_YUV422);
+    uint8_t *buf = frames[i].buf;
+    for (uint16_t y = 0; y < h; y++) {
+      for (uint16_t x = 0; x < w; x++) {
+        buf[(y * w + x) * 2] = (x & 1) ? y * 255 / h : x * 255 / w;   // U / V gradients
+        buf[(y * w + x) * 2 + 1] = tex[y * tex_w + x + 2 * i];
+      }
+    }
+  }
+
+  free(tex);
+  return cnt;
+}
+
+int main(int argc, char **argv)
+{
+  uint16_t w = 640, h = 480;
+  double min_time = 0.5;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "w:h:t:")) != -1) {
+    switch (opt) {
+      case 'w': w = atoi(optarg); break;
+      case 'h': h = atoi(optarg); break;
+      case 't': min_time = atof(optarg); break;
+      default:
+        fprintf(stderr, "Usage: %s [-w width] [-h height] [-t min_time_s] [frames.yuv ...]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  // Load the full resolution frames
+  struct image_t input[BENCH_MAX_FRAMES];
+  uint16_t input_cnt = 0;
+  for (int i = optind; i < argc; i++) {
+    input_cnt = bench_load_frames(argv[i], input, input_cnt, w, h);
+  }
+  if (input_cnt == 0) {
+    fprintf(stderr, "No frames loaded, using a synthetic sequence of %dx%d\n", w, h);
+    input_cnt = bench_synthetic_frames(input, 4, w, h);
+  }
+  if (input_cnt < 2) {
+    fprintf(stderr, "Need at least 2 frames for the optical flow\n");
+    input_cnt = bench_synthetic_frames(input, 4, w, h);
+  }
+
+  printf("kernel,width,height,param,calls,ns_per_pixel,fps,allocs_per_call\n");
+
+  static struct bench_t b;
+  b.frames_cnt = input_cnt;
+  b.corners_size = BENCH_MAX_CORNERS;
+  b.corners = malloc(sizeof(struct point_t) * b.corners_size);
+  frame_arena_init(&b.arena, 0);
+
+  // Sweep over the resolutions
+  for (uint16_t ds = 1; ds <= 4; ds *= 2) {
+    struct image_t frames[BENCH_MAX_FRAMES], gray[BENCH_MAX_FRAMES];
+    for (uint16_t i = 0; i < input_cnt; i++) {
+      image_create(&frames[i], w / ds, h / ds, IMAGE_YUV422);
+      image_create(&gray[i], w / ds, h / ds, IMAGE_GRAYSCALE);
+      image_yuv422_downsample(&input[i], &frames[i], ds);
+      image_to_grayscale(&frames[i], &gray[i]);
+    }
+    b.frames = frames;
+    b.gray = gray;
+
+    const uint16_t thresholds[] = {10, 20, 40};
+    for (uint8_t i = 0; i < 3; i++) {
+      b.param = thresholds[i];
+      fast9_num_threads = 1;
+      bench_run(&b, "fast9_detect", kernel_fast9, min_time, IMAGE_GRAYSCALE);
+      fast9_num_threads = 4;
+      bench_run(&b, "fast9_detect_4threads", kernel_fast9, min_time, IMAGE_GRAYSCALE);
+      fast9_num_threads = 1;
+      bench_run(&b, "act_fast", kernel_act_fast, min_time, IMAGE_GRAYSCALE);
+      bench_run(&b, "calculate_edge_histogram", kernel_edge_histogram, min_time, IMAGE_GRAYSCALE);
+    }
+
+    // Detect the corners to track once, only the optical flow is timed
+    for (uint16_t i = 0; i < input_cnt; i++) {
+      uint16_t num_corners = 0;
+      fast9_detect(&gray[i], 20, 10, 20, 20, &num_corners, &b.corners_size, &b.corners, NULL);
+      b.flow_corners_cnt[i] = Min(num_corners, 25);
+      memcpy(b.flow_corners[i], b.corners, sizeof(struct point_t) * b.flow_corners_cnt[i]);
+    }
+
+    // Pyramid levels
+    for (b.param = 0; b.param <= 3; b.param++) {
+      bench_run(&b, "opticFlowLK", kernel_lucas_kanade, min_time, IMAGE_GRAYSCALE);
+      bench_run(&b, "opticFlowLK_arena", kernel_lucas_kanade_arena, min_time, IMAGE_GRAYSCALE);
+    }
+
+    // Pyramid levels with the pyramid of the previous frame reused
+    for (b.param = 1; b.param <= 3; b.param++) {
+      pyramid_create(b.pyramid[0], w / ds, h / ds, b.param, opticFlowLK_border_size(5));
+      pyramid_create(b.pyramid[1], w / ds, h / ds, b.param, opticFlowLK_border_size(5));
+      b.pyramid_idx = BENCH_MAX_FRAMES;
+      bench_run(&b, "opticFlowLK_pyramid", kernel_lucas_kanade_pyramid, min_time, IMAGE_GRAYSCALE);
+      pyramid_free(b.pyramid[0], b.param);
+      pyramid_free(b.pyramid[1], b.param);
+    }
+
+    // Quality factors
+    const uint16_t qualities[] = {50, 80, 99};
+    for (uint8_t i = 0; i < 3; i++) {
+      b.param = qualities[i];
+      bench_run(&b, "jpeg_encode_image", kernel_jpeg, min_time, IMAGE_JPEG);
+    }
+
+    // Threads
+    for (b.param = 1; b.param <= 4; b.param *= 2) {
+      bench_run(&b, "jpeg_encode_image_restart", kernel_jpeg_restart, min_time, IMAGE_JPEG);
+    }
+
+    // U/V upper bound of the color filter
+    const uint16_t uv_max[] = {64, 128, 255};
+    for (uint8_t i = 0; i < 3; i++) {
+      b.param = uv_max[i];
+      bench_run(&b, "image_labeling", kernel_labeling, min_time, IMAGE_GRADIENT);
+    }
+
+    for (uint16_t i = 0; i < input_cnt; i++) {
+      image_free(&frames[i]);
+      image_free(&gray[i]);
+    }
+  }
+
+  free(b.corners);
+  frame_arena_free(&b.arena);
+  for (uint16_t i = 0; i < input_cnt; i++) {
+    image_free(&input[i]);
+  }
+
+  return 0;
+}
@@ -127,6 +127,9 @@ struct NpsFdm {
   uint32_t eng_state[FG_NET_FDM_MAX_ENGINES];// Engine state (off, cranking, running)
   float rpm[FG_NET_FDM_MAX_ENGINES];       // Engine RPM rev/min
 
+  /* perturbation of the flight plan initial conditions, set before nps_fdm_init (JSBSim only) */
+  struct NedCoor_d init_pos_offset; ///< initial position offset in m
+  double init_psi_offset;           ///< initial heading offset in rad
 };
 
 extern struct NpsFdm fdm;
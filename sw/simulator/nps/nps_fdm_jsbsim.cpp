@@ -596,13 +596,16 @@ static void init_jsbsim(double dt)
     // convert geodetic lat from flight plan to geocentric
     double gd_lat = RadOfDeg(NAV_LAT0 / 1e7);
     double gc_lat = gc_of_gd_lat_d(gd_lat, GROUND_ALT);
-    IC->SetLatitudeDegIC(DegOfRad(gc_lat));
-    IC->SetLongitudeDegIC(NAV_LON0 / 1e7);
+    // optional perturbation of the initial position, small offsets on a spherical earth are enough
+    double dlat = fdm.init_pos_offset.x / 6378137.0;
+    double dlon = fdm.init_pos_offset.y / (6378137.0 * cos(gc_lat));
+    IC->SetLatitudeDegIC(DegOfRad(gc_lat + dlat));
+    IC->SetLongitudeDegIC(NAV_LON0 / 1e7 + DegOfRad(dlon));
 
     IC->SetWindNEDFpsIC(0.0, 0.0, 0.0);
-    IC->SetAltitudeASLFtIC(FeetOfMeters(GROUND_ALT + 2.0));
+    IC->SetAltitudeASLFtIC(FeetOfMeters(GROUND_ALT + 2.0 - fdm.init_pos_offset.z));
     IC->SetTerrainElevationFtIC(FeetOfMeters(GROUND_ALT));
-    IC->SetPsiDegIC(QFU);
+    IC->SetPsiDegIC(QFU + DegOfRad(fdm.init_psi_offset));
     IC->SetVgroundFpsIC(0.);
 
     lla0.lon = RadOfDeg(NAV_LON0 / 1e7);
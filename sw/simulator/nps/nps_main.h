@@ -65,6 +65,15 @@ struct NpsMain {
   bool norc;
   char *ivy_bus;
   bool nodisplay;
+  bool batch;           ///< run headless as fast as possible
+  double duration;      ///< simulation duration in s for batch runs
+  char *trace_file;     ///< binary trace output for batch runs
+  double trace_dt;      ///< trace sampling period in s
+  bool set_wind;        ///< override the default wind with wind_ned
+  struct DoubleVect3 wind_ned; ///< constant wind in NED in m/s
+  char *wind_script;    ///< file of "time wind_north wind_east wind_down" lines
+  int turbulence;       ///< turbulence severity override, -1 to keep the default
+  unsigned long seed;   ///< seed of the simulated sensor noise
 };
 
 struct NpsMain nps_main;
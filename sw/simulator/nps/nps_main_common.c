@@ -29,6 +29,7 @@
 #include "nps_flightgear.h"
 
 #include "nps_ivy.h"
+#include "nps_random.h"
 
 #ifdef __MACH__
 pthread_mutex_t clock_mutex; // mutex for clock
@@ -97,8 +98,15 @@ int nps_main_init(int argc, char **argv)
   nps_main.real_initial_time = time_to_double(&t);
   nps_main.scaled_initial_time = time_to_double(&t);
 
+  nps_random_init(nps_main.seed);
   nps_fdm_init(SIM_DT);
   nps_atmosphere_init();
+  if (nps_main.set_wind) {
+    nps_atmosphere_set_wind_ned(nps_main.wind_ned.x, nps_main.wind_ned.y, nps_main.wind_ned.z);
+  }
+  if (nps_main.turbulence >= 0) {
+    nps_atmosphere.turbulence_severity = nps_main.turbulence;
+  }
   nps_sensors_init(nps_main.sim_time);
   printf("Simulating with dt of %f\n", SIM_DT);
 
@@ -110,7 +118,9 @@ int nps_main_init(int argc, char **argv)
 
   signal(SIGCONT, cont_hdl);
   signal(SIGTSTP, tstp_hdl);
-  printf("Time factor is %f. (Press Ctrl-Z to change)\n", nps_main.host_time_factor);
+  if (!nps_main.batch) {
+    printf("Time factor is %f. (Press Ctrl-Z to change)\n", nps_main.host_time_factor);
+  }
 
   return 0;
 }
@@ -159,6 +169,14 @@ bool nps_main_parse_options(int argc, char **argv)
   nps_main.host_time_factor = 1.0;
   nps_main.fg_fdm = 0;
   nps_main.nodisplay = false;
+  nps_main.batch = false;
+  nps_main.duration = 0.;
+  nps_main.trace_file = NULL;
+  nps_main.trace_dt = 0.;
+  nps_main.set_wind = false;
+  nps_main.wind_script = NULL;
+  nps_main.turbulence = -1;
+  nps_main.seed = 0;
 
   static const char *usage =
     "Usage: %s [options]\n"
@@ -175,7 +193,16 @@ bool nps_main_parse_options(int argc, char **argv)
     "   --ivy_bus <ivy bus>                    e.g. 127.255.255.255\n"
     "   --time_factor <factor>                 e.g. 2.5\n"
     "   --nodisplay                            e.g. disable NPS ivy messages\n"
-    "   --fg_fdm";
+    "   --fg_fdm\n"
+    "   --batch                                run headless as fast as possible (no Ivy, no FlightGear)\n"
+    "   --duration <seconds>                   e.g. 120, simulated time of a batch run\n"
+    "   --trace <file>                         e.g. trace.bin, binary trace written at the end of a batch run\n"
+    "   --trace_dt <seconds>                   e.g. 0.02, trace sampling period (default every step)\n"
+    "   --wind <north>,<east>,<down>           e.g. 3,-1,0, constant wind in m/s\n"
+    "   --wind_script <file>                   e.g. wind.txt, lines of \"time north east down\"\n"
+    "   --turbulence <severity>                e.g. 3, turbulence severity from 0 to 7\n"
+    "   --seed <number>                        e.g. 42, seed of the sensor noise\n"
+    "   --init_offset <n>,<e>,<d>,<psi>        e.g. 1,-2,0,10, initial position (m) and heading (deg) offset\n";
 
 
   while (1) {
@@ -193,6 +220,15 @@ bool nps_main_parse_options(int argc, char **argv)
       {"fg_fdm", 0, NULL, 0},
       {"fg_port_in", 1, NULL, 0},
       {"nodisplay", 0, NULL, 0},
+      {"batch", 0, NULL, 0},
+      {"duration", 1, NULL, 0},
+      {"trace", 1, NULL, 0},
+      {"trace_dt", 1, NULL, 0},
+      {"wind", 1, NULL, 0},
+      {"wind_script", 1, NULL, 0},
+      {"turbulence", 1, NULL, 0},
+      {"seed", 1, NULL, 0},
+      {"init_offset", 1, NULL, 0},
       {0, 0, 0, 0}
     };
     int option_index = 0;
@@ -231,6 +267,37 @@ bool nps_main_parse_options(int argc, char **argv)
             nps_main.fg_port_in = atoi(optarg); break;
           case 11:
             nps_main.nodisplay = true; break;
+          case 12:
+            nps_main.batch = true; break;
+          case 13:
+            nps_main.duration = atof(optarg); break;
+          case 14:
+            nps_main.trace_file = strdup(optarg); break;
+          case 15:
+            nps_main.trace_dt = atof(optarg); break;
+          case 16:
+            if (sscanf(optarg, "%lf,%lf,%lf", &nps_main.wind_ned.x, &nps_main.wind_ned.y, &nps_main.wind_ned.z) != 3) {
+              fprintf(stderr, "Invalid wind '%s', expected <north>,<east>,<down>\n", optarg);
+              exit(EXIT_FAILURE);
+            }
+            nps_main.set_wind = true;
+            break;
+          case 17:
+            nps_main.wind_script = strdup(optarg); break;
+          case 18:
+            nps_main.turbulence = atoi(optarg); break;
+          case 19:
+            nps_main.seed = strtoul(optarg, NULL, 10); break;
+          case 20: {
+            double psi_deg;
+            if (sscanf(optarg, "%lf,%lf,%lf,%lf", &fdm.init_pos_offset.x, &fdm.init_pos_offset.y,
+                       &fdm.init_pos_offset.z, &psi_deg) != 4) {
+              fprintf(stderr, "Invalid initial offset '%s', expected <n>,<e>,<d>,<psi>\n", optarg);
+              exit(EXIT_FAILURE);
+            }
+            fdm.init_psi_offset = RadOfDeg(psi_deg);
+            break;
+          }
           default:
             break;
         }
@@ -28,8 +28,9 @@
 
 #include "nps_main.h"
 #include "nps_fdm.h"
+#include "nps_trace.h"
 
-
+static int nps_main_batch(void);
 
 
 int main(int argc, char **argv)
@@ -38,6 +39,10 @@ int main(int argc, char **argv)
     return 1;
   }
 
+  if (nps_main.batch) {
+    return nps_main_batch();
+  }
+
   if (nps_main.fg_host) {
     pthread_create(&th_flight_gear, NULL, nps_flight_gear_loop, NULL);
   }
@@ -184,3 +189,105 @@ void *nps_main_loop(void *data __attribute__((unused)))
   }
   return(NULL);
 }
+
+
+/** Wind change read from the wind script */
+struct NpsWindStep {
+  double time;
+  struct DoubleVect3 wind;
+};
+
+/**
+ * Read a wind script, one "time wind_north wind_east wind_down" step per line.
+ * Empty lines and lines starting with '#' are ignored.
+ * @return number of steps, -1 on error
+ */
+static int nps_wind_script_load(const char *filename, struct NpsWindStep **steps)
+{
+  FILE *f = fopen(filename, "r");
+  if (f == NULL) {
+    return -1;
+  }
+  int nb = 0, size = 0;
+  char line[256];
+  *steps = NULL;
+  while (fgets(line, sizeof(line), f)) {
+    struct NpsWindStep step;
+    if (line[0] == '#' || sscanf(line, "%lf %lf %lf %lf", &step.time, &step.wind.x, &step.wind.y, &step.wind.z) != 4) {
+      continue;
+    }
+    if (nb == size) {
+      size = size ? 2 * size : 16;
+      struct NpsWindStep *tmp = realloc(*steps, size * sizeof(struct NpsWindStep));
+      if (tmp == NULL) {
+        nb = -1;
+        break;
+      }
+      *steps = tmp;
+    }
+    (*steps)[nb++] = step;
+  }
+  fclose(f);
+  return nb;
+}
+
+
+/**
+ * Headless run as fast as possible.
+ * No pacing on wall clock time and no Ivy or FlightGear threads, so the
+ * fdm mutex is not needed. RC comes from the RC script (or --norc),
+ * wind from --wind and --wind_script.
+ */
+static int nps_main_batch(void)
+{
+  if (nps_main.duration <= 0.) {
+    fprintf(stderr, "Batch mode needs a positive --duration\n");
+    return 1;
+  }
+
+  struct NpsWindStep *wind_steps = NULL;
+  int wind_nb = 0, wind_idx = 0;
+  if (nps_main.wind_script) {
+    wind_nb = nps_wind_script_load(nps_main.wind_script, &wind_steps);
+    if (wind_nb < 0) {
+      fprintf(stderr, "Could not read wind script %s\n", nps_main.wind_script);
+      return 1;
+    }
+  }
+  if (nps_main.trace_file) {
+    nps_trace_init(nps_main.duration, nps_main.trace_dt);
+  }
+
+  struct timespec start, end, cpu_start, cpu_end;
+  clock_get_current_time(&start);
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_start);
+  unsigned long steps = 0;
+
+  while (nps_main.sim_time < nps_main.duration) {
+    while (wind_idx < wind_nb && wind_steps[wind_idx].time <= nps_main.sim_time) {
+      nps_atmosphere_set_wind_ned(wind_steps[wind_idx].wind.x, wind_steps[wind_idx].wind.y, wind_steps[wind_idx].wind.z);
+      wind_idx++;
+    }
+    nps_main_run_sim_step();
+    nps_main.sim_time += SIM_DT;
+    steps++;
+    if (nps_main.trace_file) {
+      nps_trace_run_step(nps_main.sim_time);
+    }
+  }
+
+  clock_get_current_time(&end);
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_end);
+  double wall_time = ntime_to_double(&end) - ntime_to_double(&start);
+  double cpu_time = ntime_to_double(&cpu_end) - ntime_to_double(&cpu_start);
+  printf("Simulated %.1f s in %.3f s (%.1fx real time, %.2f us cpu per step)\n", nps_main.sim_time, wall_time,
+         wall_time > 0. ? nps_main.sim_time / wall_time : 0., steps > 0 ? 1e6 * cpu_time / steps : 0.);
+
+  free(wind_steps);
+
+  if (nps_main.trace_file && !nps_trace_write(nps_main.trace_file)) {
+    fprintf(stderr, "Could not write trace %s\n", nps_main.trace_file);
+    return 1;
+  }
+  return 0;
+}
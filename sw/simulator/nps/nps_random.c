@@ -106,12 +106,19 @@ double get_gaussian_noise(void)
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_randist.h>
 #include <stdlib.h>
-double get_gaussian_noise(void)
+static gsl_rng *nps_rng = NULL;
+
+void nps_random_init(unsigned long seed)
 {
-  static gsl_rng *r = NULL;
   // select random number generator
-  if (!r) { r = gsl_rng_alloc(gsl_rng_mt19937); }
-  return gsl_ran_gaussian(r, 1.);
+  if (!nps_rng) { nps_rng = gsl_rng_alloc(gsl_rng_mt19937); }
+  gsl_rng_set(nps_rng, seed);
+}
+
+double get_gaussian_noise(void)
+{
+  if (!nps_rng) { nps_rng = gsl_rng_alloc(gsl_rng_mt19937); }
+  return gsl_ran_gaussian(nps_rng, 1.);
 }
 #endif
 
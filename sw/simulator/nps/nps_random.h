@@ -3,6 +3,8 @@
 
 #include "math/pprz_algebra_double.h"
 
+/** Seed the generator behind all simulated sensor noise (default seed if never called) */
+extern void nps_random_init(unsigned long seed);
 extern double get_gaussian_noise(void);
 extern void double_vect3_add_gaussian_noise(struct DoubleVect3 *vect, struct DoubleVect3 *std_dev);
 extern void double_vect3_get_gaussian_noise(struct DoubleVect3 *vect, struct DoubleVect3 *std_dev);
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * @file nps_trace.c
+ * Compact binary trace of the simulation state for NPS batch runs.
+ */
+
+#include "nps_trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nps_fdm.h"
+#include "nps_autopilot.h"
+#include "state.h"
+#include "autopilot.h"
+
+#define NPS_TRACE_RECORD_SIZE (NPS_TRACE_NB_FIELDS + NPS_COMMANDS_NB)
+
+static struct {
+  float *buf;           ///< records, NPS_TRACE_RECORD_SIZE floats each
+  uint32_t nb_records;
+  uint32_t max_records;
+  double dt;
+  double next_time;
+} nps_trace;
+
+void nps_trace_init(double duration, double dt)
+{
+  nps_trace.dt = dt;
+  nps_trace.next_time = 0.;
+  nps_trace.nb_records = 0;
+  nps_trace.max_records = 1024;
+  if (dt > 0. && duration > 0.) {
+    nps_trace.max_records = (uint32_t)(duration / dt) + 2;
+  }
+  nps_trace.buf = malloc(sizeof(float) * NPS_TRACE_RECORD_SIZE * nps_trace.max_records);
+  if (nps_trace.buf == NULL) {
+    nps_trace.max_records = 0;
+  }
+}
+
+void nps_trace_run_step(double time)
+{
+  if (time < nps_trace.next_time) {
+    return;
+  }
+  nps_trace.next_time += nps_trace.dt;
+
+  if (nps_trace.nb_records >= nps_trace.max_records) {
+    uint32_t max_records = 2 * nps_trace.max_records + 1024;
+    float *buf = realloc(nps_trace.buf, sizeof(float) * NPS_TRACE_RECORD_SIZE * max_records);
+    if (buf == NULL) {
+      return;
+    }
+    nps_trace.buf = buf;
+    nps_trace.max_records = max_records;
+  }
+
+  float *r = &nps_trace.buf[nps_trace.nb_records * NPS_TRACE_RECORD_SIZE];
+  r[NPS_TRACE_TIME] = time;
+  r[NPS_TRACE_POS_X] = fdm.ltpprz_pos.x;
+  r[NPS_TRACE_POS_Y] = fdm.ltpprz_pos.y;
+  r[NPS_TRACE_POS_Z] = fdm.ltpprz_pos.z;
+  r[NPS_TRACE_VEL_X] = fdm.ltpprz_ecef_vel.x;
+  r[NPS_TRACE_VEL_Y] = fdm.ltpprz_ecef_vel.y;
+  r[NPS_TRACE_VEL_Z] = fdm.ltpprz_ecef_vel.z;
+  r[NPS_TRACE_PHI] = fdm.ltpprz_to_body_eulers.phi;
+  r[NPS_TRACE_THETA] = fdm.ltpprz_to_body_eulers.theta;
+  r[NPS_TRACE_PSI] = fdm.ltpprz_to_body_eulers.psi;
+  r[NPS_TRACE_P] = fdm.body_ecef_rotvel.p;
+  r[NPS_TRACE_Q] = fdm.body_ecef_rotvel.q;
+  r[NPS_TRACE_R] = fdm.body_ecef_rotvel.r;
+
+  struct NedCoor_f *pos = stateGetPositionNed_f();
+  struct FloatEulers *att = stateGetNedToBodyEulers_f();
+  r[NPS_TRACE_EST_POS_X] = pos->x;
+  r[NPS_TRACE_EST_POS_Y] = pos->y;
+  r[NPS_TRACE_EST_POS_Z] = pos->z;
+  r[NPS_TRACE_EST_PHI] = att->phi;
+  r[NPS_TRACE_EST_THETA] = att->theta;
+  r[NPS_TRACE_EST_PSI] = att->psi;
+  r[NPS_TRACE_AP_MODE] = autopilot_get_mode();
+
+  for (int i = 0; i < NPS_COMMANDS_NB; i++) {
+    r[NPS_TRACE_NB_FIELDS + i] = nps_autopilot.commands[i];
+  }
+  nps_trace.nb_records++;
+}
+
+bool nps_trace_write(const char *filename)
+{
+  struct NpsTraceHeader header;
+  memcpy(header.magic, NPS_TRACE_MAGIC, sizeof(header.magic));
+  header.version = NPS_TRACE_VERSION;
+  header.nb_fields = NPS_TRACE_RECORD_SIZE;
+  header.nb_commands = NPS_COMMANDS_NB;
+  header.nb_records = nps_trace.nb_records;
+  header.dt = nps_trace.dt;
+
+  bool ok = false;
+  FILE *f = fopen(filename, "wb");
+  if (f != NULL) {
+    ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    if (ok && nps_trace.nb_records > 0) {
+      ok = fwrite(nps_trace.buf, sizeof(float) * NPS_TRACE_RECORD_SIZE, nps_trace.nb_records, f) == nps_trace.nb_records;
+    }
+    ok = (fclose(f) == 0) && ok;
+  }
+
+  free(nps_trace.buf);
+  nps_trace.buf = NULL;
+  nps_trace.nb_records = 0;
+  nps_trace.max_records = 0;
+  return ok;
+}
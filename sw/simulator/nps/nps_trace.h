@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * @file nps_trace.h
+ * Compact binary trace of the simulation state for NPS batch runs.
+ *
+ * Records are sampled into memory while the simulation runs and written
+ * to disk once at the end, so tracing does not add I/O to the sim loop.
+ *
+ * File layout (host endianness):
+ *  - struct NpsTraceHeader
+ *  - nb_records records of nb_fields float32 values each, in the order
+ *    given by enum NpsTraceField, followed by the NPS_COMMANDS_NB commands
+ */
+
+#ifndef NPS_TRACE_H
+#define NPS_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define NPS_TRACE_MAGIC   "NPST"
+#define NPS_TRACE_VERSION 1
+
+/** Fields of a trace record, before the autopilot commands */
+enum NpsTraceField {
+  NPS_TRACE_TIME,                                           ///< simulation time in s
+  NPS_TRACE_POS_X, NPS_TRACE_POS_Y, NPS_TRACE_POS_Z,        ///< fdm position in local NED in m
+  NPS_TRACE_VEL_X, NPS_TRACE_VEL_Y, NPS_TRACE_VEL_Z,        ///< fdm speed in local NED in m/s
+  NPS_TRACE_PHI, NPS_TRACE_THETA, NPS_TRACE_PSI,            ///< fdm attitude in rad
+  NPS_TRACE_P, NPS_TRACE_Q, NPS_TRACE_R,                    ///< fdm body rates in rad/s
+  NPS_TRACE_EST_POS_X, NPS_TRACE_EST_POS_Y, NPS_TRACE_EST_POS_Z,  ///< estimated position in local NED in m
+  NPS_TRACE_EST_PHI, NPS_TRACE_EST_THETA, NPS_TRACE_EST_PSI,      ///< estimated attitude in rad
+  NPS_TRACE_AP_MODE,                                        ///< autopilot mode
+  NPS_TRACE_NB_FIELDS
+};
+
+struct NpsTraceHeader {
+  char magic[4];          ///< NPS_TRACE_MAGIC, not null terminated
+  uint32_t version;       ///< NPS_TRACE_VERSION
+  uint32_t nb_fields;     ///< number of float32 values per record
+  uint32_t nb_commands;   ///< number of commands at the end of each record
+  uint32_t nb_records;    ///< number of records following the header
+  float dt;               ///< sampling period in s
+};
+
+/**
+ * Allocate the trace buffer.
+ * @param[in] duration expected simulation duration in s, used to size the buffer
+ * @param[in] dt sampling period in s, 0 to record every simulation step
+ */
+extern void nps_trace_init(double duration, double dt);
+
+/**
+ * Append a record if at least one sampling period elapsed since the last one.
+ * @param[in] time current simulation time in s
+ */
+extern void nps_trace_run_step(double time);
+
+/**
+ * Write the recorded trace to a file and release the buffer.
+ * @param[in] filename output file
+ * @return true on success
+ */
+extern bool nps_trace_write(const char *filename);
+
+#endif /* NPS_TRACE_H */
@@ -155,6 +155,82 @@ module Gen_onboard = struct
       print_msg_send h msg
     ) messages
 
+  (* Field as stored in a queue entry: (name, type, passed by address)
+   * pointers to a struct are copied by value, other pointers can not be queued *)
+  let queued_field = fun (n, t) ->
+    let t = String.trim t in
+    let l = String.length t in
+    if l > 0 && t.[l-1] = '*' then begin
+      let base = String.trim (String.sub t 0 (l-1)) in
+      if String.length base > 7 && String.sub base 0 7 = "struct " && not (String.contains base '*')
+      then Some (n, base, true)
+      else None
+    end
+    else Some (n, t, false)
+
+  (* Fields of a message as stored in a queue entry, None if it can not be queued *)
+  let queued_fields = fun msg ->
+    let fields = List.map queued_field msg.fields in
+    if List.mem None fields then None
+    else Some (List.map (function Some f -> f | None -> assert false) fields)
+
+  (* Print the ring storage and the queue function of a message *)
+  let print_msg_queue = fun h msg fields ->
+    let name = Compat.capitalize_ascii msg.name in
+    Printf.fprintf h "\nstruct abi_queue_entry_%s {\n" name;
+    Printf.fprintf h "  uint8_t sender_id;\n";
+    List.iter (fun (n, t, _) -> Printf.fprintf h "  %s %s;\n" t n) fields;
+    Printf.fprintf h "};\n";
+    Printf.fprintf h "ABI_EXTERN struct abi_queue_entry_%s abi_queue_%s[ABI_QUEUE_SIZE];\n" name name;
+    Printf.fprintf h "\nstatic inline bool AbiQueueMsg%s" name;
+    print_args h msg.fields;
+    Printf.fprintf h " {\n";
+    Printf.fprintf h "  uint8_t _slot;\n";
+    Printf.fprintf h "  if (!abi_ring_insert_slot(&abi_rings[ABI_%s_ID], &_slot)) return false;\n" name;
+    Printf.fprintf h "  struct abi_queue_entry_%s *_e = &abi_queue_%s[_slot];\n" name name;
+    Printf.fprintf h "  _e->sender_id = sender_id;\n";
+    List.iter (fun (n, _, by_addr) ->
+      Printf.fprintf h "  _e->%s = %s%s;\n" n (if by_addr then "*" else "") n
+    ) fields;
+    Printf.fprintf h "  abi_ring_insert_done(&abi_rings[ABI_%s_ID]);\n" name;
+    Printf.fprintf h "  return true;\n";
+    Printf.fprintf h "}\n"
+
+  (* Print the function delivering the queued messages *)
+  let print_queue_event = fun h queued ->
+    Printf.fprintf h "\n/** Deliver the queued messages, to be called in the event loop of the autopilot */\n";
+    Printf.fprintf h "static inline void AbiQueueEvent(void) {\n";
+    Printf.fprintf h "  uint8_t _slot;\n";
+    List.iter (fun (msg, fields) ->
+      let name = Compat.capitalize_ascii msg.name in
+      Printf.fprintf h "  while (abi_ring_extract_slot(&abi_rings[ABI_%s_ID], &_slot)) {\n" name;
+      Printf.fprintf h "    struct abi_queue_entry_%s *_e = &abi_queue_%s[_slot];\n" name name;
+      Printf.fprintf h "    AbiSendMsg%s(_e->sender_id" name;
+      List.iter (fun (n, _, by_addr) ->
+        Printf.fprintf h ", %s_e->%s" (if by_addr then "&" else "") n
+      ) fields;
+      Printf.fprintf h ");\n";
+      Printf.fprintf h "    abi_ring_extract_done(&abi_rings[ABI_%s_ID]);\n" name;
+      Printf.fprintf h "  }\n"
+    ) queued;
+    Printf.fprintf h "}\n"
+
+  (* Print queued delivery for all messages that can be queued *)
+  let print_queues = fun h messages ->
+    Printf.fprintf h "\n#if ABI_USE_QUEUE\n";
+    Printf.fprintf h "/* Queued delivery */\n";
+    Printf.fprintf h "ABI_EXTERN struct abi_ring abi_rings[ABI_MESSAGE_NB];\n";
+    let queued = List.fold_left (fun l msg ->
+      match queued_fields msg with
+          Some fields -> print_msg_queue h msg fields; (msg, fields) :: l
+        | None ->
+            Printf.fprintf h "\n/* %s has array or string fields, it can not be queued */\n"
+              (Compat.capitalize_ascii msg.name);
+            l
+    ) [] messages in
+    print_queue_event h (List.rev queued);
+    Printf.fprintf h "#endif /* ABI_USE_QUEUE */\n"
+
 end (* module Gen_onboard *)
 
 
@@ -196,6 +272,9 @@ let () =
     (** Print Bind and Send functions for all messages *)
     Gen_onboard.print_bind_send h messages;
 
+    (** Print queued delivery functions *)
+    Gen_onboard.print_queues h messages;
+
     Printf.fprintf h "\n#endif // ABI_MESSAGES_H\n"
   with
       Xml.Error (msg, pos) -> failwith (sprintf "%s:%d : %s\n" filename (Xml.line pos) (Xml.error_msg msg))
@@ -37,7 +37,7 @@ let lprintf = fun c f ->
   fprintf c "%s" (String.make !margin ' ');
   fprintf c f
 
-let output_modes = fun out_h process_name telem_type modes freq ->
+let output_modes = fun out_h process_name telem_type modes freq adaptive_idx ->
   let min_period = 1./.float freq in
   let max_period = 65536. /. float freq in
 
@@ -83,7 +83,14 @@ let output_modes = fun out_h process_name telem_type modes freq ->
           l := (p, !phase) :: !l;
           i := !i + freq/10;
           right ();
-          lprintf out_h "for (j = 0; j < TELEMETRY_NB_CBS; j++) {\n";
+          fprintf out_h "#if TELEMETRY_STATS || TELEMETRY_ADAPTIVE\n";
+          lprintf out_h "uint32_t nb_bytes = (dev != NULL) ? dev->nb_bytes : 0;\n";
+          fprintf out_h "#endif\n";
+          lprintf out_h "j = 0;\n";
+          fprintf out_h "#if TELEMETRY_ADAPTIVE\n";
+          lprintf out_h "if (!telemetry_adaptive_send(&telemetry_adaptive_msgs_%s[%d])) j = TELEMETRY_NB_CBS; // decimated\n" process_name (adaptive_idx message_name);
+          fprintf out_h "#endif\n";
+          lprintf out_h "for (; j < TELEMETRY_NB_CBS; j++) {\n";
           right ();
           lprintf out_h "if (telemetry->cbs[TELEMETRY_%s_MSG_%s_IDX].slots[j] != NULL)\n" telem_type message_name;
           right ();
@@ -92,6 +99,13 @@ let output_modes = fun out_h process_name telem_type modes freq ->
           lprintf out_h "else break;\n";
           left ();
           lprintf out_h "}\n";
+          fprintf out_h "#if TELEMETRY_STATS\n";
+          lprintf out_h "telemetry->cbs[TELEMETRY_%s_MSG_%s_IDX].nb_calls++;\n" telem_type message_name;
+          lprintf out_h "if (dev != NULL) telemetry->cbs[TELEMETRY_%s_MSG_%s_IDX].nb_bytes += dev->nb_bytes - nb_bytes;\n" telem_type message_name;
+          fprintf out_h "#endif\n";
+          fprintf out_h "#if TELEMETRY_ADAPTIVE\n";
+          lprintf out_h "if (dev != NULL) telemetry_adaptive_size(&telemetry_adaptive_msgs_%s[%d], dev->nb_bytes - nb_bytes);\n" process_name (adaptive_idx message_name);
+          fprintf out_h "#endif\n";
           fprintf out_h "#if USE_PERIODIC_TELEMETRY_REPORT\n";
           lprintf out_h "if (j == 0) periodic_telemetry_err_report(TELEMETRY_PROCESS_%s, telemetry_mode_%s, %s_MSG_ID_%s);\n" process_name process_name telem_type message_name;
           fprintf out_h "#endif\n";
@@ -171,6 +185,20 @@ let print_message_table = fun out_h xml ->
     fprintf out_h "}\n\n"
   ) telemetry_types
 
+(** Priority of the messages without priority attribute, see TELEMETRY_ADAPTIVE *)
+let default_priority = "2"
+
+(** Messages of a process with their highest priority, in order of appearance *)
+let process_messages = fun modes ->
+  List.fold_left (fun l mode ->
+    List.fold_left (fun l msg ->
+      let n = ExtXml.attrib msg "name"
+      and p = int_of_string (ExtXml.attrib_or_default msg "priority" default_priority) in
+      if List.mem_assoc n l then List.map (fun (n', p') -> if n' = n then (n', max p p') else (n', p')) l
+      else l @ [(n, p)]
+    ) l (Xml.children mode)
+  ) [] modes
+
 let print_process_send = fun out_h xml freq ->
   (** For each process *)
   List.iter
@@ -208,9 +236,35 @@ let print_process_send = fun out_h xml freq ->
       fprintf out_h "extern uint8_t telemetry_mode_%s;\n" process_name;
       fprintf out_h "#endif /* PERIODIC_C_%s */\n" (Compat.uppercase_ascii process_name);
 
+      (* adaptive scheduler state of this process, only its messages are decimated *)
+      let messages = process_messages modes in
+      let nb_messages = List.length messages in
+      let adaptive_idx = fun n ->
+        let rec find = fun i l -> match l with
+          | [] -> failwith (sprintf "gen_periodic: unknown message %s" n)
+          | (n', _) :: l' -> if n' = n then i else find (i + 1) l' in
+        find 0 messages in
+      if nb_messages > 0 then begin
+        fprintf out_h "#if TELEMETRY_ADAPTIVE\n";
+        fprintf out_h "#ifdef PERIODIC_C_%s\n" (Compat.uppercase_ascii process_name);
+        fprintf out_h "struct telemetry_adaptive_msg telemetry_adaptive_msgs_%s[%d] = {" process_name nb_messages;
+        fprintf out_h "%s };\n" (String.concat ", " (List.map (fun (_, p) -> sprintf "TELEMETRY_ADAPTIVE_MSG(%d)" p) messages));
+        fprintf out_h "struct telemetry_adaptive telemetry_adaptive_%s = { .msgs = telemetry_adaptive_msgs_%s, .nb = %d };\n" process_name process_name nb_messages;
+        fprintf out_h "#else /* PERIODIC_C_%s not defined (general header) */\n" (Compat.uppercase_ascii process_name);
+        fprintf out_h "extern struct telemetry_adaptive_msg telemetry_adaptive_msgs_%s[%d];\n" process_name nb_messages;
+        fprintf out_h "extern struct telemetry_adaptive telemetry_adaptive_%s;\n" process_name;
+        fprintf out_h "#endif /* PERIODIC_C_%s */\n" (Compat.uppercase_ascii process_name);
+        fprintf out_h "#endif\n"
+      end;
+
       lprintf out_h "static inline void periodic_telemetry_send_%s(struct periodic_telemetry *telemetry, struct transport_tx *trans, struct link_device *dev) {  /* %dHz */\n" process_name freq;
       right ();
-      output_modes out_h process_name telem_type modes freq;
+      output_modes out_h process_name telem_type modes freq adaptive_idx;
+      if nb_messages > 0 then begin
+        fprintf out_h "#if TELEMETRY_ADAPTIVE\n";
+        lprintf out_h "telemetry_adaptive_periodic(&telemetry_adaptive_%s, dev, %d);\n" process_name freq;
+        fprintf out_h "#endif\n"
+      end;
       left ();
       lprintf out_h "}\n"
     )
@@ -0,0 +1,213 @@
+/* Output of gen_periodic at 60Hz for the telemetry file of test_telemetry_adaptive.c:
+ *
+ * <telemetry>
+ *   <process name="Test">
+ *     <mode name="default">
+ *       <message name="ALIVE"         period="0.5"  priority="4"/>
+ *       <message name="ROTORCRAFT_FP" period="0.1"  priority="4"/>
+ *       <message name="ATTITUDE"      period="0.05"/>
+ *       <message name="GPS_INT"       period="0.25" priority="1"/>
+ *       <message name="IMU_ACCEL_RAW" period="0.0167" priority="0"/>
+ *     </mode>
+ *   </process>
+ * </telemetry>
+ *
+ * Kept in the tree so that the test does not depend on the generator,
+ * update it when gen_periodic changes.
+ */
+
+#ifndef _VAR_PERIODIC_H_
+#define _VAR_PERIODIC_H_
+
+#include "std.h"
+#include "subsystems/datalink/telemetry_common.h"
+
+#define TELEMETRY_FREQUENCY 60
+
+/* Periodic telemetry messages of type PPRZ */
+#define TELEMETRY_PPRZ_MSG_ALIVE_IDX 0
+#define TELEMETRY_PPRZ_MSG_ROTORCRAFT_FP_IDX 1
+#define TELEMETRY_PPRZ_MSG_ATTITUDE_IDX 2
+#define TELEMETRY_PPRZ_MSG_GPS_INT_IDX 3
+#define TELEMETRY_PPRZ_MSG_IMU_ACCEL_RAW_IDX 4
+#define TELEMETRY_PPRZ_NB_MSG 5
+
+#define TELEMETRY_PPRZ_MSG_NAMES { \
+  "ALIVE", \
+  "ROTORCRAFT_FP", \
+  "ATTITUDE", \
+  "GPS_INT", \
+  "IMU_ACCEL_RAW", \
+}
+
+#define TELEMETRY_PPRZ_CBS { \
+  {.id=PPRZ_MSG_ID_ALIVE, .slots={ NULL }}, \
+  {.id=PPRZ_MSG_ID_ROTORCRAFT_FP, .slots={ NULL }}, \
+  {.id=PPRZ_MSG_ID_ATTITUDE, .slots={ NULL }}, \
+  {.id=PPRZ_MSG_ID_GPS_INT, .slots={ NULL }}, \
+  {.id=PPRZ_MSG_ID_IMU_ACCEL_RAW, .slots={ NULL }}, \
+}
+
+
+/* Periodic telemetry (type PPRZ): Test process */
+#define TELEMETRY_PROCESS_Test 0
+#define TELEMETRY_MODE_Test_default 0
+#define PERIOD_ALIVE_Test_0 (0.5)
+#define PERIOD_ROTORCRAFT_FP_Test_0 (0.1)
+#define PERIOD_ATTITUDE_Test_0 (0.05)
+#define PERIOD_GPS_INT_Test_0 (0.25)
+#define PERIOD_IMU_ACCEL_RAW_Test_0 (0.0167)
+
+/* Functions for Test process */
+#ifdef PERIODIC_C_TEST
+#ifndef TELEMETRY_MODE_TEST
+#define TELEMETRY_MODE_TEST 0
+#endif
+uint8_t telemetry_mode_Test = TELEMETRY_MODE_TEST;
+#else /* PERIODIC_C_TEST not defined (general header) */
+extern uint8_t telemetry_mode_Test;
+#endif /* PERIODIC_C_TEST */
+#if TELEMETRY_ADAPTIVE
+#ifdef PERIODIC_C_TEST
+struct telemetry_adaptive_msg telemetry_adaptive_msgs_Test[5] = {TELEMETRY_ADAPTIVE_MSG(4), TELEMETRY_ADAPTIVE_MSG(4), TELEMETRY_ADAPTIVE_MSG(2), TELEMETRY_ADAPTIVE_MSG(1), TELEMETRY_ADAPTIVE_MSG(0) };
+struct telemetry_adaptive telemetry_adaptive_Test = { .msgs = telemetry_adaptive_msgs_Test, .nb = 5 };
+#else /* PERIODIC_C_TEST not defined (general header) */
+extern struct telemetry_adaptive_msg telemetry_adaptive_msgs_Test[5];
+extern struct telemetry_adaptive telemetry_adaptive_Test;
+#endif /* PERIODIC_C_TEST */
+#endif
+static inline void periodic_telemetry_send_Test(struct periodic_telemetry *telemetry, struct transport_tx *trans, struct link_device *dev) {  /* 60Hz */
+  if (telemetry_mode_Test == TELEMETRY_MODE_Test_default) {
+    static uint8_t i1 = 0; i1++; if (i1>=1) i1=0;
+    static uint8_t i3 = 0; i3++; if (i3>=3) i3=0;
+    static uint8_t i6 = 0; i6++; if (i6>=6) i6=0;
+    static uint8_t i15 = 0; i15++; if (i15>=15) i15=0;
+    static uint8_t i30 = 0; i30++; if (i30>=30) i30=0;
+    uint8_t j;
+    if (i1 == 0) {
+#if TELEMETRY_STATS || TELEMETRY_ADAPTIVE
+      uint32_t nb_bytes = (dev != NULL) ? dev->nb_bytes : 0;
+#endif
+      j = 0;
+#if TELEMETRY_ADAPTIVE
+      if (!telemetry_adaptive_send(&telemetry_adaptive_msgs_Test[4])) j = TELEMETRY_NB_CBS; // decimated
+#endif
+      for (; j < TELEMETRY_NB_CBS; j++) {
+        if (telemetry->cbs[TELEMETRY_PPRZ_MSG_IMU_ACCEL_RAW_IDX].slots[j] != NULL)
+          telemetry->cbs[TELEMETRY_PPRZ_MSG_IMU_ACCEL_RAW_IDX].slots[j](trans, dev);
+        else break;
+      }
+#if TELEMETRY_STATS
+      telemetry->cbs[TELEMETRY_PPRZ_MSG_IMU_ACCEL_RAW_IDX].nb_calls++;
+      if (dev != NULL) telemetry->cbs[TELEMETRY_PPRZ_MSG_IMU_ACCEL_RAW_IDX].nb_bytes += dev->nb_bytes - nb_bytes;
+#endif
+#if TELEMETRY_ADAPTIVE
+      if (dev != NULL) telemetry_adaptive_size(&telemetry_adaptive_msgs_Test[4], dev->nb_bytes - nb_bytes);
+#endif
+#if USE_PERIODIC_TELEMETRY_REPORT
+      if (j == 0) periodic_telemetry_err_report(TELEMETRY_PROCESS_Test, telemetry_mode_Test, PPRZ_MSG_ID_IMU_ACCEL_RAW);
+#endif
+    }
+    if (i3 == 0) {
+#if TELEMETRY_STATS || TELEMETRY_ADAPTIVE
+      uint32_t nb_bytes = (dev != NULL) ? dev->nb_bytes : 0;
+#endif
+      j = 0;
+#if TELEMETRY_ADAPTIVE
+      if (!telemetry_adaptive_send(&telemetry_adaptive_msgs_Test[2])) j = TELEMETRY_NB_CBS; // decimated
+#endif
+      for (; j < TELEMETRY_NB_CBS; j++) {
+        if (telemetry->cbs[TELEMETRY_PPRZ_MSG_ATTITUDE_IDX].slots[j] != NULL)
+          telemetry->cbs[TELEMETRY_PPRZ_MSG_ATTITUDE_IDX].slots[j](trans, dev);
+        else break;
+      }
+#if TELEMETRY_STATS
+      telemetry->cbs[TELEMETRY_PPRZ_MSG_ATTITUDE_IDX].nb_calls++;
+      if (dev != NULL) telemetry->cbs[TELEMETRY_PPRZ_MSG_ATTITUDE_IDX].nb_bytes += dev->nb_bytes - nb_bytes;
+#endif
+#if TELEMETRY_ADAPTIVE
+      if (dev != NULL) telemetry_adaptive_size(&telemetry_adaptive_msgs_Test[2], dev->nb_bytes - nb_bytes);
+#endif
+#if USE_PERIODIC_TELEMETRY_REPORT
+      if (j == 0) periodic_telemetry_err_report(TELEMETRY_PROCESS_Test, telemetry_mode_Test, PPRZ_MSG_ID_ATTITUDE);
+#endif
+    }
+    if (i6 == 0) {
+#if TELEMETRY_STATS || TELEMETRY_ADAPTIVE
+      uint32_t nb_bytes = (dev != NULL) ? dev->nb_bytes : 0;
+#endif
+      j = 0;
+#if TELEMETRY_ADAPTIVE
+      if (!telemetry_adaptive_send(&telemetry_adaptive_msgs_Test[1])) j = TELEMETRY_NB_CBS; // decimated
+#endif
+      for (; j < TELEMETRY_NB_CBS; j++) {
+        if (telemetry->cbs[TELEMETRY_PPRZ_MSG_ROTORCRAFT_FP_IDX].slots[j] != NULL)
+          telemetry->cbs[TELEMETRY_PPRZ_MSG_ROTORCRAFT_FP_IDX].slots[j](trans, dev);
+        else break;
+      }
+#if TELEMETRY_STATS
+      telemetry->cbs[TELEMETRY_PPRZ_MSG_ROTORCRAFT_FP_IDX].nb_calls++;
+      if (dev != NULL) telemetry->cbs[TELEMETRY_PPRZ_MSG_ROTORCRAFT_FP_IDX].nb_bytes += dev->nb_bytes - nb_bytes;
+#endif
+#if TELEMETRY_ADAPTIVE
+      if (dev != NULL) telemetry_adaptive_size(&telemetry_adaptive_msgs_Test[1], dev->nb_bytes - nb_bytes);
+#endif
+#if USE_PERIODIC_TELEMETRY_REPORT
+      if (j == 0) periodic_telemetry_err_report(TELEMETRY_PROCESS_Test, telemetry_mode_Test, PPRZ_MSG_ID_ROTORCRAFT_FP);
+#endif
+    }
+    if (i15 == 6) {
+#if TELEMETRY_STATS || TELEMETRY_ADAPTIVE
+      uint32_t nb_bytes = (dev != NULL) ? dev->nb_bytes : 0;
+#endif
+      j = 0;
+#if TELEMETRY_ADAPTIVE
+      if (!telemetry_adaptive_send(&telemetry_adaptive_msgs_Test[3])) j = TELEMETRY_NB_CBS; // decimated
+#endif
+      for (; j < TELEMETRY_NB_CBS; j++) {
+        if (telemetry->cbs[TELEMETRY_PPRZ_MSG_GPS_INT_IDX].slots[j] != NULL)
+          telemetry->cbs[TELEMETRY_PPRZ_MSG_GPS_INT_IDX].slots[j](trans, dev);
+        else break;
+      }
+#if TELEMETRY_STATS
+      telemetry->cbs[TELEMETRY_PPRZ_MSG_GPS_INT_IDX].nb_calls++;
+      if (dev != NULL) telemetry->cbs[TELEMETRY_PPRZ_MSG_GPS_INT_IDX].nb_bytes += dev->nb_bytes - nb_bytes;
+#endif
+#if TELEMETRY_ADAPTIVE
+      if (dev != NULL) telemetry_adaptive_size(&telemetry_adaptive_msgs_Test[3], dev->nb_bytes - nb_bytes);
+#endif
+#if USE_PERIODIC_TELEMETRY_REPORT
+      if (j == 0) periodic_telemetry_err_report(TELEMETRY_PROCESS_Test, telemetry_mode_Test, PPRZ_MSG_ID_GPS_INT);
+#endif
+    }
+    if (i30 == 12) {
+#if TELEMETRY_STATS || TELEMETRY_ADAPTIVE
+      uint32_t nb_bytes = (dev != NULL) ? dev->nb_bytes : 0;
+#endif
+      j = 0;
+#if TELEMETRY_ADAPTIVE
+      if (!telemetry_adaptive_send(&telemetry_adaptive_msgs_Test[0])) j = TELEMETRY_NB_CBS; // decimated
+#endif
+      for (; j < TELEMETRY_NB_CBS; j++) {
+        if (telemetry->cbs[TELEMETRY_PPRZ_MSG_ALIVE_IDX].slots[j] != NULL)
+          telemetry->cbs[TELEMETRY_PPRZ_MSG_ALIVE_IDX].slots[j](trans, dev);
+        else break;
+      }
+#if TELEMETRY_STATS
+      telemetry->cbs[TELEMETRY_PPRZ_MSG_ALIVE_IDX].nb_calls++;
+      if (dev != NULL) telemetry->cbs[TELEMETRY_PPRZ_MSG_ALIVE_IDX].nb_bytes += dev->nb_bytes - nb_bytes;
+#endif
+#if TELEMETRY_ADAPTIVE
+      if (dev != NULL) telemetry_adaptive_size(&telemetry_adaptive_msgs_Test[0], dev->nb_bytes - nb_bytes);
+#endif
+#if USE_PERIODIC_TELEMETRY_REPORT
+      if (j == 0) periodic_telemetry_err_report(TELEMETRY_PROCESS_Test, telemetry_mode_Test, PPRZ_MSG_ID_ALIVE);
+#endif
+    }
+  }
+#if TELEMETRY_ADAPTIVE
+  telemetry_adaptive_periodic(&telemetry_adaptive_Test, dev, 60);
+#endif
+}
+
+#endif // _VAR_PERIODIC_H_
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test_telemetry_adaptive.c
+ * @brief Tests for the bandwidth adaptive periodic telemetry.
+ *
+ * The generated send function of a test process (generated/periodic_telemetry.h
+ * in this directory) sends its messages to a mock device, which accepts a
+ * message when it fits in its queue and counts an overrun otherwise, like the
+ * transport does. The queue is emptied at a given rate to model the link.
+ *
+ * Using libtap to create a TAP (TestAnythingProtocol) producer:
+ * https://github.com/zorgnax/libtap
+ *
+ */
+
+#include "tap.h"
+
+#define PERIODIC_C_TEST
+#include "generated/periodic_telemetry.h"
+
+extern struct periodic_telemetry pprz_telemetry;
+
+/** Messages in the order of the process, with their size and nominal rate */
+enum test_msg { ALIVE, FP, ATT, GPS, IMU, NB_TEST_MSG };
+static const uint16_t msg_size[NB_TEST_MSG] = { 20, 40, 30, 60, 50 };
+static const uint16_t msg_rate[NB_TEST_MSG] = { 2, 10, 20, 4, 60 };
+
+/** Mock device with a queue emptied by the link */
+#define MOCK_QUEUE_SIZE 256
+static struct link_device mock;
+static uint16_t mock_queue;
+static uint32_t lost[NB_TEST_MSG];
+
+static void mock_send(enum test_msg m)
+{
+  if (mock_queue + msg_size[m] > MOCK_QUEUE_SIZE) {
+    mock.nb_ovrn++;
+    lost[m]++;
+    return;
+  }
+  mock_queue += msg_size[m];
+  mock.nb_bytes += msg_size[m];
+  mock.nb_msgs++;
+}
+
+static void send_alive(struct transport_tx *trans __attribute__((unused)), struct link_device *dev __attribute__((unused))) { mock_send(ALIVE); }
+static void send_fp(struct transport_tx *trans __attribute__((unused)), struct link_device *dev __attribute__((unused))) { mock_send(FP); }
+static void send_att(struct transport_tx *trans __attribute__((unused)), struct link_device *dev __attribute__((unused))) { mock_send(ATT); }
+static void send_gps(struct transport_tx *trans __attribute__((unused)), struct link_device *dev __attribute__((unused))) { mock_send(GPS); }
+static void send_imu(struct transport_tx *trans __attribute__((unused)), struct link_device *dev __attribute__((unused))) { mock_send(IMU); }
+
+/** Statistics of the windows of the scheduler */
+struct window_stats {
+  uint16_t nb;          ///< number of windows
+  uint16_t nb_ovrn;     ///< windows with overruns
+  uint16_t nb_probes;   ///< windows probing the lower level
+  uint16_t nb_lost_max; ///< windows where a message of highest priority was lost, out of the probes
+};
+
+/** Run the telemetry for some windows of one second
+ * @param drain number of bytes sent by the link at each call
+ */
+static void run_windows(uint16_t nb, uint16_t drain, struct window_stats *s)
+{
+  s->nb = s->nb_ovrn = s->nb_probes = s->nb_lost_max = 0;
+  for (uint16_t w = 0; w < nb; w++) {
+    bool probe = telemetry_adaptive_Test.probing;
+    uint8_t ovrn = mock.nb_ovrn;
+    uint32_t lost_max = lost[ALIVE] + lost[FP];
+    for (int i = 0; i < TELEMETRY_FREQUENCY; i++) {
+      periodic_telemetry_send_Test(&pprz_telemetry, NULL, &mock);
+      mock_queue -= Min(mock_queue, drain);
+    }
+    s->nb++;
+    s->nb_probes += probe;
+    s->nb_ovrn += (mock.nb_ovrn != ovrn);
+    s->nb_lost_max += (!probe && lost[ALIVE] + lost[FP] != lost_max);
+  }
+}
+
+/** Check that the rates of the last window match the decimations
+ * @return true if the level, decimations and rates are the expected ones
+ */
+static bool check_decimation(uint8_t level, const uint8_t shift[NB_TEST_MSG])
+{
+  bool ok = (telemetry_adaptive_Test.level == level);
+  for (int i = 0; i < NB_TEST_MSG; i++) {
+    ok = ok && telemetry_adaptive_msgs_Test[i].shift == shift[i]
+         && telemetry_adaptive_msgs_Test[i].rate == msg_rate[i] >> shift[i];
+  }
+  return ok;
+}
+
+/** Run until the last window is not a probe */
+static void run_steady(uint16_t drain, struct window_stats *s)
+{
+  struct window_stats w;
+  do {
+    run_windows(1, drain, &w);
+    s->nb += w.nb;
+    s->nb_ovrn += w.nb_ovrn;
+    s->nb_probes += w.nb_probes;
+    s->nb_lost_max += w.nb_lost_max;
+  } while (w.nb_probes > 0 || telemetry_adaptive_Test.probing);
+}
+
+int main(int argc __attribute__((unused)), char **argv __attribute__((unused)))
+{
+  note("running adaptive telemetry tests");
+  plan(5);
+
+  register_periodic_telemetry(&pprz_telemetry, PPRZ_MSG_ID_ALIVE, send_alive);
+  register_periodic_telemetry(&pprz_telemetry, PPRZ_MSG_ID_ROTORCRAFT_FP, send_fp);
+  register_periodic_telemetry(&pprz_telemetry, PPRZ_MSG_ID_ATTITUDE, send_att);
+  register_periodic_telemetry(&pprz_telemetry, PPRZ_MSG_ID_GPS_INT, send_gps);
+  register_periodic_telemetry(&pprz_telemetry, PPRZ_MSG_ID_IMU_ACCEL_RAW, send_imu);
+
+  // 4280 bytes/s requested
+  const uint8_t no_shift[NB_TEST_MSG] = { 0, 0, 0, 0, 0 };
+  struct window_stats s;
+  run_windows(5, 1000, &s);
+  ok(s.nb_ovrn == 0 && check_decimation(0, no_shift), "fast link, messages sent at their nominal rate");
+
+  // 2400 bytes/s link: 2780 bytes/s at level 1, 1910 bytes/s at level 2
+  const uint8_t shift_2[NB_TEST_MSG] = { 0, 0, 0, 1, 2 };
+  run_windows(10, 40, &s);
+  run_steady(40, &s);
+  ok(check_decimation(2, shift_2), "slow link, level %d, budget %u bytes/s", telemetry_adaptive_Test.level,
+     telemetry_adaptive_Test.budget);
+
+  // only the probes of the lower level may overrun, less and less often
+  run_windows(180, 40, &s);
+  ok(s.nb_ovrn <= s.nb_probes && s.nb_probes <= 4 && telemetry_adaptive_Test.probe == TELEMETRY_ADAPTIVE_PROBE_MAX,
+     "%d windows with overruns and %d probes in %d s", s.nb_ovrn, s.nb_probes, s.nb);
+  ok(s.nb_lost_max == 0, "no message of highest priority lost out of the probes");
+
+  // the link is fast again, the probes lower the level one by one
+  run_windows(2 * TELEMETRY_ADAPTIVE_PROBE_MAX, 1000, &s);
+  run_steady(1000, &s);
+  ok(s.nb_ovrn == 0 && check_decimation(0, no_shift), "fast link again, back to level 0 after %d s", s.nb);
+
+  done_testing();
+}
@@ -0,0 +1,13 @@
+/* Airframe configuration of the tests including airborne sources,
+ * replaces the header generated from the airframe file.
+ */
+
+#ifndef AIRFRAME_H
+#define AIRFRAME_H
+
+/* local magnetic field of test_ins_float_invariant */
+#define INS_H_X 0.5138
+#define INS_H_Y 0.00019
+#define INS_H_Z 0.8578
+
+#endif
@@ -0,0 +1,14 @@
+/* Flight plan of the tests including airborne sources,
+ * replaces the header generated from the flight plan file.
+ */
+
+#ifndef FLIGHT_PLAN_H
+#define FLIGHT_PLAN_H
+
+#define NAV_LAT0 434622300
+#define NAV_LON0 12728900
+#define NAV_ALT0 0
+#define NAV_MSL0 0
+#define GROUND_ALT 0.
+
+#endif
@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test_imu_preint.c
+ * @brief Tests for the pre-integration of the IMU samples.
+ *
+ * The fixed point deltas with coning and sculling corrections are compared
+ * to the rotation and velocity increment of a coning motion integrated with
+ * a fine time step, and to the deltas without corrections.
+ *
+ * Using libtap to create a TAP (TestAnythingProtocol) producer:
+ * https://github.com/zorgnax/libtap
+ *
+ */
+
+#include "tap.h"
+
+#include <math.h>
+#include "math/pprz_algebra_float.h"
+#include "subsystems/imu/imu_preint.h"
+
+#define SAMPLE_US 500
+#define PERIOD_US 10000
+#define FINE_STEPS 50
+#define CONING_FREQ 20.
+
+static struct ImuPreint preint;
+
+/** Coning motion with a constant yaw rate, in the body frame */
+static void rates_at(double t, double w[3])
+{
+  const double a = 0.2, omega = 2. * M_PI * CONING_FREQ;
+  w[0] = a * omega * cos(omega * t);
+  w[1] = a * omega * sin(omega * t);
+  w[2] = 0.5;
+}
+
+/** Oscillating specific force in phase with the coning, in the body frame */
+static void accel_at(double t, double f[3])
+{
+  f[0] = 0.;
+  f[1] = 5. * sin(2. * M_PI * CONING_FREQ * t);
+  f[2] = -9.81;
+}
+
+/** Rotation angle between two quaternions */
+static float quat_angle_err(struct FloatQuat *a, struct FloatQuat *b)
+{
+  struct FloatQuat e;
+  float_quat_inv_comp(&e, a, b);
+  return 2.f * sqrtf(e.qx * e.qx + e.qy * e.qy + e.qz * e.qz);
+}
+
+static void quat_of_rot_vect(struct FloatQuat *q, struct FloatVect3 *v)
+{
+  float angle = float_vect3_norm(v);
+  struct FloatVect3 u = { 1.f, 0.f, 0.f };
+  if (angle > 0.f) {
+    VECT3_SDIV(u, *v, angle);
+  }
+  float_quat_of_axis_angle(q, &u, angle);
+}
+
+static void test_constant_rates(void)
+{
+  imu_preint_init(&preint, PERIOD_US);
+  struct Int32Rates gyro = { RATE_BFP_OF_REAL(0.1), RATE_BFP_OF_REAL(-0.2), RATE_BFP_OF_REAL(0.3) };
+  struct Int32Vect3 accel = { 0, 0, ACCEL_BFP_OF_REAL(-9.81) };
+  uint32_t stamp = 0;
+  bool done = false;
+  imu_preint_gyro(&preint, stamp, &gyro);
+  imu_preint_accel(&preint, stamp, &accel);
+  int n = 0;
+  while (!done) {
+    stamp += SAMPLE_US;
+    imu_preint_gyro(&preint, stamp, &gyro);
+    done = imu_preint_accel(&preint, stamp, &accel);
+    n++;
+  }
+  struct Int32Vect3 da, dv;
+  float dt;
+  imu_preint_get(&preint, &da, &dv, &dt);
+  // parallel rotation axis, no coning, angle = rates * dt up to the truncation of each increment
+  float err = fabsf(FLOAT_OF_BFP(da.x, IMU_DELTA_ANGLE_FRAC) - RATE_FLOAT_OF_BFP(gyro.p) * dt)
+              + fabsf(FLOAT_OF_BFP(da.y, IMU_DELTA_ANGLE_FRAC) - RATE_FLOAT_OF_BFP(gyro.q) * dt)
+              + fabsf(FLOAT_OF_BFP(da.z, IMU_DELTA_ANGLE_FRAC) - RATE_FLOAT_OF_BFP(gyro.r) * dt);
+  ok(n == PERIOD_US / SAMPLE_US && fabsf(dt - PERIOD_US * 1e-6f) < 1e-7f && err < 3 * n / (float)(1 << IMU_DELTA_ANGLE_FRAC),
+     "constant rates integrated over %d samples, dt %f, angle error %g rad", n, dt, err);
+}
+
+static void test_coning_sculling(void)
+{
+  imu_preint_init(&preint, PERIOD_US);
+  const double h = SAMPLE_US * 1e-6 / FINE_STEPS;
+  struct FloatQuat q, q_start;
+  float_quat_identity(&q);
+  q_start = q;
+  double dv_true[3] = { 0., 0., 0. };
+  double t = 0.;
+  uint32_t stamp = 0;
+  struct Int32Rates gyro = { 0, 0, 0 };
+  struct Int32Vect3 accel = { 0, 0, 0 };
+  imu_preint_gyro(&preint, stamp, &gyro);
+  imu_preint_accel(&preint, stamp, &accel);
+  float angle_err = 0.f, angle_err_nc = 0.f, vel_err = 0.f, vel_err_nc = 0.f;
+  int nb = 0;
+  for (int k = 0; k < 100 * PERIOD_US / SAMPLE_US; k++) {
+    // fine integration of the true motion, the samples are the mean rates and specific forces
+    double w_sum[3] = { 0., 0., 0. }, f_sum[3] = { 0., 0., 0. };
+    for (int j = 0; j < FINE_STEPS; j++) {
+      double w[3], f[3];
+      rates_at(t + h / 2., w);
+      accel_at(t + h / 2., f);
+      struct FloatRates r = { w[0], w[1], w[2] };
+      float_quat_integrate(&q, &r, h);
+      // specific force in the frame at the start of the interval
+      struct FloatQuat q_rel;
+      float_quat_inv_comp(&q_rel, &q, &q_start);
+      struct FloatVect3 f_b = { f[0], f[1], f[2] }, f_s;
+      float_quat_vmult(&f_s, &q_rel, &f_b);
+      dv_true[0] += f_s.x * h;
+      dv_true[1] += f_s.y * h;
+      dv_true[2] += f_s.z * h;
+      for (int i = 0; i < 3; i++) {
+        w_sum[i] += w[i];
+        f_sum[i] += f[i];
+      }
+      t += h;
+    }
+    stamp += SAMPLE_US;
+    RATES_ASSIGN(gyro, RATE_BFP_OF_REAL(w_sum[0] / FINE_STEPS), RATE_BFP_OF_REAL(w_sum[1] / FINE_STEPS),
+                 RATE_BFP_OF_REAL(w_sum[2] / FINE_STEPS));
+    VECT3_ASSIGN(accel, ACCEL_BFP_OF_REAL(f_sum[0] / FINE_STEPS), ACCEL_BFP_OF_REAL(f_sum[1] / FINE_STEPS),
+                 ACCEL_BFP_OF_REAL(f_sum[2] / FINE_STEPS));
+    imu_preint_gyro(&preint, stamp, &gyro);
+    if (imu_preint_accel(&preint, stamp, &accel)) {
+      // deltas without the corrections
+      struct FloatVect3 alpha = { FLOAT_OF_BFP(preint.alpha[0], IMU_DELTA_ANGLE_FRAC),
+               FLOAT_OF_BFP(preint.alpha[1], IMU_DELTA_ANGLE_FRAC), FLOAT_OF_BFP(preint.alpha[2], IMU_DELTA_ANGLE_FRAC)
+      };
+      struct FloatVect3 nu = { FLOAT_OF_BFP(preint.nu[0], IMU_DELTA_VEL_FRAC),
+               FLOAT_OF_BFP(preint.nu[1], IMU_DELTA_VEL_FRAC), FLOAT_OF_BFP(preint.nu[2], IMU_DELTA_VEL_FRAC)
+      };
+      struct Int32Vect3 da, dv;
+      float dt;
+      imu_preint_get(&preint, &da, &dv, &dt);
+      struct FloatVect3 theta = { FLOAT_OF_BFP(da.x, IMU_DELTA_ANGLE_FRAC), FLOAT_OF_BFP(da.y, IMU_DELTA_ANGLE_FRAC),
+               FLOAT_OF_BFP(da.z, IMU_DELTA_ANGLE_FRAC)
+      };
+      struct FloatQuat dq_true, dq, dq_nc;
+      float_quat_inv_comp(&dq_true, &q_start, &q);
+      quat_of_rot_vect(&dq, &theta);
+      quat_of_rot_vect(&dq_nc, &alpha);
+      angle_err += quat_angle_err(&dq_true, &dq);
+      angle_err_nc += quat_angle_err(&dq_true, &dq_nc);
+      float e = 0.f, e_nc = 0.f;
+      e += powf(FLOAT_OF_BFP(dv.x, IMU_DELTA_VEL_FRAC) - dv_true[0], 2);
+      e += powf(FLOAT_OF_BFP(dv.y, IMU_DELTA_VEL_FRAC) - dv_true[1], 2);
+      e += powf(FLOAT_OF_BFP(dv.z, IMU_DELTA_VEL_FRAC) - dv_true[2], 2);
+      e_nc += powf(nu.x - dv_true[0], 2) + powf(nu.y - dv_true[1], 2) + powf(nu.z - dv_true[2], 2);
+      vel_err += sqrtf(e);
+      vel_err_nc += sqrtf(e_nc);
+      q_start = q;
+      dv_true[0] = dv_true[1] = dv_true[2] = 0.;
+      nb++;
+    }
+  }
+  angle_err /= nb;
+  angle_err_nc /= nb;
+  vel_err /= nb;
+  vel_err_nc /= nb;
+  ok(nb == 100 && angle_err < 1e-3f && angle_err < angle_err_nc / 10.f,
+     "coning correction, mean angle error %g rad, %g rad without", angle_err, angle_err_nc);
+  ok(vel_err < 3e-3f && vel_err < vel_err_nc / 5.f,
+     "sculling correction, mean velocity error %g m/s, %g m/s without", vel_err, vel_err_nc);
+}
+
+static void test_lost_samples(void)
+{
+  imu_preint_init(&preint, PERIOD_US);
+  struct Int32Rates gyro = { 0, 0, RATE_BFP_OF_REAL(1.) };
+  struct Int32Vect3 accel = { 0, 0, ACCEL_BFP_OF_REAL(-9.81) };
+  uint32_t stamp = 0;
+  for (int k = 0; k < 10; k++) {
+    stamp += (k % 2) ? SAMPLE_US + 200 : SAMPLE_US - 200;
+    imu_preint_gyro(&preint, stamp, &gyro);
+    imu_preint_accel(&preint, stamp, &accel);
+  }
+  bool jitter_ok = preint.nb_resets == 0 && preint.alpha[2] > 0;
+  // four samples lost, much less than the integration period
+  stamp += 5 * SAMPLE_US;
+  imu_preint_gyro(&preint, stamp, &gyro);
+  bool reset = preint.nb_resets == 1 && preint.alpha[2] == 0;
+  imu_preint_accel(&preint, stamp, &accel);
+  // the sample period is estimated again after a gap
+  for (int k = 0; k < 5; k++) {
+    stamp += SAMPLE_US;
+    imu_preint_gyro(&preint, stamp, &gyro);
+    imu_preint_accel(&preint, stamp, &accel);
+  }
+  ok(jitter_ok && reset && preint.nb_resets == 2 && preint.dt == 5 * SAMPLE_US && preint.gyro_sample_dt == SAMPLE_US,
+     "integration restarted when samples are lost, not on jitter (%u resets)", preint.nb_resets);
+}
+
+int main(int argc __attribute__((unused)), char **argv __attribute__((unused)))
+{
+  note("running imu pre-integration tests");
+  plan(4);
+
+  test_constant_rates();
+  test_coning_sculling();
+  test_lost_samples();
+
+  done_testing();
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test_ins_float_invariant.c
+ * @brief Tests for the integration of the invariant filter model.
+ *
+ * The filter is compiled with INS_FINV_INTEGRATION = INS_FINV_EXP, and the
+ * second and fourth order Runge-Kutta integrations of the same model are
+ * called as ins_float_invariant_propagate does. The three are run side by
+ * side over a trajectory, each with the correction terms of its own state.
+ *
+ * Using libtap to create a TAP (TestAnythingProtocol) producer:
+ * https://github.com/zorgnax/libtap
+ *
+ */
+
+#include "tap.h"
+
+#include "subsystems/ins/ins_float_invariant.c"
+
+struct GpsState gps;
+
+#define PROP_FREQ 512
+#define DURATION 20
+
+/** Rotation angle between two quaternions */
+static float quat_angle_err(struct FloatQuat *a, struct FloatQuat *b)
+{
+  struct FloatQuat e;
+  float_quat_inv_comp(&e, a, b);
+  return 2.f * sqrtf(e.qx * e.qx + e.qy * e.qy + e.qz * e.qz);
+}
+
+/** Largest difference between two states, attitude apart */
+static float state_err(struct inv_state *a, struct inv_state *b)
+{
+  float err = 0.f;
+  err = Max(err, fabsf(a->speed.x - b->speed.x));
+  err = Max(err, fabsf(a->speed.y - b->speed.y));
+  err = Max(err, fabsf(a->speed.z - b->speed.z));
+  err = Max(err, fabsf(a->pos.x - b->pos.x));
+  err = Max(err, fabsf(a->pos.y - b->pos.y));
+  err = Max(err, fabsf(a->pos.z - b->pos.z));
+  err = Max(err, fabsf(a->bias.p - b->bias.p));
+  err = Max(err, fabsf(a->bias.q - b->bias.q));
+  err = Max(err, fabsf(a->bias.r - b->bias.r));
+  err = Max(err, fabsf(a->as - b->as));
+  err = Max(err, fabsf(a->hb - b->hb));
+  return err;
+}
+
+/** Correction terms of a state, with the current measurements and command */
+static void corrections_of(struct inv_state *s)
+{
+  ins_float_inv.state = *s;
+  error_output(&ins_float_inv);
+}
+
+int main(int argc __attribute__((unused)), char **argv __attribute__((unused)))
+{
+  note("running invariant filter integration tests");
+  plan(4);
+
+  ins_float_invariant_init();
+  // corrections from a constant GPS, baro and magnetometer measurement
+  ins_gps_fix_once = false;
+  VECT3_ASSIGN(ins_float_inv.meas.mag, 0.5f, 0.1f, 0.8f);
+  VECT3_ASSIGN(ins_float_inv.meas.speed_gps, 1.f, 0.f, 0.f);
+  ins_float_inv.meas.baro_alt = 0.5f;
+
+  struct inv_state rk4 = ins_float_inv.state, rk2, cf;
+  struct FloatEulers e0 = { 0.1f, -0.2f, 0.5f };
+  float_quat_of_eulers(&rk4.quat, &e0);
+  RATES_ASSIGN(rk4.bias, 0.01f, -0.02f, 0.005f);
+  rk2 = cf = rk4;
+
+  const float dt = 1.f / PROP_FREQ;
+  float q_err2 = 0.f, q_err_exp = 0.f, s_err2 = 0.f, s_err_exp = 0.f;
+  for (int i = 0; i < DURATION * PROP_FREQ; i++) {
+    float t = i * dt;
+    struct inv_command cmd;
+    RATES_ASSIGN(cmd.rates, 0.5f * sinf(t), 0.3f * cosf(2.f * t), 0.2f + 0.1f * sinf(0.5f * t));
+    VECT3_ASSIGN(cmd.accel, 0.3f * sinf(t), 0.2f * cosf(3.f * t), -9.81f);
+    ins_float_inv.cmd = cmd;
+    struct inv_state next;
+    // each state with its own corrections, as in ins_float_invariant_propagate
+    corrections_of(&rk4);
+    runge_kutta_4_float((float *)&next, (float *)&rk4, INV_STATE_DIM, (float *)&cmd, INV_COMMAND_DIM, invariant_model, dt);
+    rk4 = next;
+    float_quat_normalize(&rk4.quat);
+    corrections_of(&rk2);
+    runge_kutta_2_float((float *)&next, (float *)&rk2, INV_STATE_DIM, (float *)&cmd, INV_COMMAND_DIM, invariant_model, dt);
+    rk2 = next;
+    float_quat_normalize(&rk2.quat);
+    corrections_of(&cf);
+    invariant_propagate_exp(&cf, &cmd, dt);
+    float_quat_normalize(&cf.quat);
+
+    q_err2 = Max(q_err2, quat_angle_err(&rk4.quat, &rk2.quat));
+    q_err_exp = Max(q_err_exp, quat_angle_err(&rk4.quat, &cf.quat));
+    s_err2 = Max(s_err2, state_err(&rk4, &rk2));
+    s_err_exp = Max(s_err_exp, state_err(&rk4, &cf));
+  }
+
+  ok(q_err2 < 1e-5f, "RK2 attitude within %g rad of RK4", q_err2);
+  ok(s_err2 < 1e-5f, "RK2 speed, position and biases within %g of RK4", s_err2);
+  ok(q_err_exp < 2e-3f, "EXP attitude within %g rad of RK4", q_err_exp);
+  ok(s_err_exp < 3e-3f, "EXP speed, position and biases within %g of RK4", s_err_exp);
+
+  done_testing();
+}
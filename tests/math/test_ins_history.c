@@ -0,0 +1,253 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test_ins_history.c
+ * @brief Tests for the fusion of delayed measurements with the INS history.
+ *
+ * A position and speed state propagated with an acceleration is corrected by
+ * delayed position measurements, and compared to a filter fusing the same
+ * measurements at the right time.
+ *
+ * Using libtap to create a TAP (TestAnythingProtocol) producer:
+ * https://github.com/zorgnax/libtap
+ *
+ */
+
+#include "tap.h"
+
+#include <math.h>
+#include "subsystems/ins/ins_history.h"
+
+#define SIZE 64
+#define DT 0.002f
+#define DT_US 2000
+#define REPLAY_STEPS 4
+#define MEAS_SIZE 8
+
+struct TestState {
+  float z;
+  float zdot;
+};
+
+static struct InsHistory h;
+static struct TestState states[SIZE];
+static float inputs[SIZE];
+static uint32_t stamps[SIZE];
+static float dts[SIZE];
+static struct TestState replay;
+static struct InsHistoryMeas meas[MEAS_SIZE];
+static uint32_t nb_propagate;
+
+static void propagate(void *state, const float *accel, float dt)
+{
+  struct TestState *s = (struct TestState *)state;
+  s->z += s->zdot * dt;
+  s->zdot += accel[0] * dt;
+  nb_propagate++;
+}
+
+static void correct(struct TestState *s, float z_meas)
+{
+  s->zdot += 2.f * (z_meas - s->z);
+  s->z += 0.5f * (z_meas - s->z);
+}
+
+static void correct_cb(void *state, uint8_t type __attribute__((unused)), const float *values)
+{
+  correct((struct TestState *)state, values[0]);
+}
+
+/** Fuse a position measurement taken at step k */
+static void fuse(struct TestState *s, int k, float z_meas)
+{
+  float values[INS_HISTORY_MEAS_VALUES] = { z_meas };
+  ins_history_fuse(&h, s, k * DT_US, 0, values);
+}
+
+static float accel_of_step(int i)
+{
+  return sinf(0.01f * i);
+}
+
+/** Run n steps of the filter with the history, the current state is s, replays if asked */
+static void run(struct TestState *s, int from, int n, bool replay_on)
+{
+  for (int i = from; i < from + n; i++) {
+    float accel = accel_of_step(i);
+    ins_history_push(&h, i * DT_US, s, &accel, DT);
+    propagate(s, &accel, DT);
+    if (replay_on) {
+      ins_history_replay(&h, s);
+    }
+  }
+}
+
+/** Reference filter fusing nb measurements z at steps k */
+static struct TestState reference_n(int n, int nb, const int *k, const float *z)
+{
+  struct TestState s = { 0.f, 1.f };
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < nb; j++) {
+      if (i == k[j]) {
+        correct(&s, z[j]);
+      }
+    }
+    float accel = accel_of_step(i);
+    propagate(&s, &accel, DT);
+  }
+  return s;
+}
+
+/** Reference filter fusing the measurement at step k */
+static struct TestState reference(int n, int k, float z_meas)
+{
+  return reference_n(n, 1, &k, &z_meas);
+}
+
+static bool close_to(struct TestState *s, struct TestState *ref)
+{
+  return fabsf(s->z - ref->z) < 1e-5 && fabsf(s->zdot - ref->zdot) < 1e-5;
+}
+
+static void init(void)
+{
+  ins_history_init(&h, states, sizeof(struct TestState), inputs, 1, stamps, dts, SIZE,
+                   &replay, propagate, REPLAY_STEPS, meas, MEAS_SIZE, correct_cb);
+}
+
+static void test_state_at(void)
+{
+  init();
+  struct TestState s = { 0.f, 1.f };
+  // without history the measurement is fused in the current state
+  fuse(&s, 0, 0.1f);
+  bool empty = ins_history_state_at(&h, 0) == NULL && s.z == 0.05f && !h.replaying;
+  s.z = 0.f;
+  s.zdot = 1.f;
+  run(&s, 0, 100, true);
+  // 100 steps in a 64 steps history, the oldest is step 36
+  struct TestState ref = reference(50, -1, 0.f);
+  struct TestState *past = ins_history_state_at(&h, 50 * DT_US + DT_US / 2);
+  fuse(&s, 35, s.z);
+  bool too_old = ins_history_state_at(&h, 35 * DT_US) == NULL && !h.replaying && h.too_old == 1;
+  ok(empty && past != NULL && past->z == ref.z && past->zdot == ref.zdot && too_old,
+     "ins_history_state_at gives the state saved at a past time, NULL if older than the history");
+}
+
+static void test_delayed_fusion(void)
+{
+  init();
+  struct TestState s = { 0.f, 1.f };
+  run(&s, 0, 100, true);
+  // measurement taken at step 60, received at step 100
+  nb_propagate = 0;
+  struct TestState before = s;
+  fuse(&s, 60, 0.2f);
+  bool unchanged = s.z == before.z;
+  // 40 steps to propagate again, 4 per step, the present moves forward by 1 per step
+  run(&s, 100, 12, true);
+  bool pending = h.replaying;
+  run(&s, 112, 2, true);
+  uint32_t cost = nb_propagate;
+  struct TestState ref = reference(114, 60, 0.2f);
+  ok(unchanged && pending && !h.replaying && before.z != ref.z && close_to(&s, &ref),
+     "delayed measurement fused in the past state and propagated to the present, z %f ref %f", s.z, ref.z);
+  ok(cost <= 14 * (REPLAY_STEPS + 1) + 1 && h.replay_steps == 53,
+     "re-propagation limited to %d steps per cycle (%u propagations for 14 cycles)", REPLAY_STEPS, cost);
+}
+
+static void test_fusion_during_replay(void)
+{
+  init();
+  struct TestState s = { 0.f, 1.f };
+  run(&s, 0, 100, true);
+  // measurement at step 60, then at step 90 while the first one is being propagated:
+  // the second one is fused when the replay reaches step 90
+  fuse(&s, 60, 0.2f);
+  run(&s, 100, 1, true);
+  fuse(&s, 90, 0.1f);
+  bool deferred = h.rewinds == 1 && h.replaying;
+  // a measurement older than the replay restarts it, the other ones are fused again
+  fuse(&s, 62, 0.3f);
+  bool restart = h.rewinds == 2;
+  run(&s, 101, 30, true);
+  int k[3] = { 60, 62, 90 };
+  float z[3] = { 0.2f, 0.3f, 0.1f };
+  struct TestState ref = reference_n(131, 3, k, z);
+  struct TestState lost = reference_n(131, 2, k, z);
+  ok(deferred && restart && !h.replaying && close_to(&s, &ref) && !close_to(&s, &lost),
+     "measurements during a replay fused at their own time and kept on restart, z %f ref %f", s.z, ref.z);
+}
+
+static void test_current_during_replay(void)
+{
+  init();
+  struct TestState s = { 0.f, 1.f };
+  run(&s, 0, 100, true);
+  fuse(&s, 60, 0.2f);
+  run(&s, 100, 1, true);
+  // measurement without delay while the state at step 64 is being propagated:
+  // fused in the current state now, and at its time in the state being propagated
+  struct TestState before = s;
+  fuse(&s, 101, 0.3f);
+  bool now = s.z != before.z && h.rewinds == 1;
+  run(&s, 101, 30, true);
+  int k[3] = { 60, 101, 120 };
+  float z[3] = { 0.2f, 0.3f, 0.25f };
+  struct TestState ref = reference_n(131, 2, k, z);
+  bool kept = !h.replaying && close_to(&s, &ref);
+  // a later measurement before it does not erase it
+  fuse(&s, 120, 0.25f);
+  fuse(&s, 100, 0.3f);
+  run(&s, 131, 30, true);
+  int k2[4] = { 60, 100, 101, 120 };
+  float z2[4] = { 0.2f, 0.3f, 0.3f, 0.25f };
+  struct TestState ref2 = reference_n(161, 4, k2, z2);
+  ok(now && kept && !h.replaying && close_to(&s, &ref2) && h.meas_lost == 0,
+     "measurements without delay kept by the replays, z %f ref %f", s.z, ref2.z);
+}
+
+static void test_abort(void)
+{
+  init();
+  struct TestState s = { 0.f, 1.f };
+  run(&s, 0, 100, true);
+  fuse(&s, 40, 0.2f);
+  // without replay the oldest steps are overwritten by the new ones
+  run(&s, 100, 10, false);
+  struct TestState ref = reference(110, -1, 0.f);
+  bool replaced = ins_history_replay(&h, &s);
+  ok(!replaced && h.aborted == 1 && s.z == ref.z, "replay aborted when its steps are overwritten");
+}
+
+int main(int argc __attribute__((unused)), char **argv __attribute__((unused)))
+{
+  note("running ins history tests");
+  plan(6);
+
+  test_state_at();
+  test_delayed_fusion();
+  test_fusion_during_replay();
+  test_current_during_replay();
+  test_abort();
+
+  done_testing();
+}
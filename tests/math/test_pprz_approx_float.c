@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test_pprz_approx_float.c
+ * @brief Accuracy tests of the float approximations.
+ *
+ * Every function and tier is compared with libm in double precision on a dense
+ * grid, the bounds are the ones documented in pprz_approx_float.h.
+ *
+ * Using libtap to create a TAP (TestAnythingProtocol) producer:
+ * https://github.com/zorgnax/libtap
+ *
+ */
+
+#include "tap.h"
+
+#include <math.h>
+#include "math/pprz_algebra_float.h"
+#include "math/pprz_approx_float.h"
+
+#define TEST_STEPS 200000
+
+static void test_sincos(bool fast, double bound)
+{
+  double err_s = 0, err_c = 0;
+  for (int i = 0; i <= TEST_STEPS; i++) {
+    // most of the grid on [-2pi, 2pi] as in the filters, the rest up to 8192 rad
+    float x = (i % 4) ? -2 * M_PI + 4 * M_PI * i / TEST_STEPS : -8192. + 16384. * i / TEST_STEPS;
+    float s, c;
+    if (fast) {
+      float_approx_sincos_fast(x, &s, &c);
+    } else {
+      float_approx_sincos(x, &s, &c);
+    }
+    err_s = fmax(err_s, fabs(s - sin((double)x)));
+    err_c = fmax(err_c, fabs(c - cos((double)x)));
+  }
+  ok(err_s < bound && err_c < bound, "float_approx_sincos%s max error sin %g cos %g < %g", fast ? "_fast" : "",
+     err_s, err_c, bound);
+}
+
+static void test_atan2(bool fast, double bound)
+{
+  double err = 0;
+  for (int i = 0; i <= TEST_STEPS; i++) {
+    // around the unit circle, with a varying radius
+    double angle = -M_PI + 2 * M_PI * i / TEST_STEPS;
+    double r = 1e-3 + 1e3 * (i % 7);
+    float y = r * sin(angle);
+    float x = r * cos(angle);
+    float a = fast ? float_approx_atan2_fast(y, x) : float_approx_atan2(y, x);
+    err = fmax(err, fabs(a - atan2((double)y, (double)x)));
+  }
+  ok(err < bound && float_approx_atan2(0.f, 0.f) == 0.f, "float_approx_atan2%s max error %g < %g",
+     fast ? "_fast" : "", err, bound);
+}
+
+static void test_asin(bool fast, double bound)
+{
+  double err = 0;
+  for (int i = 0; i <= TEST_STEPS; i++) {
+    float x = -1. + 2. * i / TEST_STEPS;
+    float a = fast ? float_approx_asin_fast(x) : float_approx_asin(x);
+    err = fmax(err, fabs(a - asin((double)x)));
+  }
+  float out_of_range = fast ? float_approx_asin_fast(1.0001f) : float_approx_asin(1.0001f);
+  ok(err < bound && fabs(out_of_range - M_PI_2) < bound, "float_approx_asin%s max error %g < %g",
+     fast ? "_fast" : "", err, bound);
+}
+
+static void test_sqrt(bool fast, double bound)
+{
+  double err = 0;
+  for (int i = 1; i <= TEST_STEPS; i++) {
+    // relative error over many decades
+    float x = exp(-30. + 60. * i / TEST_STEPS);
+    float s = fast ? float_approx_sqrt_fast(x) : float_approx_sqrt(x);
+    float is = fast ? float_approx_invsqrt_fast(x) : float_approx_invsqrt(x);
+    double ref = sqrt((double)x);
+    err = fmax(err, fabs(s - ref) / ref);
+    err = fmax(err, fabs(is * ref - 1.));
+  }
+  float zero = fast ? float_approx_sqrt_fast(0.f) : float_approx_sqrt(0.f);
+  ok(err < bound && zero == 0.f, "float_approx_sqrt%s and invsqrt max relative error %g < %g",
+     fast ? "_fast" : "", err, bound);
+}
+
+/** Euler angles of random quaternions with the approximations of atan2 and asin */
+static void test_eulers_of_quat(bool fast, double bound)
+{
+  double err = 0;
+  srand(1);
+  for (int i = 0; i < 10000; i++) {
+    struct FloatEulers e = {
+      M_PI * (2. * rand() / RAND_MAX - 1.),
+      0.49 * M_PI * (2. * rand() / RAND_MAX - 1.),
+      M_PI * (2. * rand() / RAND_MAX - 1.)
+    };
+    struct FloatQuat q;
+    struct FloatRMat rm;
+    struct FloatEulers ref;
+    float_quat_of_eulers(&q, &e);
+    float_rmat_of_quat(&rm, &q);
+    float_eulers_of_rmat(&ref, &rm);
+    float phi = fast ? float_approx_atan2_fast(rm.m[5], rm.m[8]) : float_approx_atan2(rm.m[5], rm.m[8]);
+    float theta = fast ? -float_approx_asin_fast(rm.m[2]) : -float_approx_asin(rm.m[2]);
+    float psi = fast ? float_approx_atan2_fast(rm.m[1], rm.m[0]) : float_approx_atan2(rm.m[1], rm.m[0]);
+    err = fmax(err, fabs(phi - ref.phi));
+    err = fmax(err, fabs(theta - ref.theta));
+    err = fmax(err, fabs(psi - ref.psi));
+  }
+  ok(err < bound, "euler angles of quaternions with the %s tier, max error %g < %g", fast ? "fast" : "precise",
+     err, bound);
+}
+
+int main(int argc __attribute__((unused)), char **argv __attribute__((unused)))
+{
+  note("running float approximation tests");
+  plan(11);
+
+  test_sincos(false, 2e-7);
+  test_sincos(true, 2e-5);
+  test_atan2(false, 4e-7);
+  test_atan2(true, 4e-5);
+  test_asin(false, 3e-7);
+  test_asin(true, 8e-5);
+  test_sqrt(false, 2e-7);
+  test_sqrt(true, 5e-6);
+  test_eulers_of_quat(false, 1e-6);
+  test_eulers_of_quat(true, 1e-4);
+
+  // libm by default
+  ok(pprz_sinf(1.f) == sinf(1.f) && pprz_atan2f(1.f, 2.f) == atan2f(1.f, 2.f) && pprz_sqrtf(2.f) == sqrtf(2.f),
+     "pprz_sinf, pprz_atan2f and pprz_sqrtf call libm with PPRZ_MATH_APPROX = PPRZ_MATH_LIBM");
+
+  done_testing();
+}
@@ -29,6 +29,9 @@
 
 #include "tap.h"
 
+#include <float.h>
+#include <time.h>
+
 #include "math/pprz_geodetic_int.h"
 #include "math/pprz_geodetic_float.h"
 #include "math/pprz_geodetic_double.h"
@@ -376,10 +379,220 @@ static void test_lla_of_ecef(void)
   cmp_ok(lla_i.alt, "==", lla_ref_i.alt, "altitude (int) matches reference");
 }
 
+#define BATCH_N 1024
+#define BATCH_RUNS 50
+
+static double time_now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/** Points on a 32x32 grid of about 20km around toulouse */
+static void batch_lla_d(double *lat, double *lon, double *alt)
+{
+  for (int i = 0; i < BATCH_N; i++) {
+    lat[i] = RadOfDeg(43.5 + 0.006 * (i % 32));
+    lon[i] = RadOfDeg(1.3 + 0.008 * (i / 32));
+    alt[i] = 150. + (i % 7) * 10.;
+  }
+}
+
+/* The array versions share their per point code with the single point ones,
+ * only allow for a different rounding when the compiler contracts or vectorizes it.
+ */
+#define BATCH_CLOSE(_a, _b, _eps) (fabs((_a) - (_b)) <= (_eps) * (fabs(_b) + 1.))
+
+static void test_batch_float(void)
+{
+  note("--- batch conversions (float) vs. single point of %d points", BATCH_N);
+
+  static double lat_d[BATCH_N], lon_d[BATCH_N], alt_d[BATCH_N];
+  static float lat[BATCH_N], lon[BATCH_N], alt[BATCH_N];
+  static float x[BATCH_N], y[BATCH_N], z[BATCH_N], e[BATCH_N], n[BATCH_N], u[BATCH_N];
+  batch_lla_d(lat_d, lon_d, alt_d);
+  for (int i = 0; i < BATCH_N; i++) {
+    lat[i] = lat_d[i];
+    lon[i] = lon_d[i];
+    alt[i] = alt_d[i];
+  }
+  struct LlaCoorArray_f lla = {lat, lon, alt};
+  struct EcefCoorArray_f ecef = {x, y, z};
+  struct EnuCoorArray_f enu = {e, n, u};
+  struct UtmCoorArray_f utm = {n, e, u, 0};
+
+  int bad = 0;
+  ecef_of_lla_f_array(&ecef, &lla, BATCH_N);
+  for (int i = 0; i < BATCH_N; i++) {
+    struct LlaCoor_f l = {lat[i], lon[i], alt[i]};
+    struct EcefCoor_f r;
+    ecef_of_lla_f(&r, &l);
+    bad += !(BATCH_CLOSE(x[i], r.x, 2 * FLT_EPSILON) && BATCH_CLOSE(y[i], r.y, 2 * FLT_EPSILON)
+             && BATCH_CLOSE(z[i], r.z, 2 * FLT_EPSILON));
+  }
+  ok(bad == 0, "ecef_of_lla_f_array equals ecef_of_lla_f (%d points differ)", bad);
+
+  struct LtpDef_f ltp_def;
+  struct EcefCoor_f ref_coor = { 4624497.0 , 116475.0, 4376563.0};
+  ltp_def_from_ecef_f(&ltp_def, &ref_coor);
+  enu_of_ecef_point_f_array(&enu, &ltp_def, &ecef, BATCH_N);
+  bad = 0;
+  for (int i = 0; i < BATCH_N; i++) {
+    struct EcefCoor_f p = {x[i], y[i], z[i]};
+    struct EnuCoor_f r;
+    enu_of_ecef_point_f(&r, &ltp_def, &p);
+    bad += !(BATCH_CLOSE(e[i], r.x, 2 * FLT_EPSILON) && BATCH_CLOSE(n[i], r.y, 2 * FLT_EPSILON)
+             && BATCH_CLOSE(u[i], r.z, 2 * FLT_EPSILON));
+  }
+  ok(bad == 0, "enu_of_ecef_point_f_array equals enu_of_ecef_point_f (%d points differ)", bad);
+
+  utm_of_lla_f_array(&utm, &lla, BATCH_N);
+  bad = 0;
+  for (int i = 0; i < BATCH_N; i++) {
+    struct LlaCoor_f l = {lat[i], lon[i], alt[i]};
+    struct UtmCoor_f r = {.zone = utm.zone};
+    utm_of_lla_f(&r, &l);
+    bad += !(BATCH_CLOSE(n[i], r.north, 2 * FLT_EPSILON) && BATCH_CLOSE(e[i], r.east, 2 * FLT_EPSILON)
+             && u[i] == r.alt);
+  }
+  ok(bad == 0 && utm.zone == 31, "utm_of_lla_f_array equals utm_of_lla_f in zone %d (%d points differ)", utm.zone, bad);
+
+  /* throughput of the single point and the array versions */
+  double t0 = time_now();
+  for (int k = 0; k < BATCH_RUNS; k++) {
+    for (int i = 0; i < BATCH_N; i++) {
+      struct LlaCoor_f l = {lat[i], lon[i], alt[i]};
+      struct EcefCoor_f r;
+      ecef_of_lla_f(&r, &l);
+      x[i] = r.x;
+      y[i] = r.y;
+      z[i] = r.z;
+    }
+  }
+  double t1 = time_now();
+  for (int k = 0; k < BATCH_RUNS; k++) {
+    ecef_of_lla_f_array(&ecef, &lla, BATCH_N);
+  }
+  double t2 = time_now();
+  for (int k = 0; k < BATCH_RUNS; k++) {
+    for (int i = 0; i < BATCH_N; i++) {
+      struct LlaCoor_f l = {lat[i], lon[i], alt[i]};
+      struct UtmCoor_f r = {.zone = utm.zone};
+      utm_of_lla_f(&r, &l);
+      n[i] = r.north;
+      e[i] = r.east;
+    }
+  }
+  double t3 = time_now();
+  for (int k = 0; k < BATCH_RUNS; k++) {
+    utm_of_lla_f_array(&utm, &lla, BATCH_N);
+  }
+  double t4 = time_now();
+  const double ns = 1e9 / (BATCH_RUNS * BATCH_N);
+  note("ecef_of_lla_f: %.1f ns/point, array: %.1f ns/point", (t1 - t0) * ns, (t2 - t1) * ns);
+  note("utm_of_lla_f: %.1f ns/point, array: %.1f ns/point", (t3 - t2) * ns, (t4 - t3) * ns);
+}
+
+static void test_batch_double(void)
+{
+  note("--- batch conversions (double) vs. single point of %d points", BATCH_N);
+
+  static double lat[BATCH_N], lon[BATCH_N], alt[BATCH_N];
+  static double x[BATCH_N], y[BATCH_N], z[BATCH_N], e[BATCH_N], n[BATCH_N], u[BATCH_N];
+  batch_lla_d(lat, lon, alt);
+  struct LlaCoorArray_d lla = {lat, lon, alt};
+  struct EcefCoorArray_d ecef = {x, y, z};
+  struct EnuCoorArray_d enu = {e, n, u};
+  struct UtmCoorArray_d utm = {n, e, u, 0};
+
+  int bad = 0;
+  ecef_of_lla_d_array(&ecef, &lla, BATCH_N);
+  for (int i = 0; i < BATCH_N; i++) {
+    struct LlaCoor_d l = {lat[i], lon[i], alt[i]};
+    struct EcefCoor_d r;
+    ecef_of_lla_d(&r, &l);
+    bad += !(BATCH_CLOSE(x[i], r.x, 2 * DBL_EPSILON) && BATCH_CLOSE(y[i], r.y, 2 * DBL_EPSILON)
+             && BATCH_CLOSE(z[i], r.z, 2 * DBL_EPSILON));
+  }
+  ok(bad == 0, "ecef_of_lla_d_array equals ecef_of_lla_d (%d points differ)", bad);
+
+  struct LtpDef_d ltp_def;
+  struct EcefCoor_d ref_coor = { 4624497.0 , 116475.0, 4376563.0};
+  ltp_def_from_ecef_d(&ltp_def, &ref_coor);
+  enu_of_ecef_point_d_array(&enu, &ltp_def, &ecef, BATCH_N);
+  bad = 0;
+  for (int i = 0; i < BATCH_N; i++) {
+    struct EcefCoor_d p = {x[i], y[i], z[i]};
+    struct EnuCoor_d r;
+    enu_of_ecef_point_d(&r, &ltp_def, &p);
+    bad += !(BATCH_CLOSE(e[i], r.x, 2 * DBL_EPSILON) && BATCH_CLOSE(n[i], r.y, 2 * DBL_EPSILON)
+             && BATCH_CLOSE(u[i], r.z, 2 * DBL_EPSILON));
+  }
+  ok(bad == 0, "enu_of_ecef_point_d_array equals enu_of_ecef_point_d (%d points differ)", bad);
+
+  utm_of_lla_d_array(&utm, &lla, BATCH_N);
+  bad = 0;
+  for (int i = 0; i < BATCH_N; i++) {
+    struct LlaCoor_d l = {lat[i], lon[i], alt[i]};
+    struct UtmCoor_d r = {.zone = utm.zone};
+    utm_of_lla_d(&r, &l);
+    bad += !(BATCH_CLOSE(n[i], r.north, 2 * DBL_EPSILON) && BATCH_CLOSE(e[i], r.east, 2 * DBL_EPSILON)
+             && u[i] == r.alt);
+  }
+  ok(bad == 0 && utm.zone == 31, "utm_of_lla_d_array equals utm_of_lla_d in zone %d (%d points differ)", utm.zone, bad);
+
+  double t0 = time_now();
+  for (int k = 0; k < BATCH_RUNS; k++) {
+    for (int i = 0; i < BATCH_N; i++) {
+      struct LlaCoor_d l = {lat[i], lon[i], alt[i]};
+      struct EcefCoor_d r;
+      ecef_of_lla_d(&r, &l);
+      x[i] = r.x;
+      y[i] = r.y;
+      z[i] = r.z;
+    }
+  }
+  double t1 = time_now();
+  for (int k = 0; k < BATCH_RUNS; k++) {
+    ecef_of_lla_d_array(&ecef, &lla, BATCH_N);
+  }
+  double t2 = time_now();
+  const double ns = 1e9 / (BATCH_RUNS * BATCH_N);
+  note("ecef_of_lla_d: %.1f ns/point, array: %.1f ns/point", (t1 - t0) * ns, (t2 - t1) * ns);
+}
+
+static void test_batch_int(void)
+{
+  note("--- batch enu_of_ecef (int) vs. single point of %d points", BATCH_N);
+
+  static int32_t x[BATCH_N], y[BATCH_N], z[BATCH_N], e[BATCH_N], n[BATCH_N], u[BATCH_N];
+  struct EcefCoor_i ref_coor = { 462449700, 11647500, 437656300};
+  struct LtpDef_i ltp_def;
+  ltp_def_from_ecef_i(&ltp_def, &ref_coor);
+  for (int i = 0; i < BATCH_N; i++) {
+    x[i] = ref_coor.x + (i % 32 - 16) * 50000;
+    y[i] = ref_coor.y + (i / 32 - 16) * 50000;
+    z[i] = ref_coor.z + (i % 13 - 6) * 30000;
+  }
+  struct EcefCoorArray_i ecef = {x, y, z};
+  struct EnuCoorArray_i enu = {e, n, u};
+  enu_of_ecef_point_i_array(&enu, &ltp_def, &ecef, BATCH_N);
+
+  int bad = 0;
+  for (int i = 0; i < BATCH_N; i++) {
+    struct EcefCoor_i p = {x[i], y[i], z[i]};
+    struct EnuCoor_i r;
+    enu_of_ecef_point_i(&r, &ltp_def, &p);
+    bad += (e[i] != r.x || n[i] != r.y || u[i] != r.z);
+  }
+  ok(bad == 0, "enu_of_ecef_point_i_array equals enu_of_ecef_point_i (%d points differ)", bad);
+}
+
 int main()
 {
   note("runing geodetic math tests");
-  plan(13);
+  plan(20);
 
   test_ecef_of_ned_int();
   test_enu_of_ecef_int();
@@ -387,6 +600,9 @@ int main()
   test_ecef_to_enu_to_ecef_float();
   test_lla_of_utm();
   test_lla_of_ecef();
+  test_batch_float();
+  test_batch_double();
+  test_batch_int();
 
   done_testing();
 }
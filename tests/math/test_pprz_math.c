@@ -34,7 +34,7 @@
 int main()
 {
   note("running algebra math tests");
-  plan(3);
+  plan(5);
 
   /* test int32_vect2_normalize */
   struct Int32Vect2 v = {2300, -4200};
@@ -57,6 +57,23 @@ int main()
   ok((fabs(quat_zxy.qi - 0.9266) < 0.01 && fabs(quat_zxy.qx - -0.2317) < 0.01 && fabs(quat_zxy.qy - 0.1165) < 0.01) && fabs(quat_zxy.qz - 0.2722),
      "float_quat_of_eulers_zxy(float_eulers_of_quat_zxy(0.9266,   -0.2317,    0.1165,    0.2722)) returned [%f, %f, %f, %f]", quat_zxy.qi, quat_zxy.qx, quat_zxy.qy, quat_zxy.qz);
 
+  /* test float_quat_slerp: halfway between 0 and 90 deg yaw is 45 deg yaw */
+  struct FloatEulers e1 = {0.1, -0.2, 0.f}, e2 = {0.1, -0.2, M_PI_2};
+  struct FloatQuat q1, q2, q_mid;
+  struct FloatEulers e_mid;
+  float_quat_of_eulers(&q1, &e1);
+  float_quat_of_eulers(&q2, &e2);
+  float_quat_slerp(&q_mid, &q1, &q2, 0.5f);
+  float_eulers_of_quat(&e_mid, &q_mid);
+  ok(fabs(e_mid.phi - 0.1) < 1e-4 && fabs(e_mid.theta - -0.2) < 1e-4 && fabs(e_mid.psi - M_PI_4) < 1e-4,
+     "float_quat_slerp(yaw 0, yaw 90, 0.5) returned [%f, %f, %f]", e_mid.phi, e_mid.theta, e_mid.psi);
+
+  /* the explementary quaternion is the same rotation, slerp should take the shortest path */
+  QUAT_EXPLEMENTARY(q2, q2);
+  float_quat_slerp(&q_mid, &q1, &q2, 0.5f);
+  float_eulers_of_quat(&e_mid, &q_mid);
+  ok(fabs(e_mid.phi - 0.1) < 1e-4 && fabs(e_mid.theta - -0.2) < 1e-4 && fabs(e_mid.psi - M_PI_4) < 1e-4,
+     "float_quat_slerp(yaw 0, -(yaw 90), 0.5) returned [%f, %f, %f]", e_mid.phi, e_mid.theta, e_mid.psi);
 
   done_testing();
 }
@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test_pprz_matrix_fixed.c
+ * @brief Tests for the fixed size matrix kernels.
+ *
+ * The fixed size kernels are compared to the generic matrix functions.
+ *
+ * Using libtap to create a TAP (TestAnythingProtocol) producer:
+ * https://github.com/zorgnax/libtap
+ *
+ */
+
+#include "tap.h"
+
+#include <stdlib.h>
+#include "math/pprz_algebra_float.h"
+#include "math/pprz_simple_matrix.h"
+#include "math/pprz_matrix_decomp_float.h"
+#include "math/pprz_matrix_fixed_float.h"
+
+#define TEST_EPS 1e-5
+
+static void rand_mat(float *a, int n)
+{
+  for (int i = 0; i < n; i++) {
+    a[i] = 2.f * rand() / (float)RAND_MAX - 1.f;
+  }
+}
+
+/** Largest difference relative to the largest element of b */
+static float max_diff(float *a, float *b, int n)
+{
+  float diff = 0.f, norm = 1e-30f;
+  for (int i = 0; i < n; i++) {
+    diff = Max(diff, fabsf(a[i] - b[i]));
+    norm = Max(norm, fabsf(b[i]));
+  }
+  return diff / norm;
+}
+
+/** Random symmetric positive definite matrix a = m * m' + n * I */
+static void rand_spd(float *a, int n)
+{
+  float m[n][n];
+  rand_mat(m[0], n * n);
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      a[i * n + j] = 0.f;
+      for (int k = 0; k < n; k++) {
+        a[i * n + j] += m[i][k] * m[j][k];
+      }
+    }
+  }
+  for (int i = 0; i < n; i++) {
+    a[i * n + i] += n;
+  }
+}
+
+#define TEST_SQUARE(_n)                                                                             \
+  static void test_square_##_n(void)                                                                \
+  {                                                                                                 \
+    float a[_n][_n], b[_n][_n], o[_n][_n], ref[_n][_n], s[_n][_n], L[_n][_n];                       \
+    rand_mat(a[0], _n * _n);                                                                        \
+    rand_mat(b[0], _n * _n);                                                                        \
+                                                                                                    \
+    float_mat_fixed_mul(o[0], a[0], b[0], _n, _n, _n);                                              \
+    MAT_MUL(_n, _n, _n, ref, a, b);                                                                 \
+    float err_mul = max_diff(o[0], ref[0], _n * _n);                                                \
+    ok(err_mul < TEST_EPS, "float_mat_fixed_mul %dx%d equal to MAT_MUL (%g)", _n, _n, err_mul);     \
+                                                                                                    \
+    /* Cholesky compared with pprz_cholesky_float and used to solve s * x = v */                    \
+    rand_spd(s[0], _n);                                                                             \
+    MAKE_MATRIX_PTR(s_ptr, s, _n);                                                                  \
+    MAKE_MATRIX_PTR(ref_ptr, ref, _n);                                                              \
+    pprz_cholesky_float(ref_ptr, s_ptr, _n);                                                        \
+    bool pd = float_mat_fixed_cholesky(L[0], s[0], _n);                                             \
+    float err_chol = max_diff(L[0], ref[0], _n * _n);                                               \
+    float v[_n], x[_n], sx[_n];                                                                     \
+    rand_mat(v, _n);                                                                                \
+    float_mat_fixed_cholesky_solve(x, L[0], v, _n, 1);                                              \
+    MAT_MUL_VECT(_n, sx, s, x);                                                                     \
+    float err_solve = max_diff(sx, v, _n);                                                          \
+    s[0][0] = -1.f;                                                                                 \
+    bool not_pd = !float_mat_fixed_cholesky(L[0], s[0], _n);                                        \
+    ok(pd && not_pd && err_chol < TEST_EPS && err_solve < 10 * TEST_EPS,                            \
+       "float_mat_fixed_cholesky %dx%d equal to pprz_cholesky_float (%g), solve error %g",          \
+       _n, _n, err_chol, err_solve);                                                                \
+                                                                                                    \
+    /* SVD: u * diag(w) * v' gives a again, u and v are orthogonal */                               \
+    float w[_n], V[_n][_n], U[_n][_n], UW[_n][_n], I[_n][_n], id[_n][_n];                           \
+    memcpy(U, a, sizeof(U));                                                                        \
+    int converged = float_mat_fixed_svd(U[0], w, V[0], _n, _n);                                     \
+    for (int i = 0; i < _n; i++) {                                                                  \
+      for (int j = 0; j < _n; j++) {                                                                \
+        UW[i][j] = U[i][j] * w[j];                                                                  \
+        id[i][j] = (i == j);                                                                        \
+      }                                                                                             \
+    }                                                                                               \
+    MAT_MUL_T(_n, _n, _n, o, UW, V);                                                                \
+    float err_svd = max_diff(o[0], a[0], _n * _n);                                                  \
+    MAT_MUL_T(_n, _n, _n, I, U, U);                                                                 \
+    float err_u = max_diff(I[0], id[0], _n * _n);                                                   \
+    MAT_MUL_T(_n, _n, _n, I, V, V);                                                                 \
+    float err_v = max_diff(I[0], id[0], _n * _n);                                                   \
+    ok(converged && err_svd < 10 * TEST_EPS && err_u < 10 * TEST_EPS && err_v < 10 * TEST_EPS,      \
+       "float_mat_fixed_svd %dx%d reconstruction error %g, orthogonality %g %g",                    \
+       _n, _n, err_svd, err_u, err_v);                                                              \
+  }
+
+TEST_SQUARE(3)
+TEST_SQUARE(4)
+TEST_SQUARE(6)
+TEST_SQUARE(9)
+
+/** Least squares fit with a variable number of rows, as in linear_flow_fit */
+static void test_svd_solve(void)
+{
+  const int m = 20;
+  float a[m][3], a_ref[m][3], b[m][1], x[3][1], x_ref[3][1], w[3], w_ref[3], v[3][3], v_ref[3][3];
+  for (int i = 0; i < m; i++) {
+    a[i][0] = rand() % 320;
+    a[i][1] = rand() % 240;
+    a[i][2] = 1.f;
+    b[i][0] = 0.02f * a[i][0] - 0.01f * a[i][1] + 3.f + (rand() % 100) * 0.001f;
+  }
+  memcpy(a_ref, a, sizeof(a));
+  MAKE_MATRIX_PTR(a_ptr, a, m);
+  MAKE_MATRIX_PTR(a_ref_ptr, a_ref, m);
+  MAKE_MATRIX_PTR(b_ptr, b, m);
+  MAKE_MATRIX_PTR(x_ptr, x, 3);
+  MAKE_MATRIX_PTR(x_ref_ptr, x_ref, 3);
+  MAKE_MATRIX_PTR(v_ptr, v, 3);
+  MAKE_MATRIX_PTR(v_ref_ptr, v_ref, 3);
+
+  pprz_svd_float(a_ref_ptr, w_ref, v_ref_ptr, m, 3);
+  pprz_svd_solve_float(x_ref_ptr, a_ref_ptr, w_ref, v_ref_ptr, b_ptr, m, 3, 1);
+  int converged = float_mat_fixed_svd(a[0], w, v[0], m, 3);
+  pprz_svd_solve_float(x_ptr, a_ptr, w, v_ptr, b_ptr, m, 3, 1);
+
+  float err = max_diff(x[0], x_ref[0], 3);
+  ok(converged && err < 1e-3, "float_mat_fixed_svd [%d x 3] least squares [%f, %f, %f] equal to pprz_svd_float (%g)",
+     m, x[0][0], x[1][0], x[2][0], err);
+}
+
+int main(int argc __attribute__((unused)), char **argv __attribute__((unused)))
+{
+  note("running fixed size matrix tests");
+  plan(13);
+
+  srand(42);
+  test_square_3();
+  test_square_4();
+  test_square_6();
+  test_square_9();
+  test_svd_solve();
+
+  done_testing();
+}
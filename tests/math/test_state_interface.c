@@ -32,6 +32,7 @@
 #include "tap.h"
 #include "state.h"
 #include "math/pprz_geodetic_double.h"
+#include <string.h>
 
 static void test_pos_lla_i(void)
 {
@@ -75,14 +76,180 @@ static void test_pos_lla_i(void)
   }
 }
 
+static void set_local_origin(void)
+{
+  struct LlaCoor_i lla_origin = {.lat = 429722000, .lon = 11459000, .alt = 185000};
+  struct LtpDef_i ltp_def;
+  ltp_def_from_lla_i(&ltp_def, &lla_origin);
+  ltp_def.hmsl = 135000;
+  stateSetLocalOrigin_i(&ltp_def);
+}
+
+static void test_pos_ecef_of_ned_f(void)
+{
+  set_local_origin();
+
+  struct NedCoor_f ned = {.x = 153.2, .y = -97.4, .z = -42.7};
+  struct EcefCoor_f ecef_ref;
+  ecef_of_ned_point_f(&ecef_ref, &state.ned_origin_f, &ned);
+
+  stateSetPositionNed_f(&ned);
+  struct EcefCoor_f *ecef = stateGetPositionEcef_f();
+  ok(ecef->x == ecef_ref.x && ecef->y == ecef_ref.y && ecef->z == ecef_ref.z,
+     "stateGetPositionEcef_f() from ned_f with the precomputed rotation equals ecef_of_ned_point_f()");
+}
+
+#define POS_ALL_MASK ((1 << POS_ECEF_I) | (1 << POS_NED_I) | (1 << POS_ENU_I) | (1 << POS_LLA_I) | \
+                      (1 << POS_ECEF_F) | (1 << POS_NED_F) | (1 << POS_ENU_F) | (1 << POS_LLA_F) | (1 << POS_UTM_F))
+
+#define CLOSE_VECT3(_a, _b, _err) (fabsf((_a).x - (_b).x) < (_err) && fabsf((_a).y - (_b).y) < (_err) && \
+                                   fabsf((_a).z - (_b).z) < (_err))
+
+/** Compare all representations computed by stateCalcPositions with the ones of the single getters */
+static void test_calc_positions(void (*set_position)(void), const char *name)
+{
+  struct EcefCoor_f ecef_f;
+  struct NedCoor_f ned_f;
+  struct EnuCoor_f enu_f;
+  struct LlaCoor_f lla_f;
+  struct UtmCoor_f utm_f = {.zone = 0};
+  set_position();
+  ecef_f = *stateGetPositionEcef_f();
+  set_position();
+  ned_f = *stateGetPositionNed_f();
+  set_position();
+  enu_f = *stateGetPositionEnu_f();
+  set_position();
+  lla_f = *stateGetPositionLla_f();
+  utm_of_lla_f(&utm_f, &lla_f);
+  set_position();
+  struct LlaCoor_i lla_i = *stateGetPositionLla_i();
+
+  set_position();
+  stateCalcPositions(POS_ALL_MASK);
+  bool all_set = (state.pos_status & POS_ALL_MASK) == POS_ALL_MASK;
+
+  /* the float paths may differ, float ECEF has a resolution of 0.5m, the integer LLA keeps its path */
+  struct FloatVect3 utm_ref = {utm_f.east, utm_f.north, utm_f.alt};
+  struct FloatVect3 utm = {state.utm_pos_f.east, state.utm_pos_f.north, state.utm_pos_f.alt};
+  struct FloatVect3 ned_i_f;
+  NED_FLOAT_OF_BFP(ned_i_f, state.ned_pos_i);
+  bool same = CLOSE_VECT3(state.ecef_pos_f, ecef_f, 1.f) && CLOSE_VECT3(state.ned_pos_f, ned_f, 1.f)
+              && CLOSE_VECT3(state.enu_pos_f, enu_f, 1.f) && CLOSE_VECT3(utm, utm_ref, 1.f)
+              && CLOSE_VECT3(ned_i_f, ned_f, 1.f)
+              && fabsf(state.lla_pos_f.lat - lla_f.lat) < 1e-6 && fabsf(state.lla_pos_f.lon - lla_f.lon) < 1e-6
+              && state.lla_pos_i.lat == lla_i.lat && state.lla_pos_i.lon == lla_i.lon
+              && state.lla_pos_i.alt == lla_i.alt;
+  ok(all_set && same, "stateCalcPositions() from %s computes the same representations as the single getters", name);
+}
+
+static void set_position_ned_f(void)
+{
+  struct NedCoor_f ned = {.x = -312.5, .y = 1204.3, .z = -87.1};
+  stateSetPositionNed_f(&ned);
+}
+
+static void set_position_lla_f(void)
+{
+  struct LlaCoor_f lla = {.lat = RadOfDeg(42.9751), .lon = RadOfDeg(1.1385), .alt = 243.0};
+  stateSetPositionLla_f(&lla);
+}
+
+static void test_pos_lla_f_of_lla_i(void)
+{
+  struct LlaCoor_i lla_i = {.lat = 429751000, .lon = 11385000, .alt = 243000};
+  struct LlaCoor_f lla_ref;
+  LLA_FLOAT_OF_BFP(lla_ref, lla_i);
+  stateSetPositionLla_i(&lla_i);
+  struct LlaCoor_f *lla_f = stateGetPositionLla_f();
+  ok(lla_f->lat == lla_ref.lat && lla_f->lon == lla_ref.lon && lla_f->alt == lla_ref.alt,
+     "stateGetPositionLla_f() from lla_i");
+}
+
+static void set_attitude(int n)
+{
+  struct FloatEulers e = {0.1 * n, -0.05 * n, 0.3 * n};
+  struct FloatQuat q;
+  float_quat_of_eulers(&q, &e);
+  stateSetNedToBodyQuat_f(&q);
+}
+
+/** Several consumers read the body attitude between the updates, each representation is converted once */
+static void test_attitude_conversions_per_update(void)
+{
+  struct OrientationStats *stats = &state.ned_to_body_orientation.stats;
+  memset(stats, 0, sizeof(*stats));
+  uint32_t gen = stateGetNedToBodyGeneration();
+
+  const int updates = 100;
+  for (int n = 0; n < updates; n++) {
+    set_attitude(n);
+    // stabilization, navigation and telemetry
+    for (int c = 0; c < 3; c++) {
+      stateGetNedToBodyQuat_i();
+      stateGetNedToBodyRMat_i();
+      stateGetNedToBodyEulers_f();
+      stateGetNedToBodyRMat_f();
+    }
+    stateGetNedToBodyEulers_i();
+  }
+
+  uint32_t conversions = 0;
+  for (int i = 0; i < ORREP_NB; i++) {
+    conversions += stats->conversions[i];
+  }
+  note("%d updates: %u reads, %u conversions, max %d per update", updates, stats->gets, conversions,
+       stats->max_gen_conversions);
+  ok(stateGetNedToBodyGeneration() - gen == (uint32_t)updates && stats->sets == (uint32_t)updates
+     && stats->gets == 13u * updates && conversions == 5u * updates && stats->max_gen_conversions == 5
+     && stats->conversions[ORREP_QUAT_F] == 0,
+     "body attitude representations are converted at most once per update");
+}
+
+/** Compare all representations computed by stateCalcNedToBody with the ones of the single getters */
+static void test_calc_ned_to_body(void)
+{
+  struct OrientationStats *stats = &state.ned_to_body_orientation.stats;
+  set_attitude(7);
+  struct Int32Quat quat_i = *stateGetNedToBodyQuat_i();
+  set_attitude(7);
+  struct FloatRMat rmat_f = *stateGetNedToBodyRMat_f();
+  set_attitude(7);
+  struct FloatEulers eulers_f = *stateGetNedToBodyEulers_f();
+  set_attitude(7);
+  struct Int32RMat rmat_i = *stateGetNedToBodyRMat_i();
+
+  set_attitude(7);
+  stats->gen_conversions = 0;
+  stateCalcNedToBody(ORREP_ALL_MASK);
+  struct OrientationReps *o = &state.ned_to_body_orientation;
+  /* the integer rotation matrix is a copy of the float one instead of int32_rmat_of_quat */
+  bool same_rmat_i = true;
+  for (int i = 0; i < 9; i++) {
+    same_rmat_i &= abs(o->rmat_i.m[i] - rmat_i.m[i]) <= 2;
+  }
+  bool same = (memcmp(&o->quat_i, &quat_i, sizeof(quat_i)) == 0 && same_rmat_i
+               && memcmp(&o->rmat_f, &rmat_f, sizeof(rmat_f)) == 0
+               && fabsf(o->eulers_f.phi - eulers_f.phi) < 1e-6 && fabsf(o->eulers_f.theta - eulers_f.theta) < 1e-6
+               && fabsf(o->eulers_f.psi - eulers_f.psi) < 1e-6);
+  ok(o->status == ORREP_ALL_MASK && stats->gen_conversions == 5 && same,
+     "stateCalcNedToBody() computes all body attitude representations with one conversion each");
+}
+
 int main()
 {
   note("\n *** running state interface tests ***");
-  plan(1);
+  plan(7);
 
   stateInit();
 
   test_pos_lla_i();
+  test_pos_ecef_of_ned_f();
+  test_calc_positions(set_position_ned_f, "ned_f");
+  test_calc_positions(set_position_lla_f, "lla_f");
+  test_pos_lla_f_of_lla_i();
+  test_attitude_conversions_per_update();
+  test_calc_ned_to_body();
 
   done_testing();
 }
@@ -0,0 +1,304 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test_wls_alloc.c
+ * @brief Tests for the WLS control allocation.
+ *
+ * The active set solution is compared to a brute force reference in double,
+ * which solves the equality constrained problem of every possible working set
+ * and keeps the best feasible one. With the weights of the INDI controller the
+ * float solver only determines the inputs in the null space of B (which only
+ * affect the preferred control cost) to a few percent, so the control objective
+ * is compared.
+ *
+ * Using libtap to create a TAP (TestAnythingProtocol) producer:
+ * https://github.com/zorgnax/libtap
+ *
+ */
+
+#include "tap.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "std.h"
+#include "firmwares/rotorcraft/stabilization/wls/wls_alloc.h"
+
+#define TEST_PROBLEMS 500
+#define TEST_GAMMA_SQ 10000
+#define TEST_MAX_PPRZ 9600
+
+struct wls_problem {
+  int n_u;
+  float B[WLS_N_V][WLS_N_U];
+  float *B_ptr[WLS_N_V];
+  float v[WLS_N_V];
+  float umin[WLS_N_U];
+  float umax[WLS_N_U];
+  float up[WLS_N_U];
+};
+
+static float Wv[WLS_N_V] = {1000, 1000, 1, 100};
+
+static double randu(double min, double max)
+{
+  return min + (max - min) * rand() / (double)RAND_MAX;
+}
+
+/** Multirotor with n_u rotors, the actuator state and the control objective are random */
+static void make_problem(struct wls_problem *p, int n_u)
+{
+  p->n_u = n_u;
+  for (int i = 0; i < n_u; i++) {
+    double angle = 2 * M_PI * (i + 0.5) / n_u;
+    p->B[0][i] = -0.003 * sin(angle) * randu(0.8, 1.2);
+    p->B[1][i] = 0.003 * cos(angle) * randu(0.8, 1.2);
+    p->B[2][i] = ((i % 2) ? 0.0005 : -0.0005) * randu(0.8, 1.2);
+    p->B[3][i] = -0.001 * randu(0.8, 1.2);
+    float state = randu(0, TEST_MAX_PPRZ);
+    p->umin[i] = -state;
+    p->umax[i] = TEST_MAX_PPRZ - state;
+    p->up[i] = -state;
+  }
+  for (int i = 0; i < WLS_N_V; i++) {
+    p->B_ptr[i] = p->B[i];
+  }
+  p->v[0] = randu(-40, 40);
+  p->v[1] = randu(-40, 40);
+  p->v[2] = randu(-10, 10);
+  p->v[3] = randu(-5, 5);
+}
+
+/** Weighted cost of the WLS problem */
+static double wls_cost(struct wls_problem *p, double *u)
+{
+  double cost = 0;
+  for (int i = 0; i < WLS_N_V; i++) {
+    double e = -p->v[i];
+    for (int j = 0; j < p->n_u; j++) {
+      e += p->B[i][j] * u[j];
+    }
+    cost += TEST_GAMMA_SQ * TEST_GAMMA_SQ * Wv[i] * Wv[i] * e * e;
+  }
+  for (int j = 0; j < p->n_u; j++) {
+    cost += (u[j] - p->up[j]) * (u[j] - p->up[j]);
+  }
+  return cost;
+}
+
+/** Solve the unconstrained problem in the free variables with the normal equations */
+static void solve_free(struct wls_problem *p, int *W, double *u)
+{
+  int n_u = p->n_u;
+  double M[WLS_N_U][WLS_N_U + 1];
+  for (int i = 0; i < n_u; i++) {
+    for (int j = 0; j < n_u; j++) {
+      M[i][j] = (i == j) ? 1 : 0;
+    }
+    M[i][n_u] = p->up[i];
+    for (int k = 0; k < WLS_N_V; k++) {
+      double w = (double)TEST_GAMMA_SQ * TEST_GAMMA_SQ * Wv[k] * Wv[k];
+      for (int j = 0; j < n_u; j++) {
+        M[i][j] += w * p->B[k][i] * p->B[k][j];
+      }
+      M[i][n_u] += w * p->B[k][i] * p->v[k];
+    }
+  }
+  // fixed variables are replaced by the identity
+  for (int i = 0; i < n_u; i++) {
+    if (W[i] != 0) {
+      u[i] = (W[i] > 0) ? p->umax[i] : p->umin[i];
+      for (int r = 0; r < n_u; r++) {
+        if (W[r] == 0) {
+          M[r][n_u] -= M[r][i] * u[i];
+        }
+        M[r][i] = 0;
+        M[i][r] = 0;
+      }
+      M[i][i] = 1;
+      M[i][n_u] = u[i];
+    }
+  }
+  // Gauss elimination with partial pivoting
+  for (int c = 0; c < n_u; c++) {
+    int piv = c;
+    for (int r = c + 1; r < n_u; r++) {
+      if (fabs(M[r][c]) > fabs(M[piv][c])) {
+        piv = r;
+      }
+    }
+    for (int j = 0; j <= n_u; j++) {
+      double tmp = M[c][j];
+      M[c][j] = M[piv][j];
+      M[piv][j] = tmp;
+    }
+    for (int r = c + 1; r < n_u; r++) {
+      double f = M[r][c] / M[c][c];
+      for (int j = c; j <= n_u; j++) {
+        M[r][j] -= f * M[c][j];
+      }
+    }
+  }
+  for (int i = n_u - 1; i >= 0; i--) {
+    u[i] = M[i][n_u];
+    for (int j = i + 1; j < n_u; j++) {
+      u[i] -= M[i][j] * u[j];
+    }
+    u[i] /= M[i][i];
+  }
+}
+
+/** Best feasible solution over all 3^n_u working sets */
+static double solve_reference(struct wls_problem *p, double *u_best)
+{
+  double best = INFINITY;
+  int n_sets = 1;
+  for (int i = 0; i < p->n_u; i++) {
+    n_sets *= 3;
+  }
+  for (int s = 0; s < n_sets; s++) {
+    int W[WLS_N_U];
+    double u[WLS_N_U];
+    for (int i = 0, k = s; i < p->n_u; i++, k /= 3) {
+      W[i] = k % 3 - 1;
+    }
+    solve_free(p, W, u);
+    bool feasible = true;
+    for (int i = 0; i < p->n_u; i++) {
+      feasible &= (u[i] <= p->umax[i] + 1e-3 && u[i] >= p->umin[i] - 1e-3);
+    }
+    double cost = wls_cost(p, u);
+    if (feasible && cost < best) {
+      best = cost;
+      memcpy(u_best, u, p->n_u * sizeof(double));
+    }
+  }
+  return best;
+}
+
+static int solve_wls(struct wls_problem *p, float *u, float *W)
+{
+  return wls_alloc(u, p->v, p->umin, p->umax, p->B_ptr, p->n_u, WLS_N_V, 0, W, Wv, 0, p->up, TEST_GAMMA_SQ, 100);
+}
+
+/** Weighted error on the control objective */
+static double objective_error(struct wls_problem *p, double *u)
+{
+  double err = 0;
+  for (int i = 0; i < WLS_N_V; i++) {
+    double e = -p->v[i];
+    for (int j = 0; j < p->n_u; j++) {
+      e += p->B[i][j] * u[j];
+    }
+    err += Wv[i] * Wv[i] * e * e;
+  }
+  return sqrt(err);
+}
+
+/** Largest difference of the objective error and the inputs to the reference */
+static void compare_reference(struct wls_problem *p, float *u, double *obj_err, double *u_err)
+{
+  double u_ref[WLS_N_U], u_d[WLS_N_U];
+  solve_reference(p, u_ref);
+  for (int i = 0; i < p->n_u; i++) {
+    u_d[i] = u[i];
+    if (fabs(u_d[i] - u_ref[i]) > *u_err) {
+      *u_err = fabs(u_d[i] - u_ref[i]);
+    }
+  }
+  double err = objective_error(p, u_d) - objective_error(p, u_ref);
+  if (err > *obj_err) {
+    *obj_err = err;
+  }
+}
+
+static void test_reference(int n_u)
+{
+  struct wls_problem p;
+  int failed = 0, max_iter = 0;
+  double obj_err = 0, u_err = 0;
+
+  srand(n_u);
+  for (int n = 0; n < TEST_PROBLEMS; n++) {
+    make_problem(&p, n_u);
+    float u[WLS_N_U];
+    int iter = solve_wls(&p, u, NULL);
+    if (iter < 0) {
+      failed++;
+      continue;
+    }
+    max_iter = (iter > max_iter) ? iter : max_iter;
+    compare_reference(&p, u, &obj_err, &u_err);
+  }
+  ok(failed == 0 && obj_err < 0.5, "%d actuators: %d problems with the control objective of the reference "
+     "(max %d iterations, objective error %g, input error %g)", n_u, TEST_PROBLEMS, max_iter, obj_err, u_err);
+}
+
+/** Slowly changing objective, warm started from the previous working set */
+static void test_warm_start(int n_u)
+{
+  struct wls_problem p;
+  float W[WLS_N_U] = {0};
+  int iter_cold = 0, iter_warm = 0, failed = 0;
+  double obj_err = 0, u_err = 0;
+
+  srand(10 + n_u);
+  make_problem(&p, n_u);
+  float v0[WLS_N_V];
+  memcpy(v0, p.v, sizeof(v0));
+  for (int n = 0; n < TEST_PROBLEMS; n++) {
+    for (int i = 0; i < WLS_N_V; i++) {
+      p.v[i] = v0[i] * (1 + sin(n * 0.05 + i));
+    }
+    float u_cold[WLS_N_U], u_warm[WLS_N_U];
+    int cold = solve_wls(&p, u_cold, NULL);
+    int warm = solve_wls(&p, u_warm, W);
+    if (cold < 0 || warm < 0) {
+      failed++;
+      continue;
+    }
+    iter_cold += cold;
+    iter_warm += warm;
+    compare_reference(&p, u_warm, &obj_err, &u_err);
+  }
+  ok(failed == 0 && iter_warm < iter_cold && obj_err < 0.5,
+     "%d actuators: warm start reaches the reference objective in %d instead of %d iterations", n_u, iter_warm,
+     iter_cold);
+}
+
+int main(int argc __attribute__((unused)), char **argv __attribute__((unused)))
+{
+  note("running WLS control allocation tests");
+  plan(5);
+
+  test_reference(4);
+  test_reference(WLS_N_U);
+  test_warm_start(4);
+  test_warm_start(WLS_N_U);
+
+  struct wls_problem p;
+  float u[WLS_N_U + 1];
+  make_problem(&p, WLS_N_U);
+  ok(wls_alloc(u, p.v, p.umin, p.umax, p.B_ptr, WLS_N_U + 1, WLS_N_V, 0, 0, Wv, 0, p.up, TEST_GAMMA_SQ, 100) == -1,
+     "more actuators than WLS_N_U is refused");
+
+  done_testing();
+}
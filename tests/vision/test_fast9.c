@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test_fast9.c
+ * @brief Tests for the multi-threaded FAST9 corner detection.
+ *
+ * The detection on multiple threads must give exactly the same corners,
+ * in the same order, as the single threaded detection.
+ *
+ * Using libtap to create a TAP (TestAnythingProtocol) producer:
+ * https://github.com/zorgnax/libtap
+ *
+ */
+
+#include "tap.h"
+
+#include <stdlib.h>
+#include "modules/computer_vision/lib/vision/fast_rosten.h"
+
+#define TEST_W 161
+#define TEST_H 121
+
+/* Random blocks with some noise, to get corners at different distances */
+static void fill_blocks(struct image_t *img)
+{
+  uint8_t pixel_size = (img->type == IMAGE_YUV422) ? 2 : 1;
+  uint8_t *buf = (uint8_t *)img->buf;
+  uint8_t blocks[TEST_H / 6 + 1][TEST_W / 6 + 1];
+  for (uint16_t i = 0; i <= TEST_H / 6; i++) {
+    for (uint16_t j = 0; j <= TEST_W / 6; j++) {
+      blocks[i][j] = rand() & 0xFF;
+    }
+  }
+  for (uint16_t y = 0; y < img->h; y++) {
+    for (uint16_t x = 0; x < img->w; x++) {
+      for (uint8_t c = 0; c < pixel_size; c++) {
+        buf[(y * img->w + x) * pixel_size + c] = Min(blocks[y / 6][x / 6] + (rand() % 8), 255);
+      }
+    }
+  }
+}
+
+static void test_compare(struct image_t *img, uint8_t threshold, uint16_t min_dist, uint16_t *roi,
+                         uint16_t prev_corners, const char *name)
+{
+  uint16_t cnt[2], length[2] = {16, 16};
+  struct point_t *corners[2];
+
+  for (uint8_t t = 0; t < 2; t++) {
+    fast9_num_threads = (t == 0) ? 1 : 4;
+    corners[t] = calloc(length[t], sizeof(struct point_t));
+    // Corners from a previous detection, as used by the feature management
+    for (cnt[t] = 0; cnt[t] < prev_corners; cnt[t]++) {
+      corners[t][cnt[t]].x = 20 + 13 * cnt[t];
+      corners[t][cnt[t]].y = 30 + 7 * cnt[t];
+    }
+    fast9_detect(img, threshold, min_dist, 5, 5, &cnt[t], &length[t], &corners[t], roi);
+  }
+
+  // Only the positions are set by the detection
+  int errors = 0;
+  for (uint16_t i = 0; i < cnt[0] && i < cnt[1]; i++) {
+    if (corners[0][i].x != corners[1][i].x || corners[0][i].y != corners[1][i].y) {
+      errors++;
+    }
+  }
+  ok(cnt[0] > prev_corners && cnt[0] == cnt[1] && errors == 0,
+     "%s threshold %d min_dist %d: %d == %d corners (%d differ)", name, threshold, min_dist, cnt[0], cnt[1], errors);
+
+  free(corners[0]);
+  free(corners[1]);
+}
+
+int main(int argc __attribute__((unused)), char **argv __attribute__((unused)))
+{
+  note("running fast9 tests");
+  plan(16);
+
+  srand(42);
+
+  struct image_t gray, yuv;
+  image_create(&gray, TEST_W, TEST_H, IMAGE_GRAYSCALE);
+  image_create(&yuv, TEST_W, TEST_H, IMAGE_YUV422);
+  fill_blocks(&gray);
+  fill_blocks(&yuv);
+
+  uint16_t roi[4] = {30, 20, 120, 100};
+  const uint8_t thresholds[2] = {5, 20};
+  const uint16_t min_dists[4] = {0, 1, 4, 10};
+  for (uint8_t i = 0; i < 2; i++) {
+    for (uint8_t j = 0; j < 4; j++) {
+      test_compare(&gray, thresholds[i], min_dists[j], NULL, 0, "gray");
+    }
+  }
+  test_compare(&gray, 10, 5, roi, 0, "gray roi");
+  test_compare(&gray, 10, 0, roi, 0, "gray roi");
+  test_compare(&gray, 10, 5, NULL, 6, "gray previous corners");
+  test_compare(&gray, 10, 5, roi, 6, "gray roi previous corners");
+  test_compare(&gray, 10, 12, roi, 6, "gray roi previous corners");
+  test_compare(&yuv, 10, 0, NULL, 0, "yuv422");
+  test_compare(&yuv, 10, 5, NULL, 0, "yuv422");
+  test_compare(&yuv, 10, 5, roi, 3, "yuv422 roi previous corners");
+
+  image_free(&gray);
+  image_free(&yuv);
+
+  done_testing();
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test_frame_arena.c
+ * @brief Tests for the frame arena allocator.
+ *
+ * Checks the arena bookkeeping (alignment, overflow and growth at reset) and
+ * that the Lucas-Kanade tracker gives the same flow with and without arena.
+ *
+ * Using libtap to create a TAP (TestAnythingProtocol) producer:
+ * https://github.com/zorgnax/libtap
+ *
+ */
+
+#include "tap.h"
+
+#include <string.h>
+#include "modules/computer_vision/lib/vision/frame_arena.h"
+#include "modules/computer_vision/lib/vision/lucas_kanade.h"
+
+#define TEST_W 96
+#define TEST_H 64
+#define TEST_POINTS 25
+
+static void test_alloc(void)
+{
+  struct frame_arena_t arena;
+  frame_arena_init(&arena, 256);
+
+  uint8_t *a = frame_arena_alloc(&arena, 3);
+  uint8_t *b = frame_arena_alloc(&arena, 100);
+  uint8_t *c = frame_arena_calloc(&arena, 10, sizeof(int32_t));
+  ok(((uintptr_t)a % FRAME_ARENA_ALIGN) == 0 && ((uintptr_t)b % FRAME_ARENA_ALIGN) == 0
+     && ((uintptr_t)c % FRAME_ARENA_ALIGN) == 0, "allocations are aligned");
+  ok(b >= a + 3 && c >= b + 100 && c + 40 <= arena.buf + arena.size, "allocations do not overlap and fit in the arena");
+
+  uint32_t zeros = 0;
+  for (uint8_t i = 0; i < 40; i++) {
+    zeros += (c[i] == 0);
+  }
+  ok(zeros == 40, "frame_arena_calloc zeroes the memory");
+
+  // Does not fit anymore, served from the heap until the next reset
+  uint8_t *d = frame_arena_alloc(&arena, 512);
+  ok(d != NULL && (d < arena.buf || d >= arena.buf + arena.size) && arena.overflow_cnt == 1,
+     "allocation larger than the arena overflows to the heap");
+  memset(d, 0xAA, 512);
+
+  frame_arena_reset(&arena);
+  ok(arena.size >= arena.peak && arena.peak >= 3 + 100 + 40 + 512 && arena.overflow == NULL,
+     "reset grows the arena to the peak usage (%u bytes)", arena.peak);
+
+  uint8_t *e = frame_arena_alloc(&arena, 600);
+  ok(e == arena.buf && arena.overflow_cnt == 1, "after the reset the same frame fits in the arena");
+
+  frame_arena_free(&arena);
+  ok(arena.buf == NULL && arena.size == 0, "frame_arena_free");
+
+  // Without arena, plain heap allocations
+  int32_t *f = frame_arena_calloc(NULL, 16, sizeof(int32_t));
+  ok(f != NULL && f[0] == 0 && f[15] == 0, "calloc without arena");
+  frame_arena_release(NULL, f);
+}
+
+static void fill_texture(struct image_t *img, int16_t shift_x, int16_t shift_y)
+{
+  uint8_t *buf = (uint8_t *)img->buf;
+  for (int16_t y = 0; y < img->h; y++) {
+    for (int16_t x = 0; x < img->w; x++) {
+      int16_t u = x - shift_x, v = y - shift_y;
+      buf[y * img->w + x] = (uint8_t)(128 + 60 * sinf(u * 0.35f) * cosf(v * 0.27f) + 30 * sinf((u + 2 * v) * 0.11f));
+    }
+  }
+}
+
+/** Compare the tracked positions and flow (the other point fields are not set by the tracker) */
+static bool same_flow(struct flow_t *a, uint16_t a_cnt, struct flow_t *b, uint16_t b_cnt)
+{
+  if (a_cnt != b_cnt) {
+    return false;
+  }
+  for (uint16_t i = 0; i < a_cnt; i++) {
+    if (a[i].pos.x != b[i].pos.x || a[i].pos.y != b[i].pos.y || a[i].flow_x != b[i].flow_x
+        || a[i].flow_y != b[i].flow_y) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void test_lucas_kanade(void)
+{
+  struct image_t old_img, new_img;
+  image_create(&old_img, TEST_W, TEST_H, IMAGE_GRAYSCALE);
+  image_create(&new_img, TEST_W, TEST_H, IMAGE_GRAYSCALE);
+  fill_texture(&old_img, 0, 0);
+  fill_texture(&new_img, 2, 1);
+
+  struct point_t points[TEST_POINTS];
+  for (uint8_t i = 0; i < TEST_POINTS; i++) {
+    points[i].x = 16 + (i % 5) * 16;
+    points[i].y = 12 + (i / 5) * 10;
+    points[i].count = 0;
+    points[i].x_sub = 0;
+    points[i].y_sub = 0;
+  }
+
+  // Start from a small arena, so that the first frame also overflows
+  struct frame_arena_t arena;
+  frame_arena_init(&arena, 64);
+
+  for (uint8_t level = 0; level <= 2; level++) {
+    uint16_t cnt_heap = TEST_POINTS, cnt_arena = TEST_POINTS, cnt_arena2 = TEST_POINTS;
+    struct flow_t *heap = opticFlowLK(&new_img, &old_img, points, &cnt_heap, 5, 10, 10, 2, TEST_POINTS, level, NULL);
+
+    frame_arena_reset(&arena);
+    struct flow_t *first = opticFlowLK(&new_img, &old_img, points, &cnt_arena, 5, 10, 10, 2, TEST_POINTS, level, &arena);
+    bool same_first = same_flow(first, cnt_arena, heap, cnt_heap);
+
+    frame_arena_reset(&arena);
+    uint32_t overflows = arena.overflow_cnt;
+    struct flow_t *second = opticFlowLK(&new_img, &old_img, points, &cnt_arena2, 5, 10, 10, 2, TEST_POINTS, level,
+                                        &arena);
+    bool same_second = same_flow(second, cnt_arena2, heap, cnt_heap);
+
+    ok(cnt_heap > 0 && same_first && same_second && arena.overflow_cnt == overflows,
+       "opticFlowLK pyramid level %d: same %d vectors with the arena, no overflow after the first frame", level,
+       cnt_heap);
+    free(heap);
+  }
+
+  frame_arena_free(&arena);
+  image_free(&old_img);
+  image_free(&new_img);
+}
+
+int main(int argc __attribute__((unused)), char **argv __attribute__((unused)))
+{
+  note("running frame arena tests");
+  plan(11);
+
+  test_alloc();
+  test_lucas_kanade();
+
+  done_testing();
+}
@@ -0,0 +1,309 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test_image.c
+ * @brief Tests for the computer vision image functions.
+ *
+ * The (vectorized) image functions are compared against straightforward
+ * per pixel reference implementations, the results must be bit-exact.
+ *
+ * Using libtap to create a TAP (TestAnythingProtocol) producer:
+ * https://github.com/zorgnax/libtap
+ *
+ */
+
+#include "tap.h"
+
+#include <string.h>
+#include "modules/computer_vision/lib/vision/image.h"
+
+/* Odd sizes to also test the scalar remainders */
+#define TEST_W 70
+#define TEST_H 37
+
+static void fill_random(struct image_t *img)
+{
+  uint8_t *buf = (uint8_t *)img->buf;
+  for (uint32_t i = 0; i < img->buf_size; i++) {
+    buf[i] = rand() & 0xFF;
+  }
+}
+
+static void fill_random_gradient(struct image_t *img)
+{
+  int16_t *buf = (int16_t *)img->buf;
+  for (uint32_t i = 0; i < img->w * img->h; i++) {
+    buf[i] = (rand() % 511) - 255;
+  }
+}
+
+static void test_grayscale(void)
+{
+  struct image_t yuv, gray, gray_ref, yuv_gray, yuv_gray_ref;
+  image_create(&yuv, TEST_W, TEST_H, IMAGE_YUV422);
+  image_create(&gray, TEST_W, TEST_H, IMAGE_GRAYSCALE);
+  image_create(&gray_ref, TEST_W, TEST_H, IMAGE_GRAYSCALE);
+  image_create(&yuv_gray, TEST_W, TEST_H, IMAGE_YUV422);
+  image_create(&yuv_gray_ref, TEST_W, TEST_H, IMAGE_YUV422);
+  fill_random(&yuv);
+
+  uint8_t *src = yuv.buf, *g = gray_ref.buf, *yg = yuv_gray_ref.buf;
+  for (int i = 0; i < TEST_W * TEST_H; i++) {
+    g[i] = src[2 * i + 1];
+    yg[2 * i] = 127;
+    yg[2 * i + 1] = src[2 * i + 1];
+  }
+
+  image_to_grayscale(&yuv, &gray);
+  image_to_grayscale(&yuv, &yuv_gray);
+  ok(memcmp(gray.buf, gray_ref.buf, gray.buf_size) == 0, "image_to_grayscale grayscale output");
+  ok(memcmp(yuv_gray.buf, yuv_gray_ref.buf, yuv_gray.buf_size) == 0, "image_to_grayscale YUV422 output");
+
+  image_free(&yuv);
+  image_free(&gray);
+  image_free(&gray_ref);
+  image_free(&yuv_gray);
+  image_free(&yuv_gray_ref);
+}
+
+static void test_colorfilt(void)
+{
+  struct image_t img, img_ref;
+  image_create(&img, TEST_W, TEST_H, IMAGE_YUV422);
+  image_create(&img_ref, TEST_W, TEST_H, IMAGE_YUV422);
+  fill_random(&img);
+  image_copy(&img, &img_ref);
+
+  uint8_t y_m = 20, y_M = 230, u_m = 30, u_M = 200, v_m = 40, v_M = 210;
+  uint16_t cnt_ref = 0;
+  uint8_t *p = img_ref.buf;
+  for (int i = 0; i < TEST_W * TEST_H / 2; i++, p += 4) {
+    if (p[1] >= y_m && p[1] <= y_M && p[0] >= u_m && p[0] <= u_M && p[2] >= v_m && p[2] <= v_M) {
+      cnt_ref++;
+      p[0] = 64;
+      p[2] = 255;
+    } else {
+      p[0] = 127;
+      p[2] = 127;
+    }
+  }
+
+  uint16_t cnt = image_yuv422_colorfilt(&img, &img, y_m, y_M, u_m, u_M, v_m, v_M);
+  ok(cnt == cnt_ref, "image_yuv422_colorfilt count (%d, expected %d)", cnt, cnt_ref);
+  ok(memcmp(img.buf, img_ref.buf, img.buf_size) == 0, "image_yuv422_colorfilt output");
+
+  image_free(&img);
+  image_free(&img_ref);
+}
+
+static void test_downsample(void)
+{
+  for (uint16_t ds = 1; ds <= 4; ds *= 2) {
+    struct image_t img, small, small_ref;
+    image_create(&img, TEST_W * 4, TEST_H, IMAGE_YUV422);
+    image_create(&small, img.w / ds, img.h / ds, IMAGE_YUV422);
+    image_create(&small_ref, img.w / ds, img.h / ds, IMAGE_YUV422);
+    fill_random(&img);
+
+    uint8_t *src = img.buf, *dst = small_ref.buf;
+    for (int y = 0; y < small_ref.h; y++) {
+      for (int x = 0; x < small_ref.w; x += 2) {
+        uint8_t *s = &src[(y * ds * img.w + x * ds) * 2];
+        *dst++ = s[0];
+        *dst++ = s[1];
+        *dst++ = s[2];
+        *dst++ = s[1 + 2 * ds];
+      }
+    }
+
+    image_yuv422_downsample(&img, &small, ds);
+    ok(memcmp(small.buf, small_ref.buf, small.buf_size) == 0, "image_yuv422_downsample by %d", ds);
+
+    image_free(&img);
+    image_free(&small);
+    image_free(&small_ref);
+  }
+}
+
+static void test_pyramid_next_level(void)
+{
+  const uint8_t border = 5;
+  // [1/16 1/4 3/8 1/4 1/16]' x [1/16 1/4 3/8 1/4 1/16] * 10000 (rounded)
+  const int32_t weights[5][5] = {
+    {  39,  156,  234,  156,   39},
+    { 156,  625,  938,  625,  156},
+    { 234,  938, 1406,  938,  234},
+    { 156,  625,  938,  625,  156},
+    {  39,  156,  234,  156,   39}
+  };
+  struct image_t img, level;
+  image_create(&img, TEST_W * 2 + 2 * border, TEST_H * 2 + 2 * border, IMAGE_GRAYSCALE);
+  fill_random(&img);
+
+  pyramid_next_level(&img, &level, border);
+
+  int errors = 0;
+  uint8_t *in = img.buf, *out = level.buf;
+  for (int i = 0; i < level.h; i++) {
+    for (int j = 0; j < level.w; j++) {
+      int32_t sum = 0;
+      for (int r = -2; r <= 2; r++) {
+        for (int c = -2; c <= 2; c++) {
+          sum += weights[r + 2][c + 2] * in[(border + 2 * i + r) * img.w + border + 2 * j + c];
+        }
+      }
+      if (out[i * level.w + j] != sum / 10000) {
+        errors++;
+      }
+    }
+  }
+  ok(errors == 0, "pyramid_next_level (%d errors)", errors);
+
+  image_free(&img);
+  image_free(&level);
+}
+
+static void test_pyramid_update(void)
+{
+  const uint8_t levels = 3, border = 7;
+  struct image_t img, pyr[levels + 1], ref[levels + 1];
+  image_create(&img, TEST_W + 3, TEST_H + 1, IMAGE_GRAYSCALE);
+  pyramid_create(pyr, img.w, img.h, levels, border);
+
+  // Update the same pyramid twice, the second time it has to be fully overwritten
+  for (int n = 0; n < 2; n++) {
+    fill_random(&img);
+    pyramid_update(&img, pyr, levels, border);
+
+    // Reference: pad every level separately
+    struct image_t temp;
+    image_add_border(&img, &ref[0], border);
+    for (uint8_t i = 1; i <= levels; i++) {
+      pyramid_next_level(&ref[i - 1], &temp, border);
+      image_add_border(&temp, &ref[i], border);
+      image_free(&temp);
+    }
+
+    int errors = 0;
+    for (uint8_t i = 0; i <= levels; i++) {
+      if (pyr[i].w != ref[i].w || pyr[i].h != ref[i].h || memcmp(pyr[i].buf, ref[i].buf, ref[i].buf_size) != 0) {
+        errors++;
+      }
+    }
+    ok(errors == 0, "pyramid_update pass %d (%d levels differ)", n, errors);
+    pyramid_free(ref, levels);
+  }
+
+  pyramid_free(pyr, levels);
+  image_free(&img);
+}
+
+static void test_gradients(void)
+{
+  struct image_t img, dx, dy;
+  image_create(&img, TEST_W, TEST_H, IMAGE_GRAYSCALE);
+  image_create(&dx, TEST_W - 2, TEST_H - 2, IMAGE_GRADIENT);
+  image_create(&dy, TEST_W - 2, TEST_H - 2, IMAGE_GRADIENT);
+  fill_random(&img);
+
+  image_gradients(&img, &dx, &dy);
+
+  int errors = 0;
+  uint8_t *in = img.buf;
+  int16_t *dx_buf = dx.buf, *dy_buf = dy.buf;
+  for (int y = 1; y < img.h - 1; y++) {
+    for (int x = 1; x < img.w - 1; x++) {
+      if (dx_buf[(y - 1) * dx.w + x - 1] != in[y * img.w + x + 1] - in[y * img.w + x - 1] ||
+          dy_buf[(y - 1) * dy.w + x - 1] != in[(y + 1) * img.w + x] - in[(y - 1) * img.w + x]) {
+        errors++;
+      }
+    }
+  }
+  ok(errors == 0, "image_gradients (%d errors)", errors);
+
+  image_free(&img);
+  image_free(&dx);
+  image_free(&dy);
+}
+
+static void test_difference_multiply(void)
+{
+  struct image_t a, b, diff, ga, gb, mult;
+  image_create(&a, TEST_W + 2, TEST_H + 2, IMAGE_GRAYSCALE);
+  image_create(&b, TEST_W, TEST_H, IMAGE_GRAYSCALE);
+  image_create(&diff, TEST_W, TEST_H, IMAGE_GRADIENT);
+  image_create(&ga, TEST_W, TEST_H, IMAGE_GRADIENT);
+  image_create(&gb, TEST_W, TEST_H, IMAGE_GRADIENT);
+  image_create(&mult, TEST_W, TEST_H, IMAGE_GRADIENT);
+  fill_random(&a);
+  fill_random(&b);
+  fill_random_gradient(&ga);
+  fill_random_gradient(&gb);
+
+  uint32_t sum_diff2 = image_difference(&a, &b, &diff);
+  int32_t sum_mult = image_multiply(&ga, &gb, &mult);
+
+  int errors = 0;
+  uint32_t sum_diff2_ref = 0;
+  int32_t sum_mult_ref = 0;
+  uint8_t *a_buf = a.buf, *b_buf = b.buf;
+  int16_t *diff_buf = diff.buf, *ga_buf = ga.buf, *gb_buf = gb.buf, *mult_buf = mult.buf;
+  for (int y = 0; y < TEST_H; y++) {
+    for (int x = 0; x < TEST_W; x++) {
+      int16_t d = a_buf[(y + 1) * a.w + x + 1] - b_buf[y * b.w + x];
+      int32_t m = ga_buf[y * TEST_W + x] * gb_buf[y * TEST_W + x];
+      sum_diff2_ref += d * d;
+      sum_mult_ref += m;
+      if (diff_buf[y * TEST_W + x] != d || mult_buf[y * TEST_W + x] != (int16_t)m) {
+        errors++;
+      }
+    }
+  }
+  ok(sum_diff2 == sum_diff2_ref, "image_difference sum (%u, expected %u)", sum_diff2, sum_diff2_ref);
+  ok(sum_mult == sum_mult_ref, "image_multiply sum (%d, expected %d)", sum_mult, sum_mult_ref);
+  ok(errors == 0, "image_difference and image_multiply output (%d errors)", errors);
+  ok(image_difference(&a, &b, NULL) == sum_diff2_ref, "image_difference without output image");
+
+  image_free(&a);
+  image_free(&b);
+  image_free(&diff);
+  image_free(&ga);
+  image_free(&gb);
+  image_free(&mult);
+}
+
+int main(int argc __attribute__((unused)), char **argv __attribute__((unused)))
+{
+  note("running image function tests");
+  plan(15);
+
+  srand(42);
+
+  test_grayscale();
+  test_colorfilt();
+  test_downsample();
+  test_pyramid_next_level();
+  test_pyramid_update();
+  test_gradients();
+  test_difference_multiply();
+
+  done_testing();
+}
@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2018 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test_jpeg.c
+ * @brief Tests for the JPEG encoder.
+ *
+ * Checks the (vectorized) DCT and quantization against the scalar reference and
+ * that the restart intervals are independent and do not depend on the amount of threads.
+ * The encoder source is included to reach its static functions.
+ *
+ * Using libtap to create a TAP (TestAnythingProtocol) producer:
+ * https://github.com/zorgnax/libtap
+ *
+ */
+
+#include "tap.h"
+
+#include "modules/computer_vision/lib/encoding/jpeg.c"
+
+#define TEST_W 100
+#define TEST_H 76
+
+/** Scalar level shift, DCT and quantization of the original encoder */
+static void reference_transform(int16_t *data, uint16_t *quant, int16_t *out)
+{
+  int32_t x0, x1, x2, x3, x4, x5, x6, x7, x8;
+  int16_t *d = data;
+
+  for (uint8_t i = 0; i < 64; i++) {
+    d[i] -= 128;
+  }
+
+  for (uint8_t i = 0; i < 8; i++, d += 8) {
+    x8 = d[0] + d[7]; x0 = d[0] - d[7];
+    x7 = d[1] + d[6]; x1 = d[1] - d[6];
+    x6 = d[2] + d[5]; x2 = d[2] - d[5];
+    x5 = d[3] + d[4]; x3 = d[3] - d[4];
+    x4 = x8 + x5; x8 -= x5;
+    x5 = x7 + x6; x7 -= x6;
+    d[0] = (int16_t)(x4 + x5);
+    d[4] = (int16_t)(x4 - x5);
+    d[2] = (int16_t)((x8 * 1338 + x7 * 554) >> 10);
+    d[6] = (int16_t)((x8 * 554 - x7 * 1338) >> 10);
+    d[7] = (int16_t)((x0 * 283 - x1 * 805 + x2 * 1204 - x3 * 1420) >> 10);
+    d[5] = (int16_t)((x0 * 805 - x1 * 1420 + x2 * 283 + x3 * 1204) >> 10);
+    d[3] = (int16_t)((x0 * 1204 - x1 * 283 - x2 * 1420 - x3 * 805) >> 10);
+    d[1] = (int16_t)((x0 * 1420 + x1 * 1204 + x2 * 805 + x3 * 283) >> 10);
+  }
+
+  d = data;
+  for (uint8_t i = 0; i < 8; i++, d++) {
+    x8 = d[0] + d[56]; x0 = d[0] - d[56];
+    x7 = d[8] + d[48]; x1 = d[8] - d[48];
+    x6 = d[16] + d[40]; x2 = d[16] - d[40];
+    x5 = d[24] + d[32]; x3 = d[24] - d[32];
+    x4 = x8 + x5; x8 -= x5;
+    x5 = x7 + x6; x7 -= x6;
+    d[0] = (int16_t)((x4 + x5) >> 3);
+    d[32] = (int16_t)((x4 - x5) >> 3);
+    d[16] = (int16_t)((x8 * 1338 + x7 * 554) >> 13);
+    d[48] = (int16_t)((x8 * 554 - x7 * 1338) >> 13);
+    d[56] = (int16_t)((x0 * 283 - x1 * 805 + x2 * 1204 - x3 * 1420) >> 13);
+    d[40] = (int16_t)((x0 * 805 - x1 * 1420 + x2 * 283 + x3 * 1204) >> 13);
+    d[24] = (int16_t)((x0 * 1204 - x1 * 283 - x2 * 1420 - x3 * 805) >> 13);
+    d[8] = (int16_t)((x0 * 1420 + x1 * 1204 + x2 * 805 + x3 * 283) >> 13);
+  }
+
+  for (uint8_t i = 0; i < 64; i++) {
+    out[zigzag_table[i]] = (int16_t)((data[i] * quant[i] + 0x4000) >> 15);
+  }
+}
+
+static void test_transform(void)
+{
+  JPEG_ENCODER_STRUCTURE jpeg;
+  int16_t block[64], ref_block[64], ref[64];
+  uint32_t mismatches = 0;
+
+  srand(42);
+  for (uint32_t n = 0; n < 2000; n++) {
+    // Extreme and random blocks, with the finest (0x8000) and random quality tables
+    MakeTables(&jpeg, (n % 4 == 0) ? 99 : rand() % 100);
+    for (uint8_t i = 0; i < 64; i++) {
+      if (n < 2) {
+        block[i] = (n == 0) ? 0 : 255;
+      } else if (n < 4) {
+        block[i] = (((i >> 3) + i) & 1) ? 255 : 0;
+      } else {
+        block[i] = rand() % 256;
+      }
+      ref_block[i] = block[i];
+    }
+
+    uint16_t *quant = (n & 1) ? jpeg.ICqt : jpeg.ILqt;
+    jpeg_transform(&jpeg, block, quant);
+    reference_transform(ref_block, quant, ref);
+    mismatches += (memcmp(jpeg.Temp, ref, sizeof(ref)) != 0);
+  }
+  ok(mismatches == 0, "DCT and quantization equal to the scalar reference (%d of 2000 blocks differ)", mismatches);
+}
+
+static void fill_image(struct image_t *img)
+{
+  uint8_t *buf = (uint8_t *)img->buf;
+  for (uint32_t i = 0; i < img->buf_size; i++) {
+    uint16_t x = (i / ((img->type == IMAGE_YUV422) ? 2 : 1)) % img->w;
+    uint16_t y = (i / ((img->type == IMAGE_YUV422) ? 2 : 1)) / img->w;
+    buf[i] = (uint8_t)(128 + 50 * sinf(x * 0.21f + (i & 1)) * cosf(y * 0.13f) + (rand() % 32));
+  }
+}
+
+/** Return the pointer after the next marker (0xFF followed by not 0x00) */
+static uint8_t *find_marker(uint8_t *ptr, uint8_t *end, uint8_t *marker)
+{
+  for (; ptr + 1 < end; ptr++) {
+    if (ptr[0] == 0xFF && ptr[1] != 0x00) {
+      *marker = ptr[1];
+      return ptr + 2;
+    }
+  }
+  return NULL;
+}
+
+static void test_restart(enum image_type type, const char *name)
+{
+  struct image_t img, full, sliced, part, part_jpeg;
+  image_create(&img, TEST_W, TEST_H, type);
+  image_create(&full, TEST_W, TEST_H, IMAGE_JPEG);
+  image_create(&sliced, TEST_W, TEST_H, IMAGE_JPEG);
+  image_create(&part_jpeg, TEST_W, 16, IMAGE_JPEG);
+  fill_image(&img);
+
+  // Without restart intervals the encoding is the same as before
+  jpeg_num_threads = 1;
+  jpeg_encode_image(&img, &full, 80, true);
+  uint16_t interval = jpeg_encode_image_restart(&img, &sliced, 80, true, 0);
+  ok(interval == 0 && full.buf_size == sliced.buf_size && memcmp(full.buf, sliced.buf, full.buf_size) == 0,
+     "%s: encoding without restart intervals", name);
+
+  // Restart intervals of 2 MCU rows, with the DRI marker in the header
+  interval = jpeg_encode_image_restart(&img, &full, 80, true, 2);
+  uint8_t *buf = (uint8_t *)full.buf, *end = buf + full.buf_size;
+  uint8_t *dri = NULL, *scan = buf, marker = 0;
+  while (scan != NULL && marker != 0xDA) {
+    scan = find_marker(scan, end, &marker);
+    if (marker == 0xDD) {
+      dri = scan;
+    }
+  }
+  ok(interval == 2 * ((type == IMAGE_YUV422) ? (TEST_W + 15) / 16 : (TEST_W + 7) / 8) && dri != NULL
+     && ((dri[2] << 8) | dri[3]) == interval && end[-2] == 0xFF && end[-1] == 0xD9,
+     "%s: restart interval of %d MCUs in the DRI marker", name, interval);
+
+  // Every interval is the scan data of the image band on its own (the last band is not a full MCU row)
+  scan += (scan[0] << 8) | scan[1];
+  uint8_t slices = 0, bad = 0;
+  uint32_t row_size = img.buf_size / TEST_H;
+  part.type = type;
+  part.w = TEST_W;
+  while (scan < end) {
+    uint8_t *next = find_marker(scan, end, &marker);
+    part.h = (TEST_H - slices * 16 > 16) ? 16 : TEST_H - slices * 16;
+    part.buf_size = part.h * row_size;
+    part.buf = (uint8_t *)img.buf + slices * 16 * row_size;
+    jpeg_encode_image(&part, &part_jpeg, 80, false);
+    bad += (part_jpeg.buf_size != next - scan || memcmp(part_jpeg.buf, scan, next - scan - 2) != 0);
+    bad += (marker != ((next == end) ? 0xD9 : 0xD0 + (slices & 0x07)));
+    slices++;
+    scan = next;
+  }
+  ok(slices == (TEST_H + 15) / 16 && bad == 0, "%s: %d restart intervals with the RSTn markers, each encoded independently",
+     name, slices);
+
+  // The amount of threads does not change the output
+  for (uint8_t threads = 2; threads <= 4; threads += 2) {
+    jpeg_num_threads = threads;
+    jpeg_encode_image_restart(&img, &sliced, 80, true, 2);
+    ok(sliced.buf_size == full.buf_size && memcmp(sliced.buf, full.buf, full.buf_size) == 0,
+       "%s: same output with %d threads", name, threads);
+  }
+  jpeg_num_threads = 1;
+
+  image_free(&img);
+  image_free(&full);
+  image_free(&sliced);
+  image_free(&part_jpeg);
+}
+
+int main(int argc __attribute__((unused)), char **argv __attribute__((unused)))
+{
+  note("running JPEG encoder tests");
+  plan(11);
+
+  test_transform();
+  test_restart(IMAGE_YUV422, "YUV422");
+  test_restart(IMAGE_GRAYSCALE, "grayscale");
+
+  done_testing();
+}